@@ -11,6 +11,7 @@ class BuildSystem
 private:
     std::string build_type_;
     std::string output_type_;
+    bool benchmark_;
     
     int execute_command(const std::string& command) const
     {
@@ -19,7 +20,7 @@ private:
     }
     
 public:
-    BuildSystem() : build_type_("debug"), output_type_("executable")
+    BuildSystem() : build_type_("debug"), output_type_("executable"), benchmark_(false)
     {
     }
     
@@ -33,8 +34,37 @@ public:
         output_type_ = type;
     }
     
+    void set_benchmark(bool benchmark)
+    {
+        benchmark_ = benchmark;
+    }
+    
+    // Builds tests/benchmark.cpp alone; it has its own main()
+    int build_benchmark()
+    {
+        std::string build_dir = "build/" + build_type_;
+        fs::create_directories(build_dir);
+        
+        std::string compile_flags = build_type_ == "release" ? "-O3 -DNDEBUG" : "-O2 -DNDEBUG";
+        compile_flags += " -std=c++23 -Wall -Wextra -Iinclude -Iinclude/external";
+        std::string output_name = build_dir + "/benchmark";
+        
+        std::cout << "Building benchmark (" << build_type_ << ")..." << std::endl;
+        if (execute_command("g++ " + compile_flags + " tests/benchmark.cpp -pthread -o " + output_name) == 0)
+        {
+            std::cout << "Benchmark built: " << output_name << std::endl;
+            return 0;
+        }
+        return 1;
+    }
+    
     int build()
     {
+        if (benchmark_)
+        {
+            return build_benchmark();
+        }
+        
         std::string build_dir = "build/" + build_type_;
         fs::create_directories(build_dir);
         
@@ -175,6 +205,10 @@ int main(int argc, char* argv[])
             {
                 builder.set_output_type("dynamic");
             }
+            else if (arg == "--bench")
+            {
+                builder.set_benchmark(true);
+            }
             else if (arg == "--help")
             {
                 std::cout << "Usage: " << argv[0] << " [options]\n";
@@ -184,6 +218,7 @@ int main(int argc, char* argv[])
                 std::cout << "  --executable     Build static executable (default)\n";
                 std::cout << "  --static         Build static library\n";
                 std::cout << "  --dynamic        Build dynamic library\n";
+                std::cout << "  --bench          Build the benchmark suite (tests/benchmark.cpp)\n";
                 std::cout << "  --help           Show this help message\n";
                 return 0;
             }
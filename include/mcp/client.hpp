@@ -3,10 +3,18 @@
 #include "protocol.hpp"
 #include "jsonrpc/jsonrpc.hpp"
 #include "transport/transport.hpp"
+#include "core/asyncops.hpp"
 #include <memory>
 #include <functional>
 #include <vector>
 #include <stdexcept>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <unordered_map>
+#include <cstdint>
 
 /**
  * @file client.hpp
@@ -30,6 +38,8 @@ namespace pooriayousefi::mcp
         using PromptsCallback = std::function<void(const std::vector<Prompt>&)>;
         using ResourcesCallback = std::function<void(const std::vector<Resource>&)>;
         using ToolResultCallback = std::function<void(const std::vector<ToolResultContent>&)>;
+        using ToolChunkCallback = std::function<void(const ToolResultContent&)>;
+        using ResourceChunkCallback = std::function<void(const ResourceContent&)>;
 
         /**
          * @brief Construct client with transport
@@ -37,14 +47,17 @@ namespace pooriayousefi::mcp
          */
         explicit Client(std::shared_ptr<transport::Transport> transport)
             : transport_(std::move(transport))
-            , endpoint_(std::make_unique<jsonrpc::endpoint>([this](const json& msg) {
-                  transport_->send(msg);
+            , endpoint_(std::make_unique<jsonrpc::endpoint>([this](json&& msg) {
+                  transport_->send(std::move(msg));
               }))
             , initialized_(false)
         {
             // Set up transport message handler
-            transport_->on_message([this](const json& msg) {
-                endpoint_->receive(msg);
+            transport_->on_message([this](json&& msg) {
+                endpoint_->receive(std::move(msg));
+            });
+            transport_->set_message_filter([this](const jsonrpc::envelope& envelope) {
+                return endpoint_->accepts(envelope);
             });
 
             transport_->on_error([this](const std::string& error) {
@@ -55,9 +68,31 @@ namespace pooriayousefi::mcp
 
             transport_->on_close([this]() {
                 initialized_ = false;
+                transport_->set_encoding(transport::Encoding::json);
+                invalidate_list_cache();
+            });
+
+            endpoint_->add("notifications/tools/list_changed", [this](const json&) -> json {
+                forget_list(tools_cache_);
+                return json{};
+            });
+            endpoint_->add("notifications/prompts/list_changed", [this](const json&) -> json {
+                forget_list(prompts_cache_);
+                return json{};
+            });
+            endpoint_->add("notifications/resources/list_changed", [this](const json&) -> json {
+                forget_list(resources_cache_);
+                return json{};
             });
         }
 
+        /**
+         * @brief Close the transport so its thread stops calling into this client
+         */
+        ~Client() {
+            close();
+        }
+
         /**
          * @brief Start the client (begins transport)
          */
@@ -87,12 +122,78 @@ namespace pooriayousefi::mcp
             error_callback_ = std::move(callback);
         }
 
+        /**
+         * @brief Fail requests that get no response within timeout
+         * @param timeout Deadline applied to every request (zero = wait forever)
+         *
+         * An expired request reports "Request timed out" through its error
+         * callback, and the server is sent `$/cancelRequest` for it.
+         */
+        void set_request_timeout(std::chrono::milliseconds timeout) {
+            endpoint_->set_default_timeout(timeout);
+        }
+
+        /**
+         * @brief Record metrics and run span hooks for this client
+         * @param metrics Registry (nullptr stops recording)
+         * @param transport_name transport label of this client's traffic series
+         *
+         * Exports mcp_pending_requests (see jsonrpc::endpoint::set_metrics()) and the
+         * transport's traffic (transport::Transport::set_metrics()). Call before start().
+         */
+        void set_metrics(std::shared_ptr<core::Metrics> metrics, const std::string& transport_name = "client") {
+            endpoint_->set_metrics(metrics);
+            transport_->set_metrics(std::move(metrics), transport_name);
+        }
+
+        /**
+         * @brief Keep tool, prompt and resource lists between calls (on by default)
+         * @param enabled False sends every list call to the server
+         *
+         * A list is kept only when the server advertises `listChanged` for it, since
+         * its `notifications/<kind>/list_changed` is what drops the copy. Lists are
+         * also dropped on initialize and when the transport closes.
+         */
+        void set_list_cache(bool enabled) {
+            list_cache_enabled_ = enabled;
+            if (!enabled) invalidate_list_cache();
+        }
+
+        /**
+         * @brief Drop every cached list; the next list call asks the server again
+         */
+        void invalidate_list_cache() {
+            forget_list(tools_cache_);
+            forget_list(prompts_cache_);
+            forget_list(resources_cache_);
+        }
+
+        /**
+         * @brief Look a tool up in the cached tools/list result without a round trip
+         * @param name Tool name
+         * @return The tool, or nullopt if it is unknown or no tool list is cached
+         *
+         * The cache is filled by list_tools(); call it again after nullopt if the
+         * list may have been dropped by a change notification.
+         */
+        std::optional<Tool> find_tool(std::string_view name) const {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            if (!tools_cache_.items) return std::nullopt;
+            auto it = tool_index_.find(name);
+            if (it == tool_index_.end()) return std::nullopt;
+            return (*tools_cache_.items)[it->second];
+        }
+
         /**
          * @brief Initialize connection with server
          * @param client_info Client implementation info
          * @param capabilities Client capabilities
          * @param on_success Callback on successful initialization
          * @param on_error Callback on error
+         *
+         * Encodings in capabilities.encodings that the transport cannot carry
+         * are not offered. If the server picks one, the transport switches to it
+         * before `notifications/initialized` is sent.
          */
         void initialize(
             const Implementation& client_info,
@@ -100,18 +201,30 @@ namespace pooriayousefi::mcp
             InitializeCallback on_success,
             ErrorCallback on_error
         ) {
+            invalidate_list_cache();
+            ClientCapabilities offered = capabilities;
+            std::erase_if(offered.encodings, [this](const std::string& name) {
+                auto encoding = transport::parse_encoding(name);
+                return !encoding || !transport_->supports_encoding(*encoding);
+            });
             json params = {
                 {"protocolVersion", MCP_PROTOCOL_VERSION},
-                {"capabilities", capabilities.to_json()},
+                {"capabilities", offered.to_json()},
                 {"clientInfo", client_info.to_json()}
             };
 
             endpoint_->send_request(
                 "initialize",
                 params,
-                [this, on_success](const json& result) {
+                [this, on_success, encodings = std::move(offered.encodings)](const json& result) {
                     server_info_ = ServerInfo::from_json(result);
                     initialized_ = true;
+
+                    auto chosen = server_info_.capabilities.find("encoding");
+                    if (chosen != server_info_.capabilities.end() && chosen->is_string() &&
+                        std::find(encodings.begin(), encodings.end(), chosen->get<std::string>()) != encodings.end()) {
+                        transport_->set_encoding(*transport::parse_encoding(chosen->get<std::string>()));
+                    }
                     
                     // Send initialized notification
                     endpoint_->send_notification("notifications/initialized", json::object());
@@ -133,6 +246,9 @@ namespace pooriayousefi::mcp
          * @brief List available tools from server
          * @param on_success Callback with list of tools
          * @param on_error Callback on error
+         *
+         * Paginated lists are fetched page by page; on_success gets all of them.
+         * A cached list (see set_list_cache()) is delivered at once, on this thread.
          */
         void list_tools(ToolsCallback on_success, ErrorCallback on_error) {
             if (!initialized_) {
@@ -140,25 +256,7 @@ namespace pooriayousefi::mcp
                 return;
             }
 
-            endpoint_->send_request(
-                "tools/list",
-                json::object(),
-                [on_success](const json& result) {
-                    std::vector<Tool> tools;
-                    if (result.contains("tools") && result["tools"].is_array()) {
-                        for (const auto& tool_json : result["tools"]) {
-                            tools.push_back(Tool::from_json(tool_json));
-                        }
-                    }
-                    if (on_success) on_success(tools);
-                },
-                [on_error](const json& error) {
-                    if (on_error) {
-                        std::string msg = error.value("message", "Unknown error");
-                        on_error(msg);
-                    }
-                }
-            );
+            list_cached<Tool>(tools_cache_, "tools/list", "tools", std::move(on_success), std::move(on_error));
         }
 
         /**
@@ -167,12 +265,14 @@ namespace pooriayousefi::mcp
          * @param arguments Tool arguments as JSON
          * @param on_success Callback with tool result
          * @param on_error Callback on error
+         * @param timeout Deadline for this call; zero uses set_request_timeout()
          */
         void call_tool(
             const std::string& tool_name,
             const json& arguments,
             ToolResultCallback on_success,
-            ErrorCallback on_error
+            ErrorCallback on_error,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
         ) {
             if (!initialized_) {
                 if (on_error) on_error("Client not initialized");
@@ -188,38 +288,113 @@ namespace pooriayousefi::mcp
                 "tools/call",
                 params,
                 [on_success](const json& result) {
-                    std::vector<ToolResultContent> contents;
-                    if (result.contains("content") && result["content"].is_array()) {
-                        for (const auto& content_json : result["content"]) {
-                            ToolResultContent content;
-                            content.type = content_json.value("type", "text");
-                            if (content_json.contains("text")) {
-                                content.text = content_json["text"].get<std::string>();
-                            }
-                            if (content_json.contains("data")) {
-                                content.data = content_json["data"].get<std::string>();
-                            }
-                            if (content_json.contains("mimeType")) {
-                                content.mime_type = content_json["mimeType"].get<std::string>();
-                            }
-                            contents.push_back(content);
-                        }
-                    }
-                    if (on_success) on_success(contents);
+                    if (on_success) on_success(parse_tool_result(result));
                 },
                 [on_error](const json& error) {
                     if (on_error) {
                         std::string msg = error.value("message", "Unknown error");
                         on_error(msg);
                     }
+                },
+                timeout
+            );
+        }
+
+        /**
+         * @brief Call a tool and receive its content as the server produces it
+         * @param tool_name Name of the tool to call
+         * @param arguments Tool arguments as JSON
+         * @param on_chunk Called for each content item, in order
+         * @param on_complete Called once after the last chunk
+         * @param on_error Callback on error
+         * @param timeout Deadline for the whole call; zero uses set_request_timeout()
+         *
+         * The request carries a `partialResultToken`; a streaming server sends each
+         * chunk as `$/progress` on that token the moment it is yielded. Content in
+         * the final result (from servers that do not stream) is delivered through
+         * on_chunk as well, so the callback sees the same items either way.
+         */
+        void call_tool_streaming(
+            const std::string& tool_name,
+            const json& arguments,
+            ToolChunkCallback on_chunk,
+            std::function<void()> on_complete,
+            ErrorCallback on_error,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
+        ) {
+            if (!initialized_) {
+                if (on_error) on_error("Client not initialized");
+                return;
+            }
+
+            json params = {
+                {"name", tool_name},
+                {"arguments", arguments}
+            };
+            send_streaming("tools/call", std::move(params), [on_chunk](const json& value) {
+                for (const auto& content : parse_tool_result(value)) {
+                    if (on_chunk) on_chunk(content);
                 }
+            }, std::move(on_complete), std::move(on_error), timeout);
+        }
+
+        /**
+         * @brief Pull a tool's content chunk by chunk as it arrives
+         * @param tool_name Name of the tool to call
+         * @param arguments Tool arguments as JSON
+         * @param timeout Deadline for the whole call; zero uses set_request_timeout()
+         * @return Generator yielding each content item; throws std::runtime_error on failure
+         *
+         * The request is sent when iteration starts, and each step blocks until the
+         * next chunk arrives. Do not iterate on the transport thread (for example
+         * from inside another callback): that thread delivers the chunks.
+         *
+         * @example
+         * ```cpp
+         * for (const auto& chunk : client.stream_tool("search", {{"query", "mcp"}})) {
+         *     render(chunk);
+         * }
+         * ```
+         */
+        core::Generator<ToolResultContent> stream_tool(
+            std::string tool_name,
+            json arguments,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
+        ) {
+            auto buffer = std::make_shared<ChunkBuffer<ToolResultContent>>();
+            call_tool_streaming(
+                tool_name,
+                arguments,
+                [buffer](const ToolResultContent& content) { buffer->push(content); },
+                [buffer]() { buffer->finish(""); },
+                [buffer](const std::string& error) { buffer->finish(error.empty() ? "Unknown error" : error); },
+                timeout
             );
+
+            while (true) {
+                std::unique_lock<std::mutex> lock(buffer->mutex);
+                buffer->ready.wait(lock, [&buffer]() { return !buffer->chunks.empty() || buffer->finished; });
+                if (!buffer->chunks.empty()) {
+                    auto content = std::move(buffer->chunks.front());
+                    buffer->chunks.pop_front();
+                    lock.unlock();
+                    co_yield std::move(content);
+                    continue;
+                }
+                if (!buffer->error.empty()) {
+                    throw std::runtime_error(buffer->error);
+                }
+                co_return;
+            }
         }
 
         /**
          * @brief List available prompts from server
          * @param on_success Callback with list of prompts
          * @param on_error Callback on error
+         *
+         * Paginated lists are fetched page by page; on_success gets all of them.
+         * A cached list (see set_list_cache()) is delivered at once, on this thread.
          */
         void list_prompts(PromptsCallback on_success, ErrorCallback on_error) {
             if (!initialized_) {
@@ -227,25 +402,7 @@ namespace pooriayousefi::mcp
                 return;
             }
 
-            endpoint_->send_request(
-                "prompts/list",
-                json::object(),
-                [on_success](const json& result) {
-                    std::vector<Prompt> prompts;
-                    if (result.contains("prompts") && result["prompts"].is_array()) {
-                        for (const auto& prompt_json : result["prompts"]) {
-                            prompts.push_back(Prompt::from_json(prompt_json));
-                        }
-                    }
-                    if (on_success) on_success(prompts);
-                },
-                [on_error](const json& error) {
-                    if (on_error) {
-                        std::string msg = error.value("message", "Unknown error");
-                        on_error(msg);
-                    }
-                }
-            );
+            list_cached<Prompt>(prompts_cache_, "prompts/list", "prompts", std::move(on_success), std::move(on_error));
         }
 
         /**
@@ -266,39 +423,11 @@ namespace pooriayousefi::mcp
                 return;
             }
 
-            json args = json::object();
-            for (const auto& [key, value] : arguments) {
-                args[key] = value;
-            }
-
-            json params = {
-                {"name", prompt_name},
-                {"arguments", args}
-            };
-
             endpoint_->send_request(
                 "prompts/get",
-                params,
+                prompt_params(prompt_name, arguments),
                 [on_success](const json& result) {
-                    std::vector<PromptMessage> messages;
-                    if (result.contains("messages") && result["messages"].is_array()) {
-                        for (const auto& msg_json : result["messages"]) {
-                            PromptMessage msg;
-                            std::string role_str = msg_json.value("role", "user");
-                            msg.role = (role_str == "assistant") ? MessageRole::Assistant : MessageRole::User;
-                            
-                            if (msg_json.contains("content") && msg_json["content"].is_object()) {
-                                MessageContent content;
-                                content.type = msg_json["content"].value("type", "text");
-                                if (msg_json["content"].contains("text")) {
-                                    content.text = msg_json["content"]["text"].get<std::string>();
-                                }
-                                msg.content.push_back(content);
-                            }
-                            messages.push_back(msg);
-                        }
-                    }
-                    if (on_success) on_success(messages);
+                    if (on_success) on_success(parse_prompt_messages(result));
                 },
                 [on_error](const json& error) {
                     if (on_error) {
@@ -313,6 +442,9 @@ namespace pooriayousefi::mcp
          * @brief List available resources from server
          * @param on_success Callback with list of resources
          * @param on_error Callback on error
+         *
+         * Paginated lists are fetched page by page; on_success gets all of them.
+         * A cached list (see set_list_cache()) is delivered at once, on this thread.
          */
         void list_resources(ResourcesCallback on_success, ErrorCallback on_error) {
             if (!initialized_) {
@@ -320,25 +452,7 @@ namespace pooriayousefi::mcp
                 return;
             }
 
-            endpoint_->send_request(
-                "resources/list",
-                json::object(),
-                [on_success](const json& result) {
-                    std::vector<Resource> resources;
-                    if (result.contains("resources") && result["resources"].is_array()) {
-                        for (const auto& res_json : result["resources"]) {
-                            resources.push_back(Resource::from_json(res_json));
-                        }
-                    }
-                    if (on_success) on_success(resources);
-                },
-                [on_error](const json& error) {
-                    if (on_error) {
-                        std::string msg = error.value("message", "Unknown error");
-                        on_error(msg);
-                    }
-                }
-            );
+            list_cached<Resource>(resources_cache_, "resources/list", "resources", std::move(on_success), std::move(on_error));
         }
 
         /**
@@ -346,11 +460,13 @@ namespace pooriayousefi::mcp
          * @param uri Resource URI
          * @param on_success Callback with resource contents
          * @param on_error Callback on error
+         * @param timeout Deadline for this call; zero uses set_request_timeout()
          */
         void read_resource(
             const std::string& uri,
             std::function<void(const std::vector<ResourceContent>&)> on_success,
-            ErrorCallback on_error
+            ErrorCallback on_error,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
         ) {
             if (!initialized_) {
                 if (on_error) on_error("Client not initialized");
@@ -363,34 +479,162 @@ namespace pooriayousefi::mcp
                 "resources/read",
                 params,
                 [on_success](const json& result) {
-                    std::vector<ResourceContent> contents;
-                    if (result.contains("contents") && result["contents"].is_array()) {
-                        for (const auto& content_json : result["contents"]) {
-                            ResourceContent content;
-                            content.uri = content_json.value("uri", "");
-                            if (content_json.contains("mimeType")) {
-                                content.mime_type = content_json["mimeType"].get<std::string>();
-                            }
-                            if (content_json.contains("text")) {
-                                content.text = content_json["text"].get<std::string>();
-                            }
-                            if (content_json.contains("blob")) {
-                                content.blob = content_json["blob"].get<std::string>();
-                            }
-                            contents.push_back(content);
-                        }
-                    }
-                    if (on_success) on_success(contents);
+                    if (on_success) on_success(parse_resource_contents(result));
                 },
                 [on_error](const json& error) {
                     if (on_error) {
                         std::string msg = error.value("message", "Unknown error");
                         on_error(msg);
                     }
-                }
+                },
+                timeout
             );
         }
 
+        /**
+         * @brief Read a resource and receive its contents as the server produces them
+         * @param uri Resource URI
+         * @param on_chunk Called for each content item, in order
+         * @param on_complete Called once after the last chunk
+         * @param on_error Callback on error
+         * @param timeout Deadline for the whole call; zero uses set_request_timeout()
+         *
+         * See call_tool_streaming() for how chunks are delivered.
+         */
+        void read_resource_streaming(
+            const std::string& uri,
+            ResourceChunkCallback on_chunk,
+            std::function<void()> on_complete,
+            ErrorCallback on_error,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
+        ) {
+            if (!initialized_) {
+                if (on_error) on_error("Client not initialized");
+                return;
+            }
+
+            send_streaming("resources/read", json{{"uri", uri}}, [on_chunk](const json& value) {
+                for (const auto& content : parse_resource_contents(value)) {
+                    if (on_chunk) on_chunk(content);
+                }
+            }, std::move(on_complete), std::move(on_error), timeout);
+        }
+
+        /**
+         * @brief Accumulates calls and sends them to the server as one JSON-RPC batch
+         *
+         * All queued calls go out in a single message (a single POST over HTTP),
+         * and each response is delivered to the callbacks of its own call.
+         *
+         * @example
+         * ```cpp
+         * client.batch()
+         *     .call_tool("search", {{"query", "mcp"}}, on_results, on_error)
+         *     .read_resource("file:///notes.txt", on_notes, on_error)
+         *     .send();
+         * ```
+         */
+        class Batch {
+        public:
+            explicit Batch(Client& client) : client_(client) {}
+
+            /**
+             * @brief Queue a tools/call request
+             */
+            Batch& call_tool(
+                const std::string& tool_name,
+                const json& arguments,
+                ToolResultCallback on_success,
+                ErrorCallback on_error
+            ) {
+                json params = {
+                    {"name", tool_name},
+                    {"arguments", arguments}
+                };
+                add("tools/call", std::move(params), [on_success](const json& result) {
+                    if (on_success) on_success(parse_tool_result(result));
+                }, std::move(on_error));
+                return *this;
+            }
+
+            /**
+             * @brief Queue a resources/read request
+             */
+            Batch& read_resource(
+                const std::string& uri,
+                std::function<void(const std::vector<ResourceContent>&)> on_success,
+                ErrorCallback on_error
+            ) {
+                add("resources/read", json{{"uri", uri}}, [on_success](const json& result) {
+                    if (on_success) on_success(parse_resource_contents(result));
+                }, std::move(on_error));
+                return *this;
+            }
+
+            /**
+             * @brief Queue a prompts/get request
+             */
+            Batch& get_prompt(
+                const std::string& prompt_name,
+                const std::map<std::string, std::string>& arguments,
+                std::function<void(const std::vector<PromptMessage>&)> on_success,
+                ErrorCallback on_error
+            ) {
+                add("prompts/get", prompt_params(prompt_name, arguments), [on_success](const json& result) {
+                    if (on_success) on_success(parse_prompt_messages(result));
+                }, std::move(on_error));
+                return *this;
+            }
+
+            size_t size() const { return calls_.size(); }
+            bool empty() const { return calls_.empty(); }
+
+            /**
+             * @brief Send every queued call as one message; the batch is empty afterwards
+             * @param timeout Deadline for each call; zero uses set_request_timeout()
+             */
+            void send(std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()) {
+                auto calls = std::move(calls_);
+                auto errors = std::move(errors_);
+                calls_.clear();
+                errors_.clear();
+                if (!client_.initialized_) {
+                    for (auto& on_error : errors) {
+                        if (on_error) on_error("Client not initialized");
+                    }
+                    return;
+                }
+                client_.endpoint_->send_batch(std::move(calls), timeout);
+            }
+
+        private:
+            void add(const char* method, json params, jsonrpc::endpoint::result_cb on_result, ErrorCallback on_error) {
+                errors_.push_back(on_error);
+                calls_.push_back(jsonrpc::endpoint::outgoing_call{
+                    method,
+                    std::move(params),
+                    std::move(on_result),
+                    [on_error](const json& error) {
+                        if (on_error) {
+                            std::string msg = error.value("message", "Unknown error");
+                            on_error(msg);
+                        }
+                    }
+                });
+            }
+
+            Client& client_;
+            std::vector<jsonrpc::endpoint::outgoing_call> calls_;
+            std::vector<ErrorCallback> errors_;
+        };
+
+        /**
+         * @brief Start a batch of calls to send in one round trip
+         */
+        Batch batch() {
+            return Batch(*this);
+        }
+
         /**
          * @brief Get server info (available after initialization)
          */
@@ -402,11 +646,289 @@ namespace pooriayousefi::mcp
         }
 
     private:
+        // A list as last fetched; generation moves on every invalidation, so a fetch
+        // that was in flight when the list changed is delivered but not kept
+        template<typename T>
+        struct ListCache {
+            std::shared_ptr<const std::vector<T>> items;
+            uint64_t generation = 0;
+        };
+
+        struct NameHash {
+            using is_transparent = void;
+            size_t operator()(std::string_view name) const noexcept { return std::hash<std::string_view>{}(name); }
+        };
+
+        // A list is only worth keeping when the server will say that it changed
+        bool caches_list(const char* field) const {
+            if (!list_cache_enabled_) return false;
+            auto capability = server_info_.capabilities.find(field);
+            return capability != server_info_.capabilities.end() && capability->is_object() &&
+                capability->value("listChanged", false);
+        }
+
+        template<typename T>
+        void forget_list(ListCache<T>& cache) {
+            std::lock_guard<std::mutex> lock(cache_mutex_);
+            cache.items.reset();
+            ++cache.generation;
+            if constexpr (std::is_same_v<T, Tool>) tool_index_.clear();
+        }
+
+        // Serve a list from its cache, or fetch every page and keep the result
+        template<typename T>
+        void list_cached(
+            ListCache<T>& cache,
+            const char* method,
+            const char* field,
+            std::function<void(const std::vector<T>&)> on_success,
+            ErrorCallback on_error
+        ) {
+            if (!caches_list(field)) {
+                list_pages<T>(method, field, json::object(), nullptr, std::move(on_success), std::move(on_error));
+                return;
+            }
+
+            std::shared_ptr<const std::vector<T>> items;
+            uint64_t generation;
+            {
+                std::lock_guard<std::mutex> lock(cache_mutex_);
+                items = cache.items;
+                generation = cache.generation;
+            }
+            if (items) {
+                if (on_success) on_success(*items);
+                return;
+            }
+
+            list_pages<T>(method, field, json::object(), nullptr,
+                [this, &cache, generation, on_success](const std::vector<T>& fetched) {
+                    auto items = std::make_shared<const std::vector<T>>(fetched);
+                    {
+                        std::lock_guard<std::mutex> lock(cache_mutex_);
+                        if (cache.generation == generation) {
+                            cache.items = items;
+                            if constexpr (std::is_same_v<T, Tool>) {
+                                tool_index_.clear();
+                                for (size_t i = 0; i < items->size(); ++i) {
+                                    tool_index_.emplace((*items)[i].name, i);
+                                }
+                            }
+                        }
+                    }
+                    if (on_success) on_success(*items);
+                },
+                std::move(on_error));
+        }
+
+        // Request one page of a list method and keep following nextCursor;
+        // on_success sees the items of every page once the last one arrives
+        template<typename T>
+        void list_pages(
+            const char* method,
+            const char* field,
+            json params,
+            std::shared_ptr<std::vector<T>> items,
+            std::function<void(const std::vector<T>&)> on_success,
+            ErrorCallback on_error
+        ) {
+            if (!items) {
+                items = std::make_shared<std::vector<T>>();
+            }
+            std::string cursor = params.value("cursor", "");
+
+            endpoint_->send_request(
+                method,
+                params,
+                [this, method, field, cursor, items, on_success, on_error](const json& result) {
+                    if (result.contains(field) && result[field].is_array()) {
+                        for (const auto& item_json : result[field]) {
+                            items->push_back(T::from_json(item_json));
+                        }
+                    }
+                    // A repeated cursor would loop forever; treat it as the last page
+                    if (result.contains("nextCursor") && result["nextCursor"].is_string()) {
+                        std::string next = result["nextCursor"].get<std::string>();
+                        if (!next.empty() && next != cursor) {
+                            list_pages<T>(method, field, json{{"cursor", next}}, items, on_success, on_error);
+                            return;
+                        }
+                    }
+                    if (on_success) on_success(*items);
+                },
+                [on_error](const json& error) {
+                    if (on_error) {
+                        std::string msg = error.value("message", "Unknown error");
+                        on_error(msg);
+                    }
+                }
+            );
+        }
+
+        // Chunks handed from the transport thread to a stream_tool() consumer
+        template<typename T>
+        struct ChunkBuffer {
+            std::mutex mutex;
+            std::condition_variable ready;
+            std::deque<T> chunks;
+            bool finished = false;
+            std::string error;
+
+            void push(const T& chunk) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    chunks.push_back(chunk);
+                }
+                ready.notify_one();
+            }
+
+            void finish(const std::string& failure) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    finished = true;
+                    error = failure;
+                }
+                ready.notify_one();
+            }
+        };
+
+        // Send a request with a partialResultToken; on_partial sees every partial
+        // result and then the final result, before on_complete runs
+        void send_streaming(
+            const std::string& method,
+            json params,
+            std::function<void(const json&)> on_partial,
+            std::function<void()> on_complete,
+            ErrorCallback on_error,
+            std::chrono::milliseconds timeout
+        ) {
+            auto* endpoint = endpoint_.get();
+            std::string token = endpoint->create_progress_token();
+            params["partialResultToken"] = token;
+            endpoint->on_progress(token, on_partial);
+
+            endpoint->send_request(
+                method,
+                params,
+                [endpoint, token, on_partial, on_complete](const json& result) {
+                    endpoint->remove_progress_handler(token);
+                    on_partial(result);
+                    if (on_complete) on_complete();
+                },
+                [endpoint, token, on_error](const json& error) {
+                    endpoint->remove_progress_handler(token);
+                    if (on_error) {
+                        std::string msg = error.value("message", "Unknown error");
+                        on_error(msg);
+                    }
+                },
+                timeout
+            );
+        }
+
+        static json prompt_params(
+            const std::string& prompt_name,
+            const std::map<std::string, std::string>& arguments
+        ) {
+            json args = json::object();
+            for (const auto& [key, value] : arguments) {
+                args[key] = value;
+            }
+
+            return json{
+                {"name", prompt_name},
+                {"arguments", args}
+            };
+        }
+
+        static std::vector<ToolResultContent> parse_tool_result(const json& result) {
+            std::vector<ToolResultContent> contents;
+            if (result.contains("content") && result["content"].is_array()) {
+                for (const auto& content_json : result["content"]) {
+                    ToolResultContent content;
+                    content.type = content_json.value("type", "text");
+                    if (content_json.contains("text")) {
+                        content.text = content_json["text"].get<std::string>();
+                    }
+                    if (content_json.contains("data")) {
+                        content.data = content_json["data"].get<std::string>();
+                    }
+                    if (content_json.contains("mimeType")) {
+                        content.mime_type = content_json["mimeType"].get<std::string>();
+                    }
+                    contents.push_back(content);
+                }
+            }
+            return contents;
+        }
+
+        static std::vector<PromptMessage> parse_prompt_messages(const json& result) {
+            std::vector<PromptMessage> messages;
+            if (result.contains("messages") && result["messages"].is_array()) {
+                for (const auto& msg_json : result["messages"]) {
+                    PromptMessage msg;
+                    std::string role_str = msg_json.value("role", "user");
+                    msg.role = (role_str == "assistant") ? MessageRole::Assistant : MessageRole::User;
+                    
+                    // A single content object per the spec; Server sends an array of them
+                    auto add_content = [&msg](const json& content_json) {
+                        MessageContent content;
+                        content.type = content_json.value("type", "text");
+                        if (content_json.contains("text")) {
+                            content.text = content_json["text"].get<std::string>();
+                        }
+                        msg.content.push_back(content);
+                    };
+                    if (msg_json.contains("content") && msg_json["content"].is_object()) {
+                        add_content(msg_json["content"]);
+                    } else if (msg_json.contains("content") && msg_json["content"].is_array()) {
+                        for (const auto& content_json : msg_json["content"]) {
+                            if (content_json.is_object()) add_content(content_json);
+                        }
+                    }
+                    messages.push_back(msg);
+                }
+            }
+            return messages;
+        }
+
+        static std::vector<ResourceContent> parse_resource_contents(const json& result) {
+            std::vector<ResourceContent> contents;
+            if (result.contains("contents") && result["contents"].is_array()) {
+                for (const auto& content_json : result["contents"]) {
+                    ResourceContent content;
+                    content.uri = content_json.value("uri", "");
+                    if (content_json.contains("mimeType")) {
+                        content.mime_type = content_json["mimeType"].get<std::string>();
+                    }
+                    if (content_json.contains("text")) {
+                        content.text = content_json["text"].get<std::string>();
+                    }
+                    if (content_json.contains("blob")) {
+                        const auto& blob = content_json["blob"];
+                        if (blob.is_binary()) {
+                            content.bytes = std::string(blob.get_binary().begin(), blob.get_binary().end());
+                        } else {
+                            content.blob = blob.get<std::string>();
+                        }
+                    }
+                    contents.push_back(content);
+                }
+            }
+            return contents;
+        }
+
         std::shared_ptr<transport::Transport> transport_;
         std::unique_ptr<jsonrpc::endpoint> endpoint_;
         ServerInfo server_info_;
         bool initialized_;
         ErrorCallback error_callback_;
+        bool list_cache_enabled_ = true;
+        ListCache<Tool> tools_cache_;
+        ListCache<Prompt> prompts_cache_;
+        ListCache<Resource> resources_cache_;
+        std::unordered_map<std::string, size_t, NameHash, std::equal_to<>> tool_index_; // name -> position in tools_cache_
+        mutable std::mutex cache_mutex_;
     };
 
 } // namespace pooriayousefi::mcp
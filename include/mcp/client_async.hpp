@@ -2,8 +2,11 @@
 
 #include "client.hpp"
 #include "core/asyncops.hpp"
-#include <future>
 #include <memory>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <optional>
 
 /**
  * @file client_async.hpp
@@ -11,6 +14,8 @@
  * 
  * Provides non-blocking, coroutine-based client operations using
  * the Task<T> from asyncops.hpp for clean async/await syntax.
+ * A pending call suspends its coroutine; the response callback resumes it,
+ * so one thread can keep any number of calls outstanding.
  */
 
 namespace pooriayousefi::mcp 
@@ -39,6 +44,20 @@ namespace pooriayousefi::mcp
          */
         explicit AsyncClient(Client& client) : client_(client) {}
 
+        /**
+         * @brief Choose where coroutines resume once their response arrives
+         * @param executor Executor to resume on (e.g. a core::ThreadPool), or nullptr
+         *
+         * By default a coroutine resumes inline on the thread that delivered the
+         * response (the transport thread). Set an executor when the continuation
+         * does heavy work that should not hold up message processing.
+         */
+        void set_executor(std::shared_ptr<core::Executor> executor) {
+            executor_ = std::move(executor);
+        }
+
+        std::shared_ptr<core::Executor> executor() const { return executor_; }
+
         /**
          * @brief Async initialize connection with server
          * @param client_info Client implementation info
@@ -50,23 +69,22 @@ namespace pooriayousefi::mcp
             const Implementation& client_info,
             const ClientCapabilities& capabilities
         ) {
-            auto promise = std::make_shared<std::promise<ServerInfo>>();
-            auto future = promise->get_future();
+            core::Completion<ServerInfo> done(executor_);
 
             client_.initialize(
                 client_info,
                 capabilities,
-                [promise](const ServerInfo& info) {
-                    promise->set_value(info);
+                [done](const ServerInfo& info) mutable {
+                    done.set_value(info);
                 },
-                [promise](const std::string& error) {
-                    promise->set_exception(std::make_exception_ptr(
+                [done](const std::string& error) mutable {
+                    done.set_exception(std::make_exception_ptr(
                         std::runtime_error(error)
                     ));
                 }
             );
 
-            co_return future.get();
+            co_return co_await done;
         }
 
         /**
@@ -75,51 +93,167 @@ namespace pooriayousefi::mcp
          * @throws std::runtime_error on error
          */
         Task<std::vector<Tool>> list_tools_async() {
-            auto promise = std::make_shared<std::promise<std::vector<Tool>>>();
-            auto future = promise->get_future();
+            core::Completion<std::vector<Tool>> done(executor_);
 
             client_.list_tools(
-                [promise](const std::vector<Tool>& tools) {
-                    promise->set_value(tools);
+                [done](const std::vector<Tool>& tools) mutable {
+                    done.set_value(tools);
                 },
-                [promise](const std::string& error) {
-                    promise->set_exception(std::make_exception_ptr(
+                [done](const std::string& error) mutable {
+                    done.set_exception(std::make_exception_ptr(
                         std::runtime_error(error)
                     ));
                 }
             );
 
-            co_return future.get();
+            co_return co_await done;
         }
 
         /**
          * @brief Async call a tool on the server
          * @param tool_name Name of the tool to call
          * @param arguments Tool arguments as JSON
+         * @param timeout Deadline for this call; zero uses Client::set_request_timeout()
          * @return Task that resolves to tool result contents
-         * @throws std::runtime_error on error
+         * @throws std::runtime_error on error (including "Request timed out")
          */
         Task<std::vector<ToolResultContent>> call_tool_async(
             const std::string& tool_name,
-            const json& arguments
+            const json& arguments,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
         ) {
-            auto promise = std::make_shared<std::promise<std::vector<ToolResultContent>>>();
-            auto future = promise->get_future();
+            core::Completion<std::vector<ToolResultContent>> done(executor_);
 
             client_.call_tool(
                 tool_name,
                 arguments,
-                [promise](const std::vector<ToolResultContent>& result) {
-                    promise->set_value(result);
+                [done](const std::vector<ToolResultContent>& result) mutable {
+                    done.set_value(result);
                 },
-                [promise](const std::string& error) {
-                    promise->set_exception(std::make_exception_ptr(
+                [done](const std::string& error) mutable {
+                    done.set_exception(std::make_exception_ptr(
                         std::runtime_error(error)
                     ));
-                }
+                },
+                timeout
             );
 
-            co_return future.get();
+            co_return co_await done;
+        }
+
+        /**
+         * @brief Chunks of a streaming tool call, awaited one at a time
+         *
+         * `co_await next()` resolves to the next chunk as soon as the server
+         * sends it, or to std::nullopt once the call has completed; it throws
+         * std::runtime_error if the call failed. One coroutine consumes a stream.
+         */
+        class ToolStream {
+            struct State {
+                std::mutex mutex;
+                std::deque<ToolResultContent> chunks;
+                bool finished = false;
+                std::string error;
+                std::coroutine_handle<> waiter;
+                std::shared_ptr<core::Executor> executor;
+            };
+
+        public:
+            explicit ToolStream(std::shared_ptr<core::Executor> executor)
+                : state_(std::make_shared<State>()) {
+                state_->executor = std::move(executor);
+            }
+
+            auto next() {
+                struct awaitable {
+                    std::shared_ptr<State> state;
+
+                    bool await_ready() {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        return !state->chunks.empty() || state->finished;
+                    }
+
+                    bool await_suspend(std::coroutine_handle<> h) {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if (!state->chunks.empty() || state->finished) return false;
+                        state->waiter = h;
+                        return true;
+                    }
+
+                    std::optional<ToolResultContent> await_resume() {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if (!state->chunks.empty()) {
+                            auto content = std::move(state->chunks.front());
+                            state->chunks.pop_front();
+                            return content;
+                        }
+                        if (!state->error.empty()) throw std::runtime_error(state->error);
+                        return std::nullopt;
+                    }
+                };
+                return awaitable{state_};
+            }
+
+        private:
+            friend class AsyncClient;
+
+            void push(const ToolResultContent& content) {
+                std::unique_lock<std::mutex> lock(state_->mutex);
+                state_->chunks.push_back(content);
+                wake(lock);
+            }
+
+            void finish(const std::string& error) {
+                std::unique_lock<std::mutex> lock(state_->mutex);
+                state_->finished = true;
+                state_->error = error;
+                wake(lock);
+            }
+
+            void wake(std::unique_lock<std::mutex>& lock) {
+                auto waiter = std::exchange(state_->waiter, nullptr);
+                auto executor = state_->executor;
+                lock.unlock();
+                if (!waiter) return;
+                if (executor) executor->schedule(waiter);
+                else waiter.resume();
+            }
+
+            std::shared_ptr<State> state_;
+        };
+
+        /**
+         * @brief Call a tool and consume its content as the server streams it
+         * @param tool_name Name of the tool to call
+         * @param arguments Tool arguments as JSON
+         * @param timeout Deadline for the whole call; zero uses Client::set_request_timeout()
+         * @return Stream to `co_await next()` on; the request is already sent
+         *
+         * @example
+         * ```cpp
+         * auto stream = async_client.stream_tool("search", {{"query", "mcp"}});
+         * while (auto chunk = co_await stream.next()) {
+         *     render(*chunk);
+         * }
+         * ```
+         */
+        ToolStream stream_tool(
+            const std::string& tool_name,
+            const json& arguments,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
+        ) {
+            ToolStream stream(executor_);
+            client_.call_tool_streaming(
+                tool_name,
+                arguments,
+                [stream](const ToolResultContent& content) mutable { stream.push(content); },
+                [stream]() mutable { stream.finish(""); },
+                [stream](const std::string& error) mutable {
+                    stream.finish(error.empty() ? "Unknown error" : error);
+                },
+                timeout
+            );
+            return stream;
         }
 
         /**
@@ -128,21 +262,20 @@ namespace pooriayousefi::mcp
          * @throws std::runtime_error on error
          */
         Task<std::vector<Prompt>> list_prompts_async() {
-            auto promise = std::make_shared<std::promise<std::vector<Prompt>>>();
-            auto future = promise->get_future();
+            core::Completion<std::vector<Prompt>> done(executor_);
 
             client_.list_prompts(
-                [promise](const std::vector<Prompt>& prompts) {
-                    promise->set_value(prompts);
+                [done](const std::vector<Prompt>& prompts) mutable {
+                    done.set_value(prompts);
                 },
-                [promise](const std::string& error) {
-                    promise->set_exception(std::make_exception_ptr(
+                [done](const std::string& error) mutable {
+                    done.set_exception(std::make_exception_ptr(
                         std::runtime_error(error)
                     ));
                 }
             );
 
-            co_return future.get();
+            co_return co_await done;
         }
 
         /**
@@ -156,23 +289,22 @@ namespace pooriayousefi::mcp
             const std::string& prompt_name,
             const std::map<std::string, std::string>& arguments
         ) {
-            auto promise = std::make_shared<std::promise<std::vector<PromptMessage>>>();
-            auto future = promise->get_future();
+            core::Completion<std::vector<PromptMessage>> done(executor_);
 
             client_.get_prompt(
                 prompt_name,
                 arguments,
-                [promise](const std::vector<PromptMessage>& messages) {
-                    promise->set_value(messages);
+                [done](const std::vector<PromptMessage>& messages) mutable {
+                    done.set_value(messages);
                 },
-                [promise](const std::string& error) {
-                    promise->set_exception(std::make_exception_ptr(
+                [done](const std::string& error) mutable {
+                    done.set_exception(std::make_exception_ptr(
                         std::runtime_error(error)
                     ));
                 }
             );
 
-            co_return future.get();
+            co_return co_await done;
         }
 
         /**
@@ -181,53 +313,59 @@ namespace pooriayousefi::mcp
          * @throws std::runtime_error on error
          */
         Task<std::vector<Resource>> list_resources_async() {
-            auto promise = std::make_shared<std::promise<std::vector<Resource>>>();
-            auto future = promise->get_future();
+            core::Completion<std::vector<Resource>> done(executor_);
 
             client_.list_resources(
-                [promise](const std::vector<Resource>& resources) {
-                    promise->set_value(resources);
+                [done](const std::vector<Resource>& resources) mutable {
+                    done.set_value(resources);
                 },
-                [promise](const std::string& error) {
-                    promise->set_exception(std::make_exception_ptr(
+                [done](const std::string& error) mutable {
+                    done.set_exception(std::make_exception_ptr(
                         std::runtime_error(error)
                     ));
                 }
             );
 
-            co_return future.get();
+            co_return co_await done;
         }
 
         /**
          * @brief Async read a resource from server
          * @param uri Resource URI
+         * @param timeout Deadline for this call; zero uses Client::set_request_timeout()
          * @return Task that resolves to resource contents
-         * @throws std::runtime_error on error
+         * @throws std::runtime_error on error (including "Request timed out")
          */
         Task<std::vector<ResourceContent>> read_resource_async(
-            const std::string& uri
+            const std::string& uri,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
         ) {
-            auto promise = std::make_shared<std::promise<std::vector<ResourceContent>>>();
-            auto future = promise->get_future();
+            core::Completion<std::vector<ResourceContent>> done(executor_);
 
             client_.read_resource(
                 uri,
-                [promise](const std::vector<ResourceContent>& contents) {
-                    promise->set_value(contents);
+                [done](const std::vector<ResourceContent>& contents) mutable {
+                    done.set_value(contents);
                 },
-                [promise](const std::string& error) {
-                    promise->set_exception(std::make_exception_ptr(
+                [done](const std::string& error) mutable {
+                    done.set_exception(std::make_exception_ptr(
                         std::runtime_error(error)
                     ));
-                }
+                },
+                timeout
             );
 
-            co_return future.get();
+            co_return co_await done;
         }
 
         /**
          * @brief Execute multiple tools in parallel
+         *
+         * All calls are sent as one JSON-RPC batch, so the whole set costs a
+         * single round trip.
+         *
          * @param tool_calls Vector of (tool_name, arguments) pairs
+         * @param timeout Deadline applied to each call; zero uses Client::set_request_timeout()
          * @return Task that resolves to vector of results
          * @throws std::runtime_error if any tool fails
          * 
@@ -241,41 +379,110 @@ namespace pooriayousefi::mcp
          * ```
          */
         Task<std::vector<std::vector<ToolResultContent>>> execute_parallel_async(
-            const std::vector<std::pair<std::string, json>>& tool_calls
+            const std::vector<std::pair<std::string, json>>& tool_calls,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
         ) {
-            std::vector<std::future<std::vector<ToolResultContent>>> futures;
-            futures.reserve(tool_calls.size());
-
-            // Launch all tool calls concurrently
+            // One batch message: a single round trip for every call
+            auto batch = this->batch();
+            std::vector<core::Completion<std::vector<ToolResultContent>>> pending;
+            pending.reserve(tool_calls.size());
             for (const auto& [tool_name, args] : tool_calls) {
-                auto promise = std::make_shared<std::promise<std::vector<ToolResultContent>>>();
-                futures.push_back(promise->get_future());
-
-                client_.call_tool(
-                    tool_name,
-                    args,
-                    [promise](const std::vector<ToolResultContent>& result) {
-                        promise->set_value(result);
-                    },
-                    [promise](const std::string& error) {
-                        promise->set_exception(std::make_exception_ptr(
-                            std::runtime_error(error)
-                        ));
-                    }
-                );
+                pending.push_back(batch.call_tool(tool_name, args));
             }
+            batch.send(timeout);
 
-            // Collect all results
+            // Collect in order; completions that already arrived do not suspend
             std::vector<std::vector<ToolResultContent>> results;
-            results.reserve(futures.size());
+            results.reserve(pending.size());
 
-            for (auto& future : futures) {
-                results.push_back(future.get());
+            for (auto& done : pending) {
+                results.push_back(co_await done);
             }
 
             co_return results;
         }
 
+        /**
+         * @brief Awaitable counterpart of Client::Batch
+         *
+         * Each queued call returns a Completion to co_await once send() has
+         * put the whole batch on the wire.
+         *
+         * @example
+         * ```cpp
+         * auto batch = async_client.batch();
+         * auto search = batch.call_tool("search", {{"query", "mcp"}});
+         * auto notes = batch.read_resource("file:///notes.txt");
+         * batch.send();
+         * auto hits = co_await search;
+         * auto text = co_await notes;
+         * ```
+         */
+        class Batch {
+        public:
+            Batch(Client::Batch batch, std::shared_ptr<core::Executor> executor)
+                : batch_(std::move(batch))
+                , executor_(std::move(executor)) {}
+
+            core::Completion<std::vector<ToolResultContent>> call_tool(
+                const std::string& tool_name,
+                const json& arguments
+            ) {
+                core::Completion<std::vector<ToolResultContent>> done(executor_);
+                batch_.call_tool(tool_name, arguments,
+                    [done](const std::vector<ToolResultContent>& result) mutable { done.set_value(result); },
+                    fail(done));
+                return done;
+            }
+
+            core::Completion<std::vector<ResourceContent>> read_resource(const std::string& uri) {
+                core::Completion<std::vector<ResourceContent>> done(executor_);
+                batch_.read_resource(uri,
+                    [done](const std::vector<ResourceContent>& contents) mutable { done.set_value(contents); },
+                    fail(done));
+                return done;
+            }
+
+            core::Completion<std::vector<PromptMessage>> get_prompt(
+                const std::string& prompt_name,
+                const std::map<std::string, std::string>& arguments
+            ) {
+                core::Completion<std::vector<PromptMessage>> done(executor_);
+                batch_.get_prompt(prompt_name, arguments,
+                    [done](const std::vector<PromptMessage>& messages) mutable { done.set_value(messages); },
+                    fail(done));
+                return done;
+            }
+
+            size_t size() const { return batch_.size(); }
+
+            /**
+             * @brief Send every queued call as one message
+             * @param timeout Deadline for each call; zero uses Client::set_request_timeout()
+             */
+            void send(std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()) {
+                batch_.send(timeout);
+            }
+
+        private:
+            template<typename T>
+            static Client::ErrorCallback fail(core::Completion<T> done) {
+                return [done](const std::string& error) mutable {
+                    done.set_exception(std::make_exception_ptr(std::runtime_error(error)));
+                };
+            }
+
+            Client::Batch batch_;
+            std::shared_ptr<core::Executor> executor_;
+        };
+
+        /**
+         * @brief Start a batch of calls to send in one round trip
+         */
+        Batch batch() {
+            return Batch(client_.batch(), executor_);
+        }
+
         /**
          * @brief Get underlying synchronous client
          */
@@ -284,6 +491,7 @@ namespace pooriayousefi::mcp
 
     private:
         Client& client_;
+        std::shared_ptr<core::Executor> executor_;
     };
 
     /**
@@ -11,7 +11,13 @@
 #include <utility>
 #include <semaphore>
 #include <memory>
+#include <atomic>
+#include <optional>
+#include <new>
+#include <cstdint>
+#include <cstddef>
 #include <cassert>
+#include "objectpool.hpp"
 
 /**********************************************************************************************
 *
@@ -20,10 +26,16 @@
 *    			This header provides utilities for asynchronous programming
 *    			using C++20 coroutines. It includes:
 *    			- A Generator class template for creating coroutine-based generators.
-*    			- A GeneratorFactory class template for managing pools of objects.
+*    			- A FramePool class: per-thread coroutine frame cache used by Generator
+*    			  and Task, so short-lived coroutines do not allocate once it is warm.
+*    			- A GeneratorFactory class template yielding shared objects from an ObjectPool.
 *    			- An awaitable Task class template for defining asynchronous tasks.
 *    			- A SyncWaitTask class template and sync_wait function for synchronously
 *    			  waiting on asynchronous tasks to complete.
+*    			- An Executor interface and schedule_on awaitable for choosing the
+*    			  thread a coroutine resumes on.
+*    			- A Completion class template: a one-shot awaitable that a callback
+*    			  completes, resuming the waiting coroutine without blocking a thread.
 *
 *                   			Developed by: Pooria Yousefi
 *				   				Date: 2025-06-26
@@ -34,18 +46,126 @@
 // namespace pooriayousefi::core
 namespace pooriayousefi::core
 {
+	// Per-thread cache of coroutine frames in power-of-two size classes (64 bytes to 4KB),
+	// so starting a coroutine does not go to malloc once the cache is warm. Larger frames use
+	// operator new directly; a frame freed on another thread joins that thread's cache.
+	class FramePool
+	{
+	public:
+		static inline void* allocate(size_t size)
+		{
+			const size_t index = size_class(size);
+			if (index < class_count && !t_retired)
+			{
+				Cache& cache = local();
+				if (Block* block = cache.heads[index])
+				{
+					cache.heads[index] = block->next;
+					--cache.counts[index];
+					return block;
+				}
+				return ::operator new(class_size(index));
+			}
+			return ::operator new(size);
+		}
+
+		static inline void deallocate(void* p, size_t size) noexcept
+		{
+			const size_t index = size_class(size);
+			if (index < class_count && !t_retired)
+			{
+				Cache& cache = local();
+				if (cache.counts[index] < max_cached)
+				{
+					cache.heads[index] = ::new (p) Block{ cache.heads[index] };
+					++cache.counts[index];
+					return;
+				}
+			}
+			::operator delete(p);
+		}
+
+	private:
+		struct Block { Block* next; };
+		static constexpr size_t min_shift = 6;
+		static constexpr size_t class_count = 7; // 64 .. 4096 bytes
+		static constexpr size_t max_cached = 64; // frames kept per class and thread
+
+		struct Cache
+		{
+			Block* heads[class_count]{};
+			size_t counts[class_count]{};
+			~Cache()
+			{
+				t_retired = true; // frames freed later in thread exit bypass the cache
+				for (Block* head : heads)
+				{
+					while (head) ::operator delete(std::exchange(head, head->next));
+				}
+			}
+		};
+
+		static inline Cache& local()
+		{
+			thread_local Cache cache;
+			return cache;
+		}
+
+		static constexpr size_t class_size(size_t index) { return size_t{ 1 } << (index + min_shift); }
+
+		static constexpr size_t size_class(size_t size)
+		{
+			size_t index = 0;
+			while (index < class_count && class_size(index) < size) ++index;
+			return index;
+		}
+
+		static inline thread_local bool t_retired = false;
+	};
+
     template<class T> 
 	struct Generator
 	{
+		// Yielded values are handed out by address, never copied: an lvalue or a temporary
+		// lives in the coroutine frame while it is suspended. Only const lvalues are copied,
+		// into storage that keeps its capacity from one element to the next.
 		struct Promise
 		{
-			T current_value;
+			// Declared so the promise is not an aggregate: the compiler must not try to build it from the coroutine's arguments
+			Promise() = default;
+			T* current{ nullptr };
+			std::optional<T> copied;
+			std::exception_ptr error;
+			static inline void* operator new(size_t size) { return FramePool::allocate(size); }
+			static inline void operator delete(void* p, size_t size) noexcept { FramePool::deallocate(p, size); }
 			inline decltype(auto) initial_suspend() { return std::suspend_always{}; }
 			inline decltype(auto) final_suspend() noexcept { return std::suspend_always{}; }
 			inline decltype(auto) get_return_object() { return Generator{ std::coroutine_handle<Promise>::from_promise(*this) }; }
 			inline decltype(auto) return_void() { return std::suspend_never{}; }
-			inline decltype(auto) yield_value(T&& value) noexcept { current_value = value; return std::suspend_always{}; }
-			inline void unhandled_exception() { std::terminate(); }
+			inline decltype(auto) yield_value(T& value) noexcept { current = std::addressof(value); return std::suspend_always{}; }
+			inline decltype(auto) yield_value(T&& value) noexcept { current = std::addressof(value); return std::suspend_always{}; }
+			inline decltype(auto) yield_value(const T& value)
+			{
+				if (copied) *copied = value;
+				else copied.emplace(value);
+				current = std::addressof(*copied);
+				return std::suspend_always{};
+			}
+			// Kept until the consumer resumes, then rethrown there (the generator is done by then)
+			inline void unhandled_exception() noexcept { error = std::current_exception(); }
+			inline void advance(std::coroutine_handle<Promise> h)
+			{
+				current = nullptr;
+				if (h.done()) return; // resuming a finished coroutine is undefined
+				h.resume();
+				if (error) std::rethrow_exception(std::exchange(error, nullptr));
+			}
+			// There is none before the first advance() and once the coroutine has finished
+			inline T& value() const
+			{
+				if (!current) throw std::out_of_range{ "Generator has no current value" };
+				return *current;
+			}
 		};
         using promise_type = Promise;
 		struct Sentinel {};
@@ -61,13 +181,13 @@ namespace pooriayousefi::core
 			explicit Iterator(std::coroutine_handle<promise_type>& h) :handle{ h } {}
 			inline Iterator& operator++()
 			{
-				handle.resume();
+				handle.promise().advance(handle);
 				return *this;
 			}
 			inline void operator++(int) { (void)operator++(); }
-			inline reference operator*() { return handle.promise().current_value; }
+			inline reference operator*() { return handle.promise().value(); }
 			inline pointer operator->() { return std::addressof(operator*()); }
-			inline const_reference operator*() const { return handle.promise().current_value; }
+			inline const_reference operator*() const { return handle.promise().value(); }
 			inline pointer operator->() const { return std::addressof(operator*()); }
 			inline bool operator==(Sentinel) { return handle.done(); }
 			inline bool operator==(Sentinel) const { return handle.done(); }
@@ -79,16 +199,18 @@ namespace pooriayousefi::core
 		Generator(Generator&& other) noexcept :handle(other.handle) { other.handle = nullptr; }
 		constexpr Generator& operator=(const Generator&) = delete;
 		constexpr Generator& operator=(Generator&& other) noexcept { handle = other.handle; other.handle = nullptr; return *this; }
-		inline T get_value() { return handle.promise().current_value; }
-		inline bool next() { handle.resume(); return !handle.done(); }
-		inline bool resume() { handle.resume(); return !handle.done(); }
+		// The element last yielded; valid until the generator is resumed. Throws
+		// std::out_of_range before the first next() and after next() returned false.
+		inline T& get_value() { return handle.promise().value(); }
+		inline bool next() { handle.promise().advance(handle); return !handle.done(); }
+		inline bool resume() { handle.promise().advance(handle); return !handle.done(); }
 		inline decltype(auto) begin()
 		{
-			handle.resume();
+			handle.promise().advance(handle);
 			return Iterator{ handle };
 		}
 		inline decltype(auto) end() { return Sentinel{}; }
-		inline T get_next_value()
+		inline T& get_next_value()
 		{
 			next();
 			if (handle.done()) throw std::out_of_range{ "Generator exhausted" };
@@ -96,46 +218,30 @@ namespace pooriayousefi::core
 		}
 	};
 
+	// Yields shared objects drawn from ObjectPool<T>; each goes back to the pool when its
+	// last shared_ptr is released (and N raises the pool's per-thread limit). New code can
+	// use ObjectPool<T>::acquire() directly and skip the shared_ptr control block.
     template<class T, size_t N = 128> 
 	class GeneratorFactory
 	{
 	public:
-        using Pool = std::vector<T>;
-        using Pools = std::forward_list<Pool>;
         static constexpr inline size_t number_of_objects_in_each_pool = N;
 
-		GeneratorFactory():m_pools{}, m_object_counter{ 0 }
+		GeneratorFactory()
 		{
-			m_pools.emplace_front(Pool(number_of_objects_in_each_pool, T{}));
+			if (ObjectPool<T>::limit() < N) ObjectPool<T>::set_limit(N);
 		}
 
-		virtual ~GeneratorFactory()
-		{
-			for (auto& pool : m_pools)
-			{
-				pool.clear();
-			}
-			m_pools.clear();
-		}
+		virtual ~GeneratorFactory() = default;
 
 		inline Generator<std::shared_ptr<T>> generate()
 		{
 			while (true)
 			{
-                if (m_object_counter < number_of_objects_in_each_pool)
-                {
-                    co_yield std::make_shared<T>(m_pools.begin()->data()[m_object_counter++]);
-                }
-                else
-                {
-                    m_pools.emplace_front(Pool(number_of_objects_in_each_pool, T{}));
-                    m_object_counter = 0;
-                }
+				std::shared_ptr<T> object(ObjectPool<T>::acquire().release(), typename ObjectPool<T>::Recycler{});
+				co_yield object;
 			}
 		}
-	private:
-		Pools m_pools;
-		size_t m_object_counter;
 	};
 
 	template<class T> 
@@ -145,6 +251,8 @@ namespace pooriayousefi::core
 		{
 			std::variant<std::monostate, T, std::exception_ptr> result;
 			std::coroutine_handle<> continuation;
+			static inline void* operator new(size_t size) { return FramePool::allocate(size); }
+			static inline void operator delete(void* p, size_t size) noexcept { FramePool::deallocate(p, size); }
 			constexpr decltype(auto) get_return_object() noexcept { return Task{ *this }; }
 			constexpr void return_value(T value) { result.template emplace<1>(std::move(value)); }
 			constexpr void unhandled_exception() noexcept { result.template emplace<2>(std::current_exception()); }
@@ -152,9 +260,10 @@ namespace pooriayousefi::core
 			struct awaitable
 			{
 				constexpr bool await_ready() noexcept { return false; }
-				constexpr decltype(auto) await_suspend(std::coroutine_handle<promise_type> h) noexcept
+				inline std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
 				{
-					return h.promise().continuation;
+					if (auto c = h.promise().continuation) return c;
+					return std::noop_coroutine();
 				}
 				constexpr void await_resume() noexcept {}
 			};
@@ -162,7 +271,7 @@ namespace pooriayousefi::core
 		};
 		std::coroutine_handle<promise_type> handle;
 		explicit Task(promise_type& p) noexcept :handle{ std::coroutine_handle<promise_type>::from_promise(p) } {}
-		Task(Task&& t) noexcept :handle{ t.handle } {}
+		Task(Task&& t) noexcept :handle{ std::exchange(t.handle, nullptr) } {}
 		~Task() { if (handle) handle.destroy(); }
 		constexpr bool await_ready() { return false; }
 		constexpr decltype(auto) await_suspend(std::coroutine_handle<> c)
@@ -186,6 +295,8 @@ namespace pooriayousefi::core
 		{
 			std::exception_ptr e;
 			std::coroutine_handle<> continuation;
+			static inline void* operator new(size_t size) { return FramePool::allocate(size); }
+			static inline void operator delete(void* p, size_t size) noexcept { FramePool::deallocate(p, size); }
 			inline decltype(auto) get_return_object() noexcept { return Task{ *this }; }
 			constexpr void return_void() {}
 			inline void unhandled_exception() noexcept { e = std::current_exception(); }
@@ -193,9 +304,10 @@ namespace pooriayousefi::core
 			struct awaitable
 			{
 				constexpr bool await_ready() noexcept { return false; }
-				inline decltype(auto) await_suspend(std::coroutine_handle<promise_type> h) noexcept
+				inline std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
 				{
-					return h.promise().continuation;
+					if (auto c = h.promise().continuation) return c;
+					return std::noop_coroutine();
 				}
 				constexpr void await_resume() noexcept {}
 			};
@@ -203,7 +315,7 @@ namespace pooriayousefi::core
 		};
 		std::coroutine_handle<promise_type> handle;
 		explicit Task(promise_type& p) noexcept :handle{ std::coroutine_handle<promise_type>::from_promise(p) } {}
-		Task(Task&& t) noexcept :handle{ t.handle } {}
+		Task(Task&& t) noexcept :handle{ std::exchange(t.handle, nullptr) } {}
 		~Task() { if (handle) handle.destroy(); }
 		constexpr bool await_ready() { return false; }
 		inline decltype(auto) await_suspend(std::coroutine_handle<> c)
@@ -218,6 +330,108 @@ namespace pooriayousefi::core
 		}
 	};
 
+	// Where a suspended coroutine gets resumed. Implementations must resume every handle exactly once.
+	class Executor
+	{
+	public:
+		virtual ~Executor() = default;
+		virtual void schedule(std::coroutine_handle<> handle) = 0;
+	};
+
+	// co_await schedule_on(executor) to continue the current coroutine on the executor's thread(s).
+	inline decltype(auto) schedule_on(Executor& executor)
+	{
+		struct awaitable
+		{
+			Executor& executor;
+			constexpr bool await_ready() noexcept { return false; }
+			inline void await_suspend(std::coroutine_handle<> h) { executor.schedule(h); }
+			constexpr void await_resume() noexcept {}
+		};
+		return awaitable{ executor };
+	}
+
+	// One-shot result slot shared between a producer callback and one awaiting coroutine.
+	// Whichever side arrives second resumes the coroutine: inline on the completing thread,
+	// or through the executor when one was given. No thread blocks while the result is pending.
+	template<class T>
+	class Completion
+	{
+		static constexpr uintptr_t empty = 0;
+		static constexpr uintptr_t ready = 1;
+
+		struct State
+		{
+			std::atomic<uintptr_t> waiter{ empty };
+			std::atomic<bool> claimed{ false };
+			std::variant<std::monostate, T, std::exception_ptr> result;
+			std::shared_ptr<Executor> executor;
+		};
+
+	public:
+		explicit Completion(std::shared_ptr<Executor> executor = nullptr) :m_state{ std::make_shared<State>() }
+		{
+			m_state->executor = std::move(executor);
+		}
+
+		// Only the first set_value/set_exception takes effect; later calls are ignored.
+		inline bool set_value(T value)
+		{
+			if (m_state->claimed.exchange(true, std::memory_order_acq_rel)) return false;
+			m_state->result.template emplace<1>(std::move(value));
+			complete();
+			return true;
+		}
+
+		inline bool set_exception(std::exception_ptr e)
+		{
+			if (m_state->claimed.exchange(true, std::memory_order_acq_rel)) return false;
+			m_state->result.template emplace<2>(std::move(e));
+			complete();
+			return true;
+		}
+
+		inline bool is_ready() const { return m_state->waiter.load(std::memory_order_acquire) == ready; }
+
+		inline decltype(auto) operator co_await() const noexcept
+		{
+			struct awaitable
+			{
+				std::shared_ptr<State> state;
+				inline bool await_ready() const noexcept { return state->waiter.load(std::memory_order_acquire) == ready; }
+				inline bool await_suspend(std::coroutine_handle<> h) noexcept
+				{
+					auto expected = empty;
+					// Fails only if the producer completed in the meantime: continue without suspending.
+					return state->waiter.compare_exchange_strong(expected, reinterpret_cast<uintptr_t>(h.address()),
+						std::memory_order_acq_rel, std::memory_order_acquire);
+				}
+				inline T await_resume()
+				{
+					auto& result = state->result;
+					if (result.index() == 2)
+						std::rethrow_exception(std::get<2>(result));
+					return std::get<1>(std::move(result));
+				}
+			};
+			return awaitable{ m_state };
+		}
+
+	private:
+		inline void complete()
+		{
+			auto previous = m_state->waiter.exchange(ready, std::memory_order_acq_rel);
+			if (previous == empty) return;
+			auto h = std::coroutine_handle<>::from_address(reinterpret_cast<void*>(previous));
+			if (m_state->executor)
+				m_state->executor->schedule(h);
+			else
+				h.resume();
+		}
+
+		std::shared_ptr<State> m_state;
+	};
+
 	template<class T> using ResultType = decltype(std::declval<T&>().await_resume());
 
 	template<class T> 
@@ -247,7 +461,7 @@ namespace pooriayousefi::core
 		};
 		std::coroutine_handle<promise_type> handle;
 		explicit SyncWaitTask(promise_type& p) noexcept :handle{ std::coroutine_handle<promise_type>::from_promise(p) } {}
-		SyncWaitTask(SyncWaitTask&& t) noexcept :handle{ t.handle } {}
+		SyncWaitTask(SyncWaitTask&& t) noexcept :handle{ std::exchange(t.handle, nullptr) } {}
 		~SyncWaitTask() { if (handle) handle.destroy(); }
 		inline T&& get()
 		{
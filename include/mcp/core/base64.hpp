@@ -0,0 +1,91 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <optional>
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+/**********************************************************************************************
+*
+*                   			Base64
+*                   			-----------------------
+*    			This header provides RFC 4648 base64 encoding and decoding. It includes:
+*    			- base64_encode(): appends the padded encoding of bytes to a string
+*    			  or byte buffer.
+*    			- base64_decode(): strict decoding (padding required, no whitespace);
+*    			  nullopt on malformed input.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	template<class Out> inline void base64_encode(std::string_view bytes, Out& out)
+	{
+		static constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		// Grown geometrically, so appending piece by piece stays linear
+		if (const size_t need = out.size() + (bytes.size() + 2) / 3 * 4; need > out.capacity())
+			out.reserve(std::max(need, out.capacity() * 2));
+		size_t i = 0;
+		for (; i + 3 <= bytes.size(); i += 3)
+		{
+			const uint32_t v = (uint32_t(uint8_t(bytes[i])) << 16) | (uint32_t(uint8_t(bytes[i + 1])) << 8) | uint8_t(bytes[i + 2]);
+			out.push_back(alphabet[(v >> 18) & 63]);
+			out.push_back(alphabet[(v >> 12) & 63]);
+			out.push_back(alphabet[(v >> 6) & 63]);
+			out.push_back(alphabet[v & 63]);
+		}
+		if (const size_t rest = bytes.size() - i; rest > 0)
+		{
+			uint32_t v = uint32_t(uint8_t(bytes[i])) << 16;
+			if (rest == 2) v |= uint32_t(uint8_t(bytes[i + 1])) << 8;
+			out.push_back(alphabet[(v >> 18) & 63]);
+			out.push_back(alphabet[(v >> 12) & 63]);
+			out.push_back(rest == 2 ? alphabet[(v >> 6) & 63] : '=');
+			out.push_back('=');
+		}
+	}
+
+	inline std::string base64_encode(std::string_view bytes)
+	{
+		std::string out;
+		base64_encode(bytes, out);
+		return out;
+	}
+
+	inline std::optional<std::string> base64_decode(std::string_view text)
+	{
+		static constexpr auto table = []
+		{
+			std::array<int8_t, 256> t{};
+			t.fill(-1);
+			constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			for (size_t i = 0; i < alphabet.size(); ++i) t[uint8_t(alphabet[i])] = int8_t(i);
+			return t;
+		}();
+		if (text.size() % 4 != 0) return std::nullopt;
+		std::string out;
+		out.reserve(text.size() / 4 * 3);
+		for (size_t i = 0; i < text.size(); i += 4)
+		{
+			const bool last = i + 4 == text.size();
+			const size_t padding = last ? (text[i + 3] == '=') + (text[i + 2] == '=') : 0;
+			if (padding == 1 && text[i + 2] == '=') return std::nullopt;
+			uint32_t v = 0;
+			for (size_t j = 0; j < 4 - padding; ++j)
+			{
+				const int8_t d = table[uint8_t(text[i + j])];
+				if (d < 0) return std::nullopt;
+				v |= uint32_t(d) << (18 - 6 * j);
+			}
+			out.push_back(char((v >> 16) & 0xff));
+			if (padding < 2) out.push_back(char((v >> 8) & 0xff));
+			if (padding < 1) out.push_back(char(v & 0xff));
+		}
+		return out;
+	}
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <algorithm>
+#include <cstddef>
+#if defined(POORIAYOUSEFI_USE_ZLIB) && __has_include(<zlib.h>)
+#include <zlib.h>
+#define POORIAYOUSEFI_CORE_HAS_ZLIB 1
+#endif
+
+/**********************************************************************************************
+*
+*                   			Deflate Streams
+*                   			-----------------------
+*    			This header provides incremental DEFLATE compression on top of zlib.
+*    			It includes:
+*    			- A Deflater class: appends compressed output to a string, with sync
+*    			  flushes so a stream can be decoded message by message while its
+*    			  dictionary carries over (WebSocket permessage-deflate, SSE streams).
+*    			- An Inflater class: the reverse, with a limit on the output size.
+*    			- Raw, zlib and gzip framing.
+*    			zlib is optional: define POORIAYOUSEFI_USE_ZLIB and link with -lz.
+*    			POORIAYOUSEFI_CORE_HAS_ZLIB tells whether the classes are available.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+	enum class DeflateFormat
+	{
+		raw,  // no header or trailer (permessage-deflate)
+		zlib, // RFC 1950 ("deflate" content coding)
+		gzip  // RFC 1952
+	};
+
+	enum class DeflateFlush
+	{
+		none,  // buffer as much as zlib likes
+		sync,  // emit everything so far, ending on a byte boundary; the stream continues
+		finish // end the stream; reset() before reusing the object
+	};
+
+	namespace detail
+	{
+		inline int zlib_window_bits(DeflateFormat format, int window_bits)
+		{
+			switch (format)
+			{
+			case DeflateFormat::raw: return -window_bits;
+			case DeflateFormat::gzip: return window_bits + 16;
+			default: return window_bits;
+			}
+		}
+	}
+
+	class Deflater
+	{
+	public:
+		explicit Deflater(DeflateFormat format = DeflateFormat::raw, int level = Z_DEFAULT_COMPRESSION, int window_bits = 15)
+			:m_stream{}
+		{
+			if (deflateInit2(&m_stream, level, Z_DEFLATED, detail::zlib_window_bits(format, window_bits), 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				throw std::runtime_error("Deflater: deflateInit2 failed");
+		}
+
+		Deflater(const Deflater&) = delete;
+		Deflater& operator=(const Deflater&) = delete;
+
+		~Deflater() { deflateEnd(&m_stream); }
+
+		// Appends the compressed form of input to out
+		inline void compress(std::string_view input, std::string& out, DeflateFlush flush = DeflateFlush::sync)
+		{
+			const int mode = flush == DeflateFlush::finish ? Z_FINISH : flush == DeflateFlush::sync ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+			m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+			m_stream.avail_in = static_cast<uInt>(input.size());
+			while (true)
+			{
+				const size_t used = out.size();
+				const size_t room = std::max<size_t>(deflateBound(&m_stream, m_stream.avail_in), 256);
+				out.resize(used + room);
+				m_stream.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+				m_stream.avail_out = static_cast<uInt>(room);
+				const int status = deflate(&m_stream, mode);
+				out.resize(used + room - m_stream.avail_out);
+				if (status == Z_STREAM_ERROR) throw std::runtime_error("Deflater: stream error");
+				if (status == Z_STREAM_END) return;
+				// Done once all input is taken and zlib had room left over for the flush
+				if (m_stream.avail_in == 0 && m_stream.avail_out > 0 && mode != Z_FINISH) return;
+			}
+		}
+
+		// Starts a new stream with an empty dictionary
+		inline void reset() { deflateReset(&m_stream); }
+
+	private:
+		z_stream m_stream;
+	};
+
+	class Inflater
+	{
+	public:
+		explicit Inflater(DeflateFormat format = DeflateFormat::raw, int window_bits = 15)
+			:m_stream{}, m_finished{ false }
+		{
+			if (inflateInit2(&m_stream, detail::zlib_window_bits(format, window_bits)) != Z_OK)
+				throw std::runtime_error("Inflater: inflateInit2 failed");
+		}
+
+		Inflater(const Inflater&) = delete;
+		Inflater& operator=(const Inflater&) = delete;
+
+		~Inflater() { inflateEnd(&m_stream); }
+
+		// Appends the decompressed form of input to out; throws on corrupt data or when the
+		// output of this call would exceed limit bytes
+		inline void decompress(std::string_view input, std::string& out, size_t limit = static_cast<size_t>(-1))
+		{
+			m_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+			m_stream.avail_in = static_cast<uInt>(input.size());
+			const size_t start = out.size();
+			if (m_finished) return;
+			do
+			{
+				const size_t used = out.size();
+				const size_t room = std::clamp<size_t>(input.size() * 4, 16384, 256 * 1024);
+				out.resize(used + room);
+				m_stream.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+				m_stream.avail_out = static_cast<uInt>(room);
+				const int status = inflate(&m_stream, Z_SYNC_FLUSH);
+				out.resize(used + room - m_stream.avail_out);
+				if (status == Z_STREAM_END) m_finished = true;
+				else if (status == Z_BUF_ERROR) break; // needs more input
+				else if (status != Z_OK) throw std::runtime_error("Inflater: corrupt data");
+				if (out.size() - start > limit) throw std::length_error("Inflater: output exceeds limit");
+			} while (!m_finished && (m_stream.avail_in > 0 || m_stream.avail_out == 0)); // a full buffer may leave output pending
+		}
+
+		// True once the end of the stream was decoded
+		inline bool finished() const { return m_finished; }
+
+		inline void reset()
+		{
+			inflateReset(&m_stream);
+			m_finished = false;
+		}
+
+	private:
+		z_stream m_stream;
+		bool m_finished;
+	};
+#endif
+}
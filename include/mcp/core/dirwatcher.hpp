@@ -0,0 +1,361 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <system_error>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#if __has_include(<sys/inotify.h>)
+#include <sys/inotify.h>
+#define POORIAYOUSEFI_CORE_HAS_INOTIFY 1
+#endif
+
+/**********************************************************************************************
+*
+*                   			Directory Watcher
+*                   			-----------------------
+*    			This header provides a recursive directory watcher that reports
+*    			file changes as deltas. It includes:
+*    			- A DirectoryWatcher class: one background thread, fed by inotify where
+*    			  available, falling back to periodic polling (no inotify, or the watch
+*    			  limit is exhausted) or on request.
+*    			- Events are debounced: a burst of changes is delivered as one batch
+*    			  once it has been quiet for a while, or after a maximum delay.
+*    			- Renames arrive as removed + added; a lost-event overflow arrives as a
+*    			  single rescan event, after which the caller should rebuild its view.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	struct DirectoryWatcherOptions
+	{
+		std::chrono::milliseconds debounce{ 100 };       // deliver once events have been quiet this long
+		std::chrono::milliseconds max_delay{ 1000 };     // ...or at the latest this long after the first one
+		std::chrono::milliseconds poll_interval{ 1000 }; // period of the polling fallback
+		bool force_polling{ false };
+	};
+
+	class DirectoryWatcher
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+
+		enum class Change { added, removed, modified, rescan };
+
+		struct Event
+		{
+			Change change;
+			std::filesystem::path path; // relative to the root; empty for rescan
+			bool directory;
+		};
+
+		using callback_type = std::function<void(std::vector<Event>&&)>;
+
+		// Callbacks run on the watcher thread, one batch at a time. A callback may stop, or
+		// destroy, its own watcher; the thread then returns without touching it again.
+		DirectoryWatcher(std::filesystem::path root, callback_type callback, DirectoryWatcherOptions options = {})
+			:m_root{ std::move(root) }, m_options{ options }, m_control{ std::make_shared<Control>() },
+			m_dirs{}, m_seen{}, m_thread{}
+		{
+			m_control->callback = std::move(callback);
+			if (::pipe2(m_control->wake, O_CLOEXEC | O_NONBLOCK) != 0)
+				throw std::system_error(errno, std::generic_category(), "ERROR! pipe2 failed in DirectoryWatcher");
+#ifdef POORIAYOUSEFI_CORE_HAS_INOTIFY
+			if (!m_options.force_polling)
+			{
+				m_control->inotify = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+				if (m_control->inotify >= 0 && !watch_tree({}, nullptr)) release_inotify();
+			}
+#endif
+			if (m_control->inotify < 0) m_seen = scan();
+			m_thread = std::thread([this, control = m_control]() { run(); });
+		}
+
+		DirectoryWatcher(const DirectoryWatcher&) = delete;
+		DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+		virtual ~DirectoryWatcher() { stop(); }
+
+		// Stop the watcher thread. Changes not delivered yet are dropped.
+		inline void stop()
+		{
+			m_control->stopped = true;
+			if (!m_thread.joinable()) return;
+			if (m_thread.get_id() == std::this_thread::get_id())
+			{
+				// Called from the callback: the thread is still running it, so leave the
+				// descriptors to the control block, which it holds until it returns
+				m_thread.detach();
+				return;
+			}
+			char byte = 1;
+			[[maybe_unused]] auto written = ::write(m_control->wake[1], &byte, 1);
+			m_thread.join();
+			release_inotify();
+		}
+
+		// False when watching by polling
+		inline bool using_inotify() const { return m_control->inotify >= 0; }
+		inline const std::filesystem::path& root() const { return m_root; }
+
+	private:
+		struct Stamp
+		{
+			std::filesystem::file_time_type mtime;
+			uintmax_t size;
+		};
+
+		// State the watcher thread shares with its owner: it outlives the watcher while
+		// the thread is still inside a callback that stopped or destroyed it
+		struct Control
+		{
+			callback_type callback;
+			std::atomic<bool> stopped{ false };
+			std::atomic<int> inotify{ -1 };
+			int wake[2]{ -1, -1 };
+
+			~Control()
+			{
+				if (int fd = inotify.exchange(-1); fd >= 0) ::close(fd);
+				for (int fd : wake)
+					if (fd >= 0) ::close(fd);
+			}
+		};
+
+		inline void run()
+		{
+			if (m_control->inotify >= 0) run_inotify();
+			else run_polling();
+		}
+
+		// False once stop() has been called. The callback may have destroyed the watcher,
+		// so the caller must then return without touching any member.
+		inline bool deliver(std::vector<Event>& events)
+		{
+			if (events.empty()) return true;
+			const std::shared_ptr<Control> control = m_control;
+			try { if (control->callback) control->callback(std::move(events)); } catch (...) {}
+			if (control->stopped) return false;
+			events.clear();
+			return true;
+		}
+
+		// Wait up to timeout (negative = forever); false once stop() has been called
+		inline bool wait(int timeout_ms, bool& readable)
+		{
+			if (m_control->stopped) return false;
+			const int inotify = m_control->inotify.load(std::memory_order_relaxed);
+			pollfd fds[2] = { { m_control->wake[0], POLLIN, 0 }, { inotify, POLLIN, 0 } };
+			int n = ::poll(fds, inotify >= 0 ? 2 : 1, timeout_ms);
+			if (n < 0 && errno != EINTR) return false;
+			if (n > 0 && (fds[0].revents & POLLIN)) return false;
+			readable = n > 0 && (fds[1].revents & POLLIN);
+			return true;
+		}
+
+		inline void run_polling()
+		{
+			std::vector<Event> events;
+			bool readable = false;
+			while (wait(static_cast<int>(m_options.poll_interval.count()), readable))
+			{
+				auto current = scan();
+				for (const auto& [path, stamp] : current)
+				{
+					auto it = m_seen.find(path);
+					if (it == m_seen.end())
+						events.push_back(Event{ Change::added, path, false });
+					else if (it->second.mtime != stamp.mtime || it->second.size != stamp.size)
+						events.push_back(Event{ Change::modified, path, false });
+				}
+				for (const auto& [path, stamp] : m_seen)
+					if (!current.contains(path))
+						events.push_back(Event{ Change::removed, path, false });
+				m_seen = std::move(current);
+				if (!deliver(events)) return;
+			}
+		}
+
+		inline std::unordered_map<std::string, Stamp> scan() const
+		{
+			std::unordered_map<std::string, Stamp> files;
+			std::error_code ec;
+			auto options = std::filesystem::directory_options::skip_permission_denied;
+			for (std::filesystem::recursive_directory_iterator it(m_root, options, ec), end; !ec && it != end; it.increment(ec))
+			{
+				std::error_code stat_ec;
+				if (!it->is_regular_file(stat_ec)) continue;
+				auto mtime = it->last_write_time(stat_ec);
+				auto size = it->file_size(stat_ec);
+				if (stat_ec) continue;
+				files.emplace(std::filesystem::relative(it->path(), m_root, stat_ec).generic_string(), Stamp{ mtime, size });
+			}
+			return files;
+		}
+
+		inline void release_inotify()
+		{
+			int fd = m_control->inotify.exchange(-1);
+			if (fd >= 0) ::close(fd);
+			m_dirs.clear();
+		}
+
+#ifdef POORIAYOUSEFI_CORE_HAS_INOTIFY
+		static constexpr uint32_t watch_mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR;
+
+		// Watch rel and every directory below it; report the files found when events is given.
+		// False if the kernel refused a watch (usually the max_user_watches limit).
+		inline bool watch_tree(const std::filesystem::path& rel, std::vector<Event>* events)
+		{
+			auto add = [this](const std::filesystem::path& dir) {
+				int wd = ::inotify_add_watch(m_control->inotify, (m_root / dir).c_str(), watch_mask);
+				if (wd < 0) return errno == ENOENT || errno == ENOTDIR || errno == EACCES; // vanished or unreadable: skip it
+				m_dirs[wd] = dir;
+				return true;
+			};
+			if (!add(rel)) return false;
+			std::error_code ec;
+			auto options = std::filesystem::directory_options::skip_permission_denied;
+			for (std::filesystem::recursive_directory_iterator it(m_root / rel, options, ec), end; !ec && it != end; it.increment(ec))
+			{
+				std::error_code stat_ec;
+				auto sub = std::filesystem::relative(it->path(), m_root, stat_ec);
+				if (it->is_directory(stat_ec) && !it->is_symlink(stat_ec))
+				{
+					if (!add(sub)) return false;
+				}
+				else if (events && it->is_regular_file(stat_ec))
+				{
+					events->push_back(Event{ Change::added, sub, false });
+				}
+			}
+			return true;
+		}
+
+		inline void unwatch_tree(const std::filesystem::path& rel)
+		{
+			const std::string prefix = rel.generic_string() + "/";
+			for (auto it = m_dirs.begin(); it != m_dirs.end();)
+			{
+				const std::string dir = it->second.generic_string();
+				if (dir == rel.generic_string() || dir.starts_with(prefix))
+				{
+					::inotify_rm_watch(m_control->inotify, it->first);
+					it = m_dirs.erase(it);
+				}
+				else ++it;
+			}
+		}
+
+		inline void run_inotify()
+		{
+			alignas(inotify_event) char buffer[64 * (sizeof(inotify_event) + NAME_MAX + 1)];
+			std::vector<Event> events;
+			clock::time_point first{}, last{};
+			bool readable = false;
+			while (true)
+			{
+				int timeout = -1;
+				if (!events.empty())
+				{
+					auto now = clock::now();
+					auto until = std::min(last + m_options.debounce, first + m_options.max_delay);
+					timeout = static_cast<int>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count()));
+				}
+				if (!wait(timeout, readable)) return;
+
+				size_t before = events.size();
+				while (readable)
+				{
+					ssize_t n = ::read(m_control->inotify, buffer, sizeof(buffer));
+					if (n <= 0) break;
+					for (char* p = buffer; p < buffer + n;)
+					{
+						auto* ev = reinterpret_cast<inotify_event*>(p);
+						p += sizeof(inotify_event) + ev->len;
+						if (!translate(*ev, events))
+						{
+							// Out of watches: fall back to polling from a fresh scan
+							events.assign(1, Event{ Change::rescan, {}, true });
+							if (!deliver(events)) return;
+							release_inotify();
+							m_seen = scan();
+							run_polling();
+							return;
+						}
+					}
+				}
+
+				auto now = clock::now();
+				if (events.size() != before)
+				{
+					if (before == 0) first = now;
+					last = now;
+				}
+				const bool due = now >= last + m_options.debounce || now >= first + m_options.max_delay;
+				if (!events.empty() && due && !deliver(events)) return;
+			}
+		}
+
+		inline bool translate(const inotify_event& ev, std::vector<Event>& events)
+		{
+			if (ev.mask & IN_Q_OVERFLOW)
+			{
+				// The kernel dropped events: nothing queued so far can be trusted
+				events.assign(1, Event{ Change::rescan, {}, true });
+				return watch_tree({}, nullptr);
+			}
+			if (ev.mask & IN_IGNORED)
+			{
+				m_dirs.erase(ev.wd);
+				return true;
+			}
+			auto dir = m_dirs.find(ev.wd);
+			if (dir == m_dirs.end()) return true;
+			const std::filesystem::path rel = ev.len > 0 ? dir->second / ev.name : dir->second;
+			const bool is_dir = ev.mask & IN_ISDIR;
+
+			if (ev.mask & (IN_DELETE | IN_MOVED_FROM))
+			{
+				if (is_dir) unwatch_tree(rel);
+				events.push_back(Event{ Change::removed, rel, is_dir });
+			}
+			if (ev.mask & (IN_CREATE | IN_MOVED_TO))
+			{
+				if (!is_dir) events.push_back(Event{ Change::added, rel, false });
+				else if (!watch_tree(rel, &events)) return false; // files created before the watch existed
+			}
+			if ((ev.mask & IN_CLOSE_WRITE) && !is_dir)
+				events.push_back(Event{ Change::modified, rel, false });
+			return true;
+		}
+#else
+		inline bool watch_tree(const std::filesystem::path&, std::vector<Event>*) { return false; }
+		inline void run_inotify() { run_polling(); }
+#endif
+
+		std::filesystem::path m_root;
+		DirectoryWatcherOptions m_options;
+		std::shared_ptr<Control> m_control;
+		std::unordered_map<int, std::filesystem::path> m_dirs;
+		std::unordered_map<std::string, Stamp> m_seen;
+		std::thread m_thread;
+	};
+}
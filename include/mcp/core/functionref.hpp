@@ -0,0 +1,54 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/**********************************************************************************************
+*
+*                   			Function Reference
+*                   			-----------------------
+*    			This header provides a non-owning reference to a callable. It includes:
+*    			- A FunctionRef class template: two pointers (object + trampoline), no
+*    			  allocation and no copy of the callable, for callbacks that are only
+*    			  invoked while the referenced callable is alive (stack-scoped contexts).
+*    			- An empty state, tested with operator bool, so it can stand in for an
+*    			  optional std::function.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	template<class Signature>
+	class FunctionRef;
+
+	template<class R, class... Args>
+	class FunctionRef<R(Args...)>
+	{
+	public:
+		FunctionRef() noexcept :m_object{ nullptr }, m_invoke{ nullptr } {}
+
+		// Refers to callable, which must outlive every call through this reference
+		template<class F>
+			requires (!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> && std::is_invocable_r_v<R, F&, Args...>)
+		FunctionRef(F&& callable) noexcept
+			:m_object{ const_cast<void*>(static_cast<const void*>(std::addressof(callable))) },
+			m_invoke{ [](void* object, Args... args) -> R
+			{
+				return std::invoke(*static_cast<std::remove_reference_t<F>*>(object), std::forward<Args>(args)...);
+			} }
+		{
+		}
+
+		inline R operator()(Args... args) const { return m_invoke(m_object, std::forward<Args>(args)...); }
+		inline explicit operator bool() const noexcept { return m_invoke != nullptr; }
+
+	private:
+		void* m_object;
+		R(*m_invoke)(void*, Args...);
+	};
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**********************************************************************************************
+*
+*                   			Memory-Mapped File
+*                   			-----------------------
+*    			This header provides a RAII wrapper for reading files through
+*    			mmap(2). It includes:
+*    			- A MappedFile class that owns the file descriptor and at most one
+*    			  mapped window, so a large file can be read window by window with
+*    			  a bounded resident footprint and no intermediate copies.
+*    			- Windows are page-aligned internally; callers ask for any byte range.
+*    			- A file truncated by another process while it is mapped raises SIGBUS
+*    			  on access, so serve files that are replaced atomically (rename).
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	class MappedFile
+	{
+	public:
+		MappedFile() :m_fd{ -1 }, m_size{ 0 }, m_base{ nullptr }, m_mapped{ 0 }, m_view{} {}
+		explicit MappedFile(const std::filesystem::path& path) :MappedFile() { open(path); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept
+			:m_fd{ std::exchange(other.m_fd, -1) }, m_size{ std::exchange(other.m_size, 0) },
+			m_base{ std::exchange(other.m_base, nullptr) }, m_mapped{ std::exchange(other.m_mapped, 0) },
+			m_view{ std::exchange(other.m_view, {}) }
+		{
+		}
+
+		MappedFile& operator=(MappedFile&& other) noexcept
+		{
+			if (this != &other)
+			{
+				close();
+				m_fd = std::exchange(other.m_fd, -1);
+				m_size = std::exchange(other.m_size, 0);
+				m_base = std::exchange(other.m_base, nullptr);
+				m_mapped = std::exchange(other.m_mapped, 0);
+				m_view = std::exchange(other.m_view, {});
+			}
+			return *this;
+		}
+
+		virtual ~MappedFile() { close(); }
+
+		inline void open(const std::filesystem::path& path)
+		{
+			close();
+			int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+			if (fd < 0)
+				throw std::runtime_error("ERROR! Cannot open " + path.string() + " in MappedFile::open(): " + std::strerror(errno));
+			struct stat st{};
+			if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+			{
+				::close(fd);
+				throw std::runtime_error("ERROR! " + path.string() + " is not a regular file in MappedFile::open() method.");
+			}
+			m_fd = fd;
+			m_size = static_cast<size_t>(st.st_size);
+		}
+
+		inline void close()
+		{
+			unmap();
+			if (m_fd >= 0) ::close(m_fd);
+			m_fd = -1;
+			m_size = 0;
+		}
+
+		inline bool is_open() const { return m_fd >= 0; }
+
+		// File size when it was opened
+		inline size_t size() const { return m_size; }
+
+		// Map bytes [offset, offset + length), clamped to the file, replacing the previous window.
+		// The view stays valid until the next map(), unmap() or close().
+		inline std::string_view map(size_t offset, size_t length)
+		{
+			unmap();
+			if (!is_open() || offset >= m_size || length == 0) return {};
+			length = std::min(length, m_size - offset);
+			const size_t aligned = offset - offset % page_size();
+			const size_t span = length + (offset - aligned);
+			void* base = ::mmap(nullptr, span, PROT_READ, MAP_PRIVATE, m_fd, static_cast<off_t>(aligned));
+			if (base == MAP_FAILED)
+				throw std::runtime_error(std::string{ "ERROR! mmap failed in MappedFile::map(): " } + std::strerror(errno));
+			::madvise(base, span, MADV_SEQUENTIAL);
+			m_base = base;
+			m_mapped = span;
+			m_view = std::string_view(static_cast<const char*>(base) + (offset - aligned), length);
+			return m_view;
+		}
+
+		inline std::string_view view() const { return m_view; }
+
+		inline void unmap()
+		{
+			if (m_base) ::munmap(m_base, m_mapped);
+			m_base = nullptr;
+			m_mapped = 0;
+			m_view = {};
+		}
+
+		static inline size_t page_size()
+		{
+			static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+			return size;
+		}
+
+	private:
+		int m_fd;
+		size_t m_size;
+		void* m_base;
+		size_t m_mapped;
+		std::string_view m_view;
+	};
+}
@@ -0,0 +1,494 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**********************************************************************************************
+*
+*                   			Metrics
+*                   			-----------------------
+*    			This header provides low-overhead instrumentation for hot paths.
+*    			It includes:
+*    			- A Counter class striped across cache lines, so threads counting at
+*    			  once rarely touch the same line. Updates are single relaxed adds.
+*    			- A Histogram class with log-linear buckets in the style of
+*    			  HdrHistogram: lock-free recording, percentiles within 1/16.
+*    			- A Metrics registry of named series (one optional label each), with
+*    			  gauges read through callbacks, a visitor and Prometheus text export.
+*    			- Span hooks (start/end callbacks) for OpenTelemetry-style tracing.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	// Stripe that the calling thread's updates land on; threads are dealt stripes in turn
+	inline size_t metrics_stripe() noexcept
+	{
+		static std::atomic<size_t> next{ 0 };
+		thread_local const size_t stripe = next.fetch_add(1, std::memory_order_relaxed);
+		return stripe;
+	}
+
+	class Counter
+	{
+	public:
+		static constexpr size_t stripes = 8;
+
+		inline void add(uint64_t n = 1) noexcept
+		{
+			m_stripes[metrics_stripe() % stripes].value.fetch_add(n, std::memory_order_relaxed);
+		}
+
+		inline uint64_t value() const noexcept
+		{
+			uint64_t total = 0;
+			for (const auto& stripe : m_stripes) total += stripe.value.load(std::memory_order_relaxed);
+			return total;
+		}
+
+	private:
+		struct alignas(64) Stripe
+		{
+			std::atomic<uint64_t> value{ 0 };
+		};
+
+		std::array<Stripe, stripes> m_stripes;
+	};
+
+	struct HistogramSnapshot
+	{
+		uint64_t count;
+		uint64_t sum;
+		std::vector<uint64_t> buckets; // Histogram::bucket_count entries
+
+		// Highest value of the bucket holding the q-th fraction of recordings (0 when empty)
+		uint64_t percentile(double q) const;
+	};
+
+	// Values below 32 get a bucket each; every power of two above is split into 16, so a
+	// value is reported at most 1/16 above what was recorded. Durations are nanoseconds.
+	class Histogram
+	{
+	public:
+		static constexpr unsigned sub_bits = 4;
+		static constexpr size_t linear = size_t{ 2 } << sub_bits;
+		static constexpr size_t bucket_count = linear + (64 - sub_bits - 1) * (size_t{ 1 } << sub_bits);
+
+		Histogram() :m_buckets{}, m_sum{} {}
+
+		Histogram(const Histogram&) = delete;
+		Histogram& operator=(const Histogram&) = delete;
+
+		inline void record(uint64_t value) noexcept
+		{
+			m_buckets[bucket_of(value)].fetch_add(1, std::memory_order_relaxed);
+			m_sum.add(value);
+		}
+
+		template<class Rep, class Period>
+		inline void record(std::chrono::duration<Rep, Period> elapsed) noexcept
+		{
+			const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+			record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+		}
+
+		inline HistogramSnapshot snapshot() const
+		{
+			HistogramSnapshot out{ 0, m_sum.value(), std::vector<uint64_t>(bucket_count) };
+			for (size_t i = 0; i < bucket_count; ++i)
+			{
+				out.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+				out.count += out.buckets[i];
+			}
+			return out;
+		}
+
+		static constexpr size_t bucket_of(uint64_t value) noexcept
+		{
+			if (value < linear) return static_cast<size_t>(value);
+			const unsigned top = static_cast<unsigned>(std::bit_width(value)) - 1;
+			const unsigned shift = top - sub_bits;
+			const size_t sub = static_cast<size_t>(value >> shift) - (size_t{ 1 } << sub_bits);
+			return linear + (top - sub_bits - 1) * (size_t{ 1 } << sub_bits) + sub;
+		}
+
+		// Highest value that lands in bucket
+		static constexpr uint64_t bucket_max(size_t bucket) noexcept
+		{
+			if (bucket < linear) return bucket;
+			if (bucket + 1 >= bucket_count) return UINT64_MAX;
+			const size_t next = bucket + 1 - linear;
+			const unsigned top = static_cast<unsigned>(next >> sub_bits) + sub_bits + 1;
+			const uint64_t sub = next & ((size_t{ 1 } << sub_bits) - 1);
+			return (((uint64_t{ 1 } << sub_bits) + sub) << (top - sub_bits)) - 1;
+		}
+
+	private:
+		std::array<std::atomic<uint64_t>, bucket_count> m_buckets;
+		Counter m_sum;
+	};
+
+	inline uint64_t HistogramSnapshot::percentile(double q) const
+	{
+		if (count == 0) return 0;
+		const double clamped = q < 0.0 ? 0.0 : (q > 1.0 ? 1.0 : q);
+		const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped * static_cast<double>(count))));
+		uint64_t seen = 0;
+		for (size_t i = 0; i < buckets.size(); ++i)
+		{
+			seen += buckets[i];
+			if (seen >= rank) return Histogram::bucket_max(i);
+		}
+		return Histogram::bucket_max(buckets.size() - 1);
+	}
+
+	enum class MetricType { counter, gauge, histogram };
+
+	// One series as seen by Metrics::collect(); views are valid during the callback only
+	struct MetricSample
+	{
+		std::string_view name;
+		std::string_view help;
+		MetricType type;
+		std::string_view label_name; // empty for a series without a label
+		std::string_view label;
+		double value;                        // counter and gauge
+		const HistogramSnapshot* histogram;  // histogram
+	};
+
+	enum class SpanKind { parse, dispatch, handler, send };
+
+	inline constexpr std::string_view span_kind_name(SpanKind kind) noexcept
+	{
+		switch (kind)
+		{
+		case SpanKind::parse: return "parse";
+		case SpanKind::dispatch: return "dispatch";
+		case SpanKind::handler: return "handler";
+		case SpanKind::send: return "send";
+		}
+		return "span";
+	}
+
+	// start() returns a handle (for instance the tracer's span object) that end() receives
+	// with whether the work succeeded. Both run on the thread doing the work.
+	struct SpanHooks
+	{
+		std::function<void* (SpanKind kind, std::string_view name)> start;
+		std::function<void(void* span, bool ok)> end;
+	};
+
+	class Metrics;
+
+	// Keeps a gauge callback registered; destroying it unregisters the callback, after
+	// which the callback is no longer running or called
+	class Observation
+	{
+	public:
+		Observation() :m_metrics{ nullptr }, m_id{ 0 } {}
+		Observation(Metrics* metrics, uint64_t id) :m_metrics{ metrics }, m_id{ id } {}
+		Observation(Observation&& other) noexcept :m_metrics{ std::exchange(other.m_metrics, nullptr) }, m_id{ other.m_id } {}
+		Observation& operator=(Observation&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_metrics = std::exchange(other.m_metrics, nullptr);
+				m_id = other.m_id;
+			}
+			return *this;
+		}
+		Observation(const Observation&) = delete;
+		Observation& operator=(const Observation&) = delete;
+		~Observation() { reset(); }
+
+		inline void reset();
+
+	private:
+		Metrics* m_metrics;
+		uint64_t m_id;
+	};
+
+	class Metrics
+	{
+	public:
+		Metrics() :m_next_observer{ 1 }, m_tracing{ false } {}
+
+		Metrics(const Metrics&) = delete;
+		Metrics& operator=(const Metrics&) = delete;
+
+		// The series name{label_name="label"}, created on first use. References stay valid for
+		// the registry's lifetime, so hot paths look a series up once and keep it.
+		// Throws std::invalid_argument when name is already registered with another type.
+		inline Counter& counter(std::string_view name, std::string_view help, std::string_view label_name = {}, std::string_view label = {})
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto& series = find_or_add(name, help, MetricType::counter, label_name, label);
+			if (!series.counter) series.counter = std::make_unique<Counter>();
+			return *series.counter;
+		}
+
+		inline Histogram& histogram(std::string_view name, std::string_view help, std::string_view label_name = {}, std::string_view label = {})
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto& series = find_or_add(name, help, MetricType::histogram, label_name, label);
+			if (!series.histogram) series.histogram = std::make_unique<Histogram>();
+			return *series.histogram;
+		}
+
+		// A gauge read through read() at export time; callbacks registered for the same
+		// series are summed. read() runs with the registry locked and must not call into it.
+		[[nodiscard]] inline Observation observe(std::string_view name, std::string_view help, std::string_view label_name, std::string_view label, std::function<double()> read)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto& series = find_or_add(name, help, MetricType::gauge, label_name, label);
+			const uint64_t id = m_next_observer++;
+			series.observers.emplace_back(id, std::move(read));
+			return Observation(this, id);
+		}
+
+		// Visits every series in name order; the export hook for anything but Prometheus
+		inline void collect(const std::function<void(const MetricSample&)>& visit) const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (const auto& [name, family] : m_families)
+			{
+				for (const auto& [label, series] : family.series)
+				{
+					if (!series.counter && !series.histogram && series.observers.empty()) continue; // gauge no longer observed
+					MetricSample sample{ name, family.help, family.type, family.label_name, label, 0.0, nullptr };
+					HistogramSnapshot snapshot;
+					if (series.counter) sample.value = static_cast<double>(series.counter->value());
+					for (const auto& observer : series.observers) sample.value += observer.second();
+					if (series.histogram)
+					{
+						snapshot = series.histogram->snapshot();
+						sample.histogram = &snapshot;
+					}
+					visit(sample);
+				}
+			}
+		}
+
+		// Prometheus text exposition (format 0.0.4). Histograms are written as summaries
+		// with 0.5/0.9/0.99/0.999 quantiles, in seconds.
+		inline void write_prometheus(std::string& out) const
+		{
+			std::string_view current;
+			collect([&out, &current](const MetricSample& sample)
+				{
+					if (sample.name != current)
+					{
+						current = sample.name;
+						out.append("# HELP ").append(sample.name).push_back(' ');
+						out.append(sample.help).push_back('\n');
+						out.append("# TYPE ").append(sample.name).push_back(' ');
+						out.append(sample.type == MetricType::counter ? "counter" : sample.type == MetricType::gauge ? "gauge" : "summary").push_back('\n');
+					}
+					if (!sample.histogram)
+					{
+						write_series(out, sample.name, {}, sample, {});
+						append_number(out, sample.value);
+						out.push_back('\n');
+						return;
+					}
+					static constexpr std::pair<std::string_view, double> quantiles[] = { { "0.5", 0.5 }, { "0.9", 0.9 }, { "0.99", 0.99 }, { "0.999", 0.999 } };
+					for (const auto& [text, q] : quantiles)
+					{
+						write_series(out, sample.name, {}, sample, text);
+						append_number(out, static_cast<double>(sample.histogram->percentile(q)) * 1e-9);
+						out.push_back('\n');
+					}
+					write_series(out, sample.name, "_sum", sample, {});
+					append_number(out, static_cast<double>(sample.histogram->sum) * 1e-9);
+					out.push_back('\n');
+					write_series(out, sample.name, "_count", sample, {});
+					append_number(out, static_cast<double>(sample.histogram->count));
+					out.push_back('\n');
+				});
+		}
+
+		inline std::string prometheus() const
+		{
+			std::string out;
+			write_prometheus(out);
+			return out;
+		}
+
+		// Install before traffic starts: spans read the hooks without locking
+		inline void set_span_hooks(SpanHooks hooks)
+		{
+			m_hooks = std::move(hooks);
+			m_tracing.store(static_cast<bool>(m_hooks.start) || static_cast<bool>(m_hooks.end), std::memory_order_release);
+		}
+
+		inline bool tracing() const noexcept { return m_tracing.load(std::memory_order_acquire); }
+		inline const SpanHooks& span_hooks() const noexcept { return m_hooks; }
+
+	private:
+		friend class Observation;
+
+		struct Series
+		{
+			std::unique_ptr<Counter> counter;
+			std::unique_ptr<Histogram> histogram;
+			std::vector<std::pair<uint64_t, std::function<double()>>> observers;
+		};
+
+		struct Family
+		{
+			MetricType type;
+			std::string help;
+			std::string label_name;
+			std::map<std::string, Series, std::less<>> series;
+		};
+
+		// Called with m_mutex held
+		inline Series& find_or_add(std::string_view name, std::string_view help, MetricType type, std::string_view label_name, std::string_view label)
+		{
+			auto family = m_families.find(name);
+			if (family == m_families.end())
+				family = m_families.emplace(std::string(name), Family{ type, std::string(help), std::string(label_name), {} }).first;
+			else if (family->second.type != type || family->second.label_name != label_name)
+				throw std::invalid_argument("Metric " + std::string(name) + " is already registered with another type or label");
+			auto series = family->second.series.find(label);
+			if (series == family->second.series.end())
+				series = family->second.series.emplace(std::string(label), Series{}).first;
+			return series->second;
+		}
+
+		inline void unobserve(uint64_t id)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto& [name, family] : m_families)
+				for (auto& [label, series] : family.series)
+					std::erase_if(series.observers, [id](const auto& observer) { return observer.first == id; });
+		}
+
+		static inline void write_series(std::string& out, std::string_view name, std::string_view suffix, const MetricSample& sample, std::string_view quantile)
+		{
+			out.append(name).append(suffix);
+			if (sample.label_name.empty() && quantile.empty())
+			{
+				out.push_back(' ');
+				return;
+			}
+			out.push_back('{');
+			if (!sample.label_name.empty())
+			{
+				out.append(sample.label_name).append("=\"");
+				for (char c : sample.label)
+				{
+					if (c == '\\' || c == '"') out.push_back('\\');
+					if (c == '\n') { out.append("\\n"); continue; }
+					out.push_back(c);
+				}
+				out.push_back('"');
+				if (!quantile.empty()) out.push_back(',');
+			}
+			if (!quantile.empty()) out.append("quantile=\"").append(quantile).push_back('"');
+			out.append("} ");
+		}
+
+		static inline void append_number(std::string& out, double value)
+		{
+			char digits[32];
+			auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+			if (ec != std::errc{}) { out.append("NaN"); return; }
+			out.append(digits, end);
+		}
+
+		std::map<std::string, Family, std::less<>> m_families;
+		uint64_t m_next_observer;
+		SpanHooks m_hooks;
+		std::atomic<bool> m_tracing;
+		mutable std::mutex m_mutex;
+	};
+
+	inline void Observation::reset()
+	{
+		if (m_metrics) std::exchange(m_metrics, nullptr)->unobserve(m_id);
+	}
+
+	// Calls, failures and latency of one labelled operation: <prefix>_calls_total,
+	// <prefix>_errors_total and <prefix>_duration_seconds. Resolved once, so recording
+	// is a clock read and a few relaxed adds; a probe without a registry records nothing.
+	struct CallProbe
+	{
+		Counter* calls = nullptr;
+		Counter* errors = nullptr;
+		Histogram* latency = nullptr;
+
+		inline void resolve(Metrics* metrics, std::string_view prefix, std::string_view label_name, std::string_view label)
+		{
+			if (!metrics)
+			{
+				calls = errors = nullptr;
+				latency = nullptr;
+				return;
+			}
+			const std::string by = std::string(", by ").append(label_name);
+			calls = &metrics->counter(std::string(prefix).append("_calls_total"), "Calls" + by, label_name, label);
+			errors = &metrics->counter(std::string(prefix).append("_errors_total"), "Calls that failed" + by, label_name, label);
+			latency = &metrics->histogram(std::string(prefix).append("_duration_seconds"), "Call latency" + by, label_name, label);
+		}
+
+		inline std::chrono::steady_clock::time_point start() const noexcept
+		{
+			return latency ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+		}
+
+		inline void finish(std::chrono::steady_clock::time_point started, bool ok) const noexcept
+		{
+			if (!latency) return;
+			latency->record(std::chrono::steady_clock::now() - started);
+			calls->add();
+			if (!ok) errors->add();
+		}
+	};
+
+	// Brackets a unit of work with the registry's span hooks; free when tracing is off
+	class Span
+	{
+	public:
+		Span(const Metrics* metrics, SpanKind kind, std::string_view name)
+			:m_hooks{ metrics && metrics->tracing() ? &metrics->span_hooks() : nullptr }, m_handle{ nullptr }, m_ok{ true }
+		{
+			if (m_hooks && m_hooks->start) m_handle = m_hooks->start(kind, name);
+		}
+
+		Span(const Span&) = delete;
+		Span& operator=(const Span&) = delete;
+
+		~Span()
+		{
+			if (m_hooks && m_hooks->end) m_hooks->end(m_handle, m_ok);
+		}
+
+		inline bool active() const noexcept { return m_hooks != nullptr; }
+		inline void fail() noexcept { m_ok = false; }
+
+	private:
+		const SpanHooks* m_hooks;
+		void* m_handle;
+		bool m_ok;
+	};
+}
@@ -0,0 +1,212 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+/**********************************************************************************************
+*
+*                   			Lock-Free MPSC Ring
+*                   			-----------------------
+*    			This header provides lock-free building blocks for handing values
+*    			from many producer threads to one consumer thread. It includes:
+*    			- A bounded MpscRing class template (sequence-numbered cells after
+*    			  Dmitry Vyukov's bounded queue). Values are moved in and out;
+*    			  producers never take a lock and the consumer never uses a CAS.
+*    			- An EventCount for parking an idle consumer on atomic::wait
+*    			  without losing wake-ups, and a spin_then_park helper that only
+*    			  parks after spinning and yielding have failed.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	inline constexpr size_t cache_line_size = 64;
+
+	inline void cpu_relax()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		__builtin_ia32_pause();
+#elif defined(__aarch64__)
+		asm volatile("yield");
+#endif
+	}
+
+	template<class T>
+	class MpscRing
+	{
+	public:
+		// Capacity is rounded up to a power of two.
+		explicit MpscRing(size_t capacity = 1024)
+			:m_cells{}, m_mask{ 0 }, m_enqueue{ 0 }, m_dequeue{ 0 }
+		{
+			size_t size = 2;
+			while (size < capacity) size <<= 1;
+			m_mask = size - 1;
+			m_cells = std::make_unique<Cell[]>(size);
+			for (size_t i = 0; i < size; ++i)
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		MpscRing(const MpscRing&) = delete;
+		MpscRing& operator=(const MpscRing&) = delete;
+
+		virtual ~MpscRing()
+		{
+			T discarded;
+			while (try_pop(discarded)) {}
+		}
+
+		// Any thread. Moves from value only when it returns true (false = ring full).
+		inline bool try_push(T& value)
+		{
+			size_t pos = m_enqueue.load(std::memory_order_relaxed);
+			while (true)
+			{
+				Cell& cell = m_cells[pos & m_mask];
+				size_t seq = cell.sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+				if (diff == 0)
+				{
+					if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						::new (static_cast<void*>(cell.storage)) T(std::move(value));
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = m_enqueue.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		inline bool try_push(T&& value) { return try_push(value); }
+
+		// Consumer thread only.
+		inline bool try_pop(T& out)
+		{
+			const size_t pos = m_dequeue.load(std::memory_order_relaxed);
+			Cell& cell = m_cells[pos & m_mask];
+			if (cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+			T* item = std::launder(reinterpret_cast<T*>(cell.storage));
+			out = std::move(*item);
+			item->~T();
+			cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+			m_dequeue.store(pos + 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		// Consumer thread only.
+		inline bool empty() const
+		{
+			const size_t pos = m_dequeue.load(std::memory_order_relaxed);
+			return m_cells[pos & m_mask].sequence.load(std::memory_order_acquire) != pos + 1;
+		}
+
+		// Any thread; claimed slots not yet taken, so it may count a push still in progress.
+		inline size_t size() const
+		{
+			const size_t dequeue = m_dequeue.load(std::memory_order_relaxed);
+			const size_t enqueue = m_enqueue.load(std::memory_order_relaxed);
+			return enqueue > dequeue ? enqueue - dequeue : 0;
+		}
+
+		// Any thread; a snapshot that may be stale by the time it returns.
+		inline bool full() const
+		{
+			size_t pos = m_enqueue.load(std::memory_order_acquire);
+			size_t seq = m_cells[pos & m_mask].sequence.load(std::memory_order_acquire);
+			return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos) < 0;
+		}
+
+		inline size_t capacity() const { return m_mask + 1; }
+
+	private:
+		struct alignas(cache_line_size) Cell
+		{
+			std::atomic<size_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		std::unique_ptr<Cell[]> m_cells;
+		size_t m_mask;
+		alignas(cache_line_size) std::atomic<size_t> m_enqueue;
+		alignas(cache_line_size) std::atomic<size_t> m_dequeue; // written by the consumer only
+	};
+
+	// Lets a consumer sleep until a producer signals, with no lost wake-ups:
+	// prepare_wait(), re-check the condition, then wait() or cancel_wait().
+	class EventCount
+	{
+	public:
+		inline uint32_t prepare_wait()
+		{
+			m_waiters.fetch_add(1, std::memory_order_seq_cst);
+			std::atomic_thread_fence(std::memory_order_seq_cst); // the caller's re-check must not move above this
+			return m_epoch.load(std::memory_order_seq_cst);
+		}
+
+		inline void cancel_wait() { m_waiters.fetch_sub(1, std::memory_order_seq_cst); }
+
+		inline void wait(uint32_t epoch)
+		{
+			m_epoch.wait(epoch, std::memory_order_seq_cst);
+			m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+		}
+
+		// Cheap when nobody is parked: one fence and one load.
+		inline void notify_one()
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (m_waiters.load(std::memory_order_seq_cst) == 0) return;
+			m_epoch.fetch_add(1, std::memory_order_seq_cst);
+			m_epoch.notify_one();
+		}
+
+		inline void notify_all()
+		{
+			m_epoch.fetch_add(1, std::memory_order_seq_cst);
+			m_epoch.notify_all();
+		}
+
+	private:
+		std::atomic<uint32_t> m_epoch{ 0 };
+		std::atomic<uint32_t> m_waiters{ 0 };
+	};
+
+	// Wait until ready() holds: spin briefly, then yield, and only then park on the event count.
+	template<class Ready>
+	inline void spin_then_park(EventCount& events, Ready ready, size_t spins = 256, size_t yields = 16)
+	{
+		for (size_t i = 0; i < spins; ++i)
+		{
+			if (ready()) return;
+			cpu_relax();
+		}
+		for (size_t i = 0; i < yields; ++i)
+		{
+			if (ready()) return;
+			std::this_thread::yield();
+		}
+		auto epoch = events.prepare_wait();
+		if (ready())
+		{
+			events.cancel_wait();
+			return;
+		}
+		events.wait(epoch);
+	}
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+/**********************************************************************************************
+*
+*                   			Object Pool
+*                   			-----------------------
+*    			This header provides recycling of frequently created objects
+*    			(serialization buffers, content vectors, ...). It includes:
+*    			- An ObjectPool class template: one free list per thread and type, so
+*    			  acquire() and release never lock; handles return their object to the
+*    			  releasing thread's list through a recycling deleter.
+*    			- Bounded growth: at most limit() objects are kept per thread, and
+*    			  objects whose capacity() grew past max_capacity() are freed instead.
+*    			- Process-wide counters (created, reused, recycled, discarded).
+*    			- A pool_reset customization point; the default calls clear() where the
+*    			  type has one, so strings and vectors keep their capacity.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	// Returns a recycled object to a clean state, keeping its capacity where the type allows
+	template<class T>
+	inline void pool_reset(T& object)
+	{
+		if constexpr (requires { object.clear(); }) object.clear();
+		else object = T{};
+	}
+
+	struct ObjectPoolStats
+	{
+		size_t created;   // acquisitions that had to construct a new object
+		size_t reused;    // acquisitions served from a thread's free list
+		size_t recycled;  // releases kept for reuse
+		size_t discarded; // releases freed: list full, object too large, or thread exiting
+	};
+
+	template<class T>
+	class ObjectPool
+	{
+	public:
+		struct Recycler
+		{
+			inline void operator()(T* object) const noexcept { ObjectPool::release(object); }
+		};
+		using Handle = std::unique_ptr<T, Recycler>;
+
+		ObjectPool() = delete;
+
+		// A clean object, recycled from this thread's free list when one is available
+		static inline Handle acquire()
+		{
+			if (Cache* cache = local(); cache && !cache->free.empty())
+			{
+				T* object = cache->free.back();
+				cache->free.pop_back();
+				s_reused.fetch_add(1, std::memory_order_relaxed);
+				return Handle(object);
+			}
+			s_created.fetch_add(1, std::memory_order_relaxed);
+			return Handle(new T{});
+		}
+
+		// Called by Handle; objects from any thread join the calling thread's list
+		static inline void release(T* object) noexcept
+		{
+			if (!object) return;
+			Cache* cache = local();
+			if (cache && cache->free.size() < s_limit.load(std::memory_order_relaxed) && fits(*object))
+			{
+				try
+				{
+					pool_reset(*object);
+					cache->free.push_back(object);
+					s_recycled.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				catch (...) {}
+			}
+			s_discarded.fetch_add(1, std::memory_order_relaxed);
+			delete object;
+		}
+
+		// Objects kept per thread (default 64)
+		static inline void set_limit(size_t per_thread) { s_limit.store(per_thread, std::memory_order_relaxed); }
+		static inline size_t limit() { return s_limit.load(std::memory_order_relaxed); }
+
+		// Largest capacity() an object may have to be kept (default 1M elements)
+		static inline void set_max_capacity(size_t capacity) { s_max_capacity.store(capacity, std::memory_order_relaxed); }
+		static inline size_t max_capacity() { return s_max_capacity.load(std::memory_order_relaxed); }
+
+		static inline ObjectPoolStats stats()
+		{
+			return ObjectPoolStats{
+				s_created.load(std::memory_order_relaxed),
+				s_reused.load(std::memory_order_relaxed),
+				s_recycled.load(std::memory_order_relaxed),
+				s_discarded.load(std::memory_order_relaxed)
+			};
+		}
+
+		static inline void reset_stats()
+		{
+			s_created.store(0, std::memory_order_relaxed);
+			s_reused.store(0, std::memory_order_relaxed);
+			s_recycled.store(0, std::memory_order_relaxed);
+			s_discarded.store(0, std::memory_order_relaxed);
+		}
+
+	private:
+		struct Cache
+		{
+			std::vector<T*> free;
+			Cache() :free{} { free.reserve(s_limit.load(std::memory_order_relaxed)); }
+			~Cache()
+			{
+				t_retired = true; // objects released later in thread exit are freed directly
+				for (T* object : free) delete object;
+			}
+		};
+
+		static inline Cache* local()
+		{
+			if (t_retired) return nullptr;
+			thread_local Cache cache;
+			return &cache;
+		}
+
+		static inline bool fits(const T& object)
+		{
+			if constexpr (requires { object.capacity(); })
+				return object.capacity() <= s_max_capacity.load(std::memory_order_relaxed);
+			else
+				return true;
+		}
+
+		static inline thread_local bool t_retired = false;
+		static inline std::atomic<size_t> s_limit{ 64 };
+		static inline std::atomic<size_t> s_max_capacity{ size_t{ 1 } << 20 };
+		static inline std::atomic<size_t> s_created{ 0 };
+		static inline std::atomic<size_t> s_reused{ 0 };
+		static inline std::atomic<size_t> s_recycled{ 0 };
+		static inline std::atomic<size_t> s_discarded{ 0 };
+	};
+
+	template<class T>
+	using Pooled = typename ObjectPool<T>::Handle;
+}
@@ -0,0 +1,247 @@
+#pragma once
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+/**********************************************************************************************
+*
+*                   			Result Cache
+*                   			-----------------------
+*    			This header provides a bounded cache for the results of expensive,
+*    			deterministic calls. It includes:
+*    			- A ResultCache class template: LRU order, bounded by an estimated byte
+*    			  cost rather than an entry count, with an optional TTL per entry.
+*    			- Coalescing: concurrent get_or_compute() calls for the same key run the
+*    			  computation once; the others wait and share its value (or exception).
+*    			- Invalidation by key predicate or wholesale; results computed while an
+*    			  invalidation happened are handed out but not stored.
+*    			- Counters (hits, misses, coalesced waits, evictions, bytes).
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	struct ResultCacheStats
+	{
+		size_t hits;      // served from the cache
+		size_t misses;    // computed by the caller
+		size_t coalesced; // waited for an identical computation already running
+		size_t evictions; // entries dropped for space or age
+		size_t entries;
+		size_t bytes;     // estimated cost of the entries held
+	};
+
+	template<class V>
+	class ResultCache
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+		using Value = std::shared_ptr<const V>;
+
+		// Bookkeeping charged per entry on top of its key and value cost
+		static constexpr size_t entry_overhead = 128;
+
+		explicit ResultCache(size_t max_bytes = 64u << 20)
+			:m_max_bytes{ max_bytes }, m_bytes{ 0 }, m_generation{ 0 }, m_hits{ 0 }, m_misses{ 0 }, m_coalesced{ 0 }, m_evictions{ 0 }
+		{
+		}
+
+		ResultCache(const ResultCache&) = delete;
+		ResultCache& operator=(const ResultCache&) = delete;
+
+		// The value cached for key; otherwise compute() runs once for every concurrent caller
+		// of that key and its result is stored when cost(value) fits. ttl 0 never expires.
+		// An exception from compute() reaches every waiting caller and nothing is stored.
+		template<class Compute, class Cost>
+		inline Value get_or_compute(std::string_view key, Compute&& compute, Cost&& cost, std::chrono::milliseconds ttl = std::chrono::milliseconds::zero())
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (auto it = m_index.find(key); it != m_index.end())
+			{
+				auto entry = it->second;
+				if (entry->expires == clock::time_point{} || clock::now() < entry->expires)
+				{
+					m_lru.splice(m_lru.begin(), m_lru, entry);
+					++m_hits;
+					return entry->value;
+				}
+				remove(entry);
+				++m_evictions;
+			}
+			if (auto it = m_flights.find(key); it != m_flights.end())
+			{
+				auto flight = it->second;
+				++m_coalesced;
+				lock.unlock();
+				std::unique_lock<std::mutex> wait_lock(flight->mutex);
+				flight->ready.wait(wait_lock, [&flight] { return flight->done; });
+				if (flight->error) std::rethrow_exception(flight->error);
+				return flight->value;
+			}
+			++m_misses;
+			auto flight = std::make_shared<Flight>();
+			m_flights.emplace(std::string(key), flight);
+			const uint64_t generation = m_generation;
+			lock.unlock();
+
+			Value value;
+			try
+			{
+				value = std::make_shared<const V>(compute());
+			}
+			catch (...)
+			{
+				lock.lock();
+				forget(key, flight);
+				lock.unlock();
+				land(*flight, nullptr, std::current_exception());
+				throw;
+			}
+
+			const size_t bytes = key.size() + cost(*value) + entry_overhead;
+			lock.lock();
+			forget(key, flight);
+			if (generation == m_generation && bytes <= m_max_bytes)
+			{
+				while (m_bytes + bytes > m_max_bytes && !m_lru.empty())
+				{
+					remove(std::prev(m_lru.end()));
+					++m_evictions;
+				}
+				m_lru.push_front(Entry{ std::string(key), value, bytes, ttl > std::chrono::milliseconds::zero() ? clock::now() + ttl : clock::time_point{} });
+				m_index.emplace(m_lru.front().key, m_lru.begin());
+				m_bytes += bytes;
+			}
+			lock.unlock();
+			land(*flight, value, nullptr);
+			return value;
+		}
+
+		// Drops the entries whose key matches. Matching computations in flight are not
+		// stored, and later callers of their keys compute afresh instead of joining them.
+		template<class Pred>
+		inline void erase_if(Pred&& pred)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto it = m_lru.begin(); it != m_lru.end();)
+			{
+				auto next = std::next(it);
+				if (pred(std::string_view(it->key))) remove(it);
+				it = next;
+			}
+			std::erase_if(m_flights, [&pred](const auto& flight) { return pred(std::string_view(flight.first)); });
+			++m_generation;
+		}
+
+		inline void clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_index.clear();
+			m_lru.clear();
+			m_flights.clear();
+			m_bytes = 0;
+			++m_generation;
+		}
+
+		// Shrinking evicts least recently used entries at once
+		inline void set_max_bytes(size_t max_bytes)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_max_bytes = max_bytes;
+			while (m_bytes > m_max_bytes && !m_lru.empty())
+			{
+				remove(std::prev(m_lru.end()));
+				++m_evictions;
+			}
+		}
+
+		inline size_t max_bytes() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_max_bytes;
+		}
+
+		inline ResultCacheStats stats() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return ResultCacheStats{ m_hits, m_misses, m_coalesced, m_evictions, m_lru.size(), m_bytes };
+		}
+
+	private:
+		struct Entry
+		{
+			std::string key;
+			Value value;
+			size_t bytes;
+			clock::time_point expires; // epoch = never
+		};
+
+		struct Flight
+		{
+			std::mutex mutex;
+			std::condition_variable ready;
+			bool done = false;
+			Value value;
+			std::exception_ptr error;
+		};
+
+		struct KeyHash
+		{
+			using is_transparent = void;
+			inline size_t operator()(std::string_view key) const noexcept { return std::hash<std::string_view>{}(key); }
+		};
+
+		using Position = typename std::list<Entry>::iterator;
+
+		static inline void land(Flight& flight, Value value, std::exception_ptr error)
+		{
+			{
+				std::lock_guard<std::mutex> lock(flight.mutex);
+				flight.value = std::move(value);
+				flight.error = std::move(error);
+				flight.done = true;
+			}
+			flight.ready.notify_all();
+		}
+
+		// Called with m_mutex held; the slot may already have been dropped by an invalidation
+		inline void forget(std::string_view key, const std::shared_ptr<Flight>& flight)
+		{
+			auto it = m_flights.find(key);
+			if (it != m_flights.end() && it->second == flight) m_flights.erase(it);
+		}
+
+		// Called with m_mutex held
+		inline void remove(Position entry)
+		{
+			m_bytes -= entry->bytes;
+			m_index.erase(std::string_view(entry->key));
+			m_lru.erase(entry);
+		}
+
+		size_t m_max_bytes;
+		size_t m_bytes;
+		uint64_t m_generation;
+		size_t m_hits;
+		size_t m_misses;
+		size_t m_coalesced;
+		size_t m_evictions;
+		std::list<Entry> m_lru; // most recently used first
+		std::unordered_map<std::string_view, Position, KeyHash, std::equal_to<>> m_index; // views of Entry::key
+		std::unordered_map<std::string, std::shared_ptr<Flight>, KeyHash, std::equal_to<>> m_flights;
+		mutable std::mutex m_mutex;
+	};
+}
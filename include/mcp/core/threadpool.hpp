@@ -0,0 +1,205 @@
+#pragma once
+#include "asyncops.hpp"
+#include <functional>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+
+/**********************************************************************************************
+*
+*                   			Work-Stealing Thread Pool
+*                   			-----------------------
+*    			This header provides a bounded work-stealing thread pool.
+*    			It includes:
+*    			- A ThreadPool class with one task deque per worker. Workers pop
+*    			  their own deque LIFO and steal FIFO from the others when idle.
+*    			- A bound on the number of queued tasks: submit() blocks while
+*    			  the pool is full, try_submit() reports failure instead.
+*    			- An Executor implementation, so coroutines can resume on the pool.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	class ThreadPool : public Executor
+	{
+	public:
+		using task_type = std::function<void()>;
+
+		explicit ThreadPool(size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency()), size_t max_queued = 1024)
+			:m_workers{}, m_threads{}, m_capacity{ std::max<size_t>(1, max_queued) }, m_queued{ 0 }, m_next{ 0 }, m_stopping{ false }
+		{
+			threads = std::max<size_t>(1, threads);
+			for (size_t i = 0; i < threads; ++i)
+				m_workers.emplace_back(std::make_unique<Worker>());
+			for (size_t i = 0; i < threads; ++i)
+				m_threads.emplace_back([this, i]() { run(i); });
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		virtual ~ThreadPool() { shutdown(); }
+
+		// Queue a task, blocking while the pool is at capacity. Returns false once shut down.
+		inline bool submit(task_type task)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_state_mutex);
+				m_space_cv.wait(lock, [this]() { return m_stopping || m_queued < m_capacity; });
+				if (m_stopping) return false;
+				++m_queued;
+			}
+			enqueue(std::move(task));
+			return true;
+		}
+
+		// Queue a task only if there is room. Returns false when full or shut down.
+		inline bool try_submit(task_type task)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_state_mutex);
+				if (m_stopping || m_queued >= m_capacity) return false;
+				++m_queued;
+			}
+			enqueue(std::move(task));
+			return true;
+		}
+
+		// Resume a coroutine on a worker. A worker never blocks on its own full pool, and after
+		// shutdown the coroutine resumes on the caller instead of being lost.
+		inline void schedule(std::coroutine_handle<> handle) override
+		{
+			auto task = [handle]() { handle.resume(); };
+			if (try_submit(task)) return;
+			if (running_in_pool() || !submit(task))
+				handle.resume();
+		}
+
+		// Stop accepting work, run what is already queued and join the workers.
+		inline void shutdown()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_state_mutex);
+				if (m_stopping && m_threads.empty()) return;
+				m_stopping = true;
+			}
+			m_work_cv.notify_all();
+			m_space_cv.notify_all();
+			for (auto& t : m_threads)
+				if (t.joinable() && t.get_id() != std::this_thread::get_id())
+					t.join();
+			for (auto& t : m_threads)
+				if (t.joinable())
+					t.detach();
+			m_threads.clear();
+		}
+
+		inline bool running_in_pool() const { return tls_pool() == this; }
+		inline size_t size() const { return m_workers.size(); }
+		inline size_t capacity() const { return m_capacity; }
+		inline size_t queued() const
+		{
+			std::lock_guard<std::mutex> lock(m_state_mutex);
+			return m_queued;
+		}
+
+	private:
+		struct Worker
+		{
+			std::deque<task_type> tasks;
+			std::mutex mutex;
+		};
+
+		static inline const ThreadPool*& tls_pool() { static thread_local const ThreadPool* pool = nullptr; return pool; }
+		static inline size_t& tls_index() { static thread_local size_t index = 0; return index; }
+
+		inline void enqueue(task_type task)
+		{
+			// Work spawned by a worker stays local (hot caches); outside work is spread round-robin.
+			if (running_in_pool())
+			{
+				auto& w = *m_workers[tls_index()];
+				std::lock_guard<std::mutex> lock(w.mutex);
+				w.tasks.push_front(std::move(task));
+			}
+			else
+			{
+				auto& w = *m_workers[m_next.fetch_add(1, std::memory_order_relaxed) % m_workers.size()];
+				std::lock_guard<std::mutex> lock(w.mutex);
+				w.tasks.push_back(std::move(task));
+			}
+			m_work_cv.notify_one();
+		}
+
+		inline bool pop_local(size_t index, task_type& out)
+		{
+			auto& w = *m_workers[index];
+			std::lock_guard<std::mutex> lock(w.mutex);
+			if (w.tasks.empty()) return false;
+			out = std::move(w.tasks.front());
+			w.tasks.pop_front();
+			return true;
+		}
+
+		inline bool steal(size_t thief, task_type& out)
+		{
+			for (size_t k = 1; k < m_workers.size(); ++k)
+			{
+				auto& w = *m_workers[(thief + k) % m_workers.size()];
+				std::unique_lock<std::mutex> lock(w.mutex, std::try_to_lock);
+				if (!lock.owns_lock() || w.tasks.empty()) continue;
+				out = std::move(w.tasks.back());
+				w.tasks.pop_back();
+				return true;
+			}
+			return false;
+		}
+
+		inline void run(size_t index)
+		{
+			tls_pool() = this;
+			tls_index() = index;
+			while (true)
+			{
+				task_type task;
+				if (pop_local(index, task) || steal(index, task))
+				{
+					{
+						std::lock_guard<std::mutex> lock(m_state_mutex);
+						--m_queued;
+					}
+					m_space_cv.notify_one();
+					try { task(); } catch (...) {}
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(m_state_mutex);
+				if (m_stopping && m_queued == 0) break;
+				m_work_cv.wait_for(lock, std::chrono::milliseconds(50), [this]() { return m_stopping || m_queued > 0; });
+				if (m_stopping && m_queued == 0) break;
+			}
+			tls_pool() = nullptr;
+		}
+
+		std::vector<std::unique_ptr<Worker>> m_workers;
+		std::vector<std::thread> m_threads;
+		size_t m_capacity;
+		size_t m_queued;
+		std::atomic<size_t> m_next;
+		bool m_stopping;
+		mutable std::mutex m_state_mutex;
+		std::condition_variable m_work_cv;
+		std::condition_variable m_space_cv;
+	};
+}
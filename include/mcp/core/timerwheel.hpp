@@ -0,0 +1,162 @@
+#pragma once
+#include <functional>
+#include <thread>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+/**********************************************************************************************
+*
+*                   			Hashed Timer Wheel
+*                   			-----------------------
+*    			This header provides a hashed timer wheel for large numbers of
+*    			short-lived deadlines. It includes:
+*    			- A TimerWheel class: O(1) schedule and cancel, one background thread
+*    			  that advances the wheel every tick and fires everything that expired
+*    			  in that slot as a single batch.
+*    			- Callbacks run on the wheel thread, outside the wheel's lock, so they
+*    			  may schedule or cancel other timers.
+*
+*                   			Developed by: Pooria Yousefi
+*				   				Date: 2025-06-26
+*				   				License: MIT
+*
+**********************************************************************************************/
+
+namespace pooriayousefi::core
+{
+	class TimerWheel
+	{
+	public:
+		using clock = std::chrono::steady_clock;
+		using callback_type = std::function<void()>;
+		using timer_id = uint64_t;
+
+		// Deadlines are rounded up to whole ticks; a full revolution is tick * slots.
+		explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(10), size_t slots = 512)
+			:m_tick{ std::max(tick, std::chrono::milliseconds(1)) }, m_slots(std::max<size_t>(1, slots)), m_where{},
+			m_cursor{ 0 }, m_next_id{ 1 }, m_stopping{ false }, m_thread{}
+		{
+			m_thread = std::thread([this]() { run(); });
+		}
+
+		TimerWheel(const TimerWheel&) = delete;
+		TimerWheel& operator=(const TimerWheel&) = delete;
+
+		virtual ~TimerWheel() { stop(); }
+
+		// Run fn once, no earlier than delay from now. Returns an id for cancel(), or 0 once stopped.
+		inline timer_id schedule(std::chrono::milliseconds delay, callback_type fn)
+		{
+			auto ticks = static_cast<uint64_t>((std::max(delay, std::chrono::milliseconds(0)) + m_tick - std::chrono::milliseconds(1)) / m_tick);
+			ticks = std::max<uint64_t>(1, ticks);
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_stopping) return 0;
+			const size_t slot = static_cast<size_t>((m_cursor + ticks) % m_slots.size());
+			const timer_id id = m_next_id++;
+			m_slots[slot].push_back(Entry{ id, (ticks - 1) / m_slots.size(), std::move(fn) });
+			m_where.emplace(id, slot);
+			return id;
+		}
+
+		// Returns true if the timer was still pending and will now never fire.
+		inline bool cancel(timer_id id)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_where.find(id);
+			if (it == m_where.end()) return false;
+			auto& entries = m_slots[it->second];
+			auto e = std::find_if(entries.begin(), entries.end(), [id](const Entry& x) { return x.id == id; });
+			if (e != entries.end())
+			{
+				std::swap(*e, entries.back());
+				entries.pop_back();
+			}
+			m_where.erase(it);
+			return true;
+		}
+
+		// Stop the wheel thread. Timers that have not fired yet are dropped.
+		inline void stop()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				if (m_stopping && !m_thread.joinable()) return;
+				m_stopping = true;
+			}
+			m_cv.notify_all();
+			if (m_thread.joinable())
+			{
+				if (m_thread.get_id() == std::this_thread::get_id()) m_thread.detach();
+				else m_thread.join();
+			}
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto& entries : m_slots) entries.clear();
+			m_where.clear();
+		}
+
+		inline std::chrono::milliseconds tick() const { return m_tick; }
+		inline size_t pending() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_where.size();
+		}
+
+	private:
+		struct Entry
+		{
+			timer_id id;
+			uint64_t rounds;
+			callback_type fn;
+		};
+
+		inline void run()
+		{
+			auto next = clock::now() + m_tick;
+			std::vector<callback_type> due;
+			std::unique_lock<std::mutex> lock(m_mutex);
+			while (!m_stopping)
+			{
+				if (m_cv.wait_until(lock, next, [this]() { return m_stopping; })) break;
+				// Catch up on every tick we slept through so deadlines never drift late by more than one tick
+				while (clock::now() >= next)
+				{
+					next += m_tick;
+					m_cursor = (m_cursor + 1) % m_slots.size();
+					auto& entries = m_slots[m_cursor];
+					for (size_t i = 0; i < entries.size();)
+					{
+						if (entries[i].rounds > 0) { --entries[i].rounds; ++i; continue; }
+						m_where.erase(entries[i].id);
+						due.push_back(std::move(entries[i].fn));
+						std::swap(entries[i], entries.back());
+						entries.pop_back();
+					}
+				}
+				if (due.empty()) continue;
+				lock.unlock();
+				for (auto& fn : due)
+				{
+					try { if (fn) fn(); } catch (...) {}
+				}
+				due.clear();
+				lock.lock();
+			}
+		}
+
+		std::chrono::milliseconds m_tick;
+		std::vector<std::vector<Entry>> m_slots;
+		std::unordered_map<timer_id, size_t> m_where;
+		uint64_t m_cursor;
+		timer_id m_next_id;
+		bool m_stopping;
+		mutable std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::thread m_thread;
+	};
+}
@@ -1,12 +1,24 @@
 #pragma once
 
-#include "server.hpp"
-#include "server_streaming.hpp"
-#include "core/raiiiofsw.hpp"
-#include "core/asyncops.hpp"
+#include "../server.hpp"
+#include "../server_streaming.hpp"
+#include "../core/raiiiofsw.hpp"
+#include "../core/mappedfile.hpp"
+#include "../core/dirwatcher.hpp"
+#include "../core/asyncops.hpp"
+#include "../core/resultcache.hpp"
 #include <filesystem>
 #include <unordered_map>
+#include <map>
+#include <optional>
+#include <iterator>
+#include <ranges>
+#include <memory>
 #include <mutex>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <sys/stat.h>
 
 /**
  * @file helpers/file_resource_server.hpp
@@ -14,6 +26,10 @@
  * 
  * Provides automatic serving of files as MCP resources using
  * RAII file wrappers for safe, leak-free file operations.
+ * FileResourceServer reads through a bounded mmap window and accepts
+ * byte ranges, so clients can page through files larger than memory.
+ * Text types are returned as `text`, everything else as a base64 `blob`
+ * (raw bytes once the session negotiated CBOR or MessagePack).
  */
 
 namespace pooriayousefi::mcp::helpers 
@@ -41,7 +57,17 @@ namespace pooriayousefi::mcp::helpers
             {".svg", "image/svg+xml"},
             {".zip", "application/zip"},
             {".tar", "application/x-tar"},
-            {".gz", "application/gzip"}
+            {".gz", "application/gzip"},
+            {".csv", "text/csv"},
+            {".log", "text/plain"},
+            {".yaml", "application/yaml"},
+            {".yml", "application/yaml"},
+            {".c", "text/x-c"},
+            {".h", "text/x-c"},
+            {".cpp", "text/x-c++"},
+            {".hpp", "text/x-c++"},
+            {".py", "text/x-python"},
+            {".sh", "text/x-shellscript"}
         };
 
         fs::path file_path(path);
@@ -55,6 +81,16 @@ namespace pooriayousefi::mcp::helpers
         return "application/octet-stream";
     }
 
+    /**
+     * @brief Whether files of this MIME type are served as `text`; anything else is a `blob`
+     */
+    inline bool is_text_mime_type(std::string_view mime_type) {
+        return mime_type.starts_with("text/") ||
+               mime_type.ends_with("/json") || mime_type.ends_with("+json") ||
+               mime_type.ends_with("/xml") || mime_type.ends_with("+xml") ||
+               mime_type == "application/javascript" || mime_type == "application/yaml";
+    }
+
     /**
      * @brief Parse file:// URI to filesystem path
      */
@@ -65,6 +101,197 @@ namespace pooriayousefi::mcp::helpers
         return uri;
     }
 
+    /**
+     * @brief Resolve a path relative to root, or return an empty path if it escapes root
+     *
+     * `..` components and symlinks are resolved before the check, so
+     * "docs/../../etc/passwd" and "/srv/root-other" are both rejected.
+     */
+    inline fs::path resolve_within(const fs::path& root, const std::string& rel_path) {
+        std::error_code ec;
+        fs::path candidate = fs::weakly_canonical(root / fs::path(rel_path).relative_path(), ec);
+        if (ec) {
+            return {};
+        }
+        auto [root_end, unused] = std::mismatch(root.begin(), root.end(), candidate.begin(), candidate.end());
+        (void)unused;
+        return root_end == root.end() ? candidate : fs::path{};
+    }
+
+    namespace detail {
+        // Length of the incomplete UTF-8 sequence at the end of text (0 if it ends on a boundary)
+        inline size_t utf8_incomplete_tail(std::string_view text) {
+            for (size_t back = 1; back <= std::min<size_t>(4, text.size()); ++back) {
+                auto byte = static_cast<unsigned char>(text[text.size() - back]);
+                if ((byte & 0xC0) == 0x80) continue; // continuation byte
+                size_t needed = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+                return needed > back ? back : 0;
+            }
+            return 0;
+        }
+
+        // Number of continuation bytes at the start of text (a range that began mid-character)
+        inline size_t utf8_leading_continuation(std::string_view text) {
+            size_t n = 0;
+            while (n < std::min<size_t>(3, text.size()) && (static_cast<unsigned char>(text[n]) & 0xC0) == 0x80) ++n;
+            return n;
+        }
+    }
+
+    /**
+     * @brief Immutable resource list sorted by URI, stored in shared chunks
+     *
+     * with() returns a new version that copies the chunk table and only the
+     * chunks a change lands in; every other chunk is shared with this one. A
+     * batch of k changes therefore costs about k chunk copies plus one pointer
+     * per chunk, instead of a copy of every resource.
+     */
+    class ResourceSnapshot {
+        using chunk = std::vector<Resource>;
+        using chunk_table = std::vector<std::shared_ptr<const chunk>>;
+
+    public:
+        /// A change to one URI: a resource to add or replace, or nullopt to remove it
+        using change = std::pair<std::string, std::optional<Resource>>;
+
+        /// Chunk length after a full build; a chunk is split in two past twice this
+        static constexpr size_t chunk_size = 256;
+
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Resource;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Resource*;
+            using reference = const Resource&;
+
+            const_iterator() = default;
+
+            reference operator*() const { return (*(*chunks_)[chunk_])[item_]; }
+            pointer operator->() const { return &**this; }
+
+            const_iterator& operator++() {
+                if (++item_ == (*chunks_)[chunk_]->size()) {
+                    ++chunk_;
+                    item_ = 0;
+                }
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                auto before = *this;
+                ++*this;
+                return before;
+            }
+
+            bool operator==(const const_iterator&) const = default;
+
+        private:
+            friend class ResourceSnapshot;
+            const_iterator(const chunk_table* chunks, size_t index)
+                : chunks_(chunks), chunk_(index) {}
+
+            const chunk_table* chunks_ = nullptr;
+            size_t chunk_ = 0;
+            size_t item_ = 0;
+        };
+
+        ResourceSnapshot() = default;
+
+        /**
+         * @brief Build from resources already sorted by URI
+         */
+        template<class Range>
+        explicit ResourceSnapshot(const Range& sorted) {
+            chunk items;
+            for (const auto& resource : sorted) {
+                items.push_back(resource);
+                ++size_;
+                if (items.size() == chunk_size) {
+                    chunks_.push_back(std::make_shared<const chunk>(std::move(items)));
+                    items = {};
+                }
+            }
+            if (!items.empty()) {
+                chunks_.push_back(std::make_shared<const chunk>(std::move(items)));
+            }
+        }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        const_iterator begin() const { return const_iterator(&chunks_, 0); }
+        const_iterator end() const { return const_iterator(&chunks_, chunks_.size()); }
+
+        /**
+         * @brief A new version with the changes applied in order; this one is left as is
+         */
+        std::shared_ptr<const ResourceSnapshot> with(const std::vector<change>& changes) const {
+            auto next = std::make_shared<ResourceSnapshot>(*this);
+            std::vector<std::shared_ptr<chunk>> owned(next->chunks_.size());
+            for (const auto& [uri, resource] : changes) {
+                next->apply(uri, resource, owned);
+            }
+            return next;
+        }
+
+    private:
+        // Chunks are never empty; owned[i] is set once this version has its own copy of chunk i
+        void apply(const std::string& uri, const std::optional<Resource>& resource,
+                   std::vector<std::shared_ptr<chunk>>& owned) {
+            if (chunks_.empty()) {
+                if (resource) {
+                    owned.push_back(std::make_shared<chunk>(chunk{*resource}));
+                    chunks_.push_back(owned.back());
+                    size_ = 1;
+                }
+                return;
+            }
+
+            // First chunk ending at or after uri; anything past the end goes in the last one
+            auto found = std::lower_bound(chunks_.begin(), chunks_.end(), uri,
+                [](const std::shared_ptr<const chunk>& c, const std::string& key) { return c->back().uri < key; });
+            const size_t index = std::min(static_cast<size_t>(found - chunks_.begin()), chunks_.size() - 1);
+            const chunk& current = *chunks_[index];
+            auto at = std::lower_bound(current.begin(), current.end(), uri,
+                [](const Resource& r, const std::string& key) { return r.uri < key; });
+            const size_t offset = static_cast<size_t>(at - current.begin());
+            const bool present = at != current.end() && at->uri == uri;
+            if (!resource && !present) {
+                return;
+            }
+
+            if (!owned[index]) {
+                owned[index] = std::make_shared<chunk>(current);
+                chunks_[index] = owned[index];
+            }
+            auto& items = *owned[index];
+
+            if (!resource) {
+                items.erase(items.begin() + static_cast<std::ptrdiff_t>(offset));
+                --size_;
+                if (items.empty()) {
+                    chunks_.erase(chunks_.begin() + static_cast<std::ptrdiff_t>(index));
+                    owned.erase(owned.begin() + static_cast<std::ptrdiff_t>(index));
+                }
+            } else if (present) {
+                items[offset] = *resource;
+            } else {
+                items.insert(items.begin() + static_cast<std::ptrdiff_t>(offset), *resource);
+                ++size_;
+                if (items.size() > 2 * chunk_size) {
+                    auto upper = std::make_shared<chunk>(items.begin() + chunk_size, items.end());
+                    items.resize(chunk_size);
+                    chunks_.insert(chunks_.begin() + static_cast<std::ptrdiff_t>(index) + 1, upper);
+                    owned.insert(owned.begin() + static_cast<std::ptrdiff_t>(index) + 1, std::move(upper));
+                }
+            }
+        }
+
+        chunk_table chunks_;
+        size_t size_ = 0;
+    };
+
     /**
      * @brief File resource server with RAII file operations
      * 
@@ -75,15 +302,32 @@ namespace pooriayousefi::mcp::helpers
      * - Automatic MIME type detection
      * - Safe file reading with RAII
      * - Directory listing
-     * - Streaming for large files
+     * - Memory-mapped reads through a bounded window
+     * - Byte ranges: `resources/read` accepts `offset`/`length`, or
+     *   `range: {"start", "end"}` (end exclusive); the result's `range`
+     *   member reports the bytes actually returned and the file's `total` size
+     * - Partial results: with a `partialResultToken`, each window is sent as
+     *   soon as it is mapped instead of being collected
      * - Path traversal protection
+     * - An index kept current by watch() (inotify, or polling): changes are
+     *   applied as deltas, and `resources/list` reads an immutable snapshot,
+     *   so it never waits for a scan; each batch copies only the snapshot
+     *   chunks and rebuilds only the cached list pages it touches
+     * - An optional read cache (enable_cache()) keyed by file identity
+     *   (device, inode, mtime, size) and range, so a rewritten file is
+     *   never served stale
+     * 
+     * Text ranges are snapped to UTF-8 character boundaries, so the returned
+     * `range` may start a little later or end a little earlier than requested;
+     * continue paging from `offset + length`. Blob ranges are exact, and each
+     * partial result's blob is encoded on its own.
      * 
      * @example
      * ```cpp
      * Server server(transport, impl);
      * FileResourceServer file_server(server, "/home/user/documents");
-     * file_server.enable_streaming(true);  // Stream large files
-     * file_server.set_max_file_size(10 * 1024 * 1024);  // 10MB limit
+     * file_server.enable_streaming(true);  // Progress per window
+     * file_server.set_max_file_size(10 * 1024 * 1024);  // 10MB per read
      * ```
      */
     class FileResourceServer {
@@ -103,76 +347,266 @@ namespace pooriayousefi::mcp::helpers
             , root_dir_(fs::absolute(root_directory))
             , url_prefix_(url_prefix)
             , max_file_size_(50 * 1024 * 1024) // 50MB default
+            , read_window_(4 * 1024 * 1024)
             , enable_streaming_(false)
+            , list_cache_("resources")
         {
             if (!fs::exists(root_dir_) || !fs::is_directory(root_dir_)) {
                 throw std::runtime_error("Root directory does not exist: " + root_directory);
             }
+            root_dir_ = fs::canonical(root_dir_);
 
             register_resources();
         }
 
         /**
-         * @brief Set maximum file size to serve (bytes)
+         * @brief Set the maximum number of bytes one read may return
+         *
+         * Larger files can still be read a range at a time.
          */
         void set_max_file_size(size_t max_bytes) {
             max_file_size_ = max_bytes;
         }
 
         /**
-         * @brief Enable/disable streaming for large files
+         * @brief Set how much of a file is mapped at once (rounded up to whole pages)
+         */
+        void set_read_window(size_t bytes) {
+            const size_t page = core::MappedFile::page_size();
+            read_window_ = std::max(page, (bytes + page - 1) / page * page);
+        }
+
+        /**
+         * @brief Enable/disable progress notifications for each window read
          */
         void enable_streaming(bool enable) {
             enable_streaming_ = enable;
         }
 
+        /**
+         * @brief Keep `resources/read` results in memory
+         * @param max_bytes Estimated size of all cached results; least recently used go first
+         * @param ttl How long a result stays valid; 0 keeps it while the file is unchanged
+         *
+         * Concurrent reads of the same range are coalesced into one. Reads that
+         * send partial results or progress (enable_streaming()) bypass the cache.
+         */
+        void enable_cache(size_t max_bytes = 64u << 20, std::chrono::milliseconds ttl = std::chrono::milliseconds(0)) {
+            cache_ttl_ = ttl;
+            if (cache_) {
+                cache_->set_max_bytes(max_bytes);
+            } else {
+                cache_ = std::make_unique<core::ResultCache<json>>(max_bytes);
+            }
+        }
+
+        /**
+         * @brief Counters of the read cache (all zero when it is not enabled)
+         */
+        core::ResultCacheStats cache_stats() const {
+            return cache_ ? cache_->stats() : core::ResultCacheStats{};
+        }
+
+        /**
+         * @brief Stops watching before the index goes away
+         */
+        ~FileResourceServer() {
+            stop_watching();
+        }
+
         /**
          * @brief List all files in root directory
          * @return Vector of Resource definitions
+         *
+         * Walks the whole tree; `resources/list` uses the index instead.
          */
-        std::vector<Resource> list_files() {
+        std::vector<Resource> list_files() const {
             std::vector<Resource> resources;
-            
-            for (const auto& entry : fs::recursive_directory_iterator(root_dir_)) {
-                if (entry.is_regular_file()) {
-                    std::string rel_path = fs::relative(entry.path(), root_dir_).string();
-                    std::string uri = url_prefix_ + rel_path;
-                    
-                    resources.push_back(Resource{
-                        uri,
-                        entry.path().filename().string(),
-                        "File: " + rel_path,
-                        detect_mime_type(entry.path().string())
-                    });
-                }
+            for (auto& [key, resource] : scan()) {
+                resources.push_back(std::move(resource));
             }
-            
             return resources;
         }
 
         /**
-         * @brief Refresh resource list (call after files change)
+         * @brief Rebuild the index with a full scan (call after files change when not watching)
+         *
+         * The scan runs without blocking `resources/list`, which keeps serving
+         * the previous snapshot until the new one is published.
          */
         void refresh() {
+            auto fresh = scan();
             std::lock_guard<std::mutex> lock(mutex_);
-            cached_resources_ = list_files();
+            index_ = std::move(fresh);
+            publish();
+        }
+
+        /**
+         * @brief Keep the index current as files are added, removed or renamed
+         * @param options Debounce and polling settings; inotify is used when available
+         * @param notify Send notifications/resources/list_changed after each batch of changes
+         *
+         * Each settled burst of changes is applied to the index as deltas and
+         * published as one new snapshot, followed by at most one notification.
+         * The new snapshot shares every chunk the burst did not touch with the
+         * previous one (see ResourceSnapshot), and only the `resources/list`
+         * pages the changed URIs fall in are rebuilt.
+         */
+        void watch(core::DirectoryWatcherOptions options = {}, bool notify = true) {
+            stop_watching();
+            notify_changes_ = notify;
+            watcher_ = std::make_unique<core::DirectoryWatcher>(
+                root_dir_,
+                [this](std::vector<core::DirectoryWatcher::Event>&& events) { apply(events); },
+                options
+            );
+            // Files that changed before the watch started
+            refresh();
+        }
+
+        /**
+         * @brief Stop keeping the index current
+         */
+        void stop_watching() {
+            watcher_.reset();
+        }
+
+        /**
+         * @brief True while watch() is active; using_inotify() tells which backend
+         */
+        bool is_watching() const {
+            return watcher_ != nullptr;
+        }
+
+        bool using_inotify() const {
+            return watcher_ && watcher_->using_inotify();
+        }
+
+        /**
+         * @brief The current resource list (sorted by path); never blocks on a scan
+         */
+        std::shared_ptr<const ResourceSnapshot> snapshot() const {
+            std::lock_guard<std::mutex> lock(snapshot_mutex_);
+            return snapshot_;
         }
 
     private:
+        Resource make_resource(const std::string& rel_path) const {
+            fs::path path(rel_path);
+            return Resource{
+                url_prefix_ + rel_path,
+                path.filename().string(),
+                "File: " + rel_path,
+                detect_mime_type(rel_path)
+            };
+        }
+
+        std::map<std::string, Resource> scan() const {
+            std::map<std::string, Resource> files;
+            std::error_code ec;
+            for (fs::recursive_directory_iterator it(root_dir_, fs::directory_options::skip_permission_denied, ec), end;
+                 !ec && it != end; it.increment(ec)) {
+                std::error_code stat_ec;
+                if (it->is_regular_file(stat_ec)) {
+                    std::string rel_path = fs::relative(it->path(), root_dir_, stat_ec).generic_string();
+                    files.emplace(rel_path, make_resource(rel_path));
+                }
+            }
+            return files;
+        }
+
+        // Called with mutex_ held: readers switch to the new list on their next call.
+        // The swap runs under the list cache's lock, so resources/list never pairs
+        // the new snapshot with pages of the old one.
+        void publish() {
+            auto list = std::make_shared<const ResourceSnapshot>(index_ | std::views::values);
+            list_cache_.invalidate([&] { swap_snapshot(std::move(list)); });
+        }
+
+        // Called with mutex_ held: publishes one batch of deltas without a full copy
+        void publish(const std::vector<ResourceSnapshot::change>& changes) {
+            auto list = snapshot()->with(changes);
+            std::vector<mcp::detail::list_cache::change> items;
+            items.reserve(changes.size());
+            for (const auto& [uri, resource] : changes) {
+                items.emplace_back(uri, resource ? std::optional<json>(resource->to_json()) : std::nullopt);
+            }
+            list_cache_.update(items, [&] { swap_snapshot(std::move(list)); });
+        }
+
+        void swap_snapshot(std::shared_ptr<const ResourceSnapshot> list) {
+            std::lock_guard<std::mutex> lock(snapshot_mutex_);
+            snapshot_ = std::move(list);
+        }
+
+        // Watcher thread: fold one debounced batch of changes into the index
+        void apply(const std::vector<core::DirectoryWatcher::Event>& events) {
+            using Change = core::DirectoryWatcher::Change;
+            bool rescanned = false;
+            std::vector<ResourceSnapshot::change> changes;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (const auto& event : events) {
+                    const std::string key = event.path.generic_string();
+                    switch (event.change) {
+                    case Change::rescan:
+                        index_ = scan();
+                        rescanned = true;
+                        break;
+                    case Change::added:
+                    case Change::modified: {
+                        forget_cached(key);
+                        std::error_code ec;
+                        if (!index_.contains(key) && fs::is_regular_file(root_dir_ / event.path, ec)) {
+                            const auto& resource = index_.emplace(key, make_resource(key)).first->second;
+                            changes.emplace_back(resource.uri, resource);
+                        }
+                        break;
+                    }
+                    case Change::removed:
+                        forget_cached(key);
+                        if (event.directory) {
+                            const std::string prefix = key + "/";
+                            for (auto it = index_.lower_bound(prefix); it != index_.end() && it->first.starts_with(prefix);) {
+                                changes.emplace_back(it->second.uri, std::nullopt);
+                                it = index_.erase(it);
+                            }
+                        } else if (auto it = index_.find(key); it != index_.end()) {
+                            changes.emplace_back(it->second.uri, std::nullopt);
+                            index_.erase(it);
+                        }
+                        break;
+                    }
+                }
+                // A rescan replaced the whole index; anything else is published as deltas
+                if (rescanned) {
+                    publish();
+                } else if (!changes.empty()) {
+                    publish(changes);
+                }
+            }
+            const bool changed = rescanned || !changes.empty();
+            if (changed && notify_changes_ && server_.is_initialized()) {
+                server_.notify_resources_changed();
+            }
+        }
+
         void register_resources() {
             // Cache initial file list
             refresh();
 
             // Register resources/list handler
-            server_.add("resources/list", [this](const json&) -> json {
-                std::lock_guard<std::mutex> lock(mutex_);
-                
-                json resources_array = json::array();
-                for (const auto& resource : cached_resources_) {
-                    resources_array.push_back(resource.to_json());
-                }
-                
-                return json{{"resources", resources_array}};
+            // Paginated by Server::set_page_size(), serialized once per snapshot
+            server_.add("resources/list", [this](const json& params) -> json {
+                return list_cache_.page(params, server_.page_size(), [this]() {
+                    auto resources = snapshot();
+                    std::vector<mcp::detail::list_cache::entry> entries;
+                    entries.reserve(resources->size());
+                    for (const auto& resource : *resources) {
+                        entries.emplace_back(resource.uri, resource.to_json());
+                    }
+                    return entries;
+                }, server_.encoded_results());
             });
 
             // Register resources/read handler
@@ -184,32 +618,54 @@ namespace pooriayousefi::mcp::helpers
                     });
                 }
 
-                auto contents = read_file_resource(uri);
-                
-                json contents_array = json::array();
-                for (const auto& content : contents) {
-                    contents_array.push_back(content.to_json());
-                }
-                
-                return json{{"contents", contents_array}};
+                return read_file_resource(uri, params);
             });
         }
 
-        std::vector<ResourceContent> read_file_resource(const std::string& uri) {
+        // Byte range requested by resources/read params: [offset, offset + length)
+        static std::pair<size_t, size_t> requested_range(const json& params) {
+            auto bytes = [](const json& value) -> size_t {
+                if (!value.is_number_integer() || value.get<int64_t>() < 0) {
+                    throw jsonrpc::rpc_exception(jsonrpc::error{
+                        -32602, "Invalid range", nullptr
+                    });
+                }
+                return value.get<size_t>();
+            };
+
+            size_t offset = 0;
+            size_t length = std::numeric_limits<size_t>::max();
+            if (params.contains("range") && params["range"].is_object()) {
+                const auto& range = params["range"];
+                offset = range.contains("start") ? bytes(range["start"]) : 0;
+                if (range.contains("end")) {
+                    size_t end = bytes(range["end"]);
+                    if (end < offset) {
+                        throw jsonrpc::rpc_exception(jsonrpc::error{
+                            -32602, "Invalid range", nullptr
+                        });
+                    }
+                    length = end - offset;
+                }
+            } else {
+                if (params.contains("offset")) offset = bytes(params["offset"]);
+                if (params.contains("length")) length = bytes(params["length"]);
+            }
+            return {offset, length};
+        }
+
+        json read_file_resource(const std::string& uri, const json& params) {
             // Parse URI to path
-            std::string rel_path = parse_file_uri(uri);
+            std::string rel_path = uri;
             if (rel_path.substr(0, url_prefix_.size()) == url_prefix_) {
                 rel_path = rel_path.substr(url_prefix_.size());
+            } else {
+                rel_path = parse_file_uri(rel_path);
             }
 
-            // Resolve to absolute path
-            fs::path abs_path = root_dir_ / rel_path;
-            abs_path = fs::absolute(abs_path);
-
             // Security: Ensure path is within root directory (prevent traversal)
-            std::string abs_path_str = abs_path.string();
-            std::string root_str = root_dir_.string();
-            if (abs_path_str.substr(0, root_str.size()) != root_str) {
+            fs::path abs_path = resolve_within(root_dir_, rel_path);
+            if (abs_path.empty()) {
                 throw jsonrpc::rpc_exception(jsonrpc::error{
                     -32602, "Path traversal not allowed", nullptr
                 });
@@ -222,76 +678,181 @@ namespace pooriayousefi::mcp::helpers
                 });
             }
 
-            // Check file size
-            size_t file_size = fs::file_size(abs_path);
-            if (file_size > max_file_size_) {
+            // The same range of the same file version: uri, device, inode, mtime, size
+            struct stat info;
+            if (cache_ && !enable_streaming_ && !jsonrpc::has_partial_result_token() && ::stat(abs_path.c_str(), &info) == 0) {
+                auto [offset, length] = requested_range(params);
+                std::string key = uri;
+                key.append("\n").append(std::to_string(info.st_dev)).append(":").append(std::to_string(info.st_ino))
+                   .append(":").append(std::to_string(info.st_mtim.tv_sec)).append(".").append(std::to_string(info.st_mtim.tv_nsec))
+                   .append(":").append(std::to_string(info.st_size))
+                   .append("\n").append(std::to_string(offset)).append("+").append(std::to_string(length))
+                   .push_back(server_.encoded_results() ? 'e' : server_.encoding() != transport::Encoding::json ? 'b' : 'j');
+                return *cache_->get_or_compute(key, [&] {
+                    return read_mapped(uri, abs_path, rel_path, params);
+                }, mcp::detail::approximate_size, cache_ttl_);
+            }
+            return read_mapped(uri, abs_path, rel_path, params);
+        }
+
+        // Drops cached reads of a file, or of everything below a directory
+        void forget_cached(const std::string& rel_path) {
+            if (!cache_) return;
+            const std::string prefix = url_prefix_ + rel_path;
+            cache_->erase_if([&prefix](std::string_view key) {
+                return key.starts_with(prefix) && key.size() > prefix.size() && (key[prefix.size()] == '\n' || key[prefix.size()] == '/');
+            });
+        }
+
+        json read_mapped(const std::string& uri, const fs::path& abs_path, const std::string& rel_path, const json& params) {
+            // Mapped window by window, closed by RAII
+            core::MappedFile file;
+            try {
+                file.open(abs_path);
+            } catch (const std::exception&) {
                 throw jsonrpc::rpc_exception(jsonrpc::error{
-                    -32603, "File too large (max " + std::to_string(max_file_size_) + " bytes)", nullptr
+                    -32603, "Failed to open file: " + rel_path, nullptr
                 });
             }
 
-            // Use RAII file wrapper for safe reading
-            core::RAIIInputFileStream file(abs_path.string());
-            
-            if (!file.is_open()) {
+            const size_t file_size = file.size();
+            auto [offset, length] = requested_range(params);
+            if (offset > file_size) {
                 throw jsonrpc::rpc_exception(jsonrpc::error{
-                    -32603, "Failed to open file: " + rel_path, nullptr
+                    -32602, "Range starts past end of file (" + std::to_string(file_size) + " bytes)", nullptr
+                });
+            }
+            length = std::min(length, file_size - offset);
+            if (length > max_file_size_) {
+                throw jsonrpc::rpc_exception(jsonrpc::error{
+                    -32603, "File too large (max " + std::to_string(max_file_size_) + " bytes per read; request a range)", nullptr
                 });
             }
 
-            // Read file content
-            std::string content;
-            
-            if (enable_streaming_ && file_size > 1024 * 1024) { // 1MB threshold
-                // Stream large files in chunks
-                const size_t chunk_size = 64 * 1024; // 64KB chunks
-                content.reserve(file_size);
-                
-                char buffer[chunk_size];
-                while (file.stream().read(buffer, chunk_size) || file.stream().gcount() > 0) {
-                    content.append(buffer, file.stream().gcount());
-                    
-                    // Report progress
-                    if (auto ctx = jsonrpc::current_context()) {
-                        double progress = (double)content.size() / file_size;
-                        jsonrpc::report_progress({
-                            {"progress", progress},
-                            {"bytes_read", content.size()},
-                            {"total_bytes", file_size}
-                        });
-                    }
-                    
-                    // Check cancellation
-                    if (jsonrpc::is_canceled()) {
-                        throw jsonrpc::rpc_exception(jsonrpc::error{
-                            -32800, "Read cancelled", nullptr
-                        });
-                    }
+            const std::string mime_type = detect_mime_type(abs_path.string());
+            const bool text = is_text_mime_type(mime_type);
+            const bool partial = jsonrpc::has_partial_result_token();
+            const bool encoded = !partial && server_.encoded_results();
+            const bool raw_blobs = server_.encoding() != transport::Encoding::json;
+            const size_t end = offset + length;
+            size_t start = offset;
+            size_t sent = 0;
+
+            // Where the bytes go: escaped or base64-encoded straight into the
+            // encoded result, into one string for a json result, or one chunk
+            // per window for partial results
+            jsonrpc::encoded_buffer out;
+            std::optional<ResourceContentWriter> writer;
+            std::string data;
+            if (encoded) {
+                out.reserve(256 + uri.size() + (text ? length + length / 8 : (length + 2) / 3 * 4));
+                jsonrpc::append_raw(out, "{\"contents\":[");
+                writer.emplace(out, uri, mime_type, !text);
+            } else if (!partial) {
+                data.reserve(length);
+            }
+            auto content = [&](std::string bytes) {
+                json item = {{"uri", uri}, {"mimeType", mime_type}};
+                if (text) item["text"] = std::move(bytes);
+                else if (raw_blobs) item["blob"] = json::binary(json::binary_t::container_type(bytes.begin(), bytes.end()));
+                else item["blob"] = core::base64_encode(bytes);
+                return item;
+            };
+
+            std::string carry; // bytes of a character split across two windows
+            for (size_t pos = offset; pos < end; pos += read_window_) {
+                std::string_view window = file.map(pos, std::min(read_window_, end - pos));
+                if (pos == offset && text) {
+                    size_t skip = detail::utf8_leading_continuation(window);
+                    window.remove_prefix(skip);
+                    start += skip;
+                }
+                const bool last = pos + read_window_ >= end;
+
+                // Finish the character the last window split, then hold back one this window splits
+                if (!carry.empty()) {
+                    const auto lead = static_cast<unsigned char>(carry.front());
+                    const size_t needed = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+                    const size_t missing = std::min(window.size(), needed - carry.size());
+                    carry.append(window.substr(0, missing));
+                    window.remove_prefix(missing);
+                }
+                const size_t tail = !text || (last && end == file_size) ? 0 : detail::utf8_incomplete_tail(window);
+                const std::string_view body = window.substr(0, window.size() - tail);
+
+                if (partial) {
+                    std::string chunk = carry;
+                    chunk.append(body);
+                    sent += chunk.size();
+                    jsonrpc::report_partial_result({{"contents", json::array({content(std::move(chunk))})}});
+                } else if (encoded) {
+                    writer->append(carry);
+                    writer->append(body);
+                    sent += carry.size() + body.size();
+                } else {
+                    data.append(carry);
+                    data.append(body);
+                }
+                carry.assign(window.substr(body.size()));
+                file.unmap();
+
+                if (enable_streaming_) {
+                    size_t done = std::min(end, pos + read_window_) - offset;
+                    jsonrpc::report_progress({
+                        {"progress", length > 0 ? (double)done / length : 1.0},
+                        {"bytes_read", done},
+                        {"total_bytes", length}
+                    });
+                }
+
+                // Check cancellation
+                if (jsonrpc::is_canceled()) {
+                    throw jsonrpc::rpc_exception(jsonrpc::error{
+                        -32800, "Read cancelled", nullptr
+                    });
                 }
-            } else {
-                // Read small files at once
-                content = file.read_all();
             }
 
-            // File automatically closed by RAII wrapper
+            if (encoded) {
+                // {"contents":[...],"range":{...}}, keys in dump() order
+                writer->finish();
+                jsonrpc::append_raw(out, "],\"range\":{\"length\":");
+                jsonrpc::append_value(out, sent);
+                jsonrpc::append_raw(out, ",\"offset\":");
+                jsonrpc::append_value(out, start);
+                jsonrpc::append_raw(out, ",\"total\":");
+                jsonrpc::append_value(out, file_size);
+                jsonrpc::append_raw(out, "}}");
+                return jsonrpc::encoded(std::move(out));
+            }
 
-            std::string mime_type = detect_mime_type(abs_path.string());
+            json contents = json::array();
+            if (!partial) {
+                sent = data.size();
+                contents.push_back(content(std::move(data)));
+            }
 
-            return {ResourceContent{
-                uri,
-                mime_type,
-                content,
-                std::nullopt // blob (for binary files in future)
-            }};
+            return json{
+                {"contents", std::move(contents)},
+                {"range", {{"offset", start}, {"length", sent}, {"total", file_size}}}
+            };
         }
 
         Server& server_;
         fs::path root_dir_;
         std::string url_prefix_;
         size_t max_file_size_;
+        size_t read_window_;
         bool enable_streaming_;
-        std::vector<Resource> cached_resources_;
+        std::map<std::string, Resource> index_;  // by relative path; guarded by mutex_ (writers only)
+        std::shared_ptr<const ResourceSnapshot> snapshot_;
+        std::unique_ptr<core::DirectoryWatcher> watcher_;
+        bool notify_changes_ = true;
         std::mutex mutex_;
+        mutable std::mutex snapshot_mutex_; // held only to copy or swap snapshot_
+        mcp::detail::list_cache list_cache_;  // resources/list pages of snapshot_
+        std::unique_ptr<core::ResultCache<json>> cache_; // resources/read results, see enable_cache()
+        std::chrono::milliseconds cache_ttl_{0};
     };
 
     /**
@@ -300,6 +861,12 @@ namespace pooriayousefi::mcp::helpers
      * Extended version using StreamingServer for true streaming of large files
      * without loading entire file into memory.
      * 
+     * Nothing is registered per file: one resource template (`<prefix>{path}`)
+     * resolves any URI under the root when it is read, so construction does not
+     * walk the tree. Files are streamed as fixed-size chunks (64KB by default)
+     * through one reused buffer: text chunks snapped to UTF-8 character
+     * boundaries, and blob chunks for files whose MIME type is not text.
+     * 
      * @example
      * ```cpp
      * StreamingServer server(transport, impl);
@@ -317,72 +884,92 @@ namespace pooriayousefi::mcp::helpers
             : server_(server)
             , root_dir_(fs::absolute(root_directory))
             , url_prefix_(url_prefix)
+            , chunk_size_(64 * 1024)
         {
             if (!fs::exists(root_dir_) || !fs::is_directory(root_dir_)) {
                 throw std::runtime_error("Root directory does not exist: " + root_directory);
             }
+            root_dir_ = fs::canonical(root_dir_);
 
             register_streaming_resources();
         }
 
+        /**
+         * @brief Set the number of bytes read per chunk (at least 4, one UTF-8 character)
+         *
+         * Binary files are read in the largest multiple of 3 bytes that fits.
+         */
+        void set_chunk_size(size_t bytes) {
+            chunk_size_ = std::max<size_t>(4, bytes);
+        }
+
     private:
         void register_streaming_resources() {
-            // Register each file as a streaming resource
-            for (const auto& entry : fs::recursive_directory_iterator(root_dir_)) {
-                if (entry.is_regular_file()) {
-                    std::string rel_path = fs::relative(entry.path(), root_dir_).string();
-                    std::string uri = url_prefix_ + rel_path;
-                    
-                    Resource resource{
-                        uri,
-                        entry.path().filename().string(),
-                        "File: " + rel_path,
-                        detect_mime_type(entry.path().string())
-                    };
-
-                    // Register with streaming reader
-                    server_.register_streaming_resource(
-                        resource,
-                        [this](const std::string& uri) {
-                            return stream_file_content(uri);
-                        }
-                    );
+            server_.register_streaming_resource_template(
+                ResourceTemplate{
+                    url_prefix_ + "{path}",
+                    "Files",
+                    "Files under " + root_dir_.string(),
+                    std::nullopt
+                },
+                [this](const std::string& uri) {
+                    return stream_file_content(uri);
                 }
-            }
+            );
         }
 
-        Generator<ResourceContent> stream_file_content(const std::string& uri) {
-            std::string rel_path = parse_file_uri(uri);
+        Generator<ResourceContent> stream_file_content(std::string uri) {
+            std::string rel_path = uri;
             if (rel_path.substr(0, url_prefix_.size()) == url_prefix_) {
                 rel_path = rel_path.substr(url_prefix_.size());
+            } else {
+                rel_path = parse_file_uri(rel_path);
             }
 
-            fs::path abs_path = root_dir_ / rel_path;
-            abs_path = fs::absolute(abs_path);
-
             // Security check
-            if (abs_path.string().substr(0, root_dir_.string().size()) != root_dir_.string()) {
-                co_return; // Path traversal attempt
+            fs::path abs_path = resolve_within(root_dir_, rel_path);
+            std::error_code ec;
+            if (abs_path.empty() || !fs::is_regular_file(abs_path, ec)) {
+                co_return; // Path traversal attempt or not a file
             }
 
             // Use RAII file wrapper
-            core::RAIIInputFileStream file(abs_path.string());
-            
-            if (!file.is_open()) {
+            core::raii::native::narrow_encoded::InputFileStreamWrapper file;
+            try {
+                file.open(abs_path, std::ios_base::binary);
+            } catch (const std::exception&) {
                 co_return;
             }
 
-            // Stream file line-by-line
-            std::string line;
+            // One chunk object for the whole stream, yielded by reference: its uri and
+            // mime type are set once and its buffer keeps its capacity. Text goes in
+            // `text`, split on UTF-8 boundaries; anything else goes in `bytes` (a
+            // blob), in multiples of 3 bytes so the chunks' base64 concatenates to
+            // the whole file's
             std::string mime_type = detect_mime_type(abs_path.string());
-            
-            while (std::getline(file.stream(), line)) {
-                co_yield ResourceContent{
-                    uri,
-                    mime_type,
-                    line + "\n",
-                    std::nullopt
-                };
+            const bool is_text = is_text_mime_type(mime_type);
+            const size_t chunk_size = is_text ? chunk_size_ : std::max<size_t>(3, chunk_size_ / 3 * 3);
+            ResourceContent content{std::move(uri), std::move(mime_type), std::nullopt, std::nullopt};
+            std::string& data = is_text ? content.text.emplace() : content.bytes.emplace();
+            data.reserve(chunk_size + 4);
+            std::string carry; // bytes of a character split across two chunks
+
+            while (file.file_stream) {
+                data.assign(carry);
+                const size_t kept = data.size();
+                data.resize(kept + chunk_size);
+                file.file_stream.read(data.data() + kept, static_cast<std::streamsize>(chunk_size));
+                data.resize(kept + static_cast<size_t>(file.file_stream.gcount()));
+                if (data.empty()) {
+                    break;
+                }
+
+                if (is_text) {
+                    const size_t tail = file.file_stream ? detail::utf8_incomplete_tail(data) : 0;
+                    carry.assign(data, data.size() - tail, tail);
+                    data.resize(data.size() - tail);
+                }
+                co_yield content;
                 
                 // Check for cancellation
                 if (jsonrpc::is_canceled()) {
@@ -396,6 +983,7 @@ namespace pooriayousefi::mcp::helpers
         StreamingServer& server_;
         fs::path root_dir_;
         std::string url_prefix_;
+        size_t chunk_size_;
     };
 
 } // namespace pooriayousefi::mcp::helpers
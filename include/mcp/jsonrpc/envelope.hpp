@@ -0,0 +1,213 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <optional>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Structural scan of a JSON-RPC message: finds the top-level members of an object
+// and their raw text without building a json tree, so routing decisions (and the
+// validation checks below) can be made before, or instead of, a full parse.
+// Strings are skipped 16 bytes at a time with SSE2 where available, 8 bytes at a
+// time otherwise. The scan checks structure only; members that are kept are
+// still parsed (and validated) by nlohmann::json.
+
+namespace pooriayousefi::mcp::jsonrpc
+{
+
+    // Raw text of each top-level member, including quotes for strings; empty when absent.
+    // The views point into the scanned text, which must outlive the envelope.
+    struct envelope
+    {
+        std::string_view jsonrpc;
+        std::string_view id;
+        std::string_view method;
+        std::string_view params;
+        std::string_view result;
+        std::string_view error;
+
+        // Contents of a string member without its quotes; nullopt when the member is not
+        // a string or contains escapes (compare those after a full parse)
+        static std::optional<std::string_view> plain_string(std::string_view raw)
+        {
+            if (raw.size() < 2 || raw.front() != '"' || raw.back() != '"') return std::nullopt;
+            raw = raw.substr(1, raw.size() - 2);
+            if (raw.find('\\') != std::string_view::npos) return std::nullopt;
+            return raw;
+        }
+
+        std::optional<std::string_view> method_name() const { return plain_string(method); }
+    };
+
+    namespace detail
+    {
+        inline bool is_json_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+        inline const char* skip_space(const char* p, const char* end)
+        {
+            while (p < end && is_json_space(*p)) ++p;
+            return p;
+        }
+
+        // First '"' or '\\' in [p, end), or end
+        inline const char* find_quote_or_escape(const char* p, const char* end)
+        {
+#if defined(__SSE2__)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i escape = _mm_set1_epi8('\\');
+            while (end - p >= 16)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+                unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, escape))));
+                if (mask) return p + std::countr_zero(mask);
+                p += 16;
+            }
+#endif
+            if constexpr (std::endian::native == std::endian::little)
+            {
+                // Bytes equal to '"' or '\\' become zero; the lowest flagged byte is exact
+                constexpr uint64_t ones = 0x0101010101010101ull;
+                constexpr uint64_t highs = 0x8080808080808080ull;
+                while (end - p >= 8)
+                {
+                    uint64_t word;
+                    std::memcpy(&word, p, sizeof(word));
+                    uint64_t q = word ^ (ones * '"');
+                    uint64_t e = word ^ (ones * '\\');
+                    uint64_t mask = ((q - ones) & ~q & highs) | ((e - ones) & ~e & highs);
+                    if (mask) return p + (std::countr_zero(mask) >> 3);
+                    p += 8;
+                }
+            }
+            while (p < end && *p != '"' && *p != '\\') ++p;
+            return p;
+        }
+
+        // p is at an opening quote; returns the position after the closing quote, or nullptr
+        inline const char* skip_string(const char* p, const char* end, bool* escaped = nullptr)
+        {
+            ++p;
+            while (true)
+            {
+                p = find_quote_or_escape(p, end);
+                if (p == end) return nullptr;
+                if (*p == '"') return p + 1;
+                if (escaped) *escaped = true;
+                if (end - p < 2) return nullptr;
+                p += 2;
+            }
+        }
+
+        // Position after the value starting at p, or nullptr when it is cut off
+        inline const char* skip_value(const char* p, const char* end)
+        {
+            if (p == end) return nullptr;
+            if (*p == '"') return skip_string(p, end);
+            if (*p == '{' || *p == '[')
+            {
+                size_t depth = 0;
+                while (p < end)
+                {
+                    const char c = *p;
+                    if (c == '"')
+                    {
+                        p = skip_string(p, end);
+                        if (!p) return nullptr;
+                        continue;
+                    }
+                    if (c == '{' || c == '[') ++depth;
+                    else if ((c == '}' || c == ']') && --depth == 0) return p + 1;
+                    ++p;
+                }
+                return nullptr;
+            }
+            const char* start = p;
+            while (p < end && *p != ',' && *p != '}' && *p != ']' && !is_json_space(*p)) ++p;
+            return p == start ? nullptr : p;
+        }
+    }
+
+    // Members of the single message in text. nullopt for batches, non-objects, truncated
+    // text and escaped member names: callers then fall back to a full parse.
+    inline std::optional<envelope> scan_envelope(std::string_view text)
+    {
+        const char* p = detail::skip_space(text.data(), text.data() + text.size());
+        const char* end = text.data() + text.size();
+        if (p == end || *p != '{') return std::nullopt;
+        p = detail::skip_space(p + 1, end);
+        envelope e;
+        if (p < end && *p == '}') return detail::skip_space(p + 1, end) == end ? std::optional<envelope>(e) : std::nullopt;
+        while (p < end)
+        {
+            if (*p != '"') return std::nullopt;
+            bool escaped = false;
+            const char* key_end = detail::skip_string(p, end, &escaped);
+            if (!key_end || escaped) return std::nullopt;
+            std::string_view key(p + 1, static_cast<size_t>(key_end - p - 2));
+            p = detail::skip_space(key_end, end);
+            if (p == end || *p != ':') return std::nullopt;
+            p = detail::skip_space(p + 1, end);
+            const char* value_end = detail::skip_value(p, end);
+            if (!value_end) return std::nullopt;
+            std::string_view value(p, static_cast<size_t>(value_end - p));
+            if (key == "jsonrpc") e.jsonrpc = value;
+            else if (key == "id") e.id = value;
+            else if (key == "method") e.method = value;
+            else if (key == "params") e.params = value;
+            else if (key == "result") e.result = value;
+            else if (key == "error") e.error = value;
+            p = detail::skip_space(value_end, end);
+            if (p == end) return std::nullopt;
+            if (*p == '}') 
+            {
+                if (detail::skip_space(p + 1, end) != end) return std::nullopt;
+                return e;
+            }
+            if (*p != ',') return std::nullopt;
+            p = detail::skip_space(p + 1, end);
+        }
+        return std::nullopt;
+    }
+
+    // The checks from jsonrpc.hpp, answered from a scan. Escaped strings are compared the
+    // way they are written, so "2.0" spelled with \u escapes is treated as invalid here.
+    inline bool is_request(const envelope& e)
+    {
+        return e.jsonrpc == "\"2.0\"" && !e.method.empty() && e.result.empty() && e.error.empty();
+    }
+
+    inline bool is_notification(const envelope& e)
+    {
+        return is_request(e) && e.id.empty();
+    }
+
+    inline bool is_response(const envelope& e)
+    {
+        return e.jsonrpc == "\"2.0\"" && !e.id.empty() && (e.result.empty() != e.error.empty());
+    }
+
+    inline bool valid_raw_id(std::string_view raw_id)
+    {
+        if (raw_id == "null" || raw_id.front() == '"') return true;
+        if (raw_id.front() != '-' && (raw_id.front() < '0' || raw_id.front() > '9')) return false;
+        return raw_id.find_first_of(".eE") == std::string_view::npos;
+    }
+
+    inline bool validate_request(
+        const envelope& e,
+        std::string* why = nullptr
+    )
+    {
+        if (e.jsonrpc != "\"2.0\"") { if (why) *why = "jsonrpc != 2.0"; return false; }
+        if (e.method.empty() || e.method.front() != '"') { if (why) *why = "method missing or not string"; return false; }
+        if (!e.id.empty() && !valid_raw_id(e.id)) { if (why) *why = "invalid id type"; return false; }
+        if (!e.params.empty() && e.params.front() != '[' && e.params.front() != '{') { if (why) *why = "params must be array or object"; return false; }
+        return true;
+    }
+
+} // namespace pooriayousefi::mcp::jsonrpc
@@ -11,9 +11,25 @@
 #include <sstream>
 #include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <array>
+#include <charconv>
+#include <string_view>
+#include <utility>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
 
 // Use bundled nlohmann json.hpp
 #include "json.hpp"
+#include "envelope.hpp"
+#include "../core/threadpool.hpp"
+#include "../core/timerwheel.hpp"
+#include "../core/functionref.hpp"
+#include "../core/metrics.hpp"
 
 // JSON-RPC 2.0 implementation using nlohmann::json
 // https://www.jsonrpc.org/specification
@@ -51,6 +67,7 @@ namespace pooriayousefi::mcp::jsonrpc
     static const error invalid_params{-32602, "Invalid params", nullptr};
     static const error internal_error{-32603, "Internal error", nullptr};
     static const error request_cancelled{-32800, "Request cancelled", nullptr};
+    static const error request_timeout{-32001, "Request timed out", nullptr}; // reported locally when a deadline passes
 
     // Helpers to detect message flavors
     inline bool is_request(const json& j) 
@@ -135,20 +152,210 @@ namespace pooriayousefi::mcp::jsonrpc
         return make_request(nullptr, method, params);
     }
 
+    // Takes id and result by value: pass them with std::move and the subtrees are
+    // moved into the envelope instead of deep-copied
     inline json make_result(
-        const json& id, 
-        const json& result
+        json id, 
+        json result
     ) 
     {
-        return json{{"jsonrpc", "2.0"}, {"id", id}, {"result", result}};
+        json j = json::object();
+        j["jsonrpc"] = "2.0";
+        j["id"] = std::move(id);
+        j["result"] = std::move(result);
+        return j;
     }
 
     inline json make_error(
-        const json& id, 
+        json id, 
         const error& e
     ) 
     {
-        return json{{"jsonrpc", "2.0"}, {"id", id}, {"error", make_error_object(e)}};
+        json j = json::object();
+        j["jsonrpc"] = "2.0";
+        j["id"] = std::move(id);
+        j["error"] = make_error_object(e);
+        return j;
+    }
+
+    // --- Pre-encoded results ---
+    // A handler may return encoded(bytes) instead of building a json tree: the bytes (one
+    // complete JSON value) travel through dispatch as a binary value with a reserved subtype,
+    // and dump_into() copies them verbatim into the response envelope. Hand such messages
+    // only to transports that serialize with dump_into (Transport::accepts_encoded()).
+    using encoded_buffer = json::binary_t::container_type;
+    inline constexpr std::uint64_t encoded_subtype = 0x6a736f6e; // "json"
+
+    inline json encoded(encoded_buffer bytes) { return json::binary(std::move(bytes), encoded_subtype); }
+
+    inline bool is_encoded(const json& j) 
+    {
+        return j.is_binary() && j.get_binary().has_subtype() && j.get_binary().subtype() == encoded_subtype;
+    }
+
+    inline void append_raw(encoded_buffer& out, std::string_view bytes) 
+    {
+        out.insert(out.end(), bytes.begin(), bytes.end());
+    }
+
+    // Append the characters of s, escaped exactly as dump() escapes them, without the quotes;
+    // pieces of one string may be appended in turn as long as each holds whole characters
+    inline void append_escaped(encoded_buffer& out, std::string_view s) 
+    {
+        static constexpr char hex[] = "0123456789abcdef";
+        const size_t begin = out.size();
+        size_t run = 0; // start of the bytes not yet copied
+        for (size_t i = 0; i < s.size(); ++i) 
+        {
+            const auto c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x80) 
+            {
+                // Hand anything but well-formed UTF-8 to dump(), which rejects it the usual way
+                size_t n = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC2 ? 2 : 0;
+                bool valid = n != 0 && c <= 0xF4 && i + n <= s.size();
+                for (size_t k = 1; valid && k < n; ++k) valid = (static_cast<unsigned char>(s[i + k]) & 0xC0) == 0x80;
+                if (valid && n == 3) 
+                {
+                    auto c1 = static_cast<unsigned char>(s[i + 1]);
+                    valid = !(c == 0xE0 && c1 < 0xA0) && !(c == 0xED && c1 >= 0xA0);
+                }
+                if (valid && n == 4) 
+                {
+                    auto c1 = static_cast<unsigned char>(s[i + 1]);
+                    valid = !(c == 0xF0 && c1 < 0x90) && !(c == 0xF4 && c1 >= 0x90);
+                }
+                if (!valid) 
+                {
+                    out.resize(begin);
+                    const std::string quoted = json(std::string(s)).dump();
+                    append_raw(out, std::string_view(quoted).substr(1, quoted.size() - 2));
+                    return;
+                }
+                i += n - 1;
+                continue;
+            }
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+            append_raw(out, s.substr(run, i - run));
+            run = i + 1;
+            out.push_back('\\');
+            switch (c) 
+            {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '\b': out.push_back('b'); break;
+                case '\f': out.push_back('f'); break;
+                case '\n': out.push_back('n'); break;
+                case '\r': out.push_back('r'); break;
+                case '\t': out.push_back('t'); break;
+                default:
+                    append_raw(out, "u00");
+                    out.push_back(hex[c >> 4]);
+                    out.push_back(hex[c & 0xF]);
+            }
+        }
+        append_raw(out, s.substr(run));
+    }
+
+    // Append s as a quoted JSON string, escaped exactly as dump() escapes it
+    inline void append_string(encoded_buffer& out, std::string_view s) 
+    {
+        out.push_back('"');
+        append_escaped(out, s);
+        out.push_back('"');
+    }
+
+    inline void append_value(encoded_buffer& out, const json& value) 
+    {
+        if (value.is_string()) 
+        {
+            append_string(out, value.get_ref<const std::string&>());
+            return;
+        }
+        if (value.is_number_integer()) 
+        {
+            char digits[24];
+            auto [end, ec] = value.is_number_unsigned()
+                ? std::to_chars(digits, digits + sizeof(digits), value.get<uint64_t>())
+                : std::to_chars(digits, digits + sizeof(digits), value.get<int64_t>());
+            (void)ec;
+            out.insert(out.end(), digits, end);
+            return;
+        }
+        append_raw(out, value.dump());
+    }
+
+    // Replace encoded results in msg (or in each element of a batch) with their parsed trees,
+    // for consumers that read messages instead of serializing them
+    inline void expand_encoded(json& msg) 
+    {
+        if (msg.is_array()) 
+        {
+            for (auto& element : msg) expand_encoded(element);
+            return;
+        }
+        if (!msg.is_object()) return;
+        auto result = msg.find("result");
+        if (result != msg.end() && is_encoded(*result)) 
+        {
+            const auto& bytes = result->get_binary();
+            *result = json::parse(bytes.begin(), bytes.end());
+        }
+    }
+
+    namespace detail 
+    {
+        inline void dump_message(nlohmann::detail::serializer<json>& s, std::string& out, const json& j) 
+        {
+            if (j.is_array() && !j.empty()) 
+            {
+                out.push_back('[');
+                bool first = true;
+                for (const auto& element : j) 
+                {
+                    if (!first) out.push_back(',');
+                    first = false;
+                    dump_message(s, out, element);
+                }
+                out.push_back(']');
+                return;
+            }
+            auto result = j.is_object() ? j.find("result") : j.end();
+            if (result == j.end() || !is_encoded(*result)) 
+            {
+                s.dump(j, false, false, 0);
+                return;
+            }
+            // A response envelope around pre-encoded bytes; keys stay in dump() order
+            out.push_back('{');
+            bool first = true;
+            for (auto it = j.begin(); it != j.end(); ++it) 
+            {
+                if (!first) out.push_back(',');
+                first = false;
+                s.dump(json(it.key()), false, false, 0);
+                out.push_back(':');
+                if (it == result) 
+                {
+                    const auto& bytes = it->get_binary();
+                    out.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+                }
+                else 
+                {
+                    s.dump(*it, false, false, 0);
+                }
+            }
+            out.push_back('}');
+        }
+    }
+
+    // Serialize j into out, replacing its contents. out keeps its capacity, so a
+    // pooled buffer serves message after message without reallocating. Encoded
+    // results are written as their bytes.
+    inline void dump_into(const json& j, std::string& out)
+    {
+        out.clear();
+        nlohmann::detail::serializer<json> s(nlohmann::detail::output_adapter<char, std::string>(out), ' ', json::error_handler_t::strict);
+        detail::dump_message(s, out, j);
     }
 
     // rpc_exception allows handlers to intentionally return a specific JSON-RPC error
@@ -159,17 +366,118 @@ namespace pooriayousefi::mcp::jsonrpc
 
     [[noreturn]] inline void throw_rpc_error(error e) { throw rpc_exception(std::move(e)); }
 
+    namespace detail 
+    {
+        // Transparent hash: string-keyed maps using it (with std::equal_to<>) can be
+        // searched with a std::string_view or const char* without building a std::string
+        struct string_hash 
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+        };
+
+        template<class Value>
+        using string_map = std::unordered_map<std::string, Value, string_hash, std::equal_to<>>;
+
+        // Read-only table over a fixed key set with a collision-free (perfect) hash: a lookup
+        // is one seeded hash, one slot and one string compare. Keys and values are borrowed,
+        // so the table must be rebuilt whenever the map it was built from changes.
+        template<class Value>
+        class perfect_table 
+        {
+        public:
+            template<class Map>
+            void build(const Map& map) 
+            {
+                entries_.clear();
+                entries_.reserve(map.size());
+                for (const auto& [key, value] : map) entries_.push_back({std::string_view(key), &value});
+                size_t size = 2;
+                while (size < entries_.size() * 2) size *= 2;
+                for (;; size *= 2) 
+                {
+                    for (uint64_t seed = 1; seed <= 64; ++seed) 
+                    {
+                        if (place(size, seed)) return;
+                    }
+                }
+            }
+
+            const Value* find(std::string_view key) const 
+            {
+                if (slots_.empty()) return nullptr;
+                int32_t e = slots_[hash(key, seed_) & mask_];
+                if (e < 0 || entries_[static_cast<size_t>(e)].key != key) return nullptr;
+                return entries_[static_cast<size_t>(e)].value;
+            }
+
+        private:
+            struct entry 
+            {
+                std::string_view key;
+                const Value* value;
+            };
+
+            // FNV-1a with the seed folded into the offset basis
+            static uint64_t hash(std::string_view key, uint64_t seed) 
+            {
+                uint64_t h = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+                for (unsigned char c : key) { h ^= c; h *= 1099511628211ull; }
+                return h ^ (h >> 29);
+            }
+
+            bool place(size_t size, uint64_t seed) 
+            {
+                slots_.assign(size, -1);
+                for (size_t i = 0; i < entries_.size(); ++i) 
+                {
+                    int32_t& slot = slots_[hash(entries_[i].key, seed) & (size - 1)];
+                    if (slot >= 0) return false;
+                    slot = static_cast<int32_t>(i);
+                }
+                seed_ = seed;
+                mask_ = size - 1;
+                return true;
+            }
+
+            std::vector<entry> entries_;
+            std::vector<int32_t> slots_;
+            uint64_t seed_ = 0;
+            size_t mask_ = 0;
+        };
+    }
+
     // Dispatcher
     class dispatcher 
     {
     public:
         using handler_t = std::function<json(const json& params)>; // params may be array or object
 
+        dispatcher() : methods_(std::make_shared<const method_table>()) {}
+        // Tables are immutable once published, so copies share the current one
+        dispatcher(const dispatcher& other) : methods_(other.methods_.load(std::memory_order_acquire)) {}
+        dispatcher& operator=(const dispatcher& other) 
+        {
+            if (this != &other) methods_.store(other.methods_.load(std::memory_order_acquire), std::memory_order_release);
+            return *this;
+        }
+        dispatcher(dispatcher&& other) : dispatcher(static_cast<const dispatcher&>(other)) {}
+        dispatcher& operator=(dispatcher&& other) { return *this = static_cast<const dispatcher&>(other); }
+
+        // Builds a new table and publishes it atomically, so methods may be added while
+        // serving; dispatches already running keep the table they started with
         void add(const std::string& method, handler_t fn) 
         {
-            handlers_[method] = std::move(fn);
+            std::lock_guard<std::mutex> lock(add_mutex_);
+            auto next = std::make_shared<method_table>();
+            next->handlers = methods_.load(std::memory_order_acquire)->handlers;
+            next->handlers.insert_or_assign(method, std::make_shared<const handler_t>(std::move(fn)));
+            next->lookup.build(next->handlers);
+            methods_.store(std::move(next), std::memory_order_release);
         }
 
+        bool contains(std::string_view method) const { return methods_.load(std::memory_order_acquire)->lookup.find(method) != nullptr; }
+
         // Handle a single request/notification. Returns optional response (none for notifications).
         std::optional<json> handle_single(const json& msg) const 
         {
@@ -179,22 +487,25 @@ namespace pooriayousefi::mcp::jsonrpc
                 // Per spec, invalid request returns an error with id = null
                 return make_error(nullptr, invalid_request);
             }
-            const std::string method = msg["method"].get<std::string>();
+            const std::string& method = msg["method"].get_ref<const std::string&>();
             const bool is_notif = !msg.contains("id");
-            const json id = is_notif ? json() : msg["id"]; // null if notification
+            json id = is_notif ? json() : msg["id"]; // null if notification
 
-            auto it = handlers_.find(method);
-            if (it == handlers_.end()) 
+            const auto methods = methods_.load(std::memory_order_acquire);
+            const auto* handler = methods->lookup.find(method);
+            if (!handler) 
             {
                 if (is_notif) return std::nullopt; // notifications get no response
-                return make_error(id, method_not_found);
+                return make_error(std::move(id), method_not_found);
             }
             try 
             {
-                json params = msg.contains("params") ? msg["params"] : json{};
-                json result = it->second(params);
+                // Params are passed by reference and the result is moved into the response
+                static const json no_params;
+                auto params = msg.find("params");
+                json result = (**handler)(params != msg.end() ? *params : no_params);
                 if (is_notif) return std::nullopt;
-                return make_result(id, result);
+                return make_result(std::move(id), std::move(result));
             }
             catch (const rpc_exception& ex)
             {
@@ -226,10 +537,10 @@ namespace pooriayousefi::mcp::jsonrpc
                 for (const auto& el : input) 
                 {
                     auto r = handle_single(el);
-                    if (r) out.push_back(*r);
+                    if (r) out.push_back(std::move(*r));
                 }
                 if (out.empty()) return std::nullopt; // all were notifications
-                return json(out);
+                return json(std::move(out));
             } 
             else 
             {
@@ -238,31 +549,222 @@ namespace pooriayousefi::mcp::jsonrpc
         }
 
     private:
-        std::unordered_map<std::string, handler_t> handlers_;
+        // The lookup borrows keys and values from handlers, so a table is never copied or changed
+        struct method_table 
+        {
+            method_table() = default;
+            method_table(const method_table&) = delete;
+            method_table& operator=(const method_table&) = delete;
+            detail::string_map<std::shared_ptr<const handler_t>> handlers;
+            detail::perfect_table<std::shared_ptr<const handler_t>> lookup;
+        };
+
+        std::atomic<std::shared_ptr<const method_table>> methods_;
+        std::mutex add_mutex_; // serializes add() so concurrent registrations are not lost
     };
 
     // --- Handler call context (progress + cancellation) ---
     struct call_context 
     {
         json id; // null for notifications
-        std::function<void(const json& value)> progress; // send $/progress
-        std::function<bool()> is_canceled; // polling cancellation
+        // Callbacks refer to callables owned by the dispatch that created the context,
+        // so they are only valid while the handler runs
+        core::FunctionRef<void(const json& value)> progress; // send $/progress
+        core::FunctionRef<bool()> is_canceled; // polling cancellation
+        core::FunctionRef<void(const json& value)> partial_result; // send a partial result; empty unless params.partialResultToken was given
+    };
+
+    // Limits on how often a request's progress reports are sent (both zero = every report).
+    // A report goes out once min_interval has passed since the previous one and, when the
+    // value carries a fraction, once that fraction moved by at least min_delta. The first
+    // report and a fraction of 1.0 or more are always sent. A held-back report replaces the
+    // previously held one, and the last one is sent before the response if it never went out.
+    struct progress_throttle 
+    {
+        std::chrono::milliseconds min_interval{0};
+        double min_delta = 0.0;
     };
 
     namespace detail 
     {
+        // Fraction of a progress value: a number, or an object's numeric "progress"
+        inline std::optional<double> progress_fraction(const json& value) 
+        {
+            if (value.is_number()) return value.get<double>();
+            if (!value.is_object()) return std::nullopt;
+            auto progress = value.find("progress");
+            if (progress == value.end() || !progress->is_number()) return std::nullopt;
+            return progress->get<double>();
+        }
+
+        // Per-request throttle state; lives on the dispatching stack frame like the context
+        class progress_gate 
+        {
+        public:
+            explicit progress_gate(progress_throttle limits) : limits_(limits) {}
+
+            // True when value should be sent now; otherwise it is held as the pending report
+            bool admit(const json& value) 
+            {
+                if (limits_.min_interval.count() <= 0 && limits_.min_delta <= 0.0) return true;
+                const auto now = std::chrono::steady_clock::now();
+                const auto fraction = progress_fraction(value);
+                bool send = !sent_ || (fraction && *fraction >= 1.0);
+                if (!send && now - last_sent_ >= limits_.min_interval) 
+                {
+                    send = !fraction || !last_fraction_ || std::abs(*fraction - *last_fraction_) >= limits_.min_delta;
+                }
+                if (!send) 
+                {
+                    pending_ = value;
+                    has_pending_ = true;
+                    return false;
+                }
+                sent_ = true;
+                last_sent_ = now;
+                if (fraction) last_fraction_ = fraction;
+                has_pending_ = false;
+                return true;
+            }
+
+            // The last held-back report, if it was never sent
+            const json* pending() const { return has_pending_ ? &pending_ : nullptr; }
+
+        private:
+            progress_throttle limits_;
+            bool sent_ = false;
+            bool has_pending_ = false;
+            std::chrono::steady_clock::time_point last_sent_{};
+            std::optional<double> last_fraction_;
+            json pending_;
+        };
+
+        // Hash map split into independently locked shards: concurrent callers only
+        // contend when their keys land in the same shard.
+        template<class Key, class Value, size_t Shards = 16, class Hash = std::hash<Key>>
+        class sharded_map 
+        {
+        public:
+            void insert_or_assign(const Key& key, Value value) 
+            {
+                auto& s = shard_for(key);
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.map.insert_or_assign(key, std::move(value));
+            }
+
+            // Remove and return the value for key, if present
+            std::optional<Value> take(const Key& key) 
+            {
+                auto& s = shard_for(key);
+                std::lock_guard<std::mutex> lock(s.mutex);
+                auto it = s.map.find(key);
+                if (it == s.map.end()) return std::nullopt;
+                std::optional<Value> out(std::move(it->second));
+                s.map.erase(it);
+                return out;
+            }
+
+            // Copy of the value for key, if present
+            std::optional<Value> find(const Key& key) const 
+            {
+                auto& s = shard_for(key);
+                std::lock_guard<std::mutex> lock(s.mutex);
+                auto it = s.map.find(key);
+                if (it == s.map.end()) return std::nullopt;
+                return it->second;
+            }
+
+            // Return the existing value or insert make() under the shard lock
+            template<class Make>
+            Value get_or_insert(const Key& key, Make make) 
+            {
+                auto& s = shard_for(key);
+                std::lock_guard<std::mutex> lock(s.mutex);
+                auto it = s.map.find(key);
+                if (it == s.map.end()) it = s.map.emplace(key, make()).first;
+                return it->second;
+            }
+
+            // Modify the value for key in place under the shard lock; false if absent
+            template<class Fn>
+            bool update(const Key& key, Fn fn) 
+            {
+                auto& s = shard_for(key);
+                std::lock_guard<std::mutex> lock(s.mutex);
+                auto it = s.map.find(key);
+                if (it == s.map.end()) return false;
+                fn(it->second);
+                return true;
+            }
+
+            bool contains(const Key& key) const 
+            {
+                auto& s = shard_for(key);
+                std::lock_guard<std::mutex> lock(s.mutex);
+                return s.map.contains(key);
+            }
+
+            bool erase(const Key& key) 
+            {
+                auto& s = shard_for(key);
+                std::lock_guard<std::mutex> lock(s.mutex);
+                return s.map.erase(key) != 0;
+            }
+
+            size_t size() const 
+            {
+                size_t n = 0;
+                for (auto& s : shards_) 
+                {
+                    std::lock_guard<std::mutex> lock(s.mutex);
+                    n += s.map.size();
+                }
+                return n;
+            }
+
+        private:
+            struct alignas(64) shard 
+            {
+                mutable std::mutex mutex;
+                std::unordered_map<Key, Value, Hash> map;
+            };
+
+            shard& shard_for(const Key& key) { return shards_[Hash{}(key) % Shards]; }
+            const shard& shard_for(const Key& key) const { return shards_[Hash{}(key) % Shards]; }
+
+            std::array<shard, Shards> shards_;
+        };
+
         inline thread_local call_context* tls_ctx = nullptr;
+        inline thread_local const json* tls_request_id = nullptr; // id of the request being dispatched on this thread
+
+        // Binds the request id for the duration of a dispatch on the current thread
+        struct request_id_scope 
+        {
+            const json* previous;
+            explicit request_id_scope(const json* id) : previous(tls_request_id) { tls_request_id = id; }
+            ~request_id_scope() { tls_request_id = previous; }
+        };
     }
 
     inline const call_context* current_context() { return detail::tls_ctx; }
     inline bool is_canceled() { return detail::tls_ctx ? detail::tls_ctx->is_canceled() : false; }
     inline void report_progress(const json& value) { if (detail::tls_ctx && detail::tls_ctx->progress) detail::tls_ctx->progress(value); }
+    inline bool has_partial_result_token() { return detail::tls_ctx && detail::tls_ctx->partial_result; }
+    // Sends value to the caller right away as `$/progress` on its partialResultToken.
+    // Returns false when the caller did not ask for partial results; the handler then returns everything in its result.
+    inline bool report_partial_result(const json& value) 
+    {
+        if (!has_partial_result_token()) return false;
+        detail::tls_ctx->partial_result(value);
+        return true;
+    }
 
     // --- Endpoint: transport + client/server conveniences (MCP/LSP-style) ---
     class endpoint 
     {
     public:
-        using send_fn = std::function<void(const json&)>;
+        using send_fn = std::function<void(json&&)>; // receives ownership of each outgoing message
         using result_cb = std::function<void(const json&)>;
         using error_cb = std::function<void(const json&)>;
 
@@ -274,10 +776,7 @@ namespace pooriayousefi::mcp::jsonrpc
             {
                 // params: { id: string|number|null }
                 if (!params.is_object() || !params.contains("id")) return json{};
-                auto key = key_for_id(params["id"]);
-                auto& flag = server_cancels_[key];
-                if (!flag) flag = std::make_shared<std::atomic_bool>(false);
-                flag->store(true, std::memory_order_relaxed);
+                cancel_flag_for(key_for_id(params["id"]))->store(true, std::memory_order_relaxed);
                 return json{}; // notification: ignored
             });
 
@@ -287,8 +786,8 @@ namespace pooriayousefi::mcp::jsonrpc
                 if (!params.is_object()) return json{};
                 std::string token = params.value("token", std::string());
                 if (token.empty()) return json{};
-                auto it = progress_handlers_.find(token);
-                if (it != progress_handlers_.end() && it->second) it->second(params.value("value", json{}));
+                auto handler = progress_handlers_.find(token);
+                if (handler && *handler) (*handler)(params.value("value", json{}));
                 return json{}; // notification
             });
 
@@ -300,74 +799,174 @@ namespace pooriayousefi::mcp::jsonrpc
             });
         }
 
+        endpoint(const endpoint&) = delete;
+        endpoint& operator=(const endpoint&) = delete;
+
+        // Requests still running on the executor, and armed deadlines, reference this endpoint
+        ~endpoint() 
+        {
+            wait_idle();
+            if (timers_) timers_->stop();
+        }
+
         // Server registration: wrap to enable context in handlers
         void add(const std::string& method, dispatcher::handler_t fn) 
         {
-            disp_.add(method, [this, fn=std::move(fn)](const json& params) -> json 
+            auto probe = std::make_shared<core::CallProbe>();
+            {
+                std::lock_guard<std::mutex> lock(probes_mutex_);
+                probe->resolve(metrics_.get(), "mcp_method", "method", method);
+                probes_.emplace_back(method, probe);
+            }
+            disp_.add(method, [this, method, probe, fn=std::move(fn)](const json& params) -> json 
             {
-                // Build a context hooked into this endpoint
-                json id = current_req_id_.value_or(nullptr);
-                auto id_key = key_for_id(id);
-                auto cancel_flag = server_cancels_[id_key];
-                if (!cancel_flag) cancel_flag = (server_cancels_[id_key] = std::make_shared<std::atomic_bool>(false));
+                // Build a context hooked into this endpoint. Its callbacks are FunctionRefs to
+                // the lambdas below, so nothing is allocated unless they are called.
+                json id = detail::tls_request_id ? *detail::tls_request_id : json(nullptr);
+                auto cancel_flag = id.is_null() ? nullptr : cancel_flag_for(key_for_id(id));
 
-                // Determine progress token: either from params.progressToken or fallback to id key
-                std::string token;
-                if (params.is_object() && params.contains("progressToken") && params["progressToken"].is_string()) 
+                // Progress token: params.progressToken, or else the request id
+                auto send_report = [this, &params, &id](const json& value) 
                 {
-                    token = params["progressToken"].get<std::string>();
-                } 
-                else 
+                    auto token = params.is_object() ? params.find("progressToken") : params.end();
+                    if (token != params.end() && token->is_string()) send_progress(token->get_ref<const std::string&>(), value);
+                    else send_progress(key_for_id(id), value);
+                };
+                detail::progress_gate gate(progress_throttle_limits());
+                auto progress = [&gate, &send_report](const json& value) 
+                {
+                    if (gate.admit(value)) send_report(value);
+                };
+                auto canceled = [&cancel_flag]() { return cancel_flag && cancel_flag->load(std::memory_order_relaxed); };
+                const json* partial_token = nullptr;
+                if (params.is_object()) 
                 {
-                    token = id_key;
+                    auto token = params.find("partialResultToken");
+                    if (token != params.end() && token->is_string()) partial_token = &*token;
                 }
-
-                call_context ctx{
-                    id,
-                    [this, token](const json& value){ send_progress(token, value); },
-                    [cancel_flag](){ return cancel_flag && cancel_flag->load(std::memory_order_relaxed); }
+                auto partial = [this, partial_token](const json& value) 
+                {
+                    send_progress(partial_token->get_ref<const std::string&>(), value);
                 };
+
+                call_context ctx{id, progress, canceled, {}};
+                if (partial_token) ctx.partial_result = partial;
+                core::Span span(metrics_.get(), core::SpanKind::handler, method);
+                const auto started = probe->start();
                 detail::tls_ctx = &ctx;
                 try 
                 {
                     auto out = fn(params);
                     detail::tls_ctx = nullptr;
+                    if (auto last = gate.pending()) send_report(*last);
+                    probe->finish(started, true);
                     return out;
                 } 
                 catch(...) 
                 {
                     detail::tls_ctx = nullptr;
+                    span.fail();
+                    probe->finish(started, false);
                     throw;
                 }
             });
         }
 
-        // Client-side: send request (auto-generated id)
+        // Client-side: send request (auto-generated id).
+        // `timeout` of zero uses the default set by set_default_timeout(); when the
+        // deadline passes first, on_error receives `request_timeout`.
         std::string send_request(
             const std::string& method, 
             const json& params, 
             result_cb on_result, 
-            error_cb on_error
+            error_cb on_error,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
         ) 
         {
-            std::string id = gen_id();
-            pending_[id] = {std::move(on_result), std::move(on_error)};
-            send_(make_request(id, method, params));
+            uint64_t seq = id_counter_.fetch_add(1, std::memory_order_relaxed) + 1;
+            std::string id = format_id("req-", seq);
+            pending_seq_.insert_or_assign(seq, pending_call{std::move(on_result), std::move(on_error)});
+            arm_deadline(id, timeout);
+            transmit(make_request(id, method, params));
             return id;
         }
 
-        // Client-side: send request with explicit id (useful for testing/cancellation ordering)
+        // Client-side: send request with explicit id (useful for testing/cancellation ordering).
+        // Ids spelled like generated ones ("req-<n>", no leading zeros) are reserved and
+        // throw std::invalid_argument; any other id, "req-05" included, is kept as given.
         void send_request_with_id(
             const std::string& id, 
             const std::string& method, 
             const json& params, 
             result_cb on_result, 
-            error_cb on_error
+            error_cb on_error,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
+        ) 
+        {
+            if (generated_seq(id)) 
+            {
+                throw std::invalid_argument("request id \"" + id + "\" is reserved for generated ids");
+            }
+            pending_named_.insert_or_assign(id, pending_call{std::move(on_result), std::move(on_error)});
+            arm_deadline(id, timeout);
+            transmit(make_request(id, method, params));
+        }
+
+        // One request of a send_batch() call
+        struct outgoing_call 
+        {
+            std::string method;
+            json params;
+            result_cb on_result;
+            error_cb on_error;
+        };
+
+        // Client-side: send several requests as a single JSON-RPC batch array.
+        // Every response is routed to its own callbacks, in whatever order the peer
+        // answers. `timeout` applies to each call as in send_request. Returns the ids.
+        std::vector<std::string> send_batch(
+            std::vector<outgoing_call> calls,
+            std::chrono::milliseconds timeout = std::chrono::milliseconds::zero()
         ) 
         {
-            pending_[id] = {std::move(on_result), std::move(on_error)};
-            send_(make_request(id, method, params));
+            std::vector<std::string> ids;
+            if (calls.empty()) return ids;
+            ids.reserve(calls.size());
+            json batch = json::array();
+            batch.get_ref<json::array_t&>().reserve(calls.size());
+            for (auto& call : calls) 
+            {
+                uint64_t seq = id_counter_.fetch_add(1, std::memory_order_relaxed) + 1;
+                std::string id = format_id("req-", seq);
+                pending_seq_.insert_or_assign(seq, pending_call{std::move(call.on_result), std::move(call.on_error)});
+                batch.push_back(make_request(id, call.method, call.params));
+                ids.push_back(std::move(id));
+            }
+            for (const auto& id : ids) arm_deadline(id, timeout);
+            transmit(std::move(batch));
+            return ids;
+        }
+
+        // --- Deadlines ---
+        // Applied to every request sent without an explicit timeout (zero = wait forever)
+        void set_default_timeout(std::chrono::milliseconds timeout) { default_timeout_ = timeout.count(); }
+        std::chrono::milliseconds default_timeout() const { return std::chrono::milliseconds(default_timeout_.load()); }
+
+        // --- Progress ---
+        // Applies to report_progress() from handlers dispatched afterwards (default: no limit).
+        // Partial results and direct send_progress() calls are never throttled.
+        void set_progress_throttle(progress_throttle limits) 
+        {
+            progress_interval_ = limits.min_interval.count();
+            progress_delta_ = limits.min_delta;
         }
+        progress_throttle progress_throttle_limits() const 
+        { 
+            return progress_throttle{std::chrono::milliseconds(progress_interval_.load()), progress_delta_.load()}; 
+        }
+
+        // Tell the peer to stop working on a request we gave up on (default: on)
+        void set_cancel_on_timeout(bool enabled) { cancel_on_timeout_ = enabled; }
 
         // Client-side: notifications
         void send_notification(
@@ -375,16 +974,20 @@ namespace pooriayousefi::mcp::jsonrpc
             const json& params = json{}
         ) 
         { 
-            send_(make_notification(method, params)); 
+            transmit(make_notification(method, params)); 
         }
 
         // Progress helpers
-        std::string create_progress_token() { return gen_id("tok-"); }
-        void on_progress(const std::string& token, std::function<void(const json&)> cb) { progress_handlers_[token] = std::move(cb); }
-        void send_progress(const std::string& token, const json& value) { send_(make_notification("$/progress", json{{"token", token}, {"value", value}})); }
+        std::string create_progress_token() { return format_id("tok-", id_counter_.fetch_add(1, std::memory_order_relaxed) + 1); }
+        void on_progress(const std::string& token, std::function<void(const json&)> cb) { progress_handlers_.insert_or_assign(token, std::move(cb)); }
+        void remove_progress_handler(const std::string& token) { progress_handlers_.erase(token); }
+
+        // Number of requests sent by this endpoint that are still awaiting a response
+        size_t pending_count() const { return pending_seq_.size() + pending_named_.size(); }
+        void send_progress(const std::string& token, const json& value) { transmit(make_notification("$/progress", json{{"token", token}, {"value", value}})); }
         
         // Cancellation
-        void cancel(const json& id) { send_(make_notification("$/cancelRequest", json{{"id", id}})); }
+        void cancel(const json& id) { transmit(make_notification("$/cancelRequest", json{{"id", id}})); }
 
         // Initialize convenience
         std::string initialize(
@@ -399,27 +1002,79 @@ namespace pooriayousefi::mcp::jsonrpc
         void set_server_capabilities(json caps) { server_capabilities_ = std::move(caps); }
         bool is_initialized() const { return initialized_; }
 
+        // --- Executor (optional) ---
+        // When set, requests run on the pool and their responses are sent as they
+        // complete. Notifications, $/cancelRequest and `initialize` stay inline on
+        // the receiving thread so cancellation is never queued behind the work.
+        void set_executor(std::shared_ptr<core::ThreadPool> pool) { executor_ = std::move(pool); }
+        const std::shared_ptr<core::ThreadPool>& executor() const { return executor_; }
+
+        // Cap how many requests for `method` may run on the executor at once (0 = unlimited)
+        void set_method_concurrency(const std::string& method, size_t limit) 
+        {
+            std::lock_guard<std::mutex> lock(gates_mutex_);
+            if (limit == 0) { gates_.erase(method); return; }
+            gates_[method].limit = limit;
+        }
+
+        // --- Metrics (optional) ---
+        // Counts and times every method registered with add() (mcp_method_calls_total,
+        // mcp_method_errors_total, mcp_method_duration_seconds, labelled by method),
+        // exports mcp_pending_requests, and runs the registry's span hooks around
+        // dispatch, handlers and sends. Set before serving; null turns it off.
+        void set_metrics(std::shared_ptr<core::Metrics> metrics) 
+        {
+            pending_gauge_.reset();
+            std::lock_guard<std::mutex> lock(probes_mutex_);
+            metrics_ = std::move(metrics);
+            for (auto& [method, probe] : probes_) probe->resolve(metrics_.get(), "mcp_method", "method", method);
+            if (!metrics_) return;
+            pending_gauge_ = metrics_->observe("mcp_pending_requests", "Requests sent and still awaiting a response", {}, {},
+                [this] { return static_cast<double>(pending_count()); });
+        }
+        const std::shared_ptr<core::Metrics>& metrics() const { return metrics_; }
+
+        // Block until every request handed to the executor has been answered
+        void wait_idle() 
+        {
+            std::unique_lock<std::mutex> lock(idle_mutex_);
+            idle_cv_.wait(lock, [this]{ return in_flight_ == 0; });
+        }
+
+        // False for messages receive() would discard anyway: notifications no handler takes
+        // and responses to requests that are no longer pending (late, timed out, unknown).
+        // Transports that scan before parsing (Transport::set_message_filter) skip them.
+        bool accepts(const envelope& e) const 
+        {
+            if (is_response(e)) 
+            {
+                auto id = envelope::plain_string(e.id);
+                if (!id) return true; // numeric or escaped: let take_pending decide
+                if (auto seq = generated_seq(*id)) return pending_seq_.contains(*seq);
+                return pending_named_.contains(std::string(*id));
+            }
+            if (is_notification(e)) 
+            {
+                auto method = e.method_name();
+                return !method || disp_.contains(*method);
+            }
+            return true;
+        }
+
         // Incoming single or batch message entrypoint
         void receive(const json& msg) 
         {
             if (msg.is_array()) 
             {
-                if (msg.empty()) { send_(make_error(nullptr, invalid_request)); return; }
+                if (msg.empty()) { transmit(make_error(nullptr, invalid_request)); return; }
+                if (executor_) { receive_batch_async(json(msg)); return; }
                 std::vector<json> outs; outs.reserve(msg.size());
                 for (const auto& m : msg) {
                     // Gather responses but do not emit immediately
-                    std::optional<json> id_opt = m.contains("id") ? std::optional<json>(m["id"]) : std::optional<json>(json(nullptr));
-                    current_req_id_ = id_opt;
-                    auto r = disp_.handle_single(m);
-                    current_req_id_.reset();
-                    if (r) outs.push_back(*r);
-                    // Clean up cancellation flag for requests
-                    if (m.contains("id")) {
-                        auto id_key = key_for_id(m["id"]);
-                        server_cancels_.erase(id_key);
-                    }
+                    auto r = dispatch_inline(m);
+                    if (r) outs.push_back(std::move(*r));
                 }
-                if (!outs.empty()) send_(json(outs));
+                if (!outs.empty()) transmit(json(std::move(outs)));
                 return;
             }
             if (is_response(msg)) 
@@ -428,23 +1083,63 @@ namespace pooriayousefi::mcp::jsonrpc
                 return;
             }
             // Request/notification path
-            std::optional<json> id_opt;
-            if (msg.contains("id")) id_opt = msg["id"]; else id_opt = json(nullptr);
-            // Set current id for context
-            current_req_id_ = id_opt;
-            auto resp = disp_.handle_single(msg);
-            current_req_id_.reset();
-            if (resp) {
-                send_(*resp);
-                // Clean up cancellation flag for completed request
-                if (msg.contains("id")) {
-                    auto id_key = key_for_id(msg["id"]);
-                    server_cancels_.erase(id_key);
-                }
+            if (executor_ && runs_on_executor(msg)) 
+            {
+                dispatch_async(json(msg), [this](json resp) { transmit(std::move(resp)); });
+                return;
+            }
+            auto resp = dispatch_inline(msg);
+            if (resp) transmit(std::move(*resp));
+        }
+
+        // As above, for a message the caller hands over: requests bound for the executor
+        // (and batch elements) are moved into their tasks instead of copied
+        void receive(json&& msg) 
+        {
+            if (executor_ && msg.is_array() && !msg.empty()) { receive_batch_async(std::move(msg)); return; }
+            if (executor_ && !is_response(msg) && runs_on_executor(msg)) 
+            {
+                dispatch_async(std::move(msg), [this](json resp) { transmit(std::move(resp)); });
+                return;
             }
+            receive(std::as_const(msg));
         }
 
     private:
+        using completion_fn = std::function<void(json response)>;
+        struct pending_call 
+        {
+            result_cb on_result;
+            error_cb on_error;
+            core::TimerWheel::timer_id deadline = 0;
+        };
+        using progress_fn = std::function<void(const json&)>;
+
+        // Per-method concurrency gate for executor dispatch
+        struct method_gate 
+        {
+            size_t limit = 0;
+            size_t running = 0;
+            std::deque<std::function<void()>> waiting;
+        };
+
+        // Span name for a message: its method, "response" or "batch"; empty unless tracing
+        std::string_view traced_name(const json& msg) const 
+        {
+            if (!metrics_ || !metrics_->tracing()) return {};
+            if (msg.is_array()) return "batch";
+            auto method = msg.is_object() ? msg.find("method") : msg.end();
+            if (method != msg.end() && method->is_string()) return method->get_ref<const std::string&>();
+            return "response";
+        }
+
+        // Every outgoing message leaves through here
+        void transmit(json&& msg) 
+        {
+            core::Span span(metrics_.get(), core::SpanKind::send, traced_name(msg));
+            send_(std::move(msg));
+        }
+
         // Helper: normalize id into string key
         static std::string key_for_id(const json& id) 
         {
@@ -452,14 +1147,232 @@ namespace pooriayousefi::mcp::jsonrpc
             return id.dump();
         }
 
+        // Ids this endpoint generates are "req-<n>" with n >= 1 written by format_id, so
+        // only that exact spelling maps to a sequence number: "req-05" or "req-+5" would
+        // otherwise share the slot of "req-5"
+        static std::optional<uint64_t> generated_seq(std::string_view id) 
+        {
+            constexpr std::string_view prefix = "req-";
+            if (id.size() <= prefix.size() || id.substr(0, prefix.size()) != prefix) return std::nullopt;
+            if (id[prefix.size()] < '1' || id[prefix.size()] > '9') return std::nullopt;
+            uint64_t seq = 0;
+            const char* first = id.data() + prefix.size();
+            const char* last = id.data() + id.size();
+            auto [end, ec] = std::from_chars(first, last, seq);
+            if (ec != std::errc{} || end != last) return std::nullopt;
+            return seq;
+        }
+
+        static std::string format_id(std::string_view prefix, uint64_t seq) 
+        {
+            char digits[20];
+            auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), seq);
+            (void)ec;
+            std::string id;
+            id.reserve(prefix.size() + static_cast<size_t>(end - digits));
+            id.append(prefix).append(digits, end);
+            return id;
+        }
+
+        std::optional<pending_call> take_pending(const json& id) 
+        {
+            if (!id.is_string()) return pending_named_.take(key_for_id(id));
+            const auto& text = id.get_ref<const std::string&>();
+            if (auto seq = generated_seq(text)) return pending_seq_.take(*seq);
+            return pending_named_.take(text);
+        }
+
+        core::TimerWheel& timers() 
+        {
+            std::call_once(timers_once_, [this]{ timers_ = std::make_unique<core::TimerWheel>(); });
+            return *timers_;
+        }
+
+        // Start the clock for a request that is already in the pending table
+        void arm_deadline(const std::string& id, std::chrono::milliseconds timeout) 
+        {
+            if (timeout.count() <= 0) timeout = default_timeout();
+            if (timeout.count() <= 0) return;
+            auto timer = timers().schedule(timeout, [this, id, timeout]{ expire(id, timeout); });
+            bool armed = false;
+            auto attach = [&](auto& table, const auto& key) 
+            {
+                table.update(key, [&](pending_call& call) { call.deadline = timer; armed = true; });
+            };
+            if (auto seq = generated_seq(id)) attach(pending_seq_, *seq);
+            else attach(pending_named_, id);
+            // Answered before the deadline was attached
+            if (!armed) timers().cancel(timer);
+        }
+
+        // Wheel thread: the deadline won the race against the response
+        void expire(const std::string& id, std::chrono::milliseconds timeout) 
+        {
+            auto call = take_pending(json(id));
+            if (!call) return;
+            if (cancel_on_timeout_) cancel(json(id));
+            error e = request_timeout;
+            e.data = json{{"timeout", timeout.count()}};
+            if (call->on_error) call->on_error(make_error_object(e));
+        }
+
+        std::shared_ptr<std::atomic_bool> cancel_flag_for(const std::string& key) 
+        {
+            return server_cancels_.get_or_insert(key, []{ return std::make_shared<std::atomic_bool>(false); });
+        }
+
+        void release_cancel_flag(const json& id) 
+        {
+            server_cancels_.erase(key_for_id(id));
+        }
+
+        bool runs_on_executor(const json& msg) const 
+        {
+            if (!msg.is_object() || !msg.contains("id") || !msg.contains("method") || !msg["method"].is_string()) return false;
+            const auto& method = msg["method"].get_ref<const std::string&>();
+            return method != "initialize" && method.rfind("$/", 0) != 0;
+        }
+
+        // Run a request/notification on the calling thread
+        std::optional<json> dispatch_inline(const json& m) 
+        {
+            if (is_response(m)) { handle_incoming_response(m); return std::nullopt; }
+            json id = m.contains("id") ? m["id"] : json(nullptr);
+            std::optional<json> r;
+            {
+                detail::request_id_scope scope(&id);
+                core::Span span(metrics_.get(), core::SpanKind::dispatch, traced_name(m));
+                r = disp_.handle_single(m);
+                if (span.active() && r && r->is_object() && r->contains("error")) span.fail();
+            }
+            // Clean up cancellation flag for completed request
+            if (m.is_object() && m.contains("id")) release_cancel_flag(m["id"]);
+            return r;
+        }
+
+        // Hand a request to the executor; `done` receives its response
+        void dispatch_async(json msg, completion_fn done) 
+        {
+            json id = msg["id"];
+            // Create the flag now so a cancel that arrives before the task starts is seen
+            auto flag = cancel_flag_for(key_for_id(id));
+            const std::string method = msg["method"].get<std::string>();
+
+            {
+                std::lock_guard<std::mutex> lock(idle_mutex_);
+                ++in_flight_;
+            }
+
+            auto task = [this, msg = std::move(msg), id, flag, done = std::move(done)]() mutable 
+            {
+                std::optional<json> resp;
+                if (flag->load(std::memory_order_relaxed)) 
+                {
+                    resp = make_error(id, request_cancelled);
+                    release_cancel_flag(id);
+                } 
+                else 
+                {
+                    resp = dispatch_inline(msg);
+                }
+                if (resp) done(std::move(*resp));
+            };
+
+            std::unique_lock<std::mutex> lock(gates_mutex_);
+            auto it = gates_.find(method);
+            if (it == gates_.end()) 
+            {
+                lock.unlock();
+                submit([this, task = std::move(task)]() mutable { task(); finish_one(); });
+                return;
+            }
+            auto& gate = it->second;
+            if (gate.running >= gate.limit) 
+            {
+                gate.waiting.push_back(std::move(task));
+                return;
+            }
+            ++gate.running;
+            lock.unlock();
+            submit([this, method, task = std::move(task)]() mutable { run_gated(method, std::move(task)); });
+        }
+
+        // Run a gated task, then keep draining the method's backlog on this worker
+        void run_gated(const std::string& method, std::function<void()> task) 
+        {
+            while (task) 
+            {
+                task();
+                finish_one();
+                std::lock_guard<std::mutex> lock(gates_mutex_);
+                auto& gate = gates_[method];
+                if (gate.waiting.empty()) { if (gate.running) --gate.running; task = nullptr; }
+                else { task = std::move(gate.waiting.front()); gate.waiting.pop_front(); }
+            }
+        }
+
+        void submit(std::function<void()> task) 
+        {
+            auto pool = executor_;
+            if (!pool || !pool->submit(task)) task(); // pool gone: degrade to inline
+        }
+
+        void finish_one() 
+        {
+            std::lock_guard<std::mutex> lock(idle_mutex_);
+            if (--in_flight_ == 0) idle_cv_.notify_all();
+        }
+
+        // Batches keep their single-array reply: elements run concurrently and the
+        // array is sent once the last request completes
+        void receive_batch_async(json msg) 
+        {
+            struct batch_state 
+            {
+                std::mutex mutex;
+                std::vector<json> outs;
+                size_t remaining = 0;
+            };
+            auto state = std::make_shared<batch_state>();
+            std::vector<json*> deferred;
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                for (auto& m : msg) 
+                {
+                    if (runs_on_executor(m)) { deferred.push_back(&m); ++state->remaining; continue; }
+                    auto r = dispatch_inline(m);
+                    if (r) state->outs.push_back(std::move(*r));
+                }
+                if (deferred.empty()) 
+                {
+                    if (!state->outs.empty()) transmit(json(std::move(state->outs)));
+                    return;
+                }
+            }
+            for (json* m : deferred) 
+            {
+                dispatch_async(std::move(*m), [this, state](json resp) 
+                {
+                    std::vector<json> outs;
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        state->outs.push_back(std::move(resp));
+                        if (--state->remaining != 0) return;
+                        outs = std::move(state->outs);
+                    }
+                    transmit(json(std::move(outs)));
+                });
+            }
+        }
+
         // Incoming responses
         void handle_incoming_response(const json& r) 
         {
-            std::string key = key_for_id(r.at("id"));
-            auto it = pending_.find(key);
-            if (it == pending_.end()) return; // unknown/late
-            auto [on_ok, on_err] = it->second;
-            pending_.erase(it);
+            auto call = take_pending(r.at("id"));
+            if (!call) return; // unknown/late (or already timed out)
+            if (call->deadline && timers_) timers_->cancel(call->deadline);
+            auto& on_ok = call->on_result;
+            auto& on_err = call->on_error;
             if (r.contains("result")) 
             {
                 if (on_ok) on_ok(r["result"]);
@@ -470,21 +1383,34 @@ namespace pooriayousefi::mcp::jsonrpc
             }
         }
 
-        std::string gen_id(const std::string& prefix = "req-") 
-        {
-            std::ostringstream oss; oss << prefix << (++id_counter_);
-            return oss.str();
-        }
-
         send_fn send_;
         dispatcher disp_;
-        std::map<std::string, std::pair<result_cb, error_cb>> pending_;
-        std::unordered_map<std::string, std::shared_ptr<std::atomic_bool>> server_cancels_;
-        std::unordered_map<std::string, std::function<void(const json&)>> progress_handlers_;
-        std::optional<json> current_req_id_;
+        detail::sharded_map<uint64_t, pending_call> pending_seq_;       // ids from send_request
+        detail::sharded_map<std::string, pending_call> pending_named_; // explicit ids
+        detail::sharded_map<std::string, std::shared_ptr<std::atomic_bool>> server_cancels_;
+        detail::sharded_map<std::string, progress_fn> progress_handlers_;
         json server_capabilities_ = json::object();
         bool initialized_ = false;
-        size_t id_counter_ = 0;
+        std::atomic<uint64_t> id_counter_{0};
+
+        std::shared_ptr<core::ThreadPool> executor_;
+        std::unordered_map<std::string, method_gate> gates_;
+        std::mutex gates_mutex_;
+        size_t in_flight_ = 0;
+        std::mutex idle_mutex_;
+        std::condition_variable idle_cv_;
+
+        std::atomic<int64_t> default_timeout_{0};
+        std::atomic<int64_t> progress_interval_{0};
+        std::atomic<double> progress_delta_{0.0};
+        std::atomic<bool> cancel_on_timeout_{true};
+        std::once_flag timers_once_;
+        std::unique_ptr<core::TimerWheel> timers_; // created on first deadline
+
+        std::shared_ptr<core::Metrics> metrics_;
+        std::vector<std::pair<std::string, std::shared_ptr<core::CallProbe>>> probes_; // one per add()
+        std::mutex probes_mutex_;
+        core::Observation pending_gauge_; // before metrics_ and the pending tables go
     };
 
 } // namespace pooriayousefi::mcp::jsonrpc
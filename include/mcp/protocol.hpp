@@ -1,6 +1,7 @@
 #pragma once
 
 #include "jsonrpc/jsonrpc.hpp"
+#include "core/base64.hpp"
 #include <string>
 #include <vector>
 #include <optional>
@@ -173,6 +174,20 @@ namespace pooriayousefi::mcp
             if (uri) j["uri"] = *uri;
             return j;
         }
+
+        /**
+         * @brief Append the same JSON as to_json().dump(), without building a tree
+         */
+        void write_json(jsonrpc::encoded_buffer& out) const {
+            out.push_back('{');
+            if (data) { jsonrpc::append_raw(out, "\"data\":"); jsonrpc::append_string(out, *data); out.push_back(','); }
+            if (mime_type) { jsonrpc::append_raw(out, "\"mimeType\":"); jsonrpc::append_string(out, *mime_type); out.push_back(','); }
+            if (text) { jsonrpc::append_raw(out, "\"text\":"); jsonrpc::append_string(out, *text); out.push_back(','); }
+            jsonrpc::append_raw(out, "\"type\":");
+            jsonrpc::append_string(out, type);
+            if (uri) { jsonrpc::append_raw(out, ",\"uri\":"); jsonrpc::append_string(out, *uri); }
+            out.push_back('}');
+        }
         
         static ToolResultContent text_content(const std::string& text) {
             return ToolResultContent{"text", text, std::nullopt, std::nullopt, std::nullopt};
@@ -272,6 +287,19 @@ namespace pooriayousefi::mcp
             if (mime_type) j["mimeType"] = *mime_type;
             return j;
         }
+
+        /**
+         * @brief Append the same JSON as to_json().dump(), without building a tree
+         */
+        void write_json(jsonrpc::encoded_buffer& out) const {
+            out.push_back('{');
+            if (data) { jsonrpc::append_raw(out, "\"data\":"); jsonrpc::append_string(out, *data); out.push_back(','); }
+            if (mime_type) { jsonrpc::append_raw(out, "\"mimeType\":"); jsonrpc::append_string(out, *mime_type); out.push_back(','); }
+            if (text) { jsonrpc::append_raw(out, "\"text\":"); jsonrpc::append_string(out, *text); out.push_back(','); }
+            jsonrpc::append_raw(out, "\"type\":");
+            jsonrpc::append_string(out, type);
+            out.push_back('}');
+        }
     };
 
     /**
@@ -292,12 +320,28 @@ namespace pooriayousefi::mcp
                 {"content", contents}
             };
         }
+
+        /**
+         * @brief Append the same JSON as to_json().dump(), without building a tree
+         */
+        void write_json(jsonrpc::encoded_buffer& out) const {
+            jsonrpc::append_raw(out, "{\"content\":[");
+            for (size_t i = 0; i < content.size(); ++i) {
+                if (i) out.push_back(',');
+                content[i].write_json(out);
+            }
+            jsonrpc::append_raw(out, role == MessageRole::User ? "],\"role\":\"user\"}" : "],\"role\":\"assistant\"}");
+        }
     };
 
     // ==================== Resource Types ====================
 
     /**
      * @brief Resource content (text or blob)
+     *
+     * A blob is given either base64-encoded (`blob`) or as raw bytes (`bytes`).
+     * Raw bytes are sent as a byte string when the session negotiated a binary
+     * encoding, and base64-encoded otherwise.
      */
     struct ResourceContent 
     {
@@ -305,14 +349,121 @@ namespace pooriayousefi::mcp
         std::optional<std::string> mime_type;
         std::optional<std::string> text;
         std::optional<std::string> blob; // base64
+        std::optional<std::string> bytes = std::nullopt; // raw blob
         
-        json to_json() const {
+        /**
+         * @param raw_blobs Write `bytes` as a binary value (for CBOR/MessagePack) instead of base64
+         */
+        json to_json(bool raw_blobs = false) const {
             json j = {{"uri", uri}};
             if (mime_type) j["mimeType"] = *mime_type;
             if (text) j["text"] = *text;
-            if (blob) j["blob"] = *blob;
+            if (bytes && raw_blobs) j["blob"] = json::binary(json::binary_t::container_type(bytes->begin(), bytes->end()));
+            else if (bytes) j["blob"] = core::base64_encode(*bytes);
+            else if (blob) j["blob"] = *blob;
             return j;
         }
+
+        /**
+         * @brief The blob's bytes, whichever way it was given; nullopt if there is none or its base64 is malformed
+         */
+        std::optional<std::string> blob_data() const {
+            if (bytes) return bytes;
+            if (blob) return core::base64_decode(*blob);
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Append the same JSON as to_json().dump(), without building a tree
+         */
+        void write_json(jsonrpc::encoded_buffer& out) const {
+            out.push_back('{');
+            if (bytes) { jsonrpc::append_raw(out, "\"blob\":"); jsonrpc::append_string(out, core::base64_encode(*bytes)); out.push_back(','); }
+            else if (blob) { jsonrpc::append_raw(out, "\"blob\":"); jsonrpc::append_string(out, *blob); out.push_back(','); }
+            if (mime_type) { jsonrpc::append_raw(out, "\"mimeType\":"); jsonrpc::append_string(out, *mime_type); out.push_back(','); }
+            if (text) { jsonrpc::append_raw(out, "\"text\":"); jsonrpc::append_string(out, *text); out.push_back(','); }
+            jsonrpc::append_raw(out, "\"uri\":");
+            jsonrpc::append_string(out, uri);
+            out.push_back('}');
+        }
+    };
+
+    /**
+     * @brief Writes a ResourceContent whose text or blob arrives in pieces
+     *
+     * Appends the same JSON as ResourceContent::write_json(), for data that is
+     * only ever viewed a piece at a time, such as a file mapped window by window.
+     * Text pieces must hold whole UTF-8 characters; blob pieces are raw bytes,
+     * split anywhere, and are base64-encoded as they arrive. uri and mime_type
+     * must outlive the writer.
+     */
+    class ResourceContentWriter 
+    {
+    public:
+        ResourceContentWriter(jsonrpc::encoded_buffer& out, std::string_view uri,
+                              std::optional<std::string_view> mime_type, bool blob)
+            : out_(out), uri_(uri), mime_type_(mime_type), blob_(blob)
+        {
+            out_.push_back('{');
+            if (blob_) {
+                jsonrpc::append_raw(out_, "\"blob\":\"");
+                return;
+            }
+            write_mime_type();
+            jsonrpc::append_raw(out_, "\"text\":\"");
+        }
+
+        void append(std::string_view piece) {
+            if (!blob_) {
+                jsonrpc::append_escaped(out_, piece);
+                return;
+            }
+            // Complete the group of three bytes left over from the last piece
+            if (pending_size_ > 0) {
+                while (pending_size_ < 3 && !piece.empty()) {
+                    pending_[pending_size_++] = piece.front();
+                    piece.remove_prefix(1);
+                }
+                if (pending_size_ < 3) return;
+                core::base64_encode(std::string_view(pending_, 3), out_);
+                pending_size_ = 0;
+            }
+            const size_t whole = piece.size() / 3 * 3;
+            core::base64_encode(piece.substr(0, whole), out_);
+            for (char c : piece.substr(whole)) pending_[pending_size_++] = c;
+        }
+
+        /**
+         * @brief Close the object; call once, after the last piece
+         */
+        void finish() {
+            if (blob_) {
+                core::base64_encode(std::string_view(pending_, pending_size_), out_);
+                pending_size_ = 0;
+                jsonrpc::append_raw(out_, "\",");
+                write_mime_type();
+            } else {
+                jsonrpc::append_raw(out_, "\",");
+            }
+            jsonrpc::append_raw(out_, "\"uri\":");
+            jsonrpc::append_string(out_, uri_);
+            out_.push_back('}');
+        }
+
+    private:
+        void write_mime_type() {
+            if (!mime_type_) return;
+            jsonrpc::append_raw(out_, "\"mimeType\":");
+            jsonrpc::append_string(out_, *mime_type_);
+            out_.push_back(',');
+        }
+
+        jsonrpc::encoded_buffer& out_;
+        std::string_view uri_;
+        std::optional<std::string_view> mime_type_;
+        bool blob_;
+        char pending_[3] = {};
+        size_t pending_size_ = 0;
     };
 
     /**
@@ -415,6 +566,7 @@ namespace pooriayousefi::mcp
         std::optional<json> resources;
         std::optional<json> tools;
         std::optional<json> logging;
+        std::optional<std::string> encoding; // binary encoding chosen from ClientCapabilities::encodings
         
         json to_json() const {
             json j = json::object();
@@ -422,6 +574,7 @@ namespace pooriayousefi::mcp
             if (resources) j["resources"] = *resources;
             if (tools) j["tools"] = *tools;
             if (logging) j["logging"] = *logging;
+            if (encoding) j["encoding"] = *encoding;
             return j;
         }
     };
@@ -434,12 +587,14 @@ namespace pooriayousefi::mcp
         std::optional<json> experimental;
         std::optional<json> sampling;
         std::optional<json> roots;
+        std::vector<std::string> encodings; // binary message encodings offered ("cbor", "msgpack"), preferred first
         
         json to_json() const {
             json j = json::object();
             if (experimental) j["experimental"] = *experimental;
             if (sampling) j["sampling"] = *sampling;
             if (roots) j["roots"] = *roots;
+            if (!encodings.empty()) j["encodings"] = encodings;
             return j;
         }
     };
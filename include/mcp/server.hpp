@@ -3,11 +3,20 @@
 #include "protocol.hpp"
 #include "jsonrpc/jsonrpc.hpp"
 #include "transport/transport.hpp"
+#include "core/resultcache.hpp"
 #include <memory>
 #include <functional>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <iterator>
 #include <stdexcept>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <optional>
 
 /**
  * @file server.hpp
@@ -19,6 +28,258 @@
 
 namespace pooriayousefi::mcp 
 {
+    namespace detail {
+        /**
+         * @brief Serialized, paginated view of one list method (tools/list, ...)
+         *
+         * Items are serialized and sorted by key once, and every page is built on
+         * first request and then served from the cache until invalidate() is
+         * called. The cursor is the key of the last item on the previous page, so
+         * paging stays consistent while items are added or removed between calls.
+         * put() and erase() apply a single change in place and drop only the
+         * cached pages that change falls in. For transports that take pre-encoded
+         * results, pages are kept as the finished JSON bytes (jsonrpc::encoded),
+         * so serving one neither copies a tree nor dumps it again.
+         */
+        class list_cache {
+        public:
+            using entry = std::pair<std::string, json>;
+            using builder = std::function<std::vector<entry>()>;
+            using change = std::pair<std::string, std::optional<json>>;
+
+            /**
+             * @param field Name of the result array ("tools", "prompts", "resources")
+             */
+            explicit list_cache(std::string field) : field_(std::move(field)) {}
+
+            /**
+             * @brief Drop the cached items; the next page() rebuilds them
+             * @param publish Runs under the cache lock, e.g. to swap what the builder
+             *        reads, so no page is built or served from one without the other
+             */
+            void invalidate(const std::function<void()>& publish = {}) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (publish) publish();
+                stale_ = true;
+            }
+
+            /**
+             * @brief Apply a batch of put() (a value) and erase() (nullopt) changes as one step
+             * @param publish Runs under the cache lock first, as for invalidate()
+             */
+            void update(const std::vector<change>& changes, const std::function<void()>& publish = {}) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (publish) publish();
+                if (stale_) {
+                    return;
+                }
+                for (const auto& [key, item] : changes) {
+                    if (item) {
+                        put_locked(key, *item);
+                    } else {
+                        erase_locked(key);
+                    }
+                }
+            }
+
+            /**
+             * @brief Add or replace one item
+             *
+             * Ignored while the cache is stale, since the next page() rebuilds
+             * everything anyway.
+             */
+            void put(std::string key, json item) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!stale_) {
+                    put_locked(std::move(key), std::move(item));
+                }
+            }
+
+            /**
+             * @brief Remove one item; ignored while the cache is stale
+             */
+            void erase(const std::string& key) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!stale_) {
+                    erase_locked(key);
+                }
+            }
+
+            /**
+             * @brief Number of rebuilds so far
+             */
+            uint64_t version() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return version_;
+            }
+
+            /**
+             * @brief Number of pages currently cached
+             */
+            size_t cached_pages() const {
+                std::lock_guard<std::mutex> lock(mutex_);
+                return pages_.size();
+            }
+
+            /**
+             * @brief Result for one list request
+             * @param params Request params; an optional string `cursor` selects the page
+             * @param page_size Items per page; 0 returns everything after the cursor
+             * @param build Serializes the current items when the cache is stale
+             * @param encoded Return the page as jsonrpc::encoded bytes (see Server::encoded_results())
+             */
+            json page(const json& params, size_t page_size, const builder& build, bool encoded = false) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stale_) {
+                    entries_.clear();
+                    for (auto& [key, item] : build()) {
+                        entries_.insert_or_assign(std::move(key), std::move(item));
+                    }
+                    pages_.clear();
+                    stale_ = false;
+                    ++version_;
+                }
+                if (page_size != page_size_ || encoded != encoded_) {
+                    pages_.clear();
+                    page_size_ = page_size;
+                    encoded_ = encoded;
+                }
+
+                // The first page is cached under the empty cursor
+                std::string after;
+                if (params.is_object() && params.contains("cursor") && !params["cursor"].is_null()) {
+                    const auto& cursor = params["cursor"];
+                    if (!cursor.is_string() || cursor.get_ref<const std::string&>().empty()) {
+                        throw jsonrpc::rpc_exception(jsonrpc::error{
+                            -32602, "Invalid cursor", nullptr
+                        });
+                    }
+                    after = cursor.get_ref<const std::string&>();
+                }
+
+                auto cached = pages_.find(after);
+                if (cached != pages_.end()) {
+                    return cached->second.result;
+                }
+
+                auto first = after.empty() ? entries_.begin() : entries_.upper_bound(after);
+                auto last = first;
+                for (size_t n = 0; last != entries_.end() && (page_size == 0 || n < page_size); ++last, ++n) {}
+
+                cached_page built;
+                built.more = last != entries_.end();
+                if (first != last) {
+                    built.last = std::prev(last)->first;
+                }
+                built.result = encoded ? encode(first, last) : tree(first, last);
+                return pages_.emplace(std::move(after), std::move(built)).first->second.result;
+            }
+
+        private:
+            using entry_map = std::map<std::string, json, std::less<>>;
+
+            struct cached_page {
+                json result;
+                std::string last;   // key of the last item on the page
+                bool more = false;  // a next page follows
+            };
+
+            void put_locked(std::string key, json item) {
+                drop_pages(key);
+                entries_.insert_or_assign(std::move(key), std::move(item));
+            }
+
+            void erase_locked(const std::string& key) {
+                if (entries_.erase(key) > 0) {
+                    drop_pages(key);
+                }
+            }
+
+            // A page holds the items after its cursor up to `last`, or up to the
+            // end when nothing follows it; drop those a change to `key` falls in
+            void drop_pages(const std::string& key) {
+                for (auto it = pages_.begin(); it != pages_.end() && it->first < key;) {
+                    if (!it->second.more || key <= it->second.last) {
+                        it = pages_.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            }
+
+            json tree(entry_map::const_iterator first, entry_map::const_iterator last) const {
+                json items = json::array();
+                items.get_ref<json::array_t&>().reserve(static_cast<size_t>(std::distance(first, last)));
+                for (auto it = first; it != last; ++it) {
+                    items.push_back(it->second);
+                }
+                json result = json{{field_, std::move(items)}};
+                if (last != entries_.end()) {
+                    result["nextCursor"] = std::prev(last)->first;
+                }
+                return result;
+            }
+
+            // The bytes tree(first, last).dump() would give, keys in the same order
+            json encode(entry_map::const_iterator first, entry_map::const_iterator last) const {
+                jsonrpc::encoded_buffer out;
+                out.reserve(64 + static_cast<size_t>(std::distance(first, last)) * 128);
+                out.push_back('{');
+                if (last != entries_.end()) {
+                    jsonrpc::append_raw(out, "\"nextCursor\":");
+                    jsonrpc::append_string(out, std::prev(last)->first);
+                    out.push_back(',');
+                }
+                jsonrpc::append_string(out, field_);
+                jsonrpc::append_raw(out, ":[");
+                for (auto it = first; it != last; ++it) {
+                    if (it != first) out.push_back(',');
+                    jsonrpc::append_value(out, it->second);
+                }
+                jsonrpc::append_raw(out, "]}");
+                return jsonrpc::encoded(std::move(out));
+            }
+
+            std::string field_;
+            mutable std::mutex mutex_;
+            entry_map entries_;
+            std::map<std::string, cached_page, std::less<>> pages_;
+            size_t page_size_ = 0;
+            bool encoded_ = false;
+            uint64_t version_ = 0;
+            bool stale_ = true;
+        };
+
+        // Estimated bytes held by a result: strings, binary buffers and one node per value
+        inline size_t approximate_size(const json& value) {
+            switch (value.type()) {
+                case json::value_t::string: return sizeof(json) + value.get_ref<const std::string&>().size();
+                case json::value_t::binary: return sizeof(json) + value.get_binary().size();
+                case json::value_t::array: {
+                    size_t bytes = sizeof(json);
+                    for (const auto& element : value) bytes += approximate_size(element);
+                    return bytes;
+                }
+                case json::value_t::object: {
+                    size_t bytes = sizeof(json);
+                    for (const auto& [key, element] : value.items()) bytes += 48 + key.size() + approximate_size(element);
+                    return bytes;
+                }
+                default: return sizeof(json);
+            }
+        }
+    }
+
+    /**
+     * @brief Opts a tool or resource into the server's result cache
+     *
+     * Only for handlers whose result depends on nothing but their input
+     * (tool name and arguments, or resource URI).
+     */
+    struct CachePolicy {
+        std::chrono::milliseconds ttl{0}; ///< How long a result stays valid; 0 keeps it until invalidated or evicted
+    };
+
     /**
      * @brief MCP Server for providing tools, prompts, and resources
      */
@@ -40,15 +301,23 @@ namespace pooriayousefi::mcp
             const Implementation& server_info
         )
             : transport_(std::move(transport))
-            , endpoint_(std::make_unique<jsonrpc::endpoint>([this](const json& msg) {
-                  transport_->send(msg);
+            , endpoint_(std::make_unique<jsonrpc::endpoint>([this](json&& msg) {
+                  transport_->send(std::move(msg));
               }))
             , server_info_(server_info)
             , initialized_(false)
+            , page_size_(0)
+            , tools_list_("tools")
+            , prompts_list_("prompts")
+            , resources_list_("resources")
+            , templates_list_("resourceTemplates")
         {
             // Set up transport message handler
-            transport_->on_message([this](const json& msg) {
-                endpoint_->receive(msg);
+            transport_->on_message([this](json&& msg) {
+                endpoint_->receive(std::move(msg));
+            });
+            transport_->set_message_filter([this](const jsonrpc::envelope& envelope) {
+                return endpoint_->accepts(envelope);
             });
 
             transport_->on_error([this](const std::string& error) {
@@ -59,6 +328,7 @@ namespace pooriayousefi::mcp
 
             transport_->on_close([this]() {
                 initialized_ = false;
+                transport_->set_encoding(transport::Encoding::json);
             });
 
             // Register MCP protocol methods
@@ -107,14 +377,95 @@ namespace pooriayousefi::mcp
             capabilities_.logging = json::object();
         }
 
+        /**
+         * @brief Binary encodings this server may switch to, preferred first (default: none)
+         *
+         * During `initialize` the first one the client offers in
+         * ClientCapabilities::encodings and the transport can carry is chosen and
+         * reported as `capabilities.encoding`. The server accepts it at once and
+         * sends in it after `notifications/initialized`; resource blobs given as
+         * raw bytes then travel without base64.
+         */
+        void set_encodings(std::vector<transport::Encoding> encodings) {
+            std::lock_guard<std::mutex> lock(encoding_mutex_);
+            encodings_ = std::move(encodings);
+        }
+
+        /**
+         * @brief Paginate tools/list, prompts/list and resources/list
+         * @param page_size Items per page; 0 (the default) returns each list in one response
+         *
+         * Responses carry `nextCursor` while more items remain. Each list is
+         * serialized once and cached until the next register_* call.
+         */
+        void set_page_size(size_t page_size) {
+            page_size_ = page_size;
+        }
+
+        size_t page_size() const {
+            return page_size_;
+        }
+
+        /**
+         * @brief Whether handlers should return pre-encoded results (jsonrpc::encoded)
+         *
+         * Pre-encoded results are JSON text, so only worth building for JSON
+         * transports that take them.
+         */
+        bool encoded_results() const {
+            return transport_->accepts_encoded() && transport_->encoding() == transport::Encoding::json;
+        }
+
+        /**
+         * @brief Encoding of outgoing messages: JSON until the client negotiates a binary one
+         */
+        transport::Encoding encoding() const {
+            return transport_->encoding();
+        }
+
+        /**
+         * @brief Keep results of cacheable tools and resources (see CachePolicy)
+         * @param max_bytes Estimated size of all cached results; least recently used go first
+         *
+         * Identical concurrent calls run the handler once and share its result.
+         * Tool results are keyed by name and canonical arguments, resource
+         * results by URI. notify_tools_changed() and notify_resources_changed()
+         * drop the matching entries, as does registering a handler again.
+         */
+        void enable_result_cache(size_t max_bytes = 64u << 20) {
+            if (result_cache_) {
+                result_cache_->set_max_bytes(max_bytes);
+            } else {
+                result_cache_ = std::make_unique<core::ResultCache<json>>(max_bytes);
+            }
+        }
+
+        /**
+         * @brief Counters of the result cache (all zero when it is not enabled)
+         */
+        core::ResultCacheStats result_cache_stats() const {
+            return result_cache_ ? result_cache_->stats() : core::ResultCacheStats{};
+        }
+
+        /**
+         * @brief Drop every cached tool and resource result
+         */
+        void invalidate_result_cache() {
+            if (result_cache_) result_cache_->clear();
+        }
+
         /**
          * @brief Register a tool
          * @param tool Tool definition
          * @param handler Handler function that processes tool calls
+         * @param cache Cache results (needs enable_result_cache()); only for deterministic tools
          */
-        void register_tool(const Tool& tool, ToolHandler handler) {
-            tools_[tool.name] = tool;
-            tool_handlers_[tool.name] = std::move(handler);
+        void register_tool(const Tool& tool, ToolHandler handler, std::optional<CachePolicy> cache = std::nullopt) {
+            registered_tool entry{tool, std::move(handler), cache, {}};
+            entry.probe.resolve(metrics_.get(), "mcp_tool", "tool", tool.name);
+            tools_.insert_or_assign(tool.name, std::move(entry));
+            tools_list_.invalidate();
+            invalidate_cached("t\n" + tool.name + "\n");
         }
 
         /**
@@ -123,18 +474,62 @@ namespace pooriayousefi::mcp
          * @param handler Handler function that generates prompt messages
          */
         void register_prompt(const Prompt& prompt, PromptHandler handler) {
-            prompts_[prompt.name] = prompt;
-            prompt_handlers_[prompt.name] = std::move(handler);
+            prompts_.insert_or_assign(prompt.name, registered_prompt{prompt, std::move(handler)});
+            prompts_list_.invalidate();
         }
 
         /**
          * @brief Register a resource
          * @param resource Resource definition
          * @param reader Reader function that provides resource content
+         * @param cache Cache contents (needs enable_result_cache()); only for immutable resources
          */
-        void register_resource(const Resource& resource, ResourceReader reader) {
+        void register_resource(const Resource& resource, ResourceReader reader, std::optional<CachePolicy> cache = std::nullopt) {
             resources_[resource.uri] = resource;
-            resource_readers_[resource.uri] = std::move(reader);
+            resource_readers_[resource.uri] = registered_reader{std::move(reader), cache};
+            resources_list_.invalidate();
+            invalidate_cached("r\n");
+        }
+
+        /**
+         * @brief Register one reader for every URI matching a resource template
+         * @param resource_template Template listed by resources/templates/list (e.g. "file://{path}")
+         * @param reader Reader for any URI that starts with the template text before its first '{'
+         *
+         * Nothing is registered per resource, so a template can stand for a whole
+         * directory tree. Exact registrations win; among templates the longest prefix does.
+         * @param cache Cache contents per URI (needs enable_result_cache())
+         */
+        void register_resource_template(const ResourceTemplate& resource_template, ResourceReader reader, std::optional<CachePolicy> cache = std::nullopt) {
+            std::string prefix = resource_template.uri_template.substr(0, resource_template.uri_template.find('{'));
+            resource_templates_[resource_template.uri_template] = resource_template;
+            auto it = std::find_if(template_readers_.begin(), template_readers_.end(), [&](const auto& entry) {
+                return entry.first == prefix;
+            });
+            if (it != template_readers_.end()) {
+                it->second = registered_reader{std::move(reader), cache};
+            } else {
+                template_readers_.emplace_back(std::move(prefix), registered_reader{std::move(reader), cache});
+                std::stable_sort(template_readers_.begin(), template_readers_.end(), [](const auto& a, const auto& b) {
+                    return a.first.size() > b.first.size();
+                });
+            }
+            templates_list_.invalidate();
+            invalidate_cached("r\n");
+        }
+
+        /**
+         * @brief Register a raw JSON-RPC method, replacing any built-in handler
+         * @param method Method name (e.g. "resources/read")
+         * @param handler Receives the request params and returns the result
+         *
+         * The handler runs with the same call context as the built-in methods, so
+         * jsonrpc::report_progress() and jsonrpc::is_canceled() work inside it.
+         * Methods may be added while serving; requests already dispatched keep the
+         * table they were looked up in.
+         */
+        void add(const std::string& method, jsonrpc::dispatcher::handler_t handler) {
+            endpoint_->add(method, std::move(handler));
         }
 
         /**
@@ -144,6 +539,63 @@ namespace pooriayousefi::mcp
             error_callback_ = std::move(callback);
         }
 
+        /**
+         * @brief Run request handlers on a worker pool instead of the transport thread
+         * @param pool Shared pool (nullptr restores inline dispatch)
+         * 
+         * A slow tool no longer blocks other requests or `$/cancelRequest`;
+         * responses go out in completion order.
+         */
+        void set_executor(std::shared_ptr<core::ThreadPool> pool) {
+            endpoint_->set_executor(std::move(pool));
+        }
+
+        /**
+         * @brief Record metrics and run span hooks for this server
+         * @param metrics Registry (nullptr stops recording)
+         * @param transport_name transport label of this server's traffic series
+         * 
+         * On top of the per-method series and pending count of
+         * jsonrpc::endpoint::set_metrics() and the traffic of
+         * transport::Transport::set_metrics(), every tool gets mcp_tool_calls_total,
+         * mcp_tool_errors_total and mcp_tool_duration_seconds. Call before start().
+         */
+        void set_metrics(std::shared_ptr<core::Metrics> metrics, const std::string& transport_name = "server") {
+            metrics_ = metrics;
+            for (auto& [name, entry] : tools_) {
+                entry.probe.resolve(metrics_.get(), "mcp_tool", "tool", name);
+            }
+            endpoint_->set_metrics(metrics);
+            transport_->set_metrics(std::move(metrics), transport_name);
+        }
+
+        /**
+         * @brief Limit concurrent executions of one method on the executor
+         * @param method JSON-RPC method (e.g. "tools/call")
+         * @param limit Maximum concurrent requests (0 = unlimited)
+         */
+        void set_method_concurrency(const std::string& method, size_t limit) {
+            endpoint_->set_method_concurrency(method, limit);
+        }
+
+        /**
+         * @brief Limit how often each request's progress reports are sent
+         * @param limits Minimum interval and fraction change between reports
+         * 
+         * Held-back reports are coalesced (latest wins) and the last one is
+         * always sent before the response, so a final 100% is never lost.
+         */
+        void set_progress_throttle(jsonrpc::progress_throttle limits) {
+            endpoint_->set_progress_throttle(limits);
+        }
+
+        /**
+         * @brief Close the transport so its thread stops calling into this server
+         */
+        ~Server() {
+            close();
+        }
+
         /**
          * @brief Start the server (begins transport)
          */
@@ -156,6 +608,7 @@ namespace pooriayousefi::mcp
          */
         void close() {
             transport_->close();
+            endpoint_->wait_idle();
             initialized_ = false;
         }
 
@@ -174,9 +627,10 @@ namespace pooriayousefi::mcp
         }
 
         /**
-         * @brief Notify that tools list has changed
+         * @brief Notify that tools list has changed; cached tool results are dropped
          */
         void notify_tools_changed() {
+            invalidate_cached("t\n");
             send_notification("notifications/tools/list_changed");
         }
 
@@ -188,9 +642,10 @@ namespace pooriayousefi::mcp
         }
 
         /**
-         * @brief Notify that resources list has changed
+         * @brief Notify that resources list has changed; cached resource contents are dropped
          */
         void notify_resources_changed() {
+            invalidate_cached("r\n");
             send_notification("notifications/resources/list_changed");
         }
 
@@ -208,6 +663,22 @@ namespace pooriayousefi::mcp
         }
 
     private:
+        // Each name is stored once, with its definition and handler; all lookups take a string_view
+        struct registered_tool {
+            Tool tool;
+            ToolHandler handler;
+            std::optional<CachePolicy> cache;
+            core::CallProbe probe;
+        };
+        struct registered_prompt {
+            Prompt prompt;
+            PromptHandler handler;
+        };
+        struct registered_reader {
+            ResourceReader read;
+            std::optional<CachePolicy> cache;
+        };
+
         void register_protocol_methods() {
             // Initialize
             endpoint_->add("initialize", [this](const json& params) -> json {
@@ -222,33 +693,51 @@ namespace pooriayousefi::mcp
                     client_capabilities_ = params["capabilities"];
                 }
 
+                ServerCapabilities capabilities = capabilities_;
+                if (auto encoding = negotiate_encoding(client_capabilities_)) {
+                    // Binary input may follow the response at once; output switches on notifications/initialized
+                    transport_->accept_encoding(*encoding);
+                    capabilities.encoding = std::string(transport::encoding_name(*encoding));
+                    negotiated_encoding_ = *encoding;
+                }
+
                 initialized_ = true;
 
                 // Return server info and capabilities
                 ServerInfo info{
                     server_info_,
                     MCP_PROTOCOL_VERSION,
-                    capabilities_.to_json(),
+                    capabilities.to_json(),
                     instructions_
                 };
 
                 return info.to_json();
             });
 
+            // Initialized: the client now reads the negotiated encoding
+            endpoint_->add("notifications/initialized", [this](const json&) -> json {
+                if (initialized_) {
+                    transport_->set_encoding(negotiated_encoding_);
+                }
+                return json{};
+            });
+
             // Tools list
-            endpoint_->add("tools/list", [this](const json&) -> json {
+            endpoint_->add("tools/list", [this](const json& params) -> json {
                 if (!initialized_) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32600, "Not initialized", nullptr
                     });
                 }
 
-                json tools_array = json::array();
-                for (const auto& [name, tool] : tools_) {
-                    tools_array.push_back(tool.to_json());
-                }
-
-                return json{{"tools", tools_array}};
+                return tools_list_.page(params, page_size_, [this]() {
+                    std::vector<detail::list_cache::entry> entries;
+                    entries.reserve(tools_.size());
+                    for (const auto& [name, entry] : tools_) {
+                        entries.emplace_back(name, entry.tool.to_json());
+                    }
+                    return entries;
+                }, encoded_results());
             });
 
             // Tools call
@@ -259,32 +748,57 @@ namespace pooriayousefi::mcp
                     });
                 }
 
-                std::string tool_name = params.value("name", "");
+                // Looked up in place: the name is never copied out of the request
+                auto name = params.find("name");
+                std::string_view tool_name = name != params.end() && name->is_string()
+                    ? std::string_view(name->get_ref<const std::string&>()) : std::string_view();
                 if (tool_name.empty()) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32602, "Missing tool name", nullptr
                     });
                 }
 
-                auto it = tool_handlers_.find(tool_name);
-                if (it == tool_handlers_.end()) {
+                auto it = tools_.find(tool_name);
+                if (it == tools_.end()) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
-                        -32601, "Tool not found: " + tool_name, nullptr
+                        -32601, "Tool not found: " + std::string(tool_name), nullptr
                     });
                 }
 
-                json arguments = params.value("arguments", json::object());
+                static const json no_arguments = json::object();
+                auto args = params.find("arguments");
+                const json& arguments = args != params.end() ? *args : no_arguments;
+                const registered_tool& entry = it->second;
+                const auto started = entry.probe.start();
                 
                 try {
-                    auto result = it->second(arguments);
-                    
-                    json content_array = json::array();
-                    for (const auto& content : result) {
-                        content_array.push_back(content.to_json());
-                    }
+                    auto call = [&]() -> json {
+                        auto result = entry.handler(arguments);
+                        if (encoded_results()) {
+                            return encode_list("content", result);
+                        }
+                        
+                        json content_array = json::array();
+                        for (const auto& content : result) {
+                            content_array.push_back(content.to_json());
+                        }
 
-                    return json{{"content", content_array}};
+                        return json{{"content", std::move(content_array)}};
+                    };
+                    json result;
+                    if (!entry.cache || !result_cache_) {
+                        result = call();
+                    } else {
+                        // Object keys are sorted, so dump() is a canonical form of the arguments
+                        std::string key = "t\n";
+                        key.append(tool_name).append("\n").push_back(encoded_results() ? 'e' : 'j');
+                        key.append(arguments.dump());
+                        result = cached(key, call, *entry.cache);
+                    }
+                    entry.probe.finish(started, true);
+                    return result;
                 } catch (const std::exception& e) {
+                    entry.probe.finish(started, false);
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32603, std::string("Tool execution failed: ") + e.what(), nullptr
                     });
@@ -292,19 +806,21 @@ namespace pooriayousefi::mcp
             });
 
             // Prompts list
-            endpoint_->add("prompts/list", [this](const json&) -> json {
+            endpoint_->add("prompts/list", [this](const json& params) -> json {
                 if (!initialized_) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32600, "Not initialized", nullptr
                     });
                 }
 
-                json prompts_array = json::array();
-                for (const auto& [name, prompt] : prompts_) {
-                    prompts_array.push_back(prompt.to_json());
-                }
-
-                return json{{"prompts", prompts_array}};
+                return prompts_list_.page(params, page_size_, [this]() {
+                    std::vector<detail::list_cache::entry> entries;
+                    entries.reserve(prompts_.size());
+                    for (const auto& [name, entry] : prompts_) {
+                        entries.emplace_back(name, entry.prompt.to_json());
+                    }
+                    return entries;
+                }, encoded_results());
             });
 
             // Prompts get
@@ -315,17 +831,19 @@ namespace pooriayousefi::mcp
                     });
                 }
 
-                std::string prompt_name = params.value("name", "");
+                auto name = params.find("name");
+                std::string_view prompt_name = name != params.end() && name->is_string()
+                    ? std::string_view(name->get_ref<const std::string&>()) : std::string_view();
                 if (prompt_name.empty()) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32602, "Missing prompt name", nullptr
                     });
                 }
 
-                auto it = prompt_handlers_.find(prompt_name);
-                if (it == prompt_handlers_.end()) {
+                auto it = prompts_.find(prompt_name);
+                if (it == prompts_.end()) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
-                        -32601, "Prompt not found: " + prompt_name, nullptr
+                        -32601, "Prompt not found: " + std::string(prompt_name), nullptr
                     });
                 }
 
@@ -340,14 +858,17 @@ namespace pooriayousefi::mcp
                 }
 
                 try {
-                    auto messages = it->second(arguments);
+                    auto messages = it->second.handler(arguments);
+                    if (encoded_results()) {
+                        return encode_list("messages", messages);
+                    }
                     
                     json messages_array = json::array();
                     for (const auto& msg : messages) {
                         messages_array.push_back(msg.to_json());
                     }
 
-                    return json{{"messages", messages_array}};
+                    return json{{"messages", std::move(messages_array)}};
                 } catch (const std::exception& e) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32603, std::string("Prompt generation failed: ") + e.what(), nullptr
@@ -356,19 +877,39 @@ namespace pooriayousefi::mcp
             });
 
             // Resources list
-            endpoint_->add("resources/list", [this](const json&) -> json {
+            endpoint_->add("resources/list", [this](const json& params) -> json {
                 if (!initialized_) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32600, "Not initialized", nullptr
                     });
                 }
 
-                json resources_array = json::array();
-                for (const auto& [uri, resource] : resources_) {
-                    resources_array.push_back(resource.to_json());
+                return resources_list_.page(params, page_size_, [this]() {
+                    std::vector<detail::list_cache::entry> entries;
+                    entries.reserve(resources_.size());
+                    for (const auto& [uri, resource] : resources_) {
+                        entries.emplace_back(uri, resource.to_json());
+                    }
+                    return entries;
+                }, encoded_results());
+            });
+
+            // Resource templates list
+            endpoint_->add("resources/templates/list", [this](const json& params) -> json {
+                if (!initialized_) {
+                    throw jsonrpc::rpc_exception(jsonrpc::error{
+                        -32600, "Not initialized", nullptr
+                    });
                 }
 
-                return json{{"resources", resources_array}};
+                return templates_list_.page(params, page_size_, [this]() {
+                    std::vector<detail::list_cache::entry> entries;
+                    entries.reserve(resource_templates_.size());
+                    for (const auto& [uri_template, resource_template] : resource_templates_) {
+                        entries.emplace_back(uri_template, resource_template.to_json());
+                    }
+                    return entries;
+                }, encoded_results());
             });
 
             // Resources read
@@ -386,22 +927,36 @@ namespace pooriayousefi::mcp
                     });
                 }
 
-                auto it = resource_readers_.find(uri);
-                if (it == resource_readers_.end()) {
+                const registered_reader* reader = find_reader(uri);
+                if (!reader) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32601, "Resource not found: " + uri, nullptr
                     });
                 }
 
                 try {
-                    auto contents = it->second(uri);
-                    
-                    json contents_array = json::array();
-                    for (const auto& content : contents) {
-                        contents_array.push_back(content.to_json());
-                    }
+                    const bool encoded = encoded_results();
+                    const bool raw_blobs = transport_->encoding() != transport::Encoding::json;
+                    auto read = [&]() -> json {
+                        auto contents = reader->read(uri);
+                        if (encoded) {
+                            return encode_list("contents", contents);
+                        }
+                        
+                        json contents_array = json::array();
+                        for (const auto& content : contents) {
+                            contents_array.push_back(content.to_json(raw_blobs));
+                        }
 
-                    return json{{"contents", contents_array}};
+                        return json{{"contents", std::move(contents_array)}};
+                    };
+                    if (!reader->cache || !result_cache_) {
+                        return read();
+                    }
+                    std::string key = "r\n";
+                    key.push_back(encoded ? 'e' : raw_blobs ? 'b' : 'j');
+                    key.append(uri);
+                    return cached(key, read, *reader->cache);
                 } catch (const std::exception& e) {
                     throw jsonrpc::rpc_exception(jsonrpc::error{
                         -32603, std::string("Resource read failed: ") + e.what(), nullptr
@@ -410,22 +965,98 @@ namespace pooriayousefi::mcp
             });
         }
 
+        // First encoding the client offers that this server allows and the transport carries
+        std::optional<transport::Encoding> negotiate_encoding(const json& client_capabilities) {
+            auto offered = client_capabilities.find("encodings");
+            if (offered == client_capabilities.end() || !offered->is_array()) {
+                return std::nullopt;
+            }
+            std::lock_guard<std::mutex> lock(encoding_mutex_);
+            for (const auto& name : *offered) {
+                auto encoding = name.is_string() ? transport::parse_encoding(name.get_ref<const std::string&>()) : std::nullopt;
+                if (encoding && *encoding != transport::Encoding::json &&
+                    std::find(encodings_.begin(), encodings_.end(), *encoding) != encodings_.end() &&
+                    transport_->supports_encoding(*encoding)) {
+                    return encoding;
+                }
+            }
+            return std::nullopt;
+        }
+
+        // {"<field>":[...]} written straight from the items, for transports that take encoded results
+        template<typename T>
+        static json encode_list(std::string_view field, const std::vector<T>& items) {
+            jsonrpc::encoded_buffer out;
+            out.reserve(256);
+            out.push_back('{');
+            jsonrpc::append_string(out, field);
+            jsonrpc::append_raw(out, ":[");
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (i) out.push_back(',');
+                items[i].write_json(out);
+            }
+            jsonrpc::append_raw(out, "]}");
+            return jsonrpc::encoded(std::move(out));
+        }
+
+        // Result of compute(), shared with concurrent identical calls and kept per policy
+        template<typename Compute>
+        json cached(const std::string& key, Compute&& compute, const CachePolicy& policy) {
+            auto value = result_cache_->get_or_compute(key, std::forward<Compute>(compute), detail::approximate_size, policy.ttl);
+            return *value;
+        }
+
+        void invalidate_cached(const std::string& prefix) {
+            if (result_cache_) {
+                result_cache_->erase_if([&prefix](std::string_view key) { return key.starts_with(prefix); });
+            }
+        }
+
+        // Exact URI first, then the longest matching template prefix
+        const registered_reader* find_reader(std::string_view uri) const {
+            auto it = resource_readers_.find(uri);
+            if (it != resource_readers_.end()) {
+                return &it->second;
+            }
+            for (const auto& [prefix, reader] : template_readers_) {
+                if (uri.starts_with(prefix)) {
+                    return &reader;
+                }
+            }
+            return nullptr;
+        }
+
         std::shared_ptr<transport::Transport> transport_;
         std::unique_ptr<jsonrpc::endpoint> endpoint_;
         Implementation server_info_;
         std::optional<std::string> instructions_;
         ServerCapabilities capabilities_;
         json client_capabilities_;
-        bool initialized_;
+        std::atomic<bool> initialized_;
         ErrorCallback error_callback_;
+        std::atomic<size_t> page_size_;
+        std::vector<transport::Encoding> encodings_;
+        std::mutex encoding_mutex_;
+        std::atomic<transport::Encoding> negotiated_encoding_{transport::Encoding::json};
 
         // Registry
-        std::unordered_map<std::string, Tool> tools_;
-        std::unordered_map<std::string, ToolHandler> tool_handlers_;
-        std::unordered_map<std::string, Prompt> prompts_;
-        std::unordered_map<std::string, PromptHandler> prompt_handlers_;
+        jsonrpc::detail::string_map<registered_tool> tools_;
+        jsonrpc::detail::string_map<registered_prompt> prompts_;
         std::unordered_map<std::string, Resource> resources_;
-        std::unordered_map<std::string, ResourceReader> resource_readers_;
+        jsonrpc::detail::string_map<registered_reader> resource_readers_;
+        std::unordered_map<std::string, ResourceTemplate> resource_templates_;
+        std::vector<std::pair<std::string, registered_reader>> template_readers_; // by prefix, longest first
+
+        // Serialized list pages, invalidated by register_*
+        detail::list_cache tools_list_;
+        detail::list_cache prompts_list_;
+        detail::list_cache resources_list_;
+        detail::list_cache templates_list_;
+
+        // Results of tools and resources registered with a CachePolicy; keys start "t\n<name>\n" or "r\n"
+        std::unique_ptr<core::ResultCache<json>> result_cache_;
+
+        std::shared_ptr<core::Metrics> metrics_;
     };
 
 } // namespace pooriayousefi::mcp
@@ -3,6 +3,7 @@
 #include "server.hpp"
 #include "core/asyncops.hpp"
 #include <functional>
+#include <fstream>
 
 /**
  * @file server_streaming.hpp
@@ -10,6 +11,12 @@
  * 
  * Extends the base Server with Generator<T>-based streaming capabilities
  * for tools, prompts, and resources that produce large or incremental results.
+ *
+ * When a request carries a `partialResultToken`, every yielded chunk is sent
+ * at once as a `$/progress` notification on that token and the final result
+ * is left empty. Without a token the chunks are collected and returned
+ * together, as a plain Server would. The HTTP server transports remove the
+ * token, because their SSE stream is shared by every client.
  */
 
 namespace pooriayousefi::mcp 
@@ -77,18 +84,22 @@ namespace pooriayousefi::mcp
          * ```
          */
         void register_streaming_tool(const Tool& tool, StreamingToolHandler handler) {
-            // Wrap streaming handler to collect results
             Server::register_tool(tool, [handler = std::move(handler)](const json& args) {
                 std::vector<ToolResultContent> results;
+                const bool streaming = jsonrpc::has_partial_result_token();
+                size_t chunks = 0;
                 
-                // Iterate through generator, collecting results
                 for (const auto& content : handler(args)) {
-                    results.push_back(content);
-                    
-                    // Report progress after each chunk
-                    if (auto ctx = jsonrpc::current_context()) {
+                    ++chunks;
+                    if (streaming) {
+                        // Deliver the chunk now; nothing is held back for the final result
+                        jsonrpc::report_partial_result({
+                            {"content", json::array({content.to_json()})}
+                        });
+                    } else {
+                        results.push_back(content);
                         jsonrpc::report_progress({
-                            {"chunks_processed", results.size()}
+                            {"chunks_processed", chunks}
                         });
                     }
                     
@@ -122,29 +133,18 @@ namespace pooriayousefi::mcp
          * ```
          */
         void register_streaming_resource(const Resource& resource, StreamingResourceReader reader) {
-            // Wrap streaming reader to collect content
-            Server::register_resource(resource, [reader = std::move(reader)](const std::string& uri) {
-                std::vector<ResourceContent> contents;
-                
-                // Iterate through generator, collecting content
-                for (const auto& content : reader(uri)) {
-                    contents.push_back(content);
-                    
-                    // Report progress
-                    if (auto ctx = jsonrpc::current_context()) {
-                        jsonrpc::report_progress({
-                            {"bytes_read", content.text ? content.text->size() : 0}
-                        });
-                    }
-                    
-                    // Check for cancellation
-                    if (jsonrpc::is_canceled()) {
-                        break;
-                    }
-                }
-                
-                return contents;
-            });
+            Server::register_resource(resource, collect_chunks(std::move(reader)));
+        }
+
+        /**
+         * @brief Register a streaming reader for every URI matching a resource template
+         * @param resource_template Template listed by resources/templates/list
+         * @param reader Streaming reader for any URI under the template's prefix
+         *
+         * @see Server::register_resource_template
+         */
+        void register_streaming_resource_template(const ResourceTemplate& resource_template, StreamingResourceReader reader) {
+            Server::register_resource_template(resource_template, collect_chunks(std::move(reader)));
         }
 
         /**
@@ -178,27 +178,62 @@ namespace pooriayousefi::mcp
                 size_t processed = 0;
                 std::vector<ToolResultContent> results;
                 
+                const bool streaming = jsonrpc::has_partial_result_token();
+                
                 for (const auto& content : handler(args)) {
-                    results.push_back(content);
+                    if (streaming) {
+                        jsonrpc::report_partial_result({
+                            {"content", json::array({content.to_json()})}
+                        });
+                    } else {
+                        results.push_back(content);
+                    }
                     processed++;
                     
                     // Report progress as percentage
-                    if (auto ctx = jsonrpc::current_context()) {
-                        double progress = total > 0 ? (double)processed / total : 0.0;
+                    double progress = total > 0 ? (double)processed / total : 0.0;
+                    jsonrpc::report_progress({
+                        {"progress", progress},
+                        {"processed", processed},
+                        {"total", total}
+                    });
+                    
+                    if (jsonrpc::is_canceled()) {
+                        break;
+                    }
+                }
+                
+                return results;
+            });
+        }
+
+    private:
+        // Send each chunk as a partial result when the request has a token, else collect them
+        static ResourceReader collect_chunks(StreamingResourceReader reader) {
+            return [reader = std::move(reader)](const std::string& uri) {
+                std::vector<ResourceContent> contents;
+                const bool streaming = jsonrpc::has_partial_result_token();
+                
+                for (const auto& content : reader(uri)) {
+                    if (streaming) {
+                        jsonrpc::report_partial_result({
+                            {"contents", json::array({content.to_json()})}
+                        });
+                    } else {
+                        contents.push_back(content);
                         jsonrpc::report_progress({
-                            {"progress", progress},
-                            {"processed", processed},
-                            {"total", total}
+                            {"bytes_read", content.text ? content.text->size() : content.bytes ? content.bytes->size() : 0}
                         });
                     }
                     
+                    // Check for cancellation
                     if (jsonrpc::is_canceled()) {
                         break;
                     }
                 }
                 
-                return results;
-            });
+                return contents;
+            };
         }
     };
 
@@ -336,7 +371,8 @@ namespace pooriayousefi::mcp
      */
     template<typename T, typename Pred>
     Generator<T> filter_generator(Generator<T> generator, Pred predicate) {
-        for (const auto& item : generator) {
+        // Passes matching elements through by reference, without copying them
+        for (auto& item : generator) {
             if (predicate(item)) {
                 co_yield item;
             }
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../jsonrpc/jsonrpc.hpp"
+#include <string>
+#include <string_view>
+#include <optional>
+
+/**
+ * @file codec.hpp
+ * @brief Wire encodings for JSON-RPC messages
+ *
+ * Messages are JSON text by default. Peers that both support it may switch
+ * to CBOR (RFC 8949) or MessagePack after `initialize`; both carry binary
+ * values (json::binary) as raw byte strings, so resource blobs need no base64.
+ * A JSON text always starts with `{` or `[` (after whitespace) and a binary
+ * message never does, so a receiver can tell them apart frame by frame.
+ */
+
+namespace pooriayousefi::mcp::transport
+{
+    using json = jsonrpc::json;
+
+    /**
+     * @brief Encoding of the messages on a transport
+     */
+    enum class Encoding {
+        json,
+        cbor,
+        msgpack
+    };
+
+    /**
+     * @brief Name used in capabilities ("json", "cbor", "msgpack")
+     */
+    inline std::string_view encoding_name(Encoding encoding) {
+        switch (encoding) {
+            case Encoding::cbor: return "cbor";
+            case Encoding::msgpack: return "msgpack";
+            default: return "json";
+        }
+    }
+
+    inline std::optional<Encoding> parse_encoding(std::string_view name) {
+        if (name == "json") return Encoding::json;
+        if (name == "cbor") return Encoding::cbor;
+        if (name == "msgpack") return Encoding::msgpack;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief True when bytes are (or start like) a JSON text rather than a binary message
+     */
+    inline bool looks_like_json(std::string_view bytes) {
+        for (char c : bytes) {
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+            return c == '{' || c == '[';
+        }
+        return true;
+    }
+
+    namespace detail {
+        inline bool has_encoded(const json& message) {
+            if (message.is_array()) {
+                for (const auto& element : message) {
+                    if (has_encoded(element)) return true;
+                }
+                return false;
+            }
+            auto result = message.is_object() ? message.find("result") : message.end();
+            return result != message.end() && jsonrpc::is_encoded(*result);
+        }
+    }
+
+    /**
+     * @brief Serialize message into out (replacing its contents)
+     *
+     * JSON goes through jsonrpc::dump_into, so pre-encoded results are copied
+     * verbatim. The binary encodings parse pre-encoded results back into trees
+     * first; producers should not build them for such transports.
+     */
+    inline void encode_message(const json& message, Encoding encoding, std::string& out) {
+        if (encoding == Encoding::json) {
+            jsonrpc::dump_into(message, out);
+            return;
+        }
+        out.clear();
+        const json* source = &message;
+        json expanded;
+        if (detail::has_encoded(message)) {
+            expanded = message;
+            jsonrpc::expand_encoded(expanded);
+            source = &expanded;
+        }
+        if (encoding == Encoding::cbor) {
+            json::to_cbor(*source, nlohmann::detail::output_adapter<char>(out));
+        } else {
+            json::to_msgpack(*source, nlohmann::detail::output_adapter<char>(out));
+        }
+    }
+
+    /**
+     * @brief Parse one message; JSON texts are recognised whatever the encoding
+     * @throws json::exception on malformed input
+     */
+    inline json decode_message(std::string_view bytes, Encoding encoding) {
+        if (encoding == Encoding::json || looks_like_json(bytes)) {
+            return json::parse(bytes);
+        }
+        if (encoding == Encoding::cbor) {
+            return json::from_cbor(bytes.begin(), bytes.end(), true, true, json::cbor_tag_handler_t::ignore);
+        }
+        return json::from_msgpack(bytes.begin(), bytes.end());
+    }
+
+} // namespace pooriayousefi::mcp::transport
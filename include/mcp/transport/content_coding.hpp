@@ -0,0 +1,467 @@
+#pragma once
+
+#include "../core/deflate.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#if defined(POORIAYOUSEFI_USE_ZSTD) && __has_include(<zstd.h>)
+#include <zstd.h>
+#define POORIAYOUSEFI_TRANSPORT_HAS_ZSTD 1
+#endif
+#if defined(POORIAYOUSEFI_USE_BROTLI) && __has_include(<brotli/encode.h>) && __has_include(<brotli/decode.h>)
+#include <brotli/encode.h>
+#include <brotli/decode.h>
+#define POORIAYOUSEFI_TRANSPORT_HAS_BROTLI 1
+#endif
+
+/**
+ * @file content_coding.hpp
+ * @brief HTTP content codings (Content-Encoding / Accept-Encoding)
+ *
+ * Negotiates gzip, deflate, zstd or brotli from a client's Accept-Encoding
+ * and compresses bodies with them. Each backend is optional:
+ * - gzip and deflate need zlib (POORIAYOUSEFI_USE_ZLIB, -lz)
+ * - zstd needs libzstd (POORIAYOUSEFI_USE_ZSTD, -lzstd)
+ * - br needs brotli (POORIAYOUSEFI_USE_BROTLI, -lbrotlienc -lbrotlidec)
+ *
+ * ContentEncoder is a stream: every encode() ends on a flush point, so an SSE
+ * stream can be compressed as one body and still be decoded event by event
+ * while the compression window carries over.
+ */
+
+namespace pooriayousefi::mcp::transport
+{
+    /**
+     * @brief HTTP content coding
+     */
+    enum class ContentCoding {
+        identity,
+        gzip,
+        deflate, ///< zlib format (RFC 1950), as the "deflate" token means
+        zstd,
+        br
+    };
+
+    /**
+     * @brief Token used in Content-Encoding and Accept-Encoding
+     */
+    inline std::string_view coding_name(ContentCoding coding) {
+        switch (coding) {
+            case ContentCoding::gzip: return "gzip";
+            case ContentCoding::deflate: return "deflate";
+            case ContentCoding::zstd: return "zstd";
+            case ContentCoding::br: return "br";
+            default: return "identity";
+        }
+    }
+
+    namespace detail {
+        inline bool iequal(std::string_view a, std::string_view b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+
+        inline std::string_view trim_ows(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+            return s;
+        }
+    }
+
+    /**
+     * @brief Coding named by a token (case-insensitive; "x-gzip" is gzip)
+     */
+    inline std::optional<ContentCoding> parse_coding(std::string_view name) {
+        name = detail::trim_ows(name);
+        if (name.empty() || detail::iequal(name, "identity")) return ContentCoding::identity;
+        if (detail::iequal(name, "gzip") || detail::iequal(name, "x-gzip")) return ContentCoding::gzip;
+        if (detail::iequal(name, "deflate")) return ContentCoding::deflate;
+        if (detail::iequal(name, "zstd")) return ContentCoding::zstd;
+        if (detail::iequal(name, "br")) return ContentCoding::br;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief True when this build can encode and decode the coding
+     */
+    inline bool coding_available(ContentCoding coding) {
+        switch (coding) {
+            case ContentCoding::identity: return true;
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+            case ContentCoding::gzip:
+            case ContentCoding::deflate: return true;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+            case ContentCoding::zstd: return true;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+            case ContentCoding::br: return true;
+#endif
+            default: return false;
+        }
+    }
+
+    /**
+     * @brief Codings this build supports, best first (zstd, br, gzip, deflate)
+     */
+    inline std::vector<ContentCoding> available_codings() {
+        std::vector<ContentCoding> codings;
+        for (auto coding : {ContentCoding::zstd, ContentCoding::br, ContentCoding::gzip, ContentCoding::deflate}) {
+            if (coding_available(coding)) codings.push_back(coding);
+        }
+        return codings;
+    }
+
+    /**
+     * @brief Accept-Encoding value offering codings ("zstd, br, gzip"); empty for none
+     */
+    inline std::string accept_encoding_header(const std::vector<ContentCoding>& codings) {
+        std::string header;
+        for (auto coding : codings) {
+            if (coding == ContentCoding::identity || !coding_available(coding)) continue;
+            if (!header.empty()) header.append(", ");
+            header.append(coding_name(coding));
+        }
+        return header;
+    }
+
+    /**
+     * @brief Pick the coding for a response
+     *
+     * The highest q-value wins; ties go to the earlier entry of preferred.
+     * "*" matches any coding not listed explicitly, and q=0 refuses one.
+     * @param accept Value of the request's Accept-Encoding header
+     * @param preferred Codings the server is willing to use, best first
+     * @return identity when nothing acceptable is available
+     */
+    inline ContentCoding negotiate(std::string_view accept, const std::vector<ContentCoding>& preferred) {
+        ContentCoding best = ContentCoding::identity;
+        int best_q = 0;
+        for (auto coding : preferred) {
+            if (coding == ContentCoding::identity || !coding_available(coding)) continue;
+            int q = -1;          // from an explicit entry
+            int wildcard_q = -1; // from "*"
+            std::string_view rest = accept;
+            while (!rest.empty()) {
+                size_t comma = rest.find(',');
+                std::string_view entry = rest.substr(0, comma);
+                rest = comma == std::string_view::npos ? std::string_view{} : rest.substr(comma + 1);
+                size_t semi = entry.find(';');
+                std::string_view token = detail::trim_ows(entry.substr(0, semi));
+                // q-values in thousandths: "q=0.5" -> 500
+                int value = 1000;
+                if (semi != std::string_view::npos) {
+                    std::string_view param = detail::trim_ows(entry.substr(semi + 1));
+                    if (param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=') {
+                        param.remove_prefix(2);
+                        value = param.empty() || param[0] != '1' ? 0 : 1000;
+                        size_t dot = param.find('.');
+                        if (dot != std::string_view::npos && param[0] == '0') {
+                            int scale = 100;
+                            for (size_t i = dot + 1; i < param.size() && i <= dot + 3 && std::isdigit(static_cast<unsigned char>(param[i])); ++i, scale /= 10) {
+                                value += (param[i] - '0') * scale;
+                            }
+                        }
+                    }
+                }
+                if (token == "*") {
+                    wildcard_q = value;
+                } else if (auto parsed = parse_coding(token); parsed && *parsed == coding) {
+                    q = value;
+                }
+            }
+            if (q < 0) q = wildcard_q;
+            if (q > best_q) {
+                best = coding;
+                best_q = q;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief Settings for compressing HTTP bodies and SSE streams
+     */
+    struct HttpCompressionOptions {
+        std::vector<ContentCoding> codings = available_codings(); ///< Willing to use, best first; empty disables compression
+        size_t threshold = 1024;   ///< Bodies smaller than this are sent as they are
+        int level = -1;            ///< Compression level of the chosen coding; -1 uses its default
+        bool sse = true;           ///< Compress SSE streams as well
+        bool requests = false;     ///< Client only: compress POST bodies too (the server must accept them)
+
+        bool enabled() const { return !codings.empty(); }
+    };
+
+    /**
+     * @brief Incremental compressor for one body or stream
+     */
+    class ContentEncoder {
+    public:
+        /**
+         * @throws std::invalid_argument when the coding is not available in this build
+         */
+        explicit ContentEncoder(ContentCoding coding, [[maybe_unused]] int level = -1)
+            : coding_(coding)
+        {
+            switch (coding) {
+                case ContentCoding::identity: break;
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+                case ContentCoding::gzip:
+                case ContentCoding::deflate:
+                    deflater_ = std::make_unique<core::Deflater>(
+                        coding == ContentCoding::gzip ? core::DeflateFormat::gzip : core::DeflateFormat::zlib,
+                        level < 0 ? 6 : std::min(level, 9));
+                    break;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+                case ContentCoding::zstd:
+                    zstd_ = ZSTD_createCCtx();
+                    if (!zstd_) throw std::bad_alloc();
+                    ZSTD_CCtx_setParameter(zstd_, ZSTD_c_compressionLevel, level < 0 ? 3 : level);
+                    break;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+                case ContentCoding::br:
+                    brotli_ = BrotliEncoderCreateInstance(nullptr, nullptr, nullptr);
+                    if (!brotli_) throw std::bad_alloc();
+                    // Streams flush often; a mid quality keeps that cheap
+                    BrotliEncoderSetParameter(brotli_, BROTLI_PARAM_QUALITY, static_cast<uint32_t>(level < 0 ? 5 : std::min(level, 11)));
+                    break;
+#endif
+                default:
+                    throw std::invalid_argument("ContentEncoder: " + std::string(coding_name(coding)) + " is not available");
+            }
+        }
+
+        ContentEncoder(const ContentEncoder&) = delete;
+        ContentEncoder& operator=(const ContentEncoder&) = delete;
+
+        ~ContentEncoder() {
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+            if (zstd_) ZSTD_freeCCtx(zstd_);
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+            if (brotli_) BrotliEncoderDestroyInstance(brotli_);
+#endif
+        }
+
+        ContentCoding coding() const { return coding_; }
+
+        /**
+         * @brief Append input, compressed and flushed, to out
+         *
+         * Everything written so far can be decoded once out is delivered.
+         */
+        void encode(std::string_view input, std::string& out) {
+            write(input, out, false);
+        }
+
+        /**
+         * @brief Append the end of the body to out; the encoder is spent afterwards
+         */
+        void finish(std::string_view input, std::string& out) {
+            write(input, out, true);
+        }
+
+    private:
+        void write(std::string_view input, std::string& out, [[maybe_unused]] bool last) {
+            switch (coding_) {
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+                case ContentCoding::gzip:
+                case ContentCoding::deflate:
+                    deflater_->compress(input, out, last ? core::DeflateFlush::finish : core::DeflateFlush::sync);
+                    return;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+                case ContentCoding::zstd: {
+                    ZSTD_inBuffer in{input.data(), input.size(), 0};
+                    const auto mode = last ? ZSTD_e_end : ZSTD_e_flush;
+                    while (true) {
+                        const size_t used = out.size();
+                        const size_t room = std::max<size_t>(ZSTD_compressBound(in.size - in.pos), 256);
+                        out.resize(used + room);
+                        ZSTD_outBuffer buffer{out.data() + used, room, 0};
+                        const size_t remaining = ZSTD_compressStream2(zstd_, &buffer, &in, mode);
+                        out.resize(used + buffer.pos);
+                        if (ZSTD_isError(remaining)) throw std::runtime_error(std::string("ContentEncoder: ") + ZSTD_getErrorName(remaining));
+                        if (remaining == 0 && in.pos == in.size) return;
+                    }
+                }
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+                case ContentCoding::br: {
+                    size_t available_in = input.size();
+                    auto next_in = reinterpret_cast<const uint8_t*>(input.data());
+                    const auto op = last ? BROTLI_OPERATION_FINISH : BROTLI_OPERATION_FLUSH;
+                    do {
+                        const size_t used = out.size();
+                        const size_t room = std::max<size_t>(BrotliEncoderMaxCompressedSize(available_in), 1024);
+                        out.resize(used + room);
+                        size_t available_out = room;
+                        auto next_out = reinterpret_cast<uint8_t*>(out.data() + used);
+                        const bool ok = BrotliEncoderCompressStream(brotli_, op, &available_in, &next_in, &available_out, &next_out, nullptr);
+                        out.resize(used + room - available_out);
+                        if (!ok) throw std::runtime_error("ContentEncoder: brotli stream error");
+                    } while (available_in > 0 || BrotliEncoderHasMoreOutput(brotli_));
+                    return;
+                }
+#endif
+                default:
+                    out.append(input);
+                    return;
+            }
+        }
+
+        ContentCoding coding_;
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+        std::unique_ptr<core::Deflater> deflater_;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+        ZSTD_CCtx* zstd_ = nullptr;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+        BrotliEncoderState* brotli_ = nullptr;
+#endif
+    };
+
+    /**
+     * @brief Incremental decompressor for one body or stream
+     */
+    class ContentDecoder {
+    public:
+        /**
+         * @throws std::invalid_argument when the coding is not available in this build
+         */
+        explicit ContentDecoder(ContentCoding coding)
+            : coding_(coding)
+        {
+            switch (coding) {
+                case ContentCoding::identity: break;
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+                case ContentCoding::gzip:
+                case ContentCoding::deflate:
+                    inflater_ = std::make_unique<core::Inflater>(
+                        coding == ContentCoding::gzip ? core::DeflateFormat::gzip : core::DeflateFormat::zlib);
+                    break;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+                case ContentCoding::zstd:
+                    zstd_ = ZSTD_createDCtx();
+                    if (!zstd_) throw std::bad_alloc();
+                    break;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+                case ContentCoding::br:
+                    brotli_ = BrotliDecoderCreateInstance(nullptr, nullptr, nullptr);
+                    if (!brotli_) throw std::bad_alloc();
+                    break;
+#endif
+                default:
+                    throw std::invalid_argument("ContentDecoder: " + std::string(coding_name(coding)) + " is not available");
+            }
+        }
+
+        ContentDecoder(const ContentDecoder&) = delete;
+        ContentDecoder& operator=(const ContentDecoder&) = delete;
+
+        ~ContentDecoder() {
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+            if (zstd_) ZSTD_freeDCtx(zstd_);
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+            if (brotli_) BrotliDecoderDestroyInstance(brotli_);
+#endif
+        }
+
+        ContentCoding coding() const { return coding_; }
+
+        /**
+         * @brief Append the decompressed form of input to out
+         * @throws std::runtime_error on corrupt data
+         * @throws std::length_error when this call would produce more than limit bytes
+         */
+        void decode(std::string_view input, std::string& out, size_t limit = static_cast<size_t>(-1)) {
+            [[maybe_unused]] const size_t start = out.size();
+            switch (coding_) {
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+                case ContentCoding::gzip:
+                case ContentCoding::deflate:
+                    inflater_->decompress(input, out, limit);
+                    return;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+                case ContentCoding::zstd: {
+                    ZSTD_inBuffer in{input.data(), input.size(), 0};
+                    bool full;
+                    do {
+                        const size_t used = out.size();
+                        const size_t room = std::clamp<size_t>(input.size() * 4, 16384, 256 * 1024);
+                        out.resize(used + room);
+                        ZSTD_outBuffer buffer{out.data() + used, room, 0};
+                        const size_t status = ZSTD_decompressStream(zstd_, &buffer, &in);
+                        out.resize(used + buffer.pos);
+                        if (ZSTD_isError(status)) throw std::runtime_error("ContentDecoder: corrupt zstd data");
+                        if (out.size() - start > limit) throw std::length_error("ContentDecoder: output exceeds limit");
+                        full = buffer.pos == buffer.size; // output may be pending
+                    } while (in.pos < in.size || full);
+                    return;
+                }
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+                case ContentCoding::br: {
+                    size_t available_in = input.size();
+                    auto next_in = reinterpret_cast<const uint8_t*>(input.data());
+                    while (true) {
+                        const size_t used = out.size();
+                        const size_t room = std::clamp<size_t>(input.size() * 4, 16384, 256 * 1024);
+                        out.resize(used + room);
+                        size_t available_out = room;
+                        auto next_out = reinterpret_cast<uint8_t*>(out.data() + used);
+                        const auto result = BrotliDecoderDecompressStream(brotli_, &available_in, &next_in, &available_out, &next_out, nullptr);
+                        out.resize(used + room - available_out);
+                        if (result == BROTLI_DECODER_RESULT_ERROR) throw std::runtime_error("ContentDecoder: corrupt brotli data");
+                        if (out.size() - start > limit) throw std::length_error("ContentDecoder: output exceeds limit");
+                        if (result != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) return;
+                    }
+                }
+#endif
+                default:
+                    if (input.size() > limit) throw std::length_error("ContentDecoder: output exceeds limit");
+                    out.append(input);
+                    return;
+            }
+        }
+
+    private:
+        ContentCoding coding_;
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+        std::unique_ptr<core::Inflater> inflater_;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_ZSTD
+        ZSTD_DCtx* zstd_ = nullptr;
+#endif
+#ifdef POORIAYOUSEFI_TRANSPORT_HAS_BROTLI
+        BrotliDecoderState* brotli_ = nullptr;
+#endif
+    };
+
+    /**
+     * @brief Compress a whole body into out when it is worth it
+     * @return false when body is under the threshold, the coding is identity, or
+     *         compression would not make it smaller; send body as it is then
+     */
+    inline bool compress_body(ContentCoding coding, std::string_view body, const HttpCompressionOptions& options, std::string& out) {
+        if (coding == ContentCoding::identity || body.size() < options.threshold) return false;
+        out.clear();
+        ContentEncoder(coding, options.level).finish(body, out);
+        return out.size() < body.size();
+    }
+
+} // namespace pooriayousefi::mcp::transport
@@ -0,0 +1,868 @@
+#pragma once
+
+#include "transport.hpp"
+#include "sse_queue.hpp"
+#include "http_correlator.hpp"
+#include "content_coding.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+#include <stdexcept>
+#include <system_error>
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/**
+ * @file epoll_http.hpp
+ * @brief HTTP server transport on epoll event loops (Linux)
+ *
+ * EpollHttpServerTransport serves the same routes as HttpServerTransport
+ * (POST /jsonrpc, GET /events, GET /health, GET /metrics) without a thread per
+ * connection:
+ * - A fixed number of event-loop threads, each with its own SO_REUSEPORT
+ *   listening socket, so the kernel spreads connections across them
+ * - Sockets are non-blocking; a connection is a small struct plus its
+ *   unsent bytes, so an idle SSE subscriber costs no thread and no buffer
+ * - A POST waiting for its response only holds its exchange; the response
+ *   is handed back to the connection's loop wherever it was produced
+ * - SSE events go through the per-subscriber SseQueue, so a slow subscriber
+ *   only delays itself
+ * - Responses and SSE streams are compressed with the coding negotiated from
+ *   Accept-Encoding (see EpollHttpOptions::compression); POST bodies sent
+ *   with a Content-Encoding are decompressed
+ *
+ * Messages are delivered to the handler on the loop thread. Give the Server
+ * an executor (Server::set_executor) when handlers may be slow, or they
+ * stall every connection of that loop.
+ */
+
+namespace pooriayousefi::mcp::transport
+{
+    /**
+     * @brief Settings for EpollHttpServerTransport
+     */
+    struct EpollHttpOptions {
+        std::string host = "0.0.0.0";      ///< IPv4 address to bind ("localhost" = 127.0.0.1)
+        int port = 8080;                   ///< 0 picks a free port; see port()
+        size_t loops = 1;                  ///< Event-loop threads
+        size_t max_request_bytes = 16u << 20; ///< Larger bodies are answered with 413
+        std::chrono::milliseconds request_timeout{30000}; ///< POSTs waiting longer get 504
+        std::chrono::milliseconds sse_ping{30000}; ///< Comment line sent to idle SSE streams
+        size_t sse_queue = 256;            ///< Events queued per SSE subscriber
+        SseOverflow sse_overflow = SseOverflow::drop_oldest;
+        HttpCompressionOptions compression; ///< Codings, size threshold and level for responses and SSE
+    };
+
+    /**
+     * @brief HTTP server transport running on epoll event loops
+     *
+     * @example
+     * ```cpp
+     * EpollHttpOptions options;
+     * options.port = 8080;
+     * options.loops = std::thread::hardware_concurrency();
+     * auto transport = std::make_shared<EpollHttpServerTransport>(options);
+     * Server server(transport, impl);
+     * server.set_executor(pool);
+     * transport->start();
+     * ```
+     */
+    class EpollHttpServerTransport : public Transport {
+    public:
+        explicit EpollHttpServerTransport(EpollHttpOptions options = {})
+            : options_(std::move(options))
+            , running_(false)
+            , bound_port_(0)
+        {
+            options_.loops = std::max<size_t>(1, options_.loops);
+        }
+
+        ~EpollHttpServerTransport() override {
+            close();
+        }
+
+        using Transport::send;
+
+        bool accepts_encoded() const override { return true; }
+
+        /**
+         * @brief Send a message produced by the server endpoint
+         *
+         * Responses go to the POST that carried the request; everything else
+         * is broadcast over SSE.
+         */
+        void send(const json& message) override {
+            if (message.is_array()) {
+                for (const auto& element : message) {
+                    if (!correlator_.route_response(element)) {
+                        send_sse_notification(element);
+                    }
+                }
+                return;
+            }
+            if (!correlator_.route_response(message)) {
+                send_sse_notification(correlator_.restore_progress_token(message));
+            }
+        }
+
+        /**
+         * @brief Bind the listening sockets and start the event loops
+         * @throws std::system_error when a socket cannot be set up
+         */
+        void start() override {
+            std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+            if (running_) return;
+            loops_.clear();
+            try {
+                for (size_t i = 0; i < options_.loops; ++i) {
+                    auto loop = std::make_unique<Loop>();
+                    open_loop(*loop, i == 0 ? options_.port : bound_port_.load());
+                    loops_.push_back(std::move(loop));
+                }
+            } catch (...) {
+                for (auto& loop : loops_) close_loop(*loop);
+                loops_.clear();
+                throw;
+            }
+            running_ = true;
+            for (auto& loop : loops_) {
+                Loop* raw = loop.get();
+                loop->thread = std::thread([this, raw] { run(*raw); });
+            }
+        }
+
+        /**
+         * @brief Stop the loops and close every connection; waiting POSTs are dropped
+         */
+        void close() override {
+            std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+            if (!running_.exchange(false)) return;
+            for (auto& loop : loops_) wake(*loop);
+            for (auto& loop : loops_) {
+                if (loop->thread.joinable()) loop->thread.join();
+            }
+            correlator_.fail_all();
+            for (auto& loop : loops_) close_loop(*loop);
+            {
+                std::lock_guard<std::mutex> sse_lock(sse_mutex_);
+                sse_queues_.clear();
+            }
+            emit_close();
+        }
+
+        bool is_open() const override {
+            return running_;
+        }
+
+        /**
+         * @brief Port the server listens on (useful with options.port = 0)
+         */
+        int port() const {
+            return bound_port_.load();
+        }
+
+        /**
+         * @brief Number of requests currently waiting for a response
+         */
+        size_t in_flight() const {
+            return correlator_.size();
+        }
+
+        /**
+         * @brief Number of connected SSE clients
+         */
+        size_t sse_subscribers() const {
+            std::lock_guard<std::mutex> lock(sse_mutex_);
+            return sse_queues_.size();
+        }
+
+        /**
+         * @brief As Transport::set_metrics, plus request and SSE gauges and a /metrics route
+         *
+         * Adds mcp_http_in_flight and the SSE gauges of observe_sse_queues(); sent bytes
+         * include HTTP headers. While a registry is set, GET /metrics answers with its
+         * Prometheus text. Call before start().
+         */
+        void set_metrics(std::shared_ptr<core::Metrics> metrics, const std::string& name) override {
+            gauges_.clear();
+            Transport::set_metrics(std::move(metrics), name);
+            if (!metrics_) return;
+            gauges_ = observe_sse_queues(*metrics_, name, sse_queues_, sse_mutex_);
+            gauges_.push_back(metrics_->observe("mcp_http_in_flight", "POSTs waiting for their response", "transport", name, [this] {
+                return static_cast<double>(correlator_.size());
+            }));
+        }
+
+        /**
+         * @brief Queue a notification for every SSE subscriber
+         *
+         * The event is serialized once; each loop writes it to its own
+         * subscribers when its socket can take it.
+         */
+        void send_sse_notification(const json& notification) {
+            {
+                std::lock_guard<std::mutex> lock(sse_mutex_);
+                if (sse_queues_.empty()) return;
+                const auto event = SseEvent::from(notification);
+                for (const auto& queue : sse_queues_) {
+                    queue->push(event);
+                }
+            }
+            for (auto& loop : loops_) {
+                loop->sse_pending.store(true, std::memory_order_release);
+                wake(*loop);
+            }
+        }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        // Unsent SSE bytes above which a subscriber's events stay in its queue
+        static constexpr size_t sse_high_water = 64 * 1024;
+        // Largest request head (request line and headers)
+        static constexpr size_t max_head_bytes = 64 * 1024;
+
+        struct Connection {
+            int fd = -1;
+            uint64_t serial = 0;
+            std::string in;
+            std::string out;
+            size_t out_offset = 0;
+            bool reading = true;              // EPOLLIN armed; off once the peer stopped sending
+            bool writing = false;             // EPOLLOUT armed
+            bool close_when_flushed = false;
+            bool closed = false;              // dropped; freed at the end of the loop iteration
+            std::shared_ptr<HttpExchange> waiting; // POST whose response is pending
+            bool keep_alive = true;
+            clock::time_point deadline{};
+            std::shared_ptr<SseQueue> sse;
+            clock::time_point last_write{};
+            ContentCoding coding = ContentCoding::identity; // negotiated for the current request
+            std::unique_ptr<ContentEncoder> sse_encoder;    // compresses the whole SSE stream
+        };
+
+        struct Completed {
+            int fd;
+            uint64_t serial;
+            std::weak_ptr<HttpExchange> exchange;
+        };
+
+        struct Loop {
+            int epoll_fd = -1;
+            int listen_fd = -1;
+            int wake_fd = -1;
+            std::thread thread;
+            std::unordered_map<int, std::unique_ptr<Connection>> connections;
+            std::vector<int> dropped;
+            uint64_t next_serial = 1;
+            std::atomic<bool> sse_pending{false};
+            std::mutex inbox_mutex;
+            std::vector<Completed> inbox;
+            std::array<char, 64 * 1024> scratch;
+        };
+
+        struct Request {
+            std::string_view method;
+            std::string_view target;
+            std::string_view body;
+            std::string_view accept_encoding;
+            std::string_view content_encoding;
+            bool keep_alive = true;
+        };
+
+        // --- Setup ---
+
+        void open_loop(Loop& loop, int port) {
+            loop.listen_fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (loop.listen_fd < 0) throw_errno("socket");
+            int on = 1;
+            ::setsockopt(loop.listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            if (::setsockopt(loop.listen_fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0) throw_errno("SO_REUSEPORT");
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(port));
+            const std::string host = options_.host == "localhost" ? "127.0.0.1" : options_.host;
+            if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+                throw std::invalid_argument("EpollHttpServerTransport: not an IPv4 address: " + options_.host);
+            }
+            if (::bind(loop.listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) throw_errno("bind");
+            if (::listen(loop.listen_fd, SOMAXCONN) < 0) throw_errno("listen");
+            if (port == 0) {
+                socklen_t len = sizeof(addr);
+                ::getsockname(loop.listen_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+                port = ntohs(addr.sin_port);
+            }
+            bound_port_ = port;
+
+            loop.epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            if (loop.epoll_fd < 0) throw_errno("epoll_create1");
+            loop.wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (loop.wake_fd < 0) throw_errno("eventfd");
+            watch(loop, loop.listen_fd, EPOLLIN);
+            watch(loop, loop.wake_fd, EPOLLIN);
+        }
+
+        void close_loop(Loop& loop) {
+            reap(loop);
+            for (auto& [fd, connection] : loop.connections) {
+                if (connection->sse) connection->sse->close();
+                ::close(fd);
+            }
+            loop.connections.clear();
+            if (loop.listen_fd >= 0) ::close(loop.listen_fd);
+            if (loop.epoll_fd >= 0) ::close(loop.epoll_fd);
+            std::lock_guard<std::mutex> lock(loop.inbox_mutex);
+            if (loop.wake_fd >= 0) ::close(loop.wake_fd);
+            loop.listen_fd = loop.epoll_fd = loop.wake_fd = -1;
+            loop.inbox.clear();
+        }
+
+        [[noreturn]] static void throw_errno(const char* what) {
+            throw std::system_error(errno, std::generic_category(), std::string("EpollHttpServerTransport: ") + what);
+        }
+
+        static void watch(Loop& loop, int fd, uint32_t events) {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.fd = fd;
+            if (::epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) throw_errno("epoll_ctl");
+        }
+
+        static void rewatch(Loop& loop, Connection& connection, bool reading, bool writing) {
+            if (connection.reading == reading && connection.writing == writing) return;
+            epoll_event ev{};
+            ev.events = (reading ? EPOLLIN | EPOLLRDHUP : 0u) | (writing ? EPOLLOUT : 0u);
+            ev.data.fd = connection.fd;
+            ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_MOD, connection.fd, &ev);
+            connection.reading = reading;
+            connection.writing = writing;
+        }
+
+        // Called from any thread
+        static void wake(Loop& loop) {
+            std::lock_guard<std::mutex> lock(loop.inbox_mutex);
+            if (loop.wake_fd < 0) return;
+            uint64_t one = 1;
+            [[maybe_unused]] auto n = ::write(loop.wake_fd, &one, sizeof(one));
+        }
+
+        static void post(Loop& loop, Completed completed) {
+            std::lock_guard<std::mutex> lock(loop.inbox_mutex);
+            if (loop.wake_fd < 0) return;
+            loop.inbox.push_back(std::move(completed));
+            uint64_t one = 1;
+            [[maybe_unused]] auto n = ::write(loop.wake_fd, &one, sizeof(one));
+        }
+
+        // --- Event loop ---
+
+        void run(Loop& loop) {
+            std::array<epoll_event, 256> events;
+            auto next_tick = clock::now() + std::chrono::seconds(1);
+            while (running_) {
+                int n = ::epoll_wait(loop.epoll_fd, events.data(), static_cast<int>(events.size()), 1000);
+                if (n < 0 && errno != EINTR) {
+                    emit_error(std::string("epoll_wait failed: ") + std::strerror(errno));
+                    return;
+                }
+                for (int i = 0; i < n; ++i) {
+                    const int fd = events[i].data.fd;
+                    if (fd == loop.listen_fd) {
+                        accept_all(loop);
+                    } else if (fd == loop.wake_fd) {
+                        uint64_t count;
+                        [[maybe_unused]] auto r = ::read(loop.wake_fd, &count, sizeof(count));
+                        deliver_completed(loop);
+                        if (loop.sse_pending.exchange(false, std::memory_order_acq_rel)) {
+                            for (auto& [sse_fd, connection] : loop.connections) {
+                                if (connection->sse && !connection->closed) drain_sse(loop, *connection);
+                            }
+                        }
+                    } else {
+                        on_ready(loop, fd, events[i].events);
+                    }
+                }
+                if (clock::now() >= next_tick) {
+                    tick(loop);
+                    next_tick = clock::now() + std::chrono::seconds(1);
+                }
+                reap(loop);
+            }
+        }
+
+        void accept_all(Loop& loop) {
+            while (true) {
+                int fd = ::accept4(loop.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) {
+                    if (errno == EINTR) continue;
+                    return; // EAGAIN, or out of descriptors: try again on the next event
+                }
+                int on = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                auto connection = std::make_unique<Connection>();
+                connection->fd = fd;
+                connection->serial = loop.next_serial++;
+                epoll_event ev{};
+                ev.events = EPOLLIN | EPOLLRDHUP;
+                ev.data.fd = fd;
+                if (::epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                    ::close(fd);
+                    continue;
+                }
+                loop.connections.emplace(fd, std::move(connection));
+            }
+        }
+
+        void on_ready(Loop& loop, int fd, uint32_t events) {
+            auto it = loop.connections.find(fd);
+            if (it == loop.connections.end()) return;
+            Connection& connection = *it->second;
+            if (connection.closed) return;
+            if (events & (EPOLLERR | EPOLLHUP)) {
+                drop(loop, connection);
+                return;
+            }
+            if (events & EPOLLOUT) {
+                if (!flush(loop, connection)) return;
+                if (connection.sse) drain_sse(loop, connection);
+            }
+            if (!connection.closed && (events & (EPOLLIN | EPOLLRDHUP))) {
+                read_input(loop, connection);
+            }
+        }
+
+        void read_input(Loop& loop, Connection& connection) {
+            while (true) {
+                ssize_t n = ::recv(connection.fd, loop.scratch.data(), loop.scratch.size(), 0);
+                if (n > 0) {
+                    if (!connection.sse) connection.in.append(loop.scratch.data(), static_cast<size_t>(n));
+                    if (connection.in.size() > options_.max_request_bytes + max_head_bytes) {
+                        reply(loop, connection, 413, R"({"error":"Request too large"})", false);
+                        return;
+                    }
+                    continue;
+                }
+                if (n == 0) {
+                    // The peer stopped sending; answer what it did send, then close
+                    rewatch(loop, connection, false, connection.writing);
+                    process_input(loop, connection);
+                    if (connection.closed) return;
+                    connection.close_when_flushed = true;
+                    if (!connection.waiting) flush(loop, connection);
+                    return;
+                }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                drop(loop, connection);
+                return;
+            }
+            process_input(loop, connection);
+        }
+
+        // Handle every complete request in the input, one at a time: a pipelined
+        // request waits until the response to the one before it has been written.
+        void process_input(Loop& loop, Connection& connection) {
+            size_t consumed = 0;
+            while (!connection.waiting && !connection.sse && !connection.close_when_flushed) {
+                std::string_view input(connection.in);
+                input.remove_prefix(consumed);
+                Request request;
+                int status = 0;
+                size_t used = parse_request(input, request, status);
+                if (status != 0) {
+                    reply(loop, connection, status, "", false);
+                    return;
+                }
+                if (used == 0) break;
+                consumed += used;
+                if (!handle(loop, connection, request)) return;
+            }
+            if (connection.closed) return;
+            if (connection.sse || consumed == connection.in.size()) {
+                // Keep idle connections small
+                if (connection.in.capacity() > loop.scratch.size()) std::string().swap(connection.in);
+                else connection.in.clear();
+            } else if (consumed > 0) {
+                connection.in.erase(0, consumed);
+            }
+        }
+
+        // Bytes of the first complete request in input, 0 while incomplete; status is set
+        // when the request cannot be served and the connection should be closed
+        size_t parse_request(std::string_view input, Request& request, int& status) const {
+            size_t head_end = input.find("\r\n\r\n");
+            if (head_end == std::string_view::npos) {
+                if (input.size() > max_head_bytes) status = 431;
+                return 0;
+            }
+            std::string_view head = input.substr(0, head_end);
+            size_t line_end = head.find("\r\n");
+            std::string_view line = head.substr(0, line_end);
+            size_t sp1 = line.find(' ');
+            size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+            if (sp2 == std::string_view::npos) {
+                status = 400;
+                return 0;
+            }
+            request.method = line.substr(0, sp1);
+            request.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+            const std::string_view version = line.substr(sp2 + 1);
+            request.keep_alive = version == "HTTP/1.1";
+
+            size_t content_length = 0;
+            std::string_view headers = line_end == std::string_view::npos ? std::string_view{} : head.substr(line_end + 2);
+            while (!headers.empty()) {
+                size_t end = headers.find("\r\n");
+                std::string_view header = headers.substr(0, end);
+                headers = end == std::string_view::npos ? std::string_view{} : headers.substr(end + 2);
+                size_t colon = header.find(':');
+                if (colon == std::string_view::npos) continue;
+                std::string_view name = header.substr(0, colon);
+                std::string_view value = trim(header.substr(colon + 1));
+                if (iequals(name, "Content-Length")) {
+                    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), content_length);
+                    if (ec != std::errc{} || ptr != value.data() + value.size()) {
+                        status = 400;
+                        return 0;
+                    }
+                } else if (iequals(name, "Transfer-Encoding")) {
+                    status = 501; // chunked request bodies are not supported
+                    return 0;
+                } else if (iequals(name, "Connection")) {
+                    if (iequals(value, "close")) request.keep_alive = false;
+                    else if (iequals(value, "keep-alive")) request.keep_alive = true;
+                } else if (iequals(name, "Accept-Encoding")) {
+                    request.accept_encoding = value;
+                } else if (iequals(name, "Content-Encoding")) {
+                    request.content_encoding = value;
+                }
+            }
+            if (content_length > options_.max_request_bytes) {
+                status = 413;
+                return 0;
+            }
+            const size_t body_start = head_end + 4;
+            if (input.size() - body_start < content_length) return 0;
+            request.body = input.substr(body_start, content_length);
+            return body_start + content_length;
+        }
+
+        // False when the connection was closed
+        bool handle(Loop& loop, Connection& connection, const Request& request) {
+            std::string_view path = request.target.substr(0, request.target.find('?'));
+            connection.coding = options_.compression.enabled()
+                ? negotiate(request.accept_encoding, options_.compression.codings)
+                : ContentCoding::identity;
+            if (path == "/jsonrpc") {
+                if (request.method != "POST") return reply(loop, connection, 405, "", request.keep_alive);
+                return handle_post(loop, connection, request);
+            }
+            if (path == "/events" && request.method == "GET") {
+                start_sse(loop, connection, options_.compression.sse ? connection.coding : ContentCoding::identity);
+                return true;
+            }
+            if (path == "/health" && request.method == "GET") {
+                return reply(loop, connection, 200, R"({"status":"ok"})", request.keep_alive);
+            }
+            if (path == "/metrics" && request.method == "GET" && metrics_) {
+                return reply(loop, connection, 200, metrics_->prometheus(), request.keep_alive, "text/plain; version=0.0.4");
+            }
+            return reply(loop, connection, 404, "", request.keep_alive);
+        }
+
+        bool handle_post(Loop& loop, Connection& connection, const Request& request) {
+            std::string_view body = request.body;
+            core::ObjectPool<std::string>::Handle decoded;
+            if (!request.content_encoding.empty()) {
+                auto coding = parse_coding(request.content_encoding);
+                if (!coding || !coding_available(*coding)) {
+                    return reply(loop, connection, 415, R"({"error":"Unsupported Content-Encoding"})", request.keep_alive);
+                }
+                if (*coding != ContentCoding::identity) {
+                    decoded = core::ObjectPool<std::string>::acquire();
+                    try {
+                        ContentDecoder(*coding).decode(body, *decoded, options_.max_request_bytes);
+                    } catch (const std::length_error&) {
+                        return reply(loop, connection, 413, R"({"error":"Request too large"})", false);
+                    } catch (const std::exception&) {
+                        return reply(loop, connection, 400, R"({"error":"Corrupt request body"})", request.keep_alive);
+                    }
+                    body = *decoded;
+                }
+            }
+
+            count_received(body.size());
+            auto exchange = std::make_shared<HttpExchange>();
+            HttpPost accepted;
+            {
+                core::Span span(metrics_.get(), core::SpanKind::parse, metrics_name_);
+                accepted = correlator_.accept(body, exchange);
+                if (!accepted.message) span.fail();
+            }
+
+            if (accepted.status != 0) {
+                dispatch(accepted);
+                return reply(loop, connection, accepted.status, accepted.body, request.keep_alive);
+            }
+
+            // Registered before dispatch: the endpoint may answer before emit returns
+            connection.waiting = exchange;
+            connection.keep_alive = request.keep_alive;
+            connection.deadline = clock::now() + options_.request_timeout;
+            exchange->on_complete = [&loop, fd = connection.fd, serial = connection.serial, weak = std::weak_ptr<HttpExchange>(exchange)] {
+                post(loop, Completed{fd, serial, weak});
+            };
+            dispatch(accepted);
+
+            bool complete;
+            {
+                std::lock_guard<std::mutex> lock(exchange->mutex);
+                complete = exchange->complete();
+            }
+            if (complete) {
+                // A batch of invalid elements only, or answered inline
+                connection.waiting.reset();
+                return reply(loop, connection, 200, exchange->body(), connection.keep_alive);
+            }
+            return true;
+        }
+
+        void dispatch(HttpPost& post) {
+            if (!post.message) return;
+            std::lock_guard<std::mutex> lock(dispatch_mutex_);
+            emit_message(std::move(*post.message));
+        }
+
+        void deliver_completed(Loop& loop) {
+            std::vector<Completed> completed;
+            {
+                std::lock_guard<std::mutex> lock(loop.inbox_mutex);
+                completed.swap(loop.inbox);
+            }
+            for (auto& item : completed) {
+                auto it = loop.connections.find(item.fd);
+                if (it == loop.connections.end() || it->second->serial != item.serial || it->second->closed) continue;
+                Connection& connection = *it->second;
+                auto exchange = item.exchange.lock();
+                if (!exchange || connection.waiting != exchange) continue; // timed out or answered already
+                connection.waiting.reset();
+                if (reply(loop, connection, 200, exchange->body(), connection.keep_alive)) {
+                    process_input(loop, connection);
+                }
+            }
+        }
+
+        // Request timeouts and SSE keep-alive pings
+        void tick(Loop& loop) {
+            const auto now = clock::now();
+            std::vector<Connection*> expired;
+            for (auto& [fd, connection] : loop.connections) {
+                if (connection->closed) continue;
+                if (connection->waiting && now >= connection->deadline) {
+                    expired.push_back(connection.get());
+                } else if (connection->sse && connection->out.empty() && now - connection->last_write >= options_.sse_ping) {
+                    if (connection->sse_encoder) connection->sse_encoder->encode(": ping\n\n", connection->out);
+                    else connection->out.append(": ping\n\n");
+                    connection->last_write = now;
+                    flush(loop, *connection);
+                }
+            }
+            for (Connection* connection : expired) {
+                correlator_.forget(connection->waiting);
+                connection->waiting.reset();
+                if (reply(loop, *connection, 504, R"({"error":"Timeout"})", connection->keep_alive)) {
+                    process_input(loop, *connection);
+                }
+            }
+        }
+
+        // --- Output ---
+
+        static std::string_view reason(int status) {
+            switch (status) {
+                case 200: return "OK";
+                case 202: return "Accepted";
+                case 400: return "Bad Request";
+                case 404: return "Not Found";
+                case 405: return "Method Not Allowed";
+                case 413: return "Payload Too Large";
+                case 415: return "Unsupported Media Type";
+                case 431: return "Request Header Fields Too Large";
+                case 501: return "Not Implemented";
+                case 504: return "Gateway Timeout";
+                default: return "Error";
+            }
+        }
+
+        // False when the connection was closed. Bodies are compressed with the coding
+        // negotiated for the request being answered.
+        bool reply(Loop& loop, Connection& connection, int status, std::string_view body, bool keep_alive,
+                   std::string_view content_type = "application/json") {
+            auto& out = connection.out;
+            out.append("HTTP/1.1 ").append(std::to_string(status)).append(" ").append(reason(status)).append("\r\n");
+            if (!body.empty()) out.append("Content-Type: ").append(content_type).append("\r\n");
+            if (options_.compression.enabled()) out.append("Vary: Accept-Encoding\r\n");
+            core::ObjectPool<std::string>::Handle packed;
+            if (connection.coding != ContentCoding::identity && body.size() >= options_.compression.threshold) {
+                packed = core::ObjectPool<std::string>::acquire();
+                if (compress_body(connection.coding, body, options_.compression, *packed)) {
+                    out.append("Content-Encoding: ").append(coding_name(connection.coding)).append("\r\n");
+                    body = *packed;
+                }
+            }
+            out.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+            if (!keep_alive) out.append("Connection: close\r\n");
+            out.append("\r\n").append(body);
+            if (!keep_alive) connection.close_when_flushed = true;
+            return flush(loop, connection);
+        }
+
+        void start_sse(Loop& loop, Connection& connection, ContentCoding coding) {
+            connection.sse = std::make_shared<SseQueue>(options_.sse_queue, options_.sse_overflow);
+            {
+                std::lock_guard<std::mutex> lock(sse_mutex_);
+                sse_queues_.push_back(connection.sse);
+            }
+            connection.out.append(
+                "HTTP/1.1 200 OK\r\n"
+                "Content-Type: text/event-stream\r\n"
+                "Cache-Control: no-cache\r\n"
+                "Connection: keep-alive\r\n");
+            if (options_.compression.enabled()) connection.out.append("Vary: Accept-Encoding\r\n");
+            if (coding != ContentCoding::identity) {
+                // One stream for the whole connection, flushed after every batch of events
+                connection.sse_encoder = std::make_unique<ContentEncoder>(coding, options_.compression.level);
+                connection.out.append("Content-Encoding: ").append(coding_name(coding)).append("\r\n");
+            }
+            connection.out.append("\r\n");
+            connection.last_write = clock::now();
+            flush(loop, connection);
+        }
+
+        void drain_sse(Loop& loop, Connection& connection) {
+            if (connection.out.size() - connection.out_offset > sse_high_water) return; // the queue absorbs the backlog
+            std::vector<SseEvent> events;
+            if (!connection.sse->wait_pop(events, std::chrono::milliseconds(0))) {
+                // Closed by the disconnect policy
+                connection.close_when_flushed = true;
+                flush(loop, connection);
+                return;
+            }
+            if (events.empty()) return;
+            if (connection.sse_encoder) {
+                auto batch = core::ObjectPool<std::string>::acquire();
+                for (const auto& event : events) batch->append(*event.data);
+                connection.sse_encoder->encode(*batch, connection.out);
+            } else {
+                for (const auto& event : events) connection.out.append(*event.data);
+            }
+            connection.last_write = clock::now();
+            flush(loop, connection);
+        }
+
+        // Write as much as the socket takes. False when the connection was closed.
+        bool flush(Loop& loop, Connection& connection) {
+            while (connection.out_offset < connection.out.size()) {
+                ssize_t n = ::send(connection.fd, connection.out.data() + connection.out_offset,
+                                   connection.out.size() - connection.out_offset, MSG_NOSIGNAL);
+                if (n > 0) {
+                    connection.out_offset += static_cast<size_t>(n);
+                    count_sent(static_cast<size_t>(n));
+                    continue;
+                }
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    rewatch(loop, connection, connection.reading, true);
+                    return true;
+                }
+                drop(loop, connection);
+                return false;
+            }
+            if (connection.out.capacity() > sse_high_water) std::string().swap(connection.out);
+            else connection.out.clear();
+            connection.out_offset = 0;
+            rewatch(loop, connection, connection.reading, false);
+            if (connection.close_when_flushed) {
+                drop(loop, connection);
+                return false;
+            }
+            return true;
+        }
+
+        // The connection stops being served at once; it is freed by reap(), so callers
+        // further up the stack (and loops over the table) may still look at it
+        void drop(Loop& loop, Connection& connection) {
+            if (connection.closed) return;
+            connection.closed = true;
+            if (connection.waiting) {
+                correlator_.forget(connection.waiting);
+                connection.waiting.reset();
+            }
+            if (connection.sse) {
+                connection.sse->close();
+                std::lock_guard<std::mutex> lock(sse_mutex_);
+                sse_queues_.erase(std::remove(sse_queues_.begin(), sse_queues_.end(), connection.sse), sse_queues_.end());
+            }
+            ::epoll_ctl(loop.epoll_fd, EPOLL_CTL_DEL, connection.fd, nullptr);
+            loop.dropped.push_back(connection.fd);
+        }
+
+        // The descriptor is closed only here, so accept() cannot reuse it while the
+        // dropped connection still occupies its slot in the table
+        static void reap(Loop& loop) {
+            for (int fd : loop.dropped) {
+                ::close(fd);
+                loop.connections.erase(fd);
+            }
+            loop.dropped.clear();
+        }
+
+        static std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+            return s;
+        }
+
+        static bool iequals(std::string_view a, std::string_view b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+
+        EpollHttpOptions options_;
+        std::atomic<bool> running_;
+        std::atomic<int> bound_port_;
+        std::mutex lifecycle_mutex_;
+        std::vector<std::unique_ptr<Loop>> loops_;
+
+        // Wire id -> waiting POST
+        HttpCorrelator correlator_;
+
+        // Serializes delivery so the message handler sees one message at a time
+        std::mutex dispatch_mutex_;
+
+        std::vector<std::shared_ptr<SseQueue>> sse_queues_;
+        mutable std::mutex sse_mutex_;
+        std::vector<core::Observation> gauges_;
+    };
+
+} // namespace pooriayousefi::mcp::transport
@@ -0,0 +1,327 @@
+#pragma once
+
+#include "../jsonrpc/jsonrpc.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <charconv>
+#include <atomic>
+
+/**
+ * @file http_correlator.hpp
+ * @brief Matching JSON-RPC responses to the HTTP POSTs that carried their requests
+ *
+ * HTTP has no session, so many clients may send requests with the same id.
+ * Before a request reaches the endpoint, its id is rewritten to a unique wire
+ * id; the response is mapped back to the client's id and handed to the
+ * exchange of the POST that is waiting for it. Shared by the HTTP server
+ * transports, whatever they use for sockets.
+ *
+ * A `partialResultToken` is removed from incoming requests. Partial results
+ * are `$/progress` notifications, and over HTTP those only reach clients
+ * through SSE, which is shared by every subscriber; one client's tool output
+ * would reach them all. Without the token the handler collects its results
+ * into the response of the POST that asked for them.
+ */
+
+namespace pooriayousefi::mcp::transport
+{
+    using json = jsonrpc::json;
+
+    /**
+     * @brief One HTTP POST waiting for its response(s)
+     *
+     * A single request expects one response; a batch expects one per
+     * element that carried an id. Responses the transport produces itself
+     * (invalid batch elements) are stored up front.
+     */
+    struct HttpExchange {
+        std::mutex mutex;
+        std::condition_variable ready;  ///< Notified when complete, for threads that block on it
+        std::function<void()> on_complete; ///< Called once, outside the lock, when the last response arrives
+        size_t expected = 0;
+        bool batch = false;
+        std::vector<json> responses;
+
+        bool complete() const { return responses.size() >= expected; }
+
+        /**
+         * @brief Reply body: the response, or the array of them for a batch
+         */
+        std::string body() {
+            std::string out;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (batch) {
+                jsonrpc::dump_into(json(std::move(responses)), out);
+            } else if (!responses.empty()) {
+                jsonrpc::dump_into(responses.front(), out);
+            }
+            return out;
+        }
+    };
+
+    /**
+     * @brief Outcome of accepting a POST body
+     *
+     * `message` is what to hand to the endpoint, if anything. A non-zero
+     * `status` means the POST is answered right away with `body`; otherwise
+     * the caller waits for the exchange to complete.
+     */
+    struct HttpPost {
+        std::optional<json> message;
+        int status = 0;
+        std::string body;
+    };
+
+    /**
+     * @brief Wire-id table shared by the requests of every open POST
+     */
+    class HttpCorrelator {
+    public:
+        /**
+         * @brief Parse a POST body and register its requests on exchange
+         */
+        HttpPost accept(std::string_view body, const std::shared_ptr<HttpExchange>& exchange) {
+            HttpPost post;
+            json message;
+            try {
+                message = json::parse(body);
+            } catch (const std::exception&) {
+                post.status = 400;
+                post.body = jsonrpc::make_error(nullptr, jsonrpc::parse_error).dump();
+                return post;
+            }
+
+            exchange->batch = message.is_array();
+            if (exchange->batch) {
+                if (message.empty()) {
+                    post.status = 400;
+                    post.body = jsonrpc::make_error(nullptr, jsonrpc::invalid_request).dump();
+                    return post;
+                }
+
+                // Invalid elements are answered here: their error carries a
+                // null id, which could not be correlated after dispatch.
+                json forwarded = json::array();
+                for (auto& element : message) {
+                    if (jsonrpc::is_response(element) || jsonrpc::validate_request(element)) {
+                        if (element.contains("id") && !jsonrpc::is_response(element)) {
+                            correlate(element, exchange);
+                        }
+                        if (!jsonrpc::is_response(element)) {
+                            drop_partial_result_token(element);
+                        }
+                        forwarded.push_back(std::move(element));
+                    } else {
+                        exchange->responses.push_back(jsonrpc::make_error(nullptr, jsonrpc::invalid_request));
+                        ++exchange->expected;
+                    }
+                }
+                message = std::move(forwarded);
+            } else if (!jsonrpc::is_response(message)) {
+                if (!jsonrpc::validate_request(message)) {
+                    post.status = 200;
+                    post.body = jsonrpc::make_error(nullptr, jsonrpc::invalid_request).dump();
+                    return post;
+                }
+                if (message.contains("id")) {
+                    correlate(message, exchange);
+                }
+                drop_partial_result_token(message);
+            }
+
+            if (!message.is_array() || !message.empty()) {
+                translate_cancel(message);
+                post.message = std::move(message);
+            }
+            if (exchange->expected == 0) {
+                // Notifications and client responses carry nothing back
+                post.status = 202;
+            }
+            return post;
+        }
+
+        /**
+         * @brief Deliver a response to the exchange waiting on its wire id
+         * @return false if the message is not a response this table is waiting for
+         */
+        bool route_response(const json& message) {
+            if (!jsonrpc::is_response(message) || !message["id"].is_number_unsigned()) {
+                return false;
+            }
+
+            Entry entry;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = inflight_.find(message["id"].get<uint64_t>());
+                if (it == inflight_.end()) {
+                    return false;
+                }
+                entry = std::move(it->second);
+                inflight_.erase(it);
+            }
+
+            json response = message;
+            response["id"] = std::move(entry.original_id);
+            deliver(entry.exchange, std::move(response));
+            return true;
+        }
+
+        /**
+         * @brief Map a progress token that defaulted to a wire id back to the client's id
+         */
+        json restore_progress_token(const json& message) const {
+            if (!jsonrpc::is_notification(message) || message["method"] != "$/progress") {
+                return message;
+            }
+            const auto& params = message["params"];
+            if (!params.is_object() || !params.contains("token") || !params["token"].is_string()) {
+                return message;
+            }
+
+            uint64_t wire_id = 0;
+            const auto& token = params["token"].get_ref<const std::string&>();
+            auto [end, ec] = std::from_chars(token.data(), token.data() + token.size(), wire_id);
+            if (ec != std::errc{} || end != token.data() + token.size()) {
+                return message;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = inflight_.find(wire_id);
+            if (it == inflight_.end()) {
+                return message;
+            }
+            json restored = message;
+            const auto& original = it->second.original_id;
+            restored["params"]["token"] = original.is_string() ? original.get<std::string>() : original.dump();
+            return restored;
+        }
+
+        /**
+         * @brief Drop the requests of an exchange that is no longer waiting
+         */
+        void forget(const std::shared_ptr<HttpExchange>& exchange) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = inflight_.begin(); it != inflight_.end();) {
+                if (it->second.exchange == exchange) {
+                    it = inflight_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        /**
+         * @brief Answer every waiting request with internal_error
+         */
+        void fail_all() {
+            std::unordered_map<uint64_t, Entry> abandoned;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                abandoned.swap(inflight_);
+            }
+            for (auto& [wire_id, entry] : abandoned) {
+                deliver(entry.exchange, jsonrpc::make_error(entry.original_id, jsonrpc::internal_error));
+            }
+        }
+
+        /**
+         * @brief Number of requests currently waiting for a response
+         */
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return inflight_.size();
+        }
+
+    private:
+        struct Entry {
+            std::shared_ptr<HttpExchange> exchange;
+            json original_id;
+        };
+
+        /**
+         * @brief Assign a wire id to a request and register its exchange slot
+         */
+        void correlate(json& request, const std::shared_ptr<HttpExchange>& exchange) {
+            uint64_t wire_id = next_wire_id_.fetch_add(1, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                inflight_.emplace(wire_id, Entry{exchange, request["id"]});
+            }
+            request["id"] = wire_id;
+            ++exchange->expected;
+        }
+
+        static void drop_partial_result_token(json& request) {
+            auto params = request.find("params");
+            if (params != request.end() && params->is_object()) {
+                params->erase("partialResultToken");
+            }
+        }
+
+        /**
+         * @brief Point $/cancelRequest at the wire id of the request it names
+         *
+         * HTTP carries no session, so a cancel is only translated when exactly
+         * one in-flight request uses that id; an ambiguous cancel is dropped
+         * rather than risk cancelling another client's call.
+         */
+        void translate_cancel(json& message) {
+            if (message.is_array()) {
+                for (auto& element : message) {
+                    translate_cancel(element);
+                }
+                return;
+            }
+            if (!jsonrpc::is_notification(message) || message["method"] != "$/cancelRequest") {
+                return;
+            }
+            auto& params = message["params"];
+            if (!params.is_object() || !params.contains("id")) {
+                return;
+            }
+
+            std::optional<uint64_t> match;
+            size_t matches = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (const auto& [wire_id, entry] : inflight_) {
+                    if (entry.original_id == params["id"]) {
+                        match = wire_id;
+                        ++matches;
+                    }
+                }
+            }
+            if (matches == 1) {
+                params["id"] = *match;
+            } else {
+                params["id"] = nullptr;
+            }
+        }
+
+        static void deliver(const std::shared_ptr<HttpExchange>& exchange, json response) {
+            {
+                std::lock_guard<std::mutex> lock(exchange->mutex);
+                exchange->responses.push_back(std::move(response));
+                if (!exchange->complete()) {
+                    return;
+                }
+            }
+            exchange->ready.notify_one();
+            if (exchange->on_complete) {
+                exchange->on_complete();
+            }
+        }
+
+        std::unordered_map<uint64_t, Entry> inflight_;
+        mutable std::mutex mutex_;
+        std::atomic<uint64_t> next_wire_id_{1};
+    };
+
+} // namespace pooriayousefi::mcp::transport
@@ -1,12 +1,25 @@
 #pragma once
 
 #include "transport.hpp"
+#include "sse_queue.hpp"
+#include "http_correlator.hpp"
+#include "content_coding.hpp"
 #include "../core/asyncops.hpp"
 #include <httplib.h>
 #include <sstream>
 #include <thread>
 #include <atomic>
 #include <condition_variable>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
 
 /**
  * @file transport/http_transport.hpp
@@ -15,6 +28,11 @@
  * Provides HTTP-based MCP transport using Task<T> for async requests
  * and Generator<T> for Server-Sent Events streaming.
  * 
+ * Bodies and SSE streams are compressed with the coding negotiated through
+ * Accept-Encoding (see content_coding.hpp). The transports do this
+ * themselves, so leave httplib's own compression (CPPHTTPLIB_ZLIB_SUPPORT,
+ * CPPHTTPLIB_BROTLI_SUPPORT) off for the server, or bodies get encoded twice.
+ * 
  * @note Requires cpp-httplib: https://github.com/yhirose/cpp-httplib
  *       Header-only library, include in your project or install via package manager
  */
@@ -24,11 +42,25 @@ namespace pooriayousefi::mcp::transport
     using core::Task;
     using core::Generator;
 
+    /**
+     * @brief Connection settings for HttpClientTransport
+     */
+    struct HttpClientOptions {
+        size_t connections = 4;  ///< Keep-alive connections, each driven by its own I/O thread
+        size_t batch_limit = 1;  ///< Queued messages sent together in one POST as a JSON-RPC batch
+        std::chrono::seconds connect_timeout{5};
+        std::chrono::seconds io_timeout{30}; ///< Read and write timeout per POST
+        HttpCompressionOptions compression;  ///< Codings offered in Accept-Encoding; request bodies only with compression.requests
+    };
+
     /**
      * @brief HTTP client transport with async operations
      * 
-     * Sends JSON-RPC messages over HTTP POST and receives responses.
-     * Uses Task<T> for non-blocking async operations.
+     * Sends JSON-RPC messages over HTTP POST from a fixed set of I/O threads,
+     * each owning one keep-alive connection, so many requests can be in flight
+     * at once without a thread per request. Replies are routed by JSON-RPC id:
+     * to the send_async() call that sent the request, otherwise to the message
+     * handler. I/O threads start with start(), or on the first send.
      * 
      * @example
      * ```cpp
@@ -45,70 +77,132 @@ namespace pooriayousefi::mcp::transport
          * @brief Construct HTTP client
          * @param base_url Base URL of MCP server (e.g., "http://localhost:8080")
          * @param endpoint JSON-RPC endpoint path (default: "/jsonrpc")
+         * @param options Connection pool size, batching and timeouts
          */
         HttpClientTransport(
             const std::string& base_url,
-            const std::string& endpoint = "/jsonrpc"
+            const std::string& endpoint = "/jsonrpc",
+            HttpClientOptions options = {}
         )
             : base_url_(base_url)
             , endpoint_(endpoint)
-            , client_(parse_host(base_url), parse_port(base_url))
+            , host_(parse_host(base_url))
+            , port_(parse_port(base_url))
+            , options_(options)
+            , running_(false)
+            , in_flight_(0)
         {
-            client_.set_connection_timeout(5, 0); // 5 second timeout
-            client_.set_read_timeout(30, 0);      // 30 second read timeout
-            client_.set_write_timeout(30, 0);     // 30 second write timeout
+            options_.connections = std::max<size_t>(1, options_.connections);
+            options_.batch_limit = std::max<size_t>(1, options_.batch_limit);
         }
 
-        void send(const json& message) override {
-            std::string body = message.dump();
-            
-            auto res = client_.Post(endpoint_.c_str(), body, "application/json");
-            
-            if (!res) {
-                throw std::runtime_error("HTTP request failed: " + httplib::to_string(res.error()));
-            }
-            
-            if (res->status != 200) {
-                throw std::runtime_error("HTTP error: " + std::to_string(res->status));
-            }
+        ~HttpClientTransport() override {
+            close();
+            std::lock_guard<std::mutex> lock(threads_mutex_);
+            join_exited();
+        }
 
-            // Store response for receive()
-            std::lock_guard<std::mutex> lock(response_mutex_);
-            last_response_ = json::parse(res->body);
-            response_ready_.notify_one();
+        using Transport::send;
+
+        bool accepts_encoded() const override { return true; }
+
+        /**
+         * @brief Queue a message; its reply arrives through the message handler
+         */
+        void send(const json& message) override {
+            send(json(message));
         }
 
-        json receive() override {
-            std::unique_lock<std::mutex> lock(response_mutex_);
-            response_ready_.wait(lock, [this] { return !last_response_.is_null(); });
-            
-            json response = std::move(last_response_);
-            last_response_ = json{};
-            return response;
+        void send(json&& message) override {
+            start();
+            enqueue(std::move(message));
         }
 
         /**
-         * @brief Async send and receive
+         * @brief Send a request and resume with its response
          * @param message JSON-RPC message to send
-         * @return Task that resolves to response JSON
+         * @return Task that resolves to the response (null for notifications)
          */
         Task<json> send_async(const json& message) {
-            std::string body = message.dump();
-            
-            // Launch async HTTP request
-            co_return co_await std::async(std::launch::async, [this, body]() -> json {
-                auto res = client_.Post(endpoint_.c_str(), body, "application/json");
-                
-                if (!res) {
-                    throw std::runtime_error("HTTP request failed: " + httplib::to_string(res.error()));
+            start();
+            if (!message.is_object() || !message.contains("id")) {
+                enqueue(json(message));
+                co_return json{};
+            }
+            core::Completion<json> done;
+            {
+                std::lock_guard<std::mutex> lock(waiters_mutex_);
+                waiters_.insert_or_assign(message["id"].dump(), done);
+            }
+            enqueue(json(message));
+            co_return co_await done;
+        }
+
+        void start() override {
+            std::lock_guard<std::mutex> lock(threads_mutex_);
+            join_exited();
+            if (running_) return;
+            uint64_t generation;
+            {
+                std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+                running_ = true;
+                generation = ++generation_;
+            }
+            for (size_t i = 0; i < options_.connections; ++i) {
+                io_threads_.emplace_back([this, generation] { io_loop(generation); });
+            }
+        }
+
+        /**
+         * @brief Stop the I/O threads; queued messages are dropped and waiting calls fail
+         *
+         * May be called from the message handler. The I/O thread running it is
+         * not joined; it exits once the handler returns and is reaped by the
+         * next start() or the destructor.
+         */
+        void close() override {
+            std::vector<std::thread> threads;
+            {
+                std::lock_guard<std::mutex> lock(threads_mutex_);
+                if (!running_) return;
+                {
+                    std::lock_guard<std::mutex> queue_lock(queue_mutex_);
+                    running_ = false;
+                    ++generation_;
+                    queue_.clear();
                 }
-                
-                if (res->status != 200) {
-                    throw std::runtime_error("HTTP error: " + std::to_string(res->status));
+                threads.swap(io_threads_);
+            }
+            queue_cv_.notify_all();
+            // Waiting calls fail now rather than after a POST still in flight returns
+            std::unordered_map<std::string, core::Completion<json>> waiters;
+            {
+                std::lock_guard<std::mutex> lock(waiters_mutex_);
+                waiters.swap(waiters_);
+            }
+            for (auto& [id, waiter] : waiters) {
+                waiter.set_exception(std::make_exception_ptr(std::runtime_error("HTTP transport closed")));
+            }
+            for (auto& thread : threads) {
+                if (thread.get_id() == std::this_thread::get_id()) {
+                    std::lock_guard<std::mutex> lock(threads_mutex_);
+                    exited_.push_back(std::move(thread));
+                } else if (thread.joinable()) {
+                    thread.join();
                 }
+            }
+            emit_close();
+        }
 
-                return json::parse(res->body);
-            });
+        bool is_open() const override {
+            return running_;
+        }
+
+        /**
+         * @brief Number of messages queued or being posted
+         */
+        size_t in_flight() const {
+            return in_flight_.load();
         }
 
         /**
@@ -116,9 +210,10 @@ namespace pooriayousefi::mcp::transport
          * @param seconds Timeout in seconds
          */
         void set_timeout(int seconds) {
-            client_.set_connection_timeout(seconds, 0);
-            client_.set_read_timeout(seconds, 0);
-            client_.set_write_timeout(seconds, 0);
+            std::lock_guard<std::mutex> lock(config_mutex_);
+            options_.connect_timeout = std::chrono::seconds(seconds);
+            options_.io_timeout = std::chrono::seconds(seconds);
+            ++config_version_;
         }
 
         /**
@@ -126,13 +221,171 @@ namespace pooriayousefi::mcp::transport
          * @param headers Map of header name to value
          */
         void set_headers(const std::map<std::string, std::string>& headers) {
+            std::lock_guard<std::mutex> lock(config_mutex_);
             headers_ = headers;
-            for (const auto& [key, value] : headers_) {
-                client_.set_default_headers({{key.c_str(), value.c_str()}});
-            }
+            ++config_version_;
         }
 
     private:
+        struct connection {
+            std::unique_ptr<httplib::Client> client;
+            uint64_t version = 0;
+        };
+
+        // Join I/O threads that closed the transport from inside the handler;
+        // one still running the caller can only be detached
+        void join_exited() {
+            for (auto& thread : exited_) {
+                if (thread.get_id() == std::this_thread::get_id()) {
+                    thread.detach();
+                } else if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+            exited_.clear();
+        }
+
+        void enqueue(json&& message) {
+            in_flight_.fetch_add(1);
+            {
+                std::lock_guard<std::mutex> lock(queue_mutex_);
+                queue_.push_back(std::move(message));
+            }
+            queue_cv_.notify_one();
+        }
+
+        // (Re)create this thread's connection when the settings changed
+        void configure(connection& conn) {
+            std::lock_guard<std::mutex> lock(config_mutex_);
+            if (conn.client && conn.version == config_version_) return;
+            conn.client = std::make_unique<httplib::Client>(host_, port_);
+            conn.client->set_keep_alive(true);
+            conn.client->set_connection_timeout(options_.connect_timeout.count(), 0);
+            conn.client->set_read_timeout(options_.io_timeout.count(), 0);
+            conn.client->set_write_timeout(options_.io_timeout.count(), 0);
+            conn.client->set_decompress(false); // Content-Encoding is handled in deliver()
+            httplib::Headers headers;
+            for (const auto& [key, value] : headers_) headers.emplace(key, value);
+            if (options_.compression.enabled() && headers.find("Accept-Encoding") == headers.end()) {
+                headers.emplace("Accept-Encoding", accept_encoding_header(options_.compression.codings));
+            }
+            conn.client->set_default_headers(std::move(headers));
+            conn.version = config_version_;
+        }
+
+        void io_loop(uint64_t generation) {
+            connection conn;
+            std::vector<json> messages;
+            auto body = core::ObjectPool<std::string>::acquire();
+            auto packed = core::ObjectPool<std::string>::acquire();
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(queue_mutex_);
+                    queue_cv_.wait(lock, [&] { return !queue_.empty() || generation_ != generation; });
+                    if (generation_ != generation) return;
+                    while (!queue_.empty() && messages.size() < options_.batch_limit) {
+                        messages.push_back(std::move(queue_.front()));
+                        queue_.pop_front();
+                    }
+                }
+                const size_t count = messages.size();
+                configure(conn);
+                if (count == 1) {
+                    jsonrpc::dump_into(messages.front(), *body);
+                } else {
+                    jsonrpc::dump_into(json(messages), *body);
+                }
+                httplib::Result res;
+                const ContentCoding coding = options_.compression.requests && options_.compression.enabled()
+                    ? options_.compression.codings.front()
+                    : ContentCoding::identity;
+                if (compress_body(coding, *body, options_.compression, *packed)) {
+                    httplib::Headers headers{{"Content-Encoding", std::string(coding_name(coding))}};
+                    count_sent(packed->size());
+                    res = conn.client->Post(endpoint_.c_str(), headers, *packed, "application/json");
+                } else {
+                    count_sent(body->size());
+                    res = conn.client->Post(endpoint_.c_str(), *body, "application/json");
+                }
+                if (!res) {
+                    fail(messages, "HTTP request failed: " + httplib::to_string(res.error()));
+                    conn.client.reset(); // reconnect on next use
+                } else if (res->status != 200 && res->status != 202 && res->status != 204) {
+                    fail(messages, "HTTP error: " + std::to_string(res->status));
+                } else if (!res->body.empty()) {
+                    deliver(res->body, res->get_header_value("Content-Encoding"));
+                }
+                messages.clear();
+                in_flight_.fetch_sub(count);
+            }
+        }
+
+        void deliver(const std::string& body, const std::string& content_encoding) {
+            count_received(body.size());
+            json reply;
+            {
+                core::Span span(metrics_.get(), core::SpanKind::parse, metrics_name_);
+                try {
+                    auto coding = parse_coding(content_encoding);
+                    if (!coding) {
+                        emit_error("Unsupported Content-Encoding: " + content_encoding);
+                        return;
+                    }
+                    if (*coding == ContentCoding::identity) {
+                        reply = json::parse(body);
+                    } else {
+                        auto decoded = core::ObjectPool<std::string>::acquire();
+                        ContentDecoder(*coding).decode(body, *decoded);
+                        reply = json::parse(*decoded);
+                    }
+                } catch (const json::exception& e) {
+                    span.fail();
+                    emit_error(std::string("JSON parse error: ") + e.what());
+                    return;
+                } catch (const std::exception& e) {
+                    span.fail();
+                    emit_error(std::string("Response decoding failed: ") + e.what());
+                    return;
+                }
+            }
+            if (reply.is_array()) {
+                for (auto& element : reply) route(std::move(element));
+            } else {
+                route(std::move(reply));
+            }
+        }
+
+        // A waiting send_async() call takes its response; everything else goes to the handler
+        void route(json&& message) {
+            if (jsonrpc::is_response(message)) {
+                std::optional<core::Completion<json>> waiter;
+                {
+                    std::lock_guard<std::mutex> lock(waiters_mutex_);
+                    auto it = waiters_.find(message["id"].dump());
+                    if (it != waiters_.end()) {
+                        waiter = std::move(it->second);
+                        waiters_.erase(it);
+                    }
+                }
+                if (waiter) {
+                    waiter->set_value(std::move(message));
+                    return;
+                }
+            }
+            emit_message(std::move(message));
+        }
+
+        // Requests in a failed POST are answered locally so their callers do not wait for a timeout
+        void fail(const std::vector<json>& messages, const std::string& why) {
+            emit_error(why);
+            for (const auto& message : messages) {
+                if (!jsonrpc::is_request(message) || !message.contains("id")) continue;
+                jsonrpc::error e = jsonrpc::internal_error;
+                e.data = json{{"what", why}};
+                route(jsonrpc::make_error(message["id"], e));
+            }
+        }
+
         static std::string parse_host(const std::string& url) {
             // Parse http://host:port -> host
             size_t start = url.find("://");
@@ -165,19 +418,35 @@ namespace pooriayousefi::mcp::transport
 
         std::string base_url_;
         std::string endpoint_;
-        httplib::Client client_;
+        std::string host_;
+        int port_;
+
+        HttpClientOptions options_;
         std::map<std::string, std::string> headers_;
-        
-        json last_response_;
-        std::mutex response_mutex_;
-        std::condition_variable response_ready_;
+        uint64_t config_version_ = 0;
+        std::mutex config_mutex_;
+
+        std::atomic<bool> running_;
+        std::atomic<size_t> in_flight_;
+        std::vector<std::thread> io_threads_;
+        std::vector<std::thread> exited_;
+        std::mutex threads_mutex_;
+
+        std::deque<json> queue_;
+        uint64_t generation_ = 0;
+        std::mutex queue_mutex_;
+        std::condition_variable queue_cv_;
+
+        std::unordered_map<std::string, core::Completion<json>> waiters_;
+        std::mutex waiters_mutex_;
     };
 
     /**
      * @brief Server-Sent Events (SSE) client transport
      * 
      * Receives streaming JSON-RPC messages via SSE using Generator<T>
-     * for incremental processing.
+     * for incremental processing. Compressed streams are decoded as they
+     * arrive; events may span any number of chunks.
      * 
      * @example
      * ```cpp
@@ -194,9 +463,11 @@ namespace pooriayousefi::mcp::transport
         /**
          * @brief Construct SSE client
          * @param url SSE endpoint URL
+         * @param codings Codings offered in Accept-Encoding; empty asks for an uncompressed stream
          */
-        SseClientTransport(const std::string& url)
+        SseClientTransport(const std::string& url, std::vector<ContentCoding> codings = available_codings())
             : url_(url)
+            , codings_(std::move(codings))
             , running_(false)
         {}
 
@@ -252,42 +523,62 @@ namespace pooriayousefi::mcp::transport
     private:
         void receive_loop() {
             httplib::Client client(parse_host(url_), parse_port(url_));
+            client.set_decompress(false); // decoded incrementally below
+            httplib::Headers headers;
+            if (!codings_.empty()) headers.emplace("Accept-Encoding", accept_encoding_header(codings_));
+            std::unique_ptr<ContentDecoder> decoder;
+            std::string decoded;
             
-            client.Get(parse_path(url_).c_str(), {}, 
-                [this](const httplib::Response& response) {
-                    return running_;
+            client.Get(parse_path(url_).c_str(), headers, 
+                [this, &decoder](const httplib::Response& response) {
+                    auto coding = parse_coding(response.get_header_value("Content-Encoding"));
+                    if (!coding || !coding_available(*coding)) return false;
+                    if (*coding != ContentCoding::identity) decoder = std::make_unique<ContentDecoder>(*coding);
+                    return running_.load();
                 },
-                [this](const char* data, size_t length) {
-                    std::string chunk(data, length);
-                    process_sse_chunk(chunk);
-                    return running_;
+                [this, &decoder, &decoded](const char* data, size_t length) {
+                    if (!decoder) {
+                        process_sse_chunk(std::string_view(data, length));
+                        return running_.load();
+                    }
+                    decoded.clear();
+                    try {
+                        decoder->decode(std::string_view(data, length), decoded);
+                    } catch (const std::exception&) {
+                        return false; // corrupt stream
+                    }
+                    process_sse_chunk(decoded);
+                    return running_.load();
                 }
             );
         }
 
-        void process_sse_chunk(const std::string& chunk) {
-            // Parse SSE format: "data: {...}\n\n"
-            std::istringstream stream(chunk);
-            std::string line;
-            std::string data;
-
-            while (std::getline(stream, line)) {
+        void process_sse_chunk(std::string_view chunk) {
+            // Parse SSE format: "data: {...}\n\n"; an event may be split across chunks
+            pending_.append(chunk);
+            size_t start = 0;
+            size_t end;
+            while ((end = pending_.find('\n', start)) != std::string::npos) {
+                std::string_view line(pending_.data() + start, end - start);
+                start = end + 1;
+                if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
                 if (line.substr(0, 6) == "data: ") {
-                    data = line.substr(6);
-                } else if (line.empty() && !data.empty()) {
+                    data_ = line.substr(6);
+                } else if (line.empty() && !data_.empty()) {
                     // Complete message
                     try {
-                        json message = json::parse(data);
+                        json message = json::parse(data_);
                         
                         std::lock_guard<std::mutex> lock(queue_mutex_);
-                        message_queue_.push(message);
+                        message_queue_.push(std::move(message));
                         queue_cv_.notify_one();
                     } catch (...) {
                         // Invalid JSON, skip
                     }
-                    data.clear();
+                    data_.clear();
                 }
             }
+            pending_.erase(0, start);
         }
 
         static std::string parse_host(const std::string& url) {
@@ -330,8 +621,11 @@ namespace pooriayousefi::mcp::transport
         }
 
         std::string url_;
+        std::vector<ContentCoding> codings_;
         std::atomic<bool> running_;
         std::thread receiver_thread_;
+        std::string pending_; // received bytes not yet split into lines
+        std::string data_;    // data line of the event being read
         std::queue<json> message_queue_;
         std::mutex queue_mutex_;
         std::condition_variable queue_cv_;
@@ -343,6 +637,17 @@ namespace pooriayousefi::mcp::transport
      * Listens for JSON-RPC requests over HTTP POST and sends responses.
      * Supports SSE for streaming notifications.
      * 
+     * Every POST gets its own exchange slot in a correlation table, so any
+     * number of httplib worker threads can have `/jsonrpc` calls in flight at
+     * once. Request ids are rewritten to transport-unique wire ids on the way
+     * in and restored on the way out, which keeps two clients that both use
+     * id 1 from ever receiving each other's responses.
+     * 
+     * Responses of at least HttpCompressionOptions::threshold bytes and SSE
+     * streams are compressed when the client's Accept-Encoding allows it;
+     * an SSE stream uses one compressor for its whole life, flushed after
+     * each batch of events. POST bodies with a Content-Encoding are decoded.
+     * 
      * @example
      * ```cpp
      * HttpServerTransport transport(8080);
@@ -364,6 +669,7 @@ namespace pooriayousefi::mcp::transport
             , host_(host)
             , server_(std::make_unique<httplib::Server>())
             , running_(false)
+            , request_timeout_(std::chrono::seconds(30))
         {
             setup_routes();
         }
@@ -372,26 +678,36 @@ namespace pooriayousefi::mcp::transport
             stop();
         }
 
+        using Transport::send;
+
+        bool accepts_encoded() const override { return true; }
+
+        /**
+         * @brief Send a message produced by the server endpoint
+         * 
+         * Responses (single or batch) are routed to the POST that carried the
+         * matching request. Everything else (notifications, server-initiated
+         * requests) has no waiting POST and goes out over SSE.
+         */
         void send(const json& message) override {
-            // Store response for next HTTP response
-            std::lock_guard<std::mutex> lock(response_mutex_);
-            pending_response_ = message;
-            response_ready_.notify_one();
-        }
+            if (message.is_array()) {
+                for (const auto& element : message) {
+                    if (!correlator_.route_response(element)) {
+                        send_sse_notification(element);
+                    }
+                }
+                return;
+            }
 
-        json receive() override {
-            std::unique_lock<std::mutex> lock(request_mutex_);
-            request_ready_.wait(lock, [this] { return !pending_request_.is_null(); });
-            
-            json request = std::move(pending_request_);
-            pending_request_ = json{};
-            return request;
+            if (!correlator_.route_response(message)) {
+                send_sse_notification(correlator_.restore_progress_token(message));
+            }
         }
 
         /**
          * @brief Start HTTP server
          */
-        void start() {
+        void start() override {
             if (running_.exchange(true)) {
                 return;
             }
@@ -403,29 +719,100 @@ namespace pooriayousefi::mcp::transport
 
         /**
          * @brief Stop HTTP server
+         * 
+         * POSTs still waiting are answered with internal_error before the
+         * server thread is joined, since httplib waits for their handlers.
          */
         void stop() {
             if (running_.exchange(false)) {
+                close_sse_queues();
                 server_->stop();
+                correlator_.fail_all();
                 if (server_thread_.joinable()) {
                     server_thread_.join();
                 }
+                emit_close();
             }
         }
 
+        void close() override {
+            stop();
+        }
+
+        bool is_open() const override {
+            return running_;
+        }
+
+        /**
+         * @brief Set how long a POST waits for its response before answering 504
+         */
+        void set_request_timeout(std::chrono::milliseconds timeout) {
+            request_timeout_ = timeout;
+        }
+
+        /**
+         * @brief Number of requests currently waiting for a response
+         */
+        size_t in_flight() const {
+            return correlator_.size();
+        }
+
+        /**
+         * @brief Codings, size threshold and level used for responses and SSE streams
+         * 
+         * Call before start(); pass options with no codings to turn compression off.
+         */
+        void set_compression(HttpCompressionOptions options) {
+            compression_ = std::move(options);
+        }
+
+        /**
+         * @brief Per-subscriber queue size and what a full queue does
+         * 
+         * Applies to SSE connections opened afterwards.
+         */
+        void set_sse_queue(size_t capacity, SseOverflow policy = SseOverflow::drop_oldest) {
+            std::lock_guard<std::mutex> lock(sse_mutex_);
+            sse_capacity_ = capacity;
+            sse_policy_ = policy;
+        }
+
+        /**
+         * @brief Number of connected SSE clients
+         */
+        size_t sse_subscribers() const {
+            std::lock_guard<std::mutex> lock(sse_mutex_);
+            return sse_queues_.size();
+        }
+
+        /**
+         * @brief As Transport::set_metrics, plus request and SSE gauges and a /metrics route
+         * 
+         * Adds mcp_http_in_flight and the SSE gauges of observe_sse_queues(). While a
+         * registry is set, GET /metrics answers with its Prometheus text. Call before start().
+         */
+        void set_metrics(std::shared_ptr<core::Metrics> metrics, const std::string& name) override {
+            gauges_.clear();
+            Transport::set_metrics(std::move(metrics), name);
+            if (!metrics_) return;
+            gauges_ = observe_sse_queues(*metrics_, name, sse_queues_, sse_mutex_);
+            gauges_.push_back(metrics_->observe("mcp_http_in_flight", "POSTs waiting for their response", "transport", name, [this] {
+                return static_cast<double>(correlator_.size());
+            }));
+        }
+
         /**
          * @brief Send SSE notification to all connected clients
+         * 
+         * The event is serialized once and queued for each subscriber; the
+         * subscribers' connections write it, so this never waits on a socket.
          * @param notification Notification message
          */
         void send_sse_notification(const json& notification) {
+            const auto event = SseEvent::from(notification);
             std::lock_guard<std::mutex> lock(sse_mutex_);
-            
-            std::string data = "data: " + notification.dump() + "\n\n";
-            
-            for (auto& sink : sse_sinks_) {
-                if (sink) {
-                    sink->write(data.c_str(), data.size());
-                }
+            for (const auto& queue : sse_queues_) {
+                queue->push(event);
             }
         }
 
@@ -445,70 +832,166 @@ namespace pooriayousefi::mcp::transport
             server_->Get("/health", [](const httplib::Request&, httplib::Response& res) {
                 res.set_content("{\"status\":\"ok\"}", "application/json");
             });
+
+            // Prometheus scrape, once set_metrics() was given a registry
+            server_->Get("/metrics", [this](const httplib::Request&, httplib::Response& res) {
+                if (!metrics_) {
+                    res.status = 404;
+                    return;
+                }
+                res.set_content(metrics_->prometheus(), "text/plain; version=0.0.4");
+            });
         }
 
         void handle_jsonrpc_request(const httplib::Request& req, httplib::Response& res) {
-            try {
-                json request = json::parse(req.body);
-                
-                // Queue request
-                {
-                    std::lock_guard<std::mutex> lock(request_mutex_);
-                    pending_request_ = request;
-                    request_ready_.notify_one();
+            if (!running_) {
+                res.status = 503;
+                return;
+            }
+            std::string_view body = req.body;
+            core::ObjectPool<std::string>::Handle decoded;
+            if (req.has_header("Content-Encoding")) {
+                auto coding = parse_coding(req.get_header_value("Content-Encoding"));
+                if (!coding || !coding_available(*coding)) {
+                    res.status = 415;
+                    res.set_content("{\"error\":\"Unsupported Content-Encoding\"}", "application/json");
+                    return;
+                }
+                if (*coding != ContentCoding::identity) {
+                    decoded = core::ObjectPool<std::string>::acquire();
+                    try {
+                        ContentDecoder(*coding).decode(body, *decoded);
+                    } catch (const std::exception&) {
+                        res.status = 400;
+                        res.set_content("{\"error\":\"Corrupt request body\"}", "application/json");
+                        return;
+                    }
+                    body = *decoded;
                 }
+            }
 
-                // Wait for response
-                std::unique_lock<std::mutex> lock(response_mutex_);
-                response_ready_.wait_for(lock, std::chrono::seconds(30), [this] {
-                    return !pending_response_.is_null();
-                });
+            count_received(body.size());
+            auto exchange = std::make_shared<HttpExchange>();
+            HttpPost post;
+            {
+                core::Span span(metrics_.get(), core::SpanKind::parse, metrics_name_);
+                post = correlator_.accept(body, exchange);
+                if (!post.message) span.fail();
+            }
 
-                if (!pending_response_.is_null()) {
-                    res.set_content(pending_response_.dump(), "application/json");
-                    pending_response_ = json{};
-                } else {
-                    res.status = 504; // Gateway timeout
-                    res.set_content("{\"error\":\"Timeout\"}", "application/json");
+            if (post.message) {
+                std::lock_guard<std::mutex> lock(dispatch_mutex_);
+                emit_message(std::move(*post.message));
+            }
+
+            if (post.status != 0) {
+                res.status = post.status;
+                if (!post.body.empty()) {
+                    res.set_content(std::move(post.body), "application/json");
+                }
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(exchange->mutex);
+            bool done = exchange->ready.wait_for(lock, request_timeout_, [&exchange] {
+                return exchange->complete();
+            });
+            lock.unlock();
+
+            if (!done) {
+                correlator_.forget(exchange);
+                res.status = 504; // Gateway timeout
+                res.set_content("{\"error\":\"Timeout\"}", "application/json");
+                return;
+            }
+
+            send_body(req, res, exchange->body());
+        }
+
+        // Compressed when the client accepts a coding and the body is large enough
+        void send_body(const httplib::Request& req, httplib::Response& res, std::string body) {
+            if (compression_.enabled()) {
+                res.set_header("Vary", "Accept-Encoding");
+                const auto coding = negotiate(req.get_header_value("Accept-Encoding"), compression_.codings);
+                std::string packed;
+                if (compress_body(coding, body, compression_, packed)) {
+                    count_sent(packed.size());
+                    res.set_header("Content-Encoding", std::string(coding_name(coding)));
+                    res.set_content(std::move(packed), "application/json");
+                    return;
                 }
-            } catch (const std::exception& e) {
-                res.status = 400;
-                res.set_content(
-                    json{{"error", e.what()}}.dump(),
-                    "application/json"
-                );
             }
+            count_sent(body.size());
+            res.set_content(std::move(body), "application/json");
         }
 
-        void handle_sse_connection(const httplib::Request&, httplib::Response& res) {
-            res.set_header("Content-Type", "text/event-stream");
+        void handle_sse_connection(const httplib::Request& req, httplib::Response& res) {
             res.set_header("Cache-Control", "no-cache");
             res.set_header("Connection", "keep-alive");
 
-            // Register SSE sink
+            // One compressor per stream, so the window spans events
+            std::shared_ptr<ContentEncoder> encoder;
+            if (compression_.enabled() && compression_.sse) {
+                res.set_header("Vary", "Accept-Encoding");
+                const auto coding = negotiate(req.get_header_value("Accept-Encoding"), compression_.codings);
+                if (coding != ContentCoding::identity) {
+                    encoder = std::make_shared<ContentEncoder>(coding, compression_.level);
+                    res.set_header("Content-Encoding", std::string(coding_name(coding)));
+                }
+            }
+
+            // The queue is owned by the provider and releaser, never by a raw
+            // pointer that outlives the response.
+            std::shared_ptr<SseQueue> queue;
             {
                 std::lock_guard<std::mutex> lock(sse_mutex_);
-                sse_sinks_.push_back(&res);
+                queue = std::make_shared<SseQueue>(sse_capacity_, sse_policy_);
+                sse_queues_.push_back(queue);
             }
-
-            // Keep connection alive
-            res.set_content_provider(
+            res.set_chunked_content_provider(
                 "text/event-stream",
-                [this](size_t, httplib::DataSink& sink) {
-                    // Keep alive ping every 30 seconds
-                    std::this_thread::sleep_for(std::chrono::seconds(30));
-                    sink.write(": ping\n\n", 8);
-                    return running_;
+                [this, queue, encoder](size_t, httplib::DataSink& sink) {
+                    std::vector<SseEvent> events;
+                    // Keep alive ping every 30 seconds without traffic
+                    if (!queue->wait_pop(events, std::chrono::seconds(30)) || !running_) {
+                        return false;
+                    }
+                    if (encoder) {
+                        auto batch = core::ObjectPool<std::string>::acquire();
+                        auto packed = core::ObjectPool<std::string>::acquire();
+                        if (events.empty()) batch->append(": ping\n\n");
+                        for (const auto& event : events) batch->append(*event.data);
+                        encoder->encode(*batch, *packed);
+                        count_sent(packed->size());
+                        return sink.write(packed->data(), packed->size());
+                    }
+                    if (events.empty()) {
+                        return sink.write(": ping\n\n", 8);
+                    }
+                    for (const auto& event : events) {
+                        if (!sink.write(event.data->data(), event.data->size())) {
+                            return false;
+                        }
+                        count_sent(event.data->size());
+                    }
+                    return true;
+                },
+                [this, queue](bool) {
+                    queue->close();
+                    std::lock_guard<std::mutex> lock(sse_mutex_);
+                    sse_queues_.erase(
+                        std::remove(sse_queues_.begin(), sse_queues_.end(), queue),
+                        sse_queues_.end()
+                    );
                 }
             );
+        }
 
-            // Remove sink when connection closes
-            {
-                std::lock_guard<std::mutex> lock(sse_mutex_);
-                sse_sinks_.erase(
-                    std::remove(sse_sinks_.begin(), sse_sinks_.end(), &res),
-                    sse_sinks_.end()
-                );
+        // Wakes every SSE provider so its connection can finish
+        void close_sse_queues() {
+            std::lock_guard<std::mutex> lock(sse_mutex_);
+            for (const auto& queue : sse_queues_) {
+                queue->close();
             }
         }
 
@@ -517,16 +1000,20 @@ namespace pooriayousefi::mcp::transport
         std::unique_ptr<httplib::Server> server_;
         std::atomic<bool> running_;
         std::thread server_thread_;
+        std::chrono::milliseconds request_timeout_;
+        HttpCompressionOptions compression_;
+
+        // Wire id -> waiting POST
+        HttpCorrelator correlator_;
 
-        json pending_request_;
-        json pending_response_;
-        std::mutex request_mutex_;
-        std::mutex response_mutex_;
-        std::condition_variable request_ready_;
-        std::condition_variable response_ready_;
+        // Serializes delivery so the message handler sees one message at a time
+        std::mutex dispatch_mutex_;
 
-        std::vector<httplib::Response*> sse_sinks_;
-        std::mutex sse_mutex_;
+        std::vector<std::shared_ptr<SseQueue>> sse_queues_;
+        size_t sse_capacity_ = 256;
+        SseOverflow sse_policy_ = SseOverflow::drop_oldest;
+        mutable std::mutex sse_mutex_;
+        std::vector<core::Observation> gauges_;
     };
 
 } // namespace pooriayousefi::mcp::transport
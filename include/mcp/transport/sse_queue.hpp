@@ -0,0 +1,225 @@
+#pragma once
+
+#include "../jsonrpc/jsonrpc.hpp"
+#include "../core/objectpool.hpp"
+#include "../core/metrics.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+
+/**
+ * @file sse_queue.hpp
+ * @brief Per-subscriber outgoing queues for Server-Sent Events
+ *
+ * A notification is formatted as an SSE event once and shared by every
+ * subscriber's queue; each subscriber's connection drains its own queue, so a
+ * slow client only ever delays itself. Queues are bounded, and what happens
+ * when one fills up is chosen by SseOverflow.
+ */
+
+namespace pooriayousefi::mcp::transport
+{
+    using json = jsonrpc::json;
+
+    /**
+     * @brief What a full subscriber queue does with a new event
+     */
+    enum class SseOverflow {
+        drop_oldest,       ///< Discard the oldest queued event
+        coalesce_progress, ///< A progress update replaces the queued one for its token; otherwise drop oldest
+        disconnect         ///< Close the subscriber's stream
+    };
+
+    /**
+     * @brief One formatted SSE event ("data: ...\n\n"), shared between queues
+     */
+    struct SseEvent {
+        std::shared_ptr<const std::string> data;
+        std::string progress_key; ///< Token of a progress report (see progress_key_of), else empty
+
+        /**
+         * @brief Serialize a message once as an SSE event
+         */
+        static SseEvent from(const json& message) {
+            auto body = core::ObjectPool<std::string>::acquire();
+            jsonrpc::dump_into(message, *body);
+            auto text = std::make_shared<std::string>();
+            text->reserve(body->size() + 8);
+            text->append("data: ").append(*body).append("\n\n");
+
+            return SseEvent{std::move(text), progress_key_of(message)};
+        }
+
+        /**
+         * @brief Token of a progress report, or empty
+         * 
+         * Covers MCP `notifications/progress` and `$/progress` whose value has a
+         * numeric `progress`. Partial results also travel as `$/progress` but
+         * carry content instead, so they never share a key and are never merged.
+         */
+        static std::string progress_key_of(const json& message) {
+            if (!message.is_object()) return {};
+            auto method = message.find("method");
+            auto params = message.find("params");
+            if (method == message.end() || !method->is_string() || params == message.end() || !params->is_object()) {
+                return {};
+            }
+            if (*method == "notifications/progress") {
+                auto token = params->find("progressToken");
+                return token != params->end() ? token->dump() : std::string();
+            }
+            if (*method == "$/progress") {
+                auto token = params->find("token");
+                auto value = params->find("value");
+                if (token != params->end() && value != params->end() && value->is_object()) {
+                    auto progress = value->find("progress");
+                    if (progress != value->end() && progress->is_number()) return token->dump();
+                }
+            }
+            return {};
+        }
+    };
+
+    /**
+     * @brief Bounded ring of events waiting to be written to one subscriber
+     *
+     * Producers push without touching the network; the subscriber's content
+     * provider takes everything queued with wait_pop() and writes it.
+     */
+    class SseQueue {
+    public:
+        explicit SseQueue(size_t capacity = 256, SseOverflow policy = SseOverflow::drop_oldest)
+            : ring_(std::max<size_t>(1, capacity))
+            , policy_(policy)
+        {}
+
+        /**
+         * @brief Queue an event
+         * @return false when the subscriber is closed (now or already)
+         */
+        bool push(const SseEvent& event) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (closed_) return false;
+                if (policy_ == SseOverflow::coalesce_progress && !event.progress_key.empty()) {
+                    // Only the latest progress matters; keep the queued one's position
+                    for (size_t i = 0; i < count_; ++i) {
+                        auto& queued = ring_[(head_ + i) % ring_.size()];
+                        if (queued.progress_key == event.progress_key) {
+                            queued.data = event.data;
+                            dropped_.fetch_add(1, std::memory_order_relaxed);
+                            return true;
+                        }
+                    }
+                }
+                if (count_ == ring_.size()) {
+                    if (policy_ == SseOverflow::disconnect) {
+                        closed_ = true;
+                        ready_.notify_all();
+                        return false;
+                    }
+                    ring_[head_] = SseEvent{};
+                    head_ = (head_ + 1) % ring_.size();
+                    --count_;
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                ring_[(head_ + count_) % ring_.size()] = event;
+                ++count_;
+            }
+            ready_.notify_one();
+            return true;
+        }
+
+        /**
+         * @brief Wait up to timeout for events and move all queued ones into out
+         * @return false once the queue is closed
+         */
+        bool wait_pop(std::vector<SseEvent>& out, std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait_for(lock, timeout, [this] { return count_ > 0 || closed_; });
+            if (closed_) return false;
+            for (; count_ > 0; --count_) {
+                out.push_back(std::move(ring_[head_]));
+                head_ = (head_ + 1) % ring_.size();
+            }
+            return true;
+        }
+
+        /**
+         * @brief Stop accepting events and wake the waiting provider
+         */
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                closed_ = true;
+            }
+            ready_.notify_all();
+        }
+
+        bool closed() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return closed_;
+        }
+
+        size_t size() const {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return count_;
+        }
+
+        /**
+         * @brief Events discarded or superseded by overflow handling
+         */
+        size_t dropped() const {
+            return dropped_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::vector<SseEvent> ring_;
+        size_t head_ = 0;
+        size_t count_ = 0;
+        bool closed_ = false;
+        SseOverflow policy_;
+        std::atomic<size_t> dropped_{0};
+        mutable std::mutex mutex_;
+        std::condition_variable ready_;
+    };
+
+    /**
+     * @brief Gauges over a server's subscriber queues, labelled transport="name"
+     * 
+     * mcp_sse_subscribers, mcp_sse_queue_depth (events waiting for the slowest
+     * subscriber, i.e. how far it lags) and mcp_sse_dropped_events (dropped or
+     * superseded for the connected subscribers). queues is read under mutex.
+     */
+    inline std::vector<core::Observation> observe_sse_queues(
+        core::Metrics& metrics,
+        const std::string& name,
+        const std::vector<std::shared_ptr<SseQueue>>& queues,
+        std::mutex& mutex
+    ) {
+        std::vector<core::Observation> gauges;
+        gauges.push_back(metrics.observe("mcp_sse_subscribers", "Connected SSE clients", "transport", name, [&queues, &mutex] {
+            std::lock_guard<std::mutex> lock(mutex);
+            return static_cast<double>(queues.size());
+        }));
+        gauges.push_back(metrics.observe("mcp_sse_queue_depth", "Events waiting for the slowest SSE client", "transport", name, [&queues, &mutex] {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t deepest = 0;
+            for (const auto& queue : queues) deepest = std::max(deepest, queue->size());
+            return static_cast<double>(deepest);
+        }));
+        gauges.push_back(metrics.observe("mcp_sse_dropped_events", "Events dropped or superseded for connected SSE clients", "transport", name, [&queues, &mutex] {
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t dropped = 0;
+            for (const auto& queue : queues) dropped += queue->dropped();
+            return static_cast<double>(dropped);
+        }));
+        return gauges;
+    }
+
+} // namespace pooriayousefi::mcp::transport
@@ -0,0 +1,460 @@
+#pragma once
+
+#include "transport.hpp"
+#include "../core/objectpool.hpp"
+#include <vector>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <optional>
+#include <array>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/uio.h>
+
+/**
+ * @file stdio_fast.hpp
+ * @brief Raw file-descriptor stdio transport
+ *
+ * FastStdioTransport talks to its peer through read(2)/writev(2) on two file
+ * descriptors (stdin/stdout by default) instead of iostreams:
+ * - Input lands in one reusable buffer and is parsed in place, without
+ *   copying each message into a std::string first
+ * - Output is queued, and whichever sender finds the queue idle writes every
+ *   queued message with a single writev()
+ * - Messages may be newline-delimited JSON or LSP-style `Content-Length`
+ *   frames. A framed payload is parsed as soon as its length has arrived,
+ *   without scanning the body for a newline
+ * - Framed payloads may be CBOR or MessagePack once negotiated (codec.hpp)
+ */
+
+namespace pooriayousefi::mcp::transport
+{
+    /**
+     * @brief Message framing on a stdio stream
+     */
+    enum class StdioFraming
+    {
+        newline,          ///< One JSON text per line
+        content_length,   ///< `Content-Length: N\r\n\r\n` header before each payload
+        detect            ///< Accept either on input; reply in whichever framing the peer used
+    };
+
+    /**
+     * @brief Configuration for FastStdioTransport
+     */
+    struct FastStdioOptions
+    {
+        int input_fd = STDIN_FILENO;
+        int output_fd = STDOUT_FILENO;
+        StdioFraming framing = StdioFraming::detect;
+        size_t read_chunk = 64 * 1024;                 ///< Minimum free space for each read()
+        size_t max_message_bytes = 64 * 1024 * 1024;  ///< Larger frames are reported and dropped
+        bool close_fds = false;                        ///< Close both fds in close()
+    };
+
+    namespace detail
+    {
+        /**
+         * @brief Contiguous input buffer that is reused for the whole session
+         *
+         * Bytes are appended at the tail and consumed from the head. Instead of
+         * wrapping around like a ring, the unconsumed tail is moved back to the
+         * front when space runs out, so a complete message is always contiguous
+         * and can be handed to the parser without copying.
+         */
+        class frame_buffer
+        {
+        public:
+            // Writable space of at least min_free bytes at the tail
+            char* prepare(size_t min_free)
+            {
+                if (storage_.size() - tail_ >= min_free) return storage_.data() + tail_;
+                if (head_ > 0)
+                {
+                    std::memmove(storage_.data(), storage_.data() + head_, tail_ - head_);
+                    tail_ -= head_;
+                    head_ = 0;
+                }
+                if (storage_.size() - tail_ < min_free)
+                    storage_.resize(std::max(storage_.size() * 2, tail_ + min_free));
+                return storage_.data() + tail_;
+            }
+
+            size_t writable() const { return storage_.size() - tail_; }
+            void commit(size_t n) { tail_ += n; }
+            const char* data() const { return storage_.data() + head_; }
+            size_t size() const { return tail_ - head_; }
+
+            void consume(size_t n)
+            {
+                head_ += n;
+                if (head_ == tail_) head_ = tail_ = 0;
+            }
+
+            void clear() { head_ = tail_ = 0; }
+
+        private:
+            std::vector<char> storage_;
+            size_t head_ = 0;
+            size_t tail_ = 0;
+        };
+    }
+
+    /**
+     * @brief Stdio transport built on raw reads and vectored writes
+     *
+     * Drop-in replacement for StdioTransport when messages are large or frequent.
+     * The descriptors are not owned unless FastStdioOptions::close_fds is set, which
+     * also makes the transport usable over pipes and sockets.
+     *
+     * @example
+     * ```cpp
+     * auto transport = std::make_shared<transport::FastStdioTransport>();
+     * Server server(transport, {"my-server", "1.0.0"});
+     * server.start();
+     * ```
+     */
+    class FastStdioTransport : public Transport
+    {
+    public:
+        explicit FastStdioTransport(FastStdioOptions options = {})
+            : options_(options)
+            , running_(false)
+            , reply_framed_(options.framing == StdioFraming::content_length)
+        {}
+
+        using Transport::send;
+
+        bool accepts_encoded() const override { return true; }
+
+        // Binary messages need Content-Length frames, which are sent whenever one is in use
+        bool supports_encoding(Encoding encoding) const override {
+            return encoding == Encoding::json || options_.framing != StdioFraming::newline;
+        }
+
+        void send(const json& message) override {
+            out_frame frame;
+            frame.body = core::ObjectPool<std::string>::acquire();
+            const Encoding encoding = this->encoding();
+            try {
+                encode_message(message, encoding, *frame.body);
+            } catch (const std::exception& e) {
+                emit_error(std::string("Failed to send message: ") + e.what());
+                return;
+            }
+            if (encoding != Encoding::json || reply_framed_.load(std::memory_order_relaxed)) {
+                frame.set_header(frame.body->size());
+            } else {
+                frame.body->push_back('\n');
+            }
+            enqueue(std::move(frame));
+        }
+
+        void start() override {
+            if (running_) return;
+            running_ = true;
+            read_thread_ = std::thread([this]() { read_loop(); });
+        }
+
+        void close() override {
+            running_ = false;
+            if (read_thread_.joinable() && read_thread_.get_id() != std::this_thread::get_id()) {
+                read_thread_.join();
+            }
+            flush();
+            if (options_.close_fds && !fds_closed_.exchange(true)) {
+                ::close(options_.input_fd);
+                if (options_.output_fd != options_.input_fd) ::close(options_.output_fd);
+            }
+        }
+
+        bool is_open() const override {
+            return running_;
+        }
+
+        /**
+         * @brief Block until every queued message has been written
+         */
+        void flush() {
+            std::unique_lock<std::mutex> lock(out_mutex_);
+            out_cv_.wait(lock, [this]() { return !writing_ && out_queue_.empty(); });
+        }
+
+        ~FastStdioTransport() {
+            close();
+            if (read_thread_.joinable()) read_thread_.detach();
+        }
+
+    private:
+        // Body buffers are pooled: once written they return to the pool with their
+        // capacity, so a steady stream of replies does not allocate per message
+        struct out_frame
+        {
+            std::array<char, 48> header{};
+            size_t header_size = 0;   // 0 for newline framing
+            core::Pooled<std::string> body;
+
+            void set_header(size_t length) {
+                static constexpr std::string_view prefix = "Content-Length: ";
+                char* p = std::copy(prefix.begin(), prefix.end(), header.data());
+                p = std::to_chars(p, header.data() + header.size() - 4, length).ptr;
+                p = std::copy_n("\r\n\r\n", 4, p);
+                header_size = static_cast<size_t>(p - header.data());
+            }
+        };
+
+        // --- Output: leader/follower writev coalescing ---
+
+        void enqueue(out_frame frame) {
+            std::deque<out_frame> batch;
+            {
+                std::lock_guard<std::mutex> lock(out_mutex_);
+                out_queue_.push_back(std::move(frame));
+                if (writing_) return; // the active writer picks it up
+                writing_ = true;
+            }
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> lock(out_mutex_);
+                    if (out_queue_.empty()) {
+                        writing_ = false;
+                        break;
+                    }
+                    batch.swap(out_queue_);
+                }
+                write_batch(batch);
+                batch.clear();
+            }
+            out_cv_.notify_all();
+        }
+
+        void write_batch(std::deque<out_frame>& batch) {
+            std::vector<iovec> iov;
+            iov.reserve(std::min<size_t>(batch.size() * 2, IOV_MAX));
+            auto add = [&iov](const char* data, size_t size) {
+                if (size > 0) iov.push_back(iovec{const_cast<char*>(data), size});
+            };
+
+            auto it = batch.begin();
+            while (it != batch.end()) {
+                iov.clear();
+                for (; it != batch.end() && iov.size() + 2 <= IOV_MAX; ++it) {
+                    add(it->header.data(), it->header_size);
+                    add(it->body->data(), it->body->size());
+                }
+                if (!writev_all(iov)) return;
+            }
+        }
+
+        bool writev_all(std::vector<iovec>& iov) {
+            size_t first = 0;
+            while (first < iov.size()) {
+                ssize_t n = ::writev(options_.output_fd, iov.data() + first,
+                                     static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX)));
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                        pollfd p{options_.output_fd, POLLOUT, 0};
+                        ::poll(&p, 1, 100);
+                        continue;
+                    }
+                    emit_error(std::string("Failed to send message: ") + std::strerror(errno));
+                    return false;
+                }
+                count_sent(static_cast<size_t>(n));
+                // Skip fully written vectors, trim a partially written one
+                auto left = static_cast<size_t>(n);
+                while (first < iov.size() && left >= iov[first].iov_len) {
+                    left -= iov[first].iov_len;
+                    ++first;
+                }
+                if (first < iov.size() && left > 0) {
+                    iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + left;
+                    iov[first].iov_len -= left;
+                }
+            }
+            return true;
+        }
+
+        // --- Input ---
+
+        void read_loop() {
+            while (running_) {
+                pollfd p{options_.input_fd, POLLIN, 0};
+                int ready = ::poll(&p, 1, 100); // bounded so close() is noticed
+                if (ready == 0) continue;
+                if (ready < 0) {
+                    if (errno == EINTR) continue;
+                    emit_error(std::string("Read error: ") + std::strerror(errno));
+                    break;
+                }
+
+                // Size the read for the frame in progress, so a large payload
+                // arrives in as few reads and buffer moves as possible
+                size_t want = std::max(options_.read_chunk, pending_need_);
+                char* dst = in_.prepare(want);
+                ssize_t n = ::read(options_.input_fd, dst, in_.writable());
+                if (n == 0) break; // EOF
+                if (n < 0) {
+                    if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+                    emit_error(std::string("Read error: ") + std::strerror(errno));
+                    break;
+                }
+                in_.commit(static_cast<size_t>(n));
+                drain();
+            }
+            running_ = false;
+            emit_close();
+        }
+
+        // Dispatch every complete message in the buffer
+        void drain() {
+            if (discard_remaining_ > 0) {
+                size_t n = std::min(discard_remaining_, in_.size());
+                in_.consume(n);
+                discard_remaining_ -= n;
+                if (discard_remaining_ > 0) return;
+            }
+            while (true) {
+                skip_separators();
+                if (in_.size() == 0) return;
+                bool more = uses_header(*in_.data()) ? take_framed() : take_line();
+                if (!more) return;
+            }
+        }
+
+        void skip_separators() {
+            size_t n = 0;
+            const char* p = in_.data();
+            while (n < in_.size() && (p[n] == '\n' || p[n] == '\r' || p[n] == ' ' || p[n] == '\t')) ++n;
+            if (n) {
+                in_.consume(n);
+                scan_from_ = scan_from_ > n ? scan_from_ - n : 0;
+            }
+        }
+
+        bool uses_header(char first) const {
+            switch (options_.framing) {
+                case StdioFraming::newline: return false;
+                case StdioFraming::content_length: return true;
+                default: return first == 'C' || first == 'c'; // JSON never starts with a letter C
+            }
+        }
+
+        bool take_line() {
+            const char* p = in_.data();
+            const size_t len = in_.size();
+            const void* nl = std::memchr(p + scan_from_, '\n', len - scan_from_);
+            if (!nl) {
+                scan_from_ = len; // never rescan bytes already searched
+                if (len > options_.max_message_bytes) {
+                    emit_error("Message exceeds maximum size");
+                    in_.clear();
+                    scan_from_ = 0;
+                }
+                return false;
+            }
+            size_t end = static_cast<size_t>(static_cast<const char*>(nl) - p);
+            size_t stop = end;
+            if (stop > 0 && p[stop - 1] == '\r') --stop;
+            parse_and_emit(p, stop);
+            in_.consume(end + 1);
+            scan_from_ = 0;
+            return true;
+        }
+
+        bool take_framed() {
+            const char* p = in_.data();
+            const size_t len = in_.size();
+            std::string_view view(p, len);
+            size_t header_end = view.find("\r\n\r\n");
+            if (header_end == std::string_view::npos) {
+                if (len > 8192) { // no sane header is this long
+                    emit_error("Malformed Content-Length header");
+                    in_.clear();
+                }
+                return false;
+            }
+
+            auto length = content_length(view.substr(0, header_end));
+            size_t body_start = header_end + 4;
+            if (!length) {
+                emit_error("Missing Content-Length header");
+                in_.consume(body_start);
+                return true;
+            }
+            if (*length > options_.max_message_bytes) {
+                // Skip the body, including the part still to arrive, so it is never read as headers
+                emit_error("Message exceeds maximum size");
+                if (len - body_start >= *length) {
+                    in_.consume(body_start + *length);
+                    scan_from_ = 0;
+                    return true;
+                }
+                discard_remaining_ = *length - (len - body_start);
+                in_.clear();
+                scan_from_ = 0;
+                return false;
+            }
+            if (len - body_start < *length) {
+                pending_need_ = body_start + *length - len;
+                return false;
+            }
+            pending_need_ = 0;
+            if (options_.framing == StdioFraming::detect) reply_framed_.store(true, std::memory_order_relaxed);
+            parse_and_emit(p + body_start, *length);
+            in_.consume(body_start + *length);
+            scan_from_ = 0;
+            return true;
+        }
+
+        static std::optional<size_t> content_length(std::string_view headers) {
+            constexpr std::string_view name = "content-length:";
+            while (!headers.empty()) {
+                size_t eol = headers.find("\r\n");
+                std::string_view line = headers.substr(0, eol);
+                if (line.size() > name.size() &&
+                    std::equal(name.begin(), name.end(), line.begin(),
+                               [](char a, char b) { return a == std::tolower(static_cast<unsigned char>(b)); })) {
+                    auto digits = line.substr(name.size());
+                    while (!digits.empty() && digits.front() == ' ') digits.remove_prefix(1);
+                    size_t value = 0;
+                    auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), value);
+                    if (ec == std::errc{} && ptr != digits.data()) return value;
+                    return std::nullopt;
+                }
+                if (eol == std::string_view::npos) break;
+                headers.remove_prefix(eol + 2);
+            }
+            return std::nullopt;
+        }
+
+        void parse_and_emit(const char* first, size_t length) {
+            emit_text(std::string_view(first, length)); // straight from the buffer
+        }
+
+        FastStdioOptions options_;
+        std::atomic<bool> running_;
+        std::atomic<bool> reply_framed_;
+        std::atomic<bool> fds_closed_{false};
+        std::thread read_thread_;
+
+        detail::frame_buffer in_;
+        size_t scan_from_ = 0;    // newline search resumes here
+        size_t pending_need_ = 0; // bytes still missing from the current framed payload
+        size_t discard_remaining_ = 0; // bytes of an oversized framed payload still to be dropped
+
+        std::mutex out_mutex_;
+        std::condition_variable out_cv_;
+        std::deque<out_frame> out_queue_;
+        bool writing_ = false;
+    };
+
+} // namespace pooriayousefi::mcp::transport
@@ -1,15 +1,19 @@
 #pragma once
 
 #include "../jsonrpc/jsonrpc.hpp"
+#include "codec.hpp"
+#include "../core/mpscring.hpp"
+#include "../core/objectpool.hpp"
+#include "../core/metrics.hpp"
 #include <functional>
 #include <memory>
 #include <string>
 #include <iostream>
-#include <queue>
 #include <mutex>
 #include <thread>
 #include <condition_variable>
 #include <atomic>
+#include <deque>
 
 /**
  * @file transport.hpp
@@ -18,7 +22,7 @@
  * Provides base Transport interface and implementations for:
  * - Standard I/O (stdio) - for command-line tools and subprocess communication
  * - HTTP/SSE - for web-based clients and servers
- * - WebSocket - for bidirectional streaming (future)
+ * - WebSocket - for bidirectional streaming (websocket.hpp)
  */
 
 namespace pooriayousefi::mcp::transport 
@@ -31,9 +35,10 @@ namespace pooriayousefi::mcp::transport
     class Transport 
     {
     public:
-        using MessageHandler = std::function<void(const json&)>;
+        using MessageHandler = std::function<void(json&&)>; // handlers may take const json& or json
         using ErrorHandler = std::function<void(const std::string&)>;
         using CloseHandler = std::function<void()>;
+        using MessageFilter = std::function<bool(const jsonrpc::envelope&)>;
 
         virtual ~Transport() = default;
 
@@ -43,6 +48,60 @@ namespace pooriayousefi::mcp::transport
          */
         virtual void send(const json& message) = 0;
 
+        /**
+         * @brief Send a JSON-RPC message the caller no longer needs
+         *
+         * Transports that queue messages override this to take ownership
+         * instead of copying. The default forwards to send(const json&).
+         */
+        virtual void send(json&& message) {
+            send(static_cast<const json&>(message));
+        }
+
+        /**
+         * @brief Whether messages may carry pre-encoded results (jsonrpc::encoded)
+         *
+         * True for transports that serialize with jsonrpc::dump_into, which writes
+         * encoded bytes verbatim. Transports that hand json trees to a peer keep
+         * the default and are only ever given ordinary messages.
+         */
+        virtual bool accepts_encoded() const { return false; }
+
+        /**
+         * @brief Whether this transport can carry messages in encoding
+         *
+         * JSON always; CBOR and MessagePack only where frames are binary-safe
+         * (length-prefixed stdio, WebSocket) or messages stay trees (in-memory).
+         */
+        virtual bool supports_encoding(Encoding encoding) const { return encoding == Encoding::json; }
+
+        /**
+         * @brief Send in encoding from now on, and decode binary input as it
+         * @throws std::invalid_argument if the transport cannot carry it
+         *
+         * JSON input is still accepted. Server and Client switch after
+         * negotiating it in `initialize`; see ClientCapabilities::encodings.
+         */
+        void set_encoding(Encoding encoding) {
+            accept_encoding(encoding);
+            encoding_.store(encoding, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Decode binary input as encoding, without changing what is sent
+         */
+        void accept_encoding(Encoding encoding) {
+            if (!supports_encoding(encoding)) {
+                throw std::invalid_argument("Transport does not support encoding " + std::string(encoding_name(encoding)));
+            }
+            decoding_.store(encoding, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Encoding of outgoing messages
+         */
+        Encoding encoding() const { return encoding_.load(std::memory_order_relaxed); }
+
         /**
          * @brief Start receiving messages (non-blocking)
          */
@@ -65,6 +124,17 @@ namespace pooriayousefi::mcp::transport
             message_handler_ = std::move(handler); 
         }
 
+        /**
+         * @brief Set a check run on each incoming message's envelope before it is parsed
+         *
+         * Messages the filter rejects are dropped without building a json tree.
+         * Transports that receive text (stdio, fast stdio, WebSocket) apply it; batches and
+         * messages the scanner cannot read are always parsed and delivered.
+         */
+        void set_message_filter(MessageFilter filter) {
+            message_filter_ = std::move(filter);
+        }
+
         /**
          * @brief Set handler for transport errors
          */
@@ -79,13 +149,82 @@ namespace pooriayousefi::mcp::transport
             close_handler_ = std::move(handler); 
         }
 
+        /**
+         * @brief Record this transport's traffic in metrics, labelled transport="name"
+         * @param metrics Registry to record into (null stops recording)
+         * @param name Label value telling this transport apart from others
+         *
+         * Counts messages received and payload bytes in and out, and runs parse spans.
+         * Transports with queues add gauges for them (queue depth, SSE backlog).
+         * Call before start().
+         */
+        virtual void set_metrics(std::shared_ptr<core::Metrics> metrics, const std::string& name) {
+            metrics_ = std::move(metrics);
+            metrics_name_ = name;
+            received_messages_ = metrics_ ? &metrics_->counter("mcp_transport_received_messages_total", "Messages received", "transport", name) : nullptr;
+            received_bytes_ = metrics_ ? &metrics_->counter("mcp_transport_received_bytes_total", "Payload bytes received", "transport", name) : nullptr;
+            sent_bytes_ = metrics_ ? &metrics_->counter("mcp_transport_sent_bytes_total", "Payload bytes written", "transport", name) : nullptr;
+        }
+
     protected:
         MessageHandler message_handler_;
         ErrorHandler error_handler_;
         CloseHandler close_handler_;
+        MessageFilter message_filter_;
+        std::atomic<Encoding> encoding_{Encoding::json};
+        std::atomic<Encoding> decoding_{Encoding::json};
+        std::shared_ptr<core::Metrics> metrics_;
+        std::string metrics_name_;
+        core::Counter* received_messages_ = nullptr;
+        core::Counter* received_bytes_ = nullptr;
+        core::Counter* sent_bytes_ = nullptr;
+
+        void count_received(size_t bytes) {
+            if (received_bytes_) received_bytes_->add(bytes);
+        }
+
+        void count_sent(size_t bytes) {
+            if (sent_bytes_) sent_bytes_->add(bytes);
+        }
+
+        // False when the filter rejects the message in text, which then needs no parse
+        bool admit(std::string_view text) const {
+            if (!message_filter_) return true;
+            auto envelope = jsonrpc::scan_envelope(text);
+            return !envelope || message_filter_(*envelope);
+        }
+
+        // Filters, parses and delivers one message received as text (or, once a binary
+        // encoding is accepted, as CBOR/MessagePack); parse errors go to the error handler
+        void emit_text(std::string_view text) {
+            if (text.empty()) return;
+            count_received(text.size());
+            const Encoding decoding = decoding_.load(std::memory_order_relaxed);
+            const bool binary = decoding != Encoding::json && !looks_like_json(text);
+            if (!binary && !admit(text)) return;
+            json msg;
+            {
+                core::Span span(metrics_.get(), core::SpanKind::parse, metrics_name_);
+                try {
+                    msg = binary ? decode_message(text, decoding) : json::parse(text);
+                } catch (const json::exception& e) {
+                    span.fail();
+                    emit_error(std::string(binary ? "Decode error: " : "JSON parse error: ") + e.what());
+                    return;
+                }
+            }
+            emit_message(std::move(msg));
+        }
+
+        // Hands the parsed message to the handler, which may move from it
+        void emit_message(json&& msg) {
+            if (received_messages_) received_messages_->add();
+            if (message_handler_) message_handler_(std::move(msg));
+        }
 
         void emit_message(const json& msg) {
-            if (message_handler_) message_handler_(msg);
+            if (received_messages_) received_messages_->add();
+            if (message_handler_) message_handler_(json(msg));
         }
 
         void emit_error(const std::string& error) {
@@ -108,10 +247,18 @@ namespace pooriayousefi::mcp::transport
     public:
         StdioTransport() : running_(false) {}
 
+        using Transport::send;
+
+        bool accepts_encoded() const override { return true; }
+
         void send(const json& message) override {
             std::lock_guard<std::mutex> lock(write_mutex_);
             try {
-                std::cout << message.dump() << "\n" << std::flush;
+                auto line = core::ObjectPool<std::string>::acquire();
+                jsonrpc::dump_into(message, *line);
+                line->push_back('\n');
+                std::cout.write(line->data(), static_cast<std::streamsize>(line->size())).flush();
+                count_sent(line->size());
             } catch (const std::exception& e) {
                 emit_error(std::string("Failed to send message: ") + e.what());
             }
@@ -126,13 +273,7 @@ namespace pooriayousefi::mcp::transport
                 std::string line;
                 while (running_ && std::getline(std::cin, line)) {
                     if (line.empty()) continue;
-                    
-                    try {
-                        json msg = json::parse(line);
-                        emit_message(msg);
-                    } catch (const json::exception& e) {
-                        emit_error(std::string("JSON parse error: ") + e.what());
-                    }
+                    emit_text(line);
                 }
                 running_ = false;
                 emit_close();
@@ -166,11 +307,23 @@ namespace pooriayousefi::mcp::transport
      * 
      * Allows direct message passing without network/stdio overhead.
      * Useful for unit tests and local client-server pairs.
+     *
+     * Each transport owns a bounded lock-free ring that any number of peers'
+     * threads push into and its own thread drains. Sending an rvalue moves the
+     * message into the ring, so nothing is copied. An idle receiver spins
+     * briefly before parking, so bursts are handed over without a wake-up.
+     *
+     * send() never blocks: when the ring is full, messages wait in an unbounded
+     * overflow list until the receiver has emptied the ring. Both ends often
+     * send from their receive threads, so waiting for room could deadlock.
      */
     class InMemoryTransport : public Transport, public std::enable_shared_from_this<InMemoryTransport>
     {
     public:
-        InMemoryTransport() : running_(false) {}
+        /**
+         * @param capacity Messages queued in the ring before the overflow list is used (rounded up to a power of two)
+         */
+        explicit InMemoryTransport(size_t capacity = 1024) : running_(false), queue_(capacity) {}
 
         /**
          * @brief Connect two in-memory transports as peers
@@ -182,24 +335,27 @@ namespace pooriayousefi::mcp::transport
             }
         }
 
-        void send(const json& message) override {
-            if (!running_) {
-                emit_error("Transport not started");
-                return;
-            }
+        // Messages are handed over as trees, so binary values need no encoding
+        bool supports_encoding(Encoding) const override { return true; }
 
-            auto peer = peer_.lock();
-            if (!peer) {
-                emit_error("No peer connected");
-                return;
-            }
+        /**
+         * @brief As Transport::set_metrics, plus mcp_transport_queue_depth for this transport's ring
+         */
+        void set_metrics(std::shared_ptr<core::Metrics> metrics, const std::string& name) override {
+            queue_gauge_.reset();
+            Transport::set_metrics(std::move(metrics), name);
+            if (!metrics_) return;
+            queue_gauge_ = metrics_->observe("mcp_transport_queue_depth", "Messages waiting to be delivered", "transport", name,
+                [this] { return static_cast<double>(queue_.size() + overflow_size_.load(std::memory_order_relaxed)); });
+        }
 
-            // Deliver message to peer's queue
-            {
-                std::lock_guard<std::mutex> lock(peer->queue_mutex_);
-                peer->message_queue_.push(message);
-            }
-            peer->queue_cv_.notify_one();
+        void send(const json& message) override {
+            json copy = message;
+            deliver(copy);
+        }
+
+        void send(json&& message) override {
+            deliver(message);
         }
 
         void start() override {
@@ -208,22 +364,30 @@ namespace pooriayousefi::mcp::transport
 
             // Start message processing thread
             process_thread_ = std::thread([this]() {
+                json msg;
+                std::deque<json> spilled;
                 while (running_) {
-                    json msg;
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex_);
-                        queue_cv_.wait(lock, [this]() { 
-                            return !message_queue_.empty() || !running_; 
-                        });
-                        
-                        if (!running_) break;
-                        if (message_queue_.empty()) continue;
-
-                        msg = message_queue_.front();
-                        message_queue_.pop();
+                    if (queue_.try_pop(msg)) {
+                        emit_message(std::move(msg));
+                        continue;
                     }
-
-                    emit_message(msg);
+                    // The ring is empty, so everything still queued went to the overflow list
+                    if (overflow_size_.load(std::memory_order_acquire) > 0) {
+                        {
+                            std::lock_guard<std::mutex> lock(overflow_mutex_);
+                            spilled.swap(overflow_);
+                            overflow_size_.store(0, std::memory_order_release);
+                        }
+                        while (!spilled.empty() && running_) {
+                            emit_message(std::move(spilled.front()));
+                            spilled.pop_front();
+                        }
+                        spilled.clear();
+                        continue;
+                    }
+                    core::spin_then_park(arrivals_, [this]() {
+                        return !queue_.empty() || overflow_size_.load(std::memory_order_acquire) > 0 || !running_;
+                    });
                 }
             });
         }
@@ -231,7 +395,7 @@ namespace pooriayousefi::mcp::transport
         void close() override {
             if (!running_) return;
             running_ = false;
-            queue_cv_.notify_all();
+            arrivals_.notify_all();
             if (process_thread_.joinable()) {
                 process_thread_.join();
             }
@@ -247,22 +411,48 @@ namespace pooriayousefi::mcp::transport
         }
 
     private:
+        // Moves from message once the peer's ring accepts it
+        void deliver(json& message) {
+            if (!running_) {
+                emit_error("Transport not started");
+                return;
+            }
+
+            auto peer = peer_.lock();
+            if (!peer) {
+                emit_error("No peer connected");
+                return;
+            }
+
+            // Once anything has spilled, later messages follow it so each sender's order holds
+            if (peer->overflow_size_.load(std::memory_order_acquire) > 0 || !peer->queue_.try_push(message)) {
+                std::lock_guard<std::mutex> lock(peer->overflow_mutex_);
+                peer->overflow_.push_back(std::move(message));
+                peer->overflow_size_.store(peer->overflow_.size(), std::memory_order_release);
+            }
+            peer->arrivals_.notify_one();
+        }
+
         std::atomic<bool> running_;
         std::weak_ptr<InMemoryTransport> peer_;
-        std::queue<json> message_queue_;
-        std::mutex queue_mutex_;
-        std::condition_variable queue_cv_;
+        core::MpscRing<json> queue_;
+        core::EventCount arrivals_;  // receiver parks here when the ring and overflow list are empty
+        std::deque<json> overflow_;  // messages that found the ring full, in arrival order
+        std::atomic<size_t> overflow_size_{0};
+        std::mutex overflow_mutex_;
         std::thread process_thread_;
+        core::Observation queue_gauge_;
     };
 
     /**
      * @brief Create a pair of connected in-memory transports
+     * @param capacity Per-direction queue capacity in messages
      * @return std::pair of connected transports (client, server)
      */
     inline std::pair<std::shared_ptr<InMemoryTransport>, std::shared_ptr<InMemoryTransport>>
-    create_in_memory_pair() {
-        auto client = std::make_shared<InMemoryTransport>();
-        auto server = std::make_shared<InMemoryTransport>();
+    create_in_memory_pair(size_t capacity = 1024) {
+        auto client = std::make_shared<InMemoryTransport>(capacity);
+        auto server = std::make_shared<InMemoryTransport>(capacity);
         client->connect_peer(server);
         return {client, server};
     }
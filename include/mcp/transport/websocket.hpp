@@ -0,0 +1,1073 @@
+#pragma once
+
+#include "transport.hpp"
+#include "../core/base64.hpp"
+#include "../core/deflate.hpp"
+#include "../core/objectpool.hpp"
+#include <string>
+#include <string_view>
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <optional>
+#include <functional>
+#include <stdexcept>
+#include <algorithm>
+#include <charconv>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/**
+ * @file websocket.hpp
+ * @brief WebSocket (RFC 6455) transports
+ *
+ * One persistent, full-duplex socket carries requests, responses, progress
+ * and notifications in both directions, with no per-message HTTP exchange:
+ * - WebSocketClientTransport connects to ws://host:port/path
+ * - WebSocketServerTransport listens and serves one peer at a time, like a
+ *   stdio transport; further upgrade requests are refused with 503 while a
+ *   session is open
+ * - Messages go out as text frames, or binary frames (WebSocketFrames);
+ *   either kind is accepted on input
+ * - CBOR and MessagePack (codec.hpp) travel in binary frames once negotiated
+ * - permessage-deflate (RFC 7692) is negotiated when the build has zlib
+ *   (see core/deflate.hpp); small messages are sent uncompressed
+ * - Idle connections are pinged, and closed when a ping goes unanswered
+ *
+ * wss:// (TLS) is not supported; terminate TLS in front of the server.
+ */
+
+namespace pooriayousefi::mcp::transport
+{
+    /**
+     * @brief Frame type used for outgoing messages
+     */
+    enum class WebSocketFrames {
+        text,
+        binary
+    };
+
+    /**
+     * @brief Settings shared by the WebSocket transports
+     */
+    struct WebSocketOptions {
+        WebSocketFrames frames = WebSocketFrames::text;
+        bool compression = true;            ///< Negotiate permessage-deflate when zlib is available
+        int compression_level = 6;
+        size_t compression_threshold = 256; ///< Smaller messages are sent uncompressed
+        std::chrono::milliseconds ping_interval{30000}; ///< Ping after this long without traffic (0 = never)
+        std::chrono::milliseconds pong_timeout{10000};  ///< Close when a ping goes unanswered this long
+        std::chrono::milliseconds handshake_timeout{5000};
+        size_t max_message_bytes = 64u << 20; ///< Larger messages close the connection (1009)
+    };
+
+    enum class WebSocketRole {
+        client,
+        server
+    };
+
+    namespace detail {
+
+        inline std::array<uint8_t, 20> sha1(std::string_view data) {
+            uint32_t h[5] = {0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u};
+            std::string message(data);
+            message.push_back('\x80');
+            while (message.size() % 64 != 56) message.push_back('\0');
+            const uint64_t bits = uint64_t(data.size()) * 8;
+            for (int i = 7; i >= 0; --i) message.push_back(char(bits >> (i * 8)));
+
+            for (size_t offset = 0; offset < message.size(); offset += 64) {
+                uint32_t w[80];
+                for (int i = 0; i < 16; ++i) {
+                    const auto* p = reinterpret_cast<const uint8_t*>(message.data() + offset + 4 * i);
+                    w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+                }
+                for (int i = 16; i < 80; ++i) w[i] = std::rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+                uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                for (int i = 0; i < 80; ++i) {
+                    uint32_t f, k;
+                    if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999u; }
+                    else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1u; }
+                    else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDCu; }
+                    else { f = b ^ c ^ d; k = 0xCA62C1D6u; }
+                    const uint32_t t = std::rotl(a, 5) + f + e + k + w[i];
+                    e = d; d = c; c = std::rotl(b, 30); b = a; a = t;
+                }
+                h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+            }
+            std::array<uint8_t, 20> digest;
+            for (int i = 0; i < 20; ++i) digest[i] = uint8_t(h[i / 4] >> (24 - 8 * (i % 4)));
+            return digest;
+        }
+
+        // Sec-WebSocket-Accept for a Sec-WebSocket-Key
+        inline std::string websocket_accept(std::string_view key) {
+            std::string input(key);
+            input.append("258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+            auto digest = sha1(input);
+            return core::base64_encode(std::string_view(reinterpret_cast<const char*>(digest.data()), digest.size()));
+        }
+
+        inline bool iequals(std::string_view a, std::string_view b) {
+            return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+                return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+            });
+        }
+
+        inline std::string_view trim(std::string_view s) {
+            while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+            while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+            return s;
+        }
+
+        // Value of a header in an HTTP head (request or status line first)
+        inline std::optional<std::string_view> http_header(std::string_view head, std::string_view name) {
+            size_t line_end = head.find("\r\n");
+            while (line_end != std::string_view::npos) {
+                head.remove_prefix(line_end + 2);
+                line_end = head.find("\r\n");
+                std::string_view line = head.substr(0, line_end);
+                size_t colon = line.find(':');
+                if (colon != std::string_view::npos && iequals(trim(line.substr(0, colon)), name)) {
+                    return trim(line.substr(colon + 1));
+                }
+            }
+            return std::nullopt;
+        }
+
+        // True when a comma-separated header value lists token
+        inline bool header_has_token(std::string_view value, std::string_view token) {
+            while (!value.empty()) {
+                size_t comma = value.find(',');
+                if (iequals(trim(value.substr(0, comma)), token)) return true;
+                if (comma == std::string_view::npos) break;
+                value.remove_prefix(comma + 1);
+            }
+            return false;
+        }
+
+        // Negotiated permessage-deflate parameters (RFC 7692)
+        struct deflate_params {
+            bool server_no_context_takeover = false;
+            bool client_no_context_takeover = false;
+            int server_max_window_bits = 15;
+            int client_max_window_bits = 15;
+
+            // The permessage-deflate entry of a Sec-WebSocket-Extensions value, if any
+            // and if every parameter is one we can honour. When answering an offer,
+            // `offer` is true: a bare client_max_window_bits is allowed there.
+            static std::optional<deflate_params> parse(std::string_view header, bool offer) {
+                while (!header.empty()) {
+                    size_t comma = header.find(',');
+                    std::string_view extension = header.substr(0, comma);
+                    header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+                    size_t semi = extension.find(';');
+                    if (!iequals(trim(extension.substr(0, semi)), "permessage-deflate")) continue;
+                    deflate_params params;
+                    bool usable = true;
+                    while (semi != std::string_view::npos && usable) {
+                        extension.remove_prefix(semi + 1);
+                        semi = extension.find(';');
+                        std::string_view param = trim(extension.substr(0, semi));
+                        size_t eq = param.find('=');
+                        std::string_view name = trim(param.substr(0, eq));
+                        std::string_view value = eq == std::string_view::npos ? std::string_view{} : trim(param.substr(eq + 1));
+                        if (!value.empty() && value.front() == '"' && value.size() >= 2) value = value.substr(1, value.size() - 2);
+                        int bits = 15;
+                        if (!value.empty()) {
+                            auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), bits);
+                            usable = ec == std::errc{} && ptr == value.data() + value.size() && bits >= 8 && bits <= 15;
+                        }
+                        if (iequals(name, "server_no_context_takeover")) params.server_no_context_takeover = true;
+                        else if (iequals(name, "client_no_context_takeover")) params.client_no_context_takeover = true;
+                        // zlib cannot produce raw deflate with an 8-bit window
+                        else if (iequals(name, "server_max_window_bits")) { usable = usable && !value.empty() && bits >= 9; params.server_max_window_bits = bits; }
+                        else if (iequals(name, "client_max_window_bits")) { usable = usable && (offer || (!value.empty() && bits >= 9)); if (!offer) params.client_max_window_bits = bits; }
+                        else usable = false;
+                    }
+                    if (usable) return params;
+                }
+                return std::nullopt;
+            }
+
+            std::string header() const {
+                std::string out = "permessage-deflate";
+                if (server_no_context_takeover) out += "; server_no_context_takeover";
+                if (client_no_context_takeover) out += "; client_no_context_takeover";
+                if (server_max_window_bits < 15) out += "; server_max_window_bits=" + std::to_string(server_max_window_bits);
+                if (client_max_window_bits < 15) out += "; client_max_window_bits=" + std::to_string(client_max_window_bits);
+                return out;
+            }
+        };
+
+        // XOR with the 4-byte mask, 8 bytes at a time; `phase` is the offset into the mask
+        inline void apply_mask(char* data, size_t size, const std::array<uint8_t, 4>& mask) {
+            uint64_t wide;
+            uint8_t pattern[8];
+            for (int i = 0; i < 8; ++i) pattern[i] = mask[i % 4];
+            std::memcpy(&wide, pattern, 8);
+            size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                uint64_t word;
+                std::memcpy(&word, data + i, 8);
+                word ^= wide;
+                std::memcpy(data + i, &word, 8);
+            }
+            for (; i < size; ++i) data[i] = char(uint8_t(data[i]) ^ mask[i % 4]);
+        }
+
+        inline bool write_all(int fd, iovec* parts, int count) {
+            while (count > 0) {
+                msghdr msg{};
+                msg.msg_iov = parts;
+                msg.msg_iovlen = static_cast<size_t>(count);
+                ssize_t n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                size_t written = static_cast<size_t>(n);
+                while (count > 0 && written >= parts->iov_len) {
+                    written -= parts->iov_len;
+                    ++parts;
+                    --count;
+                }
+                if (count > 0) {
+                    parts->iov_base = static_cast<char*>(parts->iov_base) + written;
+                    parts->iov_len -= written;
+                }
+            }
+            return true;
+        }
+
+        // Reads an HTTP head into buffer (which then also holds any bytes after it);
+        // returns the head length including the blank line, or 0 on timeout, close or overflow
+        inline size_t read_http_head(int fd, std::string& buffer, std::chrono::milliseconds timeout) {
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            char chunk[4096];
+            while (true) {
+                size_t end = buffer.find("\r\n\r\n");
+                if (end != std::string::npos) return end + 4;
+                if (buffer.size() > 16384) return 0;
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+                if (left.count() <= 0) return 0;
+                pollfd p{fd, POLLIN, 0};
+                int r = ::poll(&p, 1, static_cast<int>(left.count()));
+                if (r < 0 && errno == EINTR) continue;
+                if (r <= 0) return 0;
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) return 0;
+                buffer.append(chunk, static_cast<size_t>(n));
+            }
+        }
+
+        inline void send_http(int fd, const std::string& text) {
+            iovec part{const_cast<char*>(text.data()), text.size()};
+            write_all(fd, &part, 1);
+        }
+    }
+
+    /**
+     * @brief One established WebSocket connection
+     *
+     * Owns the socket after the handshake. A reader thread assembles
+     * messages and answers pings; send() may be called from any thread.
+     * The transports below wrap it; it is usable on its own for tests and
+     * custom listeners.
+     */
+    class WebSocketConnection {
+    public:
+        using MessageFn = std::function<void(std::string_view payload)>;
+        using CloseFn = std::function<void(const std::string& error)>; ///< Empty error: closed cleanly
+
+        /**
+         * @param fd Connected socket, already upgraded
+         * @param role Which end of the connection this is (clients mask their frames)
+         * @param options Frame type, compression threshold, limits and ping timing
+         * @param deflate Negotiated permessage-deflate parameters, if any
+         * @param buffered Bytes read past the handshake
+         */
+        WebSocketConnection(int fd, WebSocketRole role, WebSocketOptions options,
+                            std::optional<detail::deflate_params> deflate, std::string buffered = {})
+            : fd_(fd)
+            , role_(role)
+            , options_(options)
+            , deflate_(deflate)
+            , in_(std::move(buffered))
+            , open_(true)
+            , rng_(std::random_device{}())
+        {
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+            if (deflate_) {
+                const bool client = role_ == WebSocketRole::client;
+                deflater_ = std::make_unique<core::Deflater>(core::DeflateFormat::raw, options_.compression_level,
+                    client ? deflate_->client_max_window_bits : deflate_->server_max_window_bits);
+                inflater_ = std::make_unique<core::Inflater>(core::DeflateFormat::raw, 15);
+            }
+#endif
+        }
+
+        WebSocketConnection(const WebSocketConnection&) = delete;
+        WebSocketConnection& operator=(const WebSocketConnection&) = delete;
+
+        ~WebSocketConnection() {
+            close();
+            if (reader_.joinable()) {
+                if (reader_.get_id() == std::this_thread::get_id()) reader_.detach();
+                else reader_.join();
+            }
+            if (fd_ >= 0) ::close(fd_);
+        }
+
+        /**
+         * @brief Start the reader thread
+         */
+        void start(MessageFn on_message, CloseFn on_close) {
+            on_message_ = std::move(on_message);
+            on_close_ = std::move(on_close);
+            reader_ = std::thread([this] { read_loop(); });
+        }
+
+        /**
+         * @brief Send one data message
+         * @return false when the connection is closed or the write failed
+         */
+        bool send(std::string_view payload) {
+            return send(payload, options_.frames);
+        }
+
+        /**
+         * @brief Send one data message as a text or binary frame
+         */
+        bool send(std::string_view payload, WebSocketFrames frames) {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            if (!open_ || close_sent_) return false;
+            const uint8_t opcode = frames == WebSocketFrames::binary ? 0x2 : 0x1;
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+            if (deflater_ && payload.size() >= options_.compression_threshold) {
+                auto packed = core::ObjectPool<std::string>::acquire();
+                deflater_->compress(payload, *packed, core::DeflateFlush::sync);
+                if (packed->size() >= 4) packed->resize(packed->size() - 4); // drop the 00 00 ff ff sync marker
+                const bool reset = role_ == WebSocketRole::client ? deflate_->client_no_context_takeover : deflate_->server_no_context_takeover;
+                if (reset) deflater_->reset();
+                return write_frame(opcode, *packed, true, packed.get());
+            }
+#endif
+            return write_frame(opcode, payload, false, nullptr);
+        }
+
+        /**
+         * @brief Send a ping now (the reader also pings idle connections)
+         */
+        bool ping() {
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            if (!open_ || close_sent_) return false;
+            return write_frame(0x9, {}, false, nullptr);
+        }
+
+        /**
+         * @brief Start the closing handshake and wait (briefly) for the reader to finish
+         */
+        void close(uint16_t code = 1000) {
+            {
+                std::lock_guard<std::mutex> lock(send_mutex_);
+                if (open_ && !close_sent_) {
+                    const char body[2] = {char(code >> 8), char(code & 0xff)};
+                    write_frame(0x8, std::string_view(body, 2), false, nullptr);
+                    close_sent_ = true;
+                }
+            }
+            if (!reader_.joinable() || reader_.get_id() == std::this_thread::get_id()) return;
+            std::unique_lock<std::mutex> lock(state_mutex_);
+            if (!finished_cv_.wait_for(lock, std::chrono::seconds(1), [this] { return finished_; })) {
+                ::shutdown(fd_, SHUT_RDWR); // the peer never answered; unblock the reader
+            }
+            lock.unlock();
+            reader_.join();
+        }
+
+        bool is_open() const { return open_; }
+
+        /**
+         * @brief Whether permessage-deflate was negotiated
+         */
+        bool compressed() const { return deflate_.has_value(); }
+
+        /**
+         * @brief Pings sent and pongs received (health counters)
+         */
+        size_t pings_sent() const { return pings_sent_.load(); }
+        size_t pongs_received() const { return pongs_received_.load(); }
+
+    private:
+        using clock = std::chrono::steady_clock;
+
+        // Caller holds send_mutex_. scratch, when given, is a mutable copy of payload
+        // (the compressed form) that may be masked in place.
+        bool write_frame(uint8_t opcode, std::string_view payload, bool rsv1, std::string* scratch) {
+            std::array<char, 14> header;
+            size_t n = 0;
+            header[n++] = char(0x80 | (rsv1 ? 0x40 : 0) | opcode);
+            const bool mask = role_ == WebSocketRole::client;
+            const char mask_bit = mask ? char(0x80) : 0;
+            if (payload.size() < 126) {
+                header[n++] = char(mask_bit | char(payload.size()));
+            } else if (payload.size() <= 0xffff) {
+                header[n++] = char(mask_bit | 126);
+                header[n++] = char(payload.size() >> 8);
+                header[n++] = char(payload.size() & 0xff);
+            } else {
+                header[n++] = char(mask_bit | 127);
+                for (int i = 7; i >= 0; --i) header[n++] = char(uint64_t(payload.size()) >> (8 * i));
+            }
+
+            core::Pooled<std::string> masked;
+            if (mask) {
+                std::array<uint8_t, 4> key;
+                const uint32_t random = rng_();
+                std::memcpy(key.data(), &random, 4);
+                std::memcpy(header.data() + n, key.data(), 4);
+                n += 4;
+                if (!scratch) {
+                    masked = core::ObjectPool<std::string>::acquire();
+                    masked->assign(payload);
+                    scratch = masked.get();
+                }
+                detail::apply_mask(scratch->data(), scratch->size(), key);
+                payload = *scratch;
+            }
+
+            iovec parts[2] = {
+                {header.data(), n},
+                {const_cast<char*>(payload.data()), payload.size()}
+            };
+            if (!detail::write_all(fd_, parts, payload.empty() ? 1 : 2)) {
+                ::shutdown(fd_, SHUT_RDWR); // the reader reports the failure
+                return false;
+            }
+            return true;
+        }
+
+        void read_loop() {
+            std::string error;
+            std::array<char, 65536> chunk;
+            auto last_traffic = clock::now();
+            std::optional<clock::time_point> pong_deadline;
+            bool running = process(error);
+            while (running) {
+                int timeout = -1;
+                const auto now = clock::now();
+                if (pong_deadline) {
+                    timeout = static_cast<int>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(*pong_deadline - now).count()));
+                } else if (options_.ping_interval.count() > 0) {
+                    timeout = static_cast<int>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(last_traffic + options_.ping_interval - now).count()));
+                }
+                pollfd p{fd_, POLLIN, 0};
+                int r = ::poll(&p, 1, timeout);
+                if (r < 0) {
+                    if (errno == EINTR) continue;
+                    error = std::string("poll failed: ") + std::strerror(errno);
+                    break;
+                }
+                if (r == 0) {
+                    if (pong_deadline && clock::now() >= *pong_deadline) {
+                        error = "ping timeout";
+                        break;
+                    }
+                    if (!pong_deadline && ping()) {
+                        pings_sent_.fetch_add(1);
+                        pong_deadline = clock::now() + options_.pong_timeout;
+                    }
+                    continue;
+                }
+                ssize_t n = ::recv(fd_, chunk.data(), chunk.size(), 0);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) {
+                    if (!close_sent_ && !close_received_) error = "connection closed without a close frame";
+                    break;
+                }
+                in_.append(chunk.data(), static_cast<size_t>(n));
+                last_traffic = clock::now();
+                pong_deadline.reset(); // any traffic shows the peer is alive
+                running = process(error);
+            }
+
+            open_ = false;
+            ::shutdown(fd_, SHUT_RDWR);
+            {
+                std::lock_guard<std::mutex> lock(state_mutex_);
+                finished_ = true;
+            }
+            finished_cv_.notify_all();
+            if (on_close_) on_close_(error);
+        }
+
+        // Handles every complete frame in in_. False once the connection should end.
+        bool process(std::string& error) {
+            size_t offset = 0;
+            bool keep_going = true;
+            while (keep_going) {
+                const size_t available = in_.size() - offset;
+                if (available < 2) break;
+                const auto* p = reinterpret_cast<const uint8_t*>(in_.data() + offset);
+                const bool fin = p[0] & 0x80;
+                const bool rsv1 = p[0] & 0x40;
+                const uint8_t opcode = p[0] & 0x0f;
+                const bool masked = p[1] & 0x80;
+                uint64_t length = p[1] & 0x7f;
+                size_t header = 2;
+                if (length == 126) {
+                    if (available < 4) break;
+                    length = (uint64_t(p[2]) << 8) | p[3];
+                    header = 4;
+                } else if (length == 127) {
+                    if (available < 10) break;
+                    length = 0;
+                    for (int i = 0; i < 8; ++i) length = (length << 8) | p[2 + i];
+                    header = 10;
+                }
+                if ((p[0] & 0x30) || (rsv1 && (!deflate_ || opcode == 0x0 || opcode >= 0x8))) {
+                    return fail(1002, "reserved bits set", error);
+                }
+                if (masked != (role_ == WebSocketRole::server)) {
+                    return fail(1002, role_ == WebSocketRole::server ? "unmasked client frame" : "masked server frame", error);
+                }
+                if (opcode >= 0x8 && (!fin || length > 125)) return fail(1002, "invalid control frame", error);
+                if (length > options_.max_message_bytes || message_.size() + length > options_.max_message_bytes) {
+                    return fail(1009, "message too large", error);
+                }
+                std::array<uint8_t, 4> key{};
+                if (masked) {
+                    if (available < header + 4) break;
+                    std::memcpy(key.data(), p + header, 4);
+                    header += 4;
+                }
+                if (available < header + length) break;
+                char* payload = in_.data() + offset + header;
+                if (masked) detail::apply_mask(payload, static_cast<size_t>(length), key);
+                const std::string_view data(payload, static_cast<size_t>(length));
+                offset += header + static_cast<size_t>(length);
+
+                switch (opcode) {
+                    case 0x1:
+                    case 0x2:
+                        if (in_message_) return fail(1002, "new message inside a fragmented one", error);
+                        message_compressed_ = rsv1;
+                        if (fin) {
+                            keep_going = deliver(data, error);
+                        } else {
+                            message_.assign(data);
+                            in_message_ = true;
+                        }
+                        break;
+                    case 0x0:
+                        if (!in_message_) return fail(1002, "continuation without a message", error);
+                        message_.append(data);
+                        if (fin) {
+                            in_message_ = false;
+                            std::string whole = std::move(message_);
+                            message_.clear();
+                            keep_going = deliver(whole, error);
+                        }
+                        break;
+                    case 0x8: {
+                        close_received_ = true;
+                        uint16_t code = data.size() >= 2 ? uint16_t((uint8_t(data[0]) << 8) | uint8_t(data[1])) : 1000;
+                        {
+                            std::lock_guard<std::mutex> lock(send_mutex_);
+                            if (!close_sent_) {
+                                const char body[2] = {char(code >> 8), char(code & 0xff)};
+                                write_frame(0x8, std::string_view(body, 2), false, nullptr);
+                                close_sent_ = true;
+                            }
+                        }
+                        if (code != 1000 && code != 1001) error = "closed by peer with code " + std::to_string(code);
+                        keep_going = false;
+                        break;
+                    }
+                    case 0x9: {
+                        std::lock_guard<std::mutex> lock(send_mutex_);
+                        if (open_ && !close_sent_) {
+                            std::string copy(data); // the pong may need masking
+                            write_frame(0xA, copy, false, &copy);
+                        }
+                        break;
+                    }
+                    case 0xA:
+                        pongs_received_.fetch_add(1);
+                        break;
+                    default:
+                        return fail(1002, "unknown opcode", error);
+                }
+            }
+            in_.erase(0, offset);
+            return keep_going;
+        }
+
+        bool deliver(std::string_view data, std::string& error) {
+            if (!message_compressed_) {
+                if (on_message_) on_message_(data);
+                return true;
+            }
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+            auto input = core::ObjectPool<std::string>::acquire();
+            input->assign(data).append("\x00\x00\xff\xff", 4);
+            auto text = core::ObjectPool<std::string>::acquire();
+            try {
+                inflater_->decompress(*input, *text, options_.max_message_bytes);
+            } catch (const std::length_error&) {
+                return fail(1009, "message too large", error);
+            } catch (const std::exception&) {
+                return fail(1007, "corrupt compressed message", error);
+            }
+            const bool reset = role_ == WebSocketRole::client ? deflate_->server_no_context_takeover : deflate_->client_no_context_takeover;
+            if (reset) inflater_->reset();
+            if (on_message_) on_message_(*text);
+            return true;
+#else
+            return fail(1002, "compressed message without permessage-deflate", error);
+#endif
+        }
+
+        bool fail(uint16_t code, const std::string& why, std::string& error) {
+            error = why;
+            std::lock_guard<std::mutex> lock(send_mutex_);
+            if (!close_sent_) {
+                const char body[2] = {char(code >> 8), char(code & 0xff)};
+                write_frame(0x8, std::string_view(body, 2), false, nullptr);
+                close_sent_ = true;
+            }
+            return false;
+        }
+
+        int fd_;
+        WebSocketRole role_;
+        WebSocketOptions options_;
+        std::optional<detail::deflate_params> deflate_;
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+        std::unique_ptr<core::Deflater> deflater_; // guarded by send_mutex_
+        std::unique_ptr<core::Inflater> inflater_; // reader thread only
+#endif
+
+        std::string in_;
+        std::string message_;      // fragments of the message being assembled
+        bool in_message_ = false;
+        bool message_compressed_ = false;
+
+        std::atomic<bool> open_;
+        std::atomic<bool> close_sent_{false};
+        std::atomic<bool> close_received_{false};
+        std::atomic<size_t> pings_sent_{0};
+        std::atomic<size_t> pongs_received_{0};
+        std::mt19937 rng_;         // mask keys; guarded by send_mutex_
+        std::mutex send_mutex_;
+
+        std::thread reader_;
+        MessageFn on_message_;
+        CloseFn on_close_;
+        std::mutex state_mutex_;
+        std::condition_variable finished_cv_;
+        bool finished_ = false;
+    };
+
+    namespace detail {
+        // Binary encodings always travel in binary frames. Returns the payload bytes
+        // sent, or 0 when the connection failed.
+        inline size_t send_message(WebSocketConnection& connection, const json& message, Encoding encoding) {
+            auto bytes = core::ObjectPool<std::string>::acquire();
+            encode_message(message, encoding, *bytes);
+            const bool sent = encoding == Encoding::json ? connection.send(*bytes) : connection.send(*bytes, WebSocketFrames::binary);
+            return sent ? bytes->size() : 0;
+        }
+    }
+
+    /**
+     * @brief WebSocket client transport
+     *
+     * @example
+     * ```cpp
+     * auto transport = std::make_shared<WebSocketClientTransport>("ws://localhost:8765/mcp");
+     * Client client(transport);
+     * transport->start(); // connects; throws if the upgrade fails
+     * ```
+     */
+    class WebSocketClientTransport : public Transport {
+    public:
+        explicit WebSocketClientTransport(std::string url, WebSocketOptions options = {})
+            : url_(std::move(url))
+            , options_(options)
+        {}
+
+        ~WebSocketClientTransport() override {
+            close();
+        }
+
+        using Transport::send;
+
+        bool accepts_encoded() const override { return true; }
+
+        bool supports_encoding(Encoding) const override { return true; }
+
+        void send(const json& message) override {
+            auto connection = current();
+            if (!connection) {
+                emit_error("WebSocket not connected");
+                return;
+            }
+            if (size_t sent = detail::send_message(*connection, message, encoding())) count_sent(sent);
+            else emit_error("WebSocket send failed");
+        }
+
+        /**
+         * @brief Connect and perform the upgrade
+         * @throws std::runtime_error when the server cannot be reached or refuses the upgrade
+         */
+        void start() override {
+            std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+            if (connection_ && connection_->is_open()) return;
+            auto [host, port, path] = parse_url(url_);
+            int fd = connect_to(host, port);
+
+            std::array<uint8_t, 16> nonce;
+            std::random_device random;
+            for (auto& byte : nonce) byte = uint8_t(random());
+            const std::string key = core::base64_encode(std::string_view(reinterpret_cast<const char*>(nonce.data()), nonce.size()));
+
+            std::string request = "GET " + path + " HTTP/1.1\r\n"
+                "Host: " + host + ":" + std::to_string(port) + "\r\n"
+                "Upgrade: websocket\r\n"
+                "Connection: Upgrade\r\n"
+                "Sec-WebSocket-Key: " + key + "\r\n"
+                "Sec-WebSocket-Version: 13\r\n";
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+            if (options_.compression) request += "Sec-WebSocket-Extensions: permessage-deflate; client_max_window_bits\r\n";
+#endif
+            request += "\r\n";
+            detail::send_http(fd, request);
+
+            std::string buffer;
+            size_t head_length = detail::read_http_head(fd, buffer, options_.handshake_timeout);
+            std::string_view head(buffer.data(), head_length);
+            auto accept = detail::http_header(head, "Sec-WebSocket-Accept");
+            if (head_length == 0 || head.substr(0, 12) != "HTTP/1.1 101" || !accept || *accept != detail::websocket_accept(key)) {
+                ::close(fd);
+                std::string status(head.substr(0, head.find("\r\n")));
+                throw std::runtime_error("WebSocket upgrade failed" + (status.empty() ? std::string() : ": " + status));
+            }
+            std::optional<detail::deflate_params> deflate;
+            if (auto extensions = detail::http_header(head, "Sec-WebSocket-Extensions")) {
+                deflate = detail::deflate_params::parse(*extensions, false);
+#ifndef POORIAYOUSEFI_CORE_HAS_ZLIB
+                deflate.reset();
+#endif
+                if (!deflate || !options_.compression) {
+                    ::close(fd);
+                    throw std::runtime_error("WebSocket upgrade failed: unsupported extension");
+                }
+            }
+
+            set_encoding(Encoding::json); // a new session negotiates afresh
+            auto connection = std::make_shared<WebSocketConnection>(fd, WebSocketRole::client, options_, deflate, buffer.substr(head_length));
+            connection->start(
+                [this](std::string_view text) { emit_text(text); },
+                [this](const std::string& error) {
+                    if (!error.empty()) emit_error("WebSocket: " + error);
+                    emit_close();
+                });
+            std::lock_guard<std::mutex> connection_lock(connection_mutex_);
+            connection_ = std::move(connection);
+        }
+
+        void close() override {
+            std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+            std::shared_ptr<WebSocketConnection> connection;
+            {
+                std::lock_guard<std::mutex> connection_lock(connection_mutex_);
+                connection = std::move(connection_);
+            }
+            if (connection) connection->close();
+        }
+
+        bool is_open() const override {
+            auto connection = current();
+            return connection && connection->is_open();
+        }
+
+        /**
+         * @brief The live connection (compression, ping counters), or nullptr
+         */
+        std::shared_ptr<WebSocketConnection> connection() const {
+            return current();
+        }
+
+    private:
+        struct url_parts {
+            std::string host;
+            int port;
+            std::string path;
+        };
+
+        static url_parts parse_url(const std::string& url) {
+            constexpr std::string_view scheme = "ws://";
+            if (url.compare(0, scheme.size(), scheme) != 0) {
+                throw std::invalid_argument("WebSocketClientTransport: only ws:// URLs are supported: " + url);
+            }
+            std::string_view rest = std::string_view(url).substr(scheme.size());
+            size_t slash = rest.find('/');
+            std::string_view authority = rest.substr(0, slash);
+            url_parts parts{std::string(authority), 80, slash == std::string_view::npos ? "/" : std::string(rest.substr(slash))};
+            if (size_t colon = authority.rfind(':'); colon != std::string_view::npos) {
+                parts.host = std::string(authority.substr(0, colon));
+                parts.port = std::stoi(std::string(authority.substr(colon + 1)));
+            }
+            return parts;
+        }
+
+        static int connect_to(const std::string& host, int port) {
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* found = nullptr;
+            if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0 || !found) {
+                throw std::runtime_error("WebSocket: cannot resolve " + host);
+            }
+            int fd = -1;
+            for (addrinfo* ai = found; ai; ai = ai->ai_next) {
+                fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+                if (fd < 0) continue;
+                if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+                ::close(fd);
+                fd = -1;
+            }
+            ::freeaddrinfo(found);
+            if (fd < 0) throw std::runtime_error("WebSocket: cannot connect to " + host + ":" + std::to_string(port));
+            int on = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+            return fd;
+        }
+
+        std::shared_ptr<WebSocketConnection> current() const {
+            std::lock_guard<std::mutex> lock(connection_mutex_);
+            return connection_;
+        }
+
+        std::string url_;
+        WebSocketOptions options_;
+        std::mutex lifecycle_mutex_;
+        std::shared_ptr<WebSocketConnection> connection_;
+        mutable std::mutex connection_mutex_;
+    };
+
+    /**
+     * @brief WebSocket server transport serving one peer at a time
+     *
+     * Upgrade requests on any path are accepted. While a session is open,
+     * other upgrade requests are answered with 503; once it ends, the next
+     * client may connect. Messages sent while no peer is connected are dropped.
+     *
+     * @example
+     * ```cpp
+     * auto transport = std::make_shared<WebSocketServerTransport>(8765);
+     * Server server(transport, impl);
+     * transport->start();
+     * ```
+     */
+    class WebSocketServerTransport : public Transport {
+    public:
+        explicit WebSocketServerTransport(int port, std::string host = "0.0.0.0", WebSocketOptions options = {})
+            : port_(port)
+            , host_(std::move(host))
+            , options_(options)
+            , running_(false)
+        {}
+
+        ~WebSocketServerTransport() override {
+            close();
+        }
+
+        using Transport::send;
+
+        bool accepts_encoded() const override { return true; }
+
+        bool supports_encoding(Encoding) const override { return true; }
+
+        void send(const json& message) override {
+            auto session = current();
+            if (!session) return;
+            if (size_t sent = detail::send_message(*session, message, encoding())) count_sent(sent);
+            else emit_error("WebSocket send failed");
+        }
+
+        /**
+         * @brief Bind and start accepting connections
+         * @throws std::runtime_error when the socket cannot be set up
+         */
+        void start() override {
+            std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+            if (running_) return;
+            listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (listen_fd_ < 0) throw std::runtime_error("WebSocket: socket failed");
+            int on = 1;
+            ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(port_));
+            const std::string host = host_ == "localhost" ? "127.0.0.1" : host_;
+            if (::inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1 ||
+                ::bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 ||
+                ::listen(listen_fd_, 16) < 0) {
+                ::close(listen_fd_);
+                listen_fd_ = -1;
+                throw std::runtime_error("WebSocket: cannot listen on " + host_ + ":" + std::to_string(port_));
+            }
+            socklen_t len = sizeof(addr);
+            ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+            bound_port_ = ntohs(addr.sin_port);
+            running_ = true;
+            accept_thread_ = std::thread([this] { accept_loop(); });
+        }
+
+        void close() override {
+            std::lock_guard<std::mutex> lock(lifecycle_mutex_);
+            if (!running_.exchange(false)) return;
+            if (accept_thread_.joinable()) accept_thread_.join();
+            ::close(listen_fd_);
+            listen_fd_ = -1;
+            std::shared_ptr<WebSocketConnection> session;
+            {
+                std::lock_guard<std::mutex> session_lock(session_mutex_);
+                session = std::move(session_);
+            }
+            if (session) session->close(1001);
+            emit_close();
+        }
+
+        bool is_open() const override {
+            return running_;
+        }
+
+        /**
+         * @brief Port the server listens on (useful when constructed with port 0)
+         */
+        int port() const {
+            return bound_port_.load();
+        }
+
+        /**
+         * @brief True while a peer is connected
+         */
+        bool has_peer() const {
+            auto session = current();
+            return session && session->is_open();
+        }
+
+        /**
+         * @brief The current session (compression, ping counters), or nullptr
+         */
+        std::shared_ptr<WebSocketConnection> connection() const {
+            return current();
+        }
+
+    private:
+        void accept_loop() {
+            while (running_) {
+                pollfd p{listen_fd_, POLLIN, 0};
+                int r = ::poll(&p, 1, 200);
+                if (r <= 0) continue;
+                int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+                if (fd < 0) continue;
+                int on = 1;
+                ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+                upgrade(fd);
+            }
+        }
+
+        void upgrade(int fd) {
+            std::string buffer;
+            size_t head_length = detail::read_http_head(fd, buffer, options_.handshake_timeout);
+            std::string_view head(buffer.data(), head_length);
+            auto upgrade = detail::http_header(head, "Upgrade");
+            auto connection = detail::http_header(head, "Connection");
+            auto version = detail::http_header(head, "Sec-WebSocket-Version");
+            auto key = detail::http_header(head, "Sec-WebSocket-Key");
+            if (head_length == 0 || head.substr(0, 4) != "GET " || !upgrade || !detail::iequals(*upgrade, "websocket") ||
+                !connection || !detail::header_has_token(*connection, "upgrade") || !key) {
+                if (head_length) detail::send_http(fd, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+                ::close(fd);
+                return;
+            }
+            if (!version || *version != "13") {
+                detail::send_http(fd, "HTTP/1.1 426 Upgrade Required\r\nSec-WebSocket-Version: 13\r\nContent-Length: 0\r\n\r\n");
+                ::close(fd);
+                return;
+            }
+            if (has_peer()) {
+                detail::send_http(fd, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+                ::close(fd);
+                return;
+            }
+
+            std::optional<detail::deflate_params> deflate;
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+            if (auto extensions = detail::http_header(head, "Sec-WebSocket-Extensions"); extensions && options_.compression) {
+                deflate = detail::deflate_params::parse(*extensions, true);
+            }
+#endif
+            std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                "Upgrade: websocket\r\n"
+                "Connection: Upgrade\r\n"
+                "Sec-WebSocket-Accept: " + detail::websocket_accept(*key) + "\r\n";
+            if (deflate) response += "Sec-WebSocket-Extensions: " + deflate->header() + "\r\n";
+            response += "\r\n";
+            detail::send_http(fd, response);
+
+            set_encoding(Encoding::json); // a new session negotiates afresh
+            auto session = std::make_shared<WebSocketConnection>(fd, WebSocketRole::server, options_, deflate, buffer.substr(head_length));
+            std::shared_ptr<WebSocketConnection> previous;
+            {
+                std::lock_guard<std::mutex> lock(session_mutex_);
+                previous = std::move(session_); // a finished session, freed outside the lock
+                session_ = session;
+            }
+            session->start(
+                [this](std::string_view text) { emit_text(text); },
+                [this](const std::string& error) {
+                    if (!error.empty()) emit_error("WebSocket: " + error);
+                });
+        }
+
+        std::shared_ptr<WebSocketConnection> current() const {
+            std::lock_guard<std::mutex> lock(session_mutex_);
+            return session_;
+        }
+
+        int port_;
+        std::string host_;
+        WebSocketOptions options_;
+        std::atomic<bool> running_;
+        std::atomic<int> bound_port_{0};
+        int listen_fd_ = -1;
+        std::thread accept_thread_;
+        std::mutex lifecycle_mutex_;
+        std::shared_ptr<WebSocketConnection> session_;
+        mutable std::mutex session_mutex_;
+    };
+
+} // namespace pooriayousefi::mcp::transport
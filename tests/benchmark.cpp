@@ -0,0 +1,384 @@
+/**
+ * @file benchmark.cpp
+ * @brief Microbenchmarks and an open-loop load generator for the SDK
+ *
+ * Usage:
+ *   benchmark micro [--filter TEXT] [--time MS] [--payload BYTES]
+ *   benchmark load  [--transport memory|pipe|http|epoll] [--concurrency N] [--rate PER_SEC]
+ *                   [--duration MS] [--warmup MS] [--payload BYTES] [--chunks N]
+ *                   [--workers N] [--port PORT]
+ *
+ * `micro` times the pieces every request goes through: parsing, building and
+ * dumping envelopes, dispatcher::handle and Generator iteration.
+ *
+ * `load` starts a StreamingServer and a client transport in one process and
+ * sends tools/call requests on a fixed schedule, whether or not earlier ones
+ * have been answered. Latency is measured from the scheduled send time, so a
+ * server that falls behind shows up as queueing delay instead of as a lower
+ * request rate (no coordinated omission). The http and epoll transports need
+ * cpp-httplib for the client side and are left out when it is not installed.
+ */
+
+#include <mcp/server_streaming.hpp>
+#include <mcp/transport/transport.hpp>
+#include <mcp/transport/stdio_fast.hpp>
+#include <mcp/core/metrics.hpp>
+#include <mcp/core/threadpool.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#if __has_include(<httplib.h>)
+#include <mcp/transport/http_transport.hpp>
+#include <mcp/transport/epoll_http.hpp>
+#define MCP_BENCHMARK_HTTP 1
+#endif
+
+using namespace pooriayousefi::mcp;
+using pooriayousefi::core::Histogram;
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    // Keeps the compiler from discarding a result it can prove unused
+    template<class T>
+    void keep(T&& value) {
+        asm volatile("" : : "g"(std::addressof(value)) : "memory");
+    }
+
+    double micros(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+    json tool_call(json id, const std::string& tool, const std::string& payload) {
+        return json{{"jsonrpc", "2.0"}, {"id", std::move(id)}, {"method", "tools/call"},
+                    {"params", {{"name", tool}, {"arguments", {{"data", payload}}}}}};
+    }
+
+    // ==================== Microbenchmarks ====================
+
+    struct MicroOptions {
+        std::string filter;
+        std::chrono::milliseconds time{300}; ///< Per benchmark, after warm-up
+        size_t payload = 64;                 ///< Bytes of the string argument
+    };
+
+    /**
+     * @brief Time fn in batches long enough that reading the clock is noise
+     *
+     * Reports the mean and the p50/p99 of the per-batch averages; the
+     * histogram holds picoseconds per call so cheap calls keep their digits.
+     */
+    template<class Fn>
+    void micro(const MicroOptions& options, std::string_view name, Fn&& fn) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string_view::npos) return;
+
+        size_t batch = 1;
+        for (;;) {
+            auto started = Clock::now();
+            for (size_t i = 0; i < batch; ++i) fn();
+            if (Clock::now() - started >= std::chrono::microseconds(50) || batch >= (size_t{1} << 20)) break;
+            batch *= 2;
+        }
+
+        auto per_call = std::make_unique<Histogram>();
+        uint64_t calls = 0;
+        Clock::duration total{};
+        while (total < options.time) {
+            auto started = Clock::now();
+            for (size_t i = 0; i < batch; ++i) fn();
+            auto elapsed = Clock::now() - started;
+            total += elapsed;
+            calls += batch;
+            per_call->record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) * 1000 / batch);
+        }
+
+        const auto snapshot = per_call->snapshot();
+        const double mean_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(total).count()) / static_cast<double>(calls);
+        std::printf("%-32s %12llu %12.1f %12.1f %12.1f %14.0f\n", std::string(name).c_str(),
+                    static_cast<unsigned long long>(calls), mean_ns,
+                    static_cast<double>(snapshot.percentile(0.5)) / 1000.0,
+                    static_cast<double>(snapshot.percentile(0.99)) / 1000.0,
+                    1e9 / mean_ns);
+    }
+
+    // payload by value: the frame outlives the caller's argument expression
+    Generator<ToolResultContent> chunks_of(std::string payload, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            co_yield ToolResultContent::text_content(payload);
+        }
+    }
+
+    int run_micro(const MicroOptions& options) {
+        const std::string payload(options.payload, 'x');
+        const json request = tool_call(1, "echo", payload);
+        const std::string request_text = request.dump();
+        const json result = {{"content", json::array({ToolResultContent::text_content(payload).to_json()})}};
+
+        json batch = json::array();
+        for (int i = 0; i < 16; ++i) batch.push_back(tool_call(i, "echo", payload));
+        const std::string batch_text = batch.dump();
+
+        jsonrpc::dispatcher dispatcher;
+        dispatcher.add("tools/call", [](const json& params) {
+            return json{{"content", json::array({{{"type", "text"}, {"text", params["arguments"]["data"]}}})}};
+        });
+
+        std::printf("payload %zu bytes, %lld ms per benchmark\n\n", options.payload, static_cast<long long>(options.time.count()));
+        std::printf("%-32s %12s %12s %12s %12s %14s\n", "benchmark", "calls", "mean ns", "p50 ns", "p99 ns", "calls/s");
+
+        micro(options, "parse/request", [&] { keep(json::parse(request_text)); });
+        micro(options, "parse/batch16", [&] { keep(json::parse(batch_text)); });
+        micro(options, "dump/request", [&] { keep(request.dump()); });
+        micro(options, "make_result", [&] { keep(jsonrpc::make_result(1, result)); });
+        micro(options, "make_result+dump", [&] { keep(jsonrpc::make_result(1, result).dump()); });
+        micro(options, "dispatcher::handle/single", [&] { keep(dispatcher.handle(request)); });
+        micro(options, "dispatcher::handle/batch16", [&] { keep(dispatcher.handle(batch)); });
+        micro(options, "dispatcher::handle/wire", [&] {
+            // Bytes in, bytes out: what a transport and the endpoint do per message
+            auto response = dispatcher.handle(json::parse(request_text));
+            keep(response->dump());
+        });
+        micro(options, "generator/yield64", [&] {
+            size_t bytes = 0;
+            for (const auto& content : chunks_of(payload, 64)) bytes += content.text->size();
+            keep(bytes);
+        });
+        micro(options, "generator/collect64", [&] {
+            // StreamingServer without a partialResultToken: gather, then one content array
+            std::vector<ToolResultContent> collected;
+            for (const auto& content : chunks_of(payload, 64)) collected.push_back(content);
+            json content = json::array();
+            for (const auto& item : collected) content.push_back(item.to_json());
+            keep(jsonrpc::make_result(1, json{{"content", std::move(content)}}).dump());
+        });
+        return EXIT_SUCCESS;
+    }
+
+    // ==================== Load generator ====================
+
+    struct LoadOptions {
+        std::string transport = "memory";        ///< memory, pipe, http or epoll
+        size_t concurrency = 4;                  ///< Sender threads (and HTTP connections)
+        double rate = 10000;                     ///< Requests per second over all senders
+        std::chrono::milliseconds duration{5000};
+        std::chrono::milliseconds warmup{1000};  ///< Sent on schedule but not reported
+        size_t payload = 64;                     ///< Bytes of the string argument
+        size_t chunks = 0;                       ///< Call the streaming tool for this many chunks; 0 = echo
+        size_t workers = 0;                      ///< Server executor threads; 0 = dispatch on the transport thread
+        int port = 18080;                        ///< For --transport http (epoll picks a free port)
+    };
+
+    struct Rig {
+        std::shared_ptr<transport::Transport> server_transport;
+        std::shared_ptr<transport::Transport> client_transport; ///< Paired with the server; HTTP clients are made by connect()
+        std::unique_ptr<StreamingServer> server;
+    };
+
+    Rig make_rig(const LoadOptions& options) {
+        Rig rig;
+        if (options.transport == "memory") {
+            auto [client, server] = transport::create_in_memory_pair(65536);
+            rig.client_transport = client;
+            rig.server_transport = server;
+        } else if (options.transport == "pipe") {
+            int requests[2], responses[2];
+            if (::pipe(requests) != 0 || ::pipe(responses) != 0) throw std::runtime_error("pipe() failed");
+            rig.client_transport = std::make_shared<transport::FastStdioTransport>(transport::FastStdioOptions{
+                .input_fd = responses[0], .output_fd = requests[1], .close_fds = true});
+            rig.server_transport = std::make_shared<transport::FastStdioTransport>(transport::FastStdioOptions{
+                .input_fd = requests[0], .output_fd = responses[1], .close_fds = true});
+#ifdef MCP_BENCHMARK_HTTP
+        } else if (options.transport == "http") {
+            rig.server_transport = std::make_shared<transport::HttpServerTransport>(options.port, "127.0.0.1");
+        } else if (options.transport == "epoll") {
+            transport::EpollHttpOptions epoll_options;
+            epoll_options.host = "127.0.0.1";
+            epoll_options.port = 0;
+            rig.server_transport = std::make_shared<transport::EpollHttpServerTransport>(epoll_options);
+#endif
+        } else {
+            throw std::invalid_argument("unknown transport: " + options.transport);
+        }
+
+        rig.server = std::make_unique<StreamingServer>(rig.server_transport, Implementation{"benchmark", "1.0.0"});
+        rig.server->enable_tools();
+        rig.server->register_tool(Tool{"echo", "Returns its data argument", ToolInputSchema{}}, [](const json& args) {
+            return std::vector<ToolResultContent>{ToolResultContent::text_content(args["data"].get<std::string>())};
+        });
+        rig.server->register_streaming_tool(Tool{"stream", "Yields its data argument in chunks", ToolInputSchema{}},
+            [chunks = options.chunks](const json& args) {
+                return chunks_of(args["data"].get<std::string>(), chunks);
+            });
+        if (options.workers > 0) {
+            rig.server->set_executor(std::make_shared<pooriayousefi::core::ThreadPool>(options.workers, 65536));
+        }
+        return rig;
+    }
+
+    // The client side of a started rig; HTTP servers only know their port once listening
+    std::shared_ptr<transport::Transport> connect(const LoadOptions& options, const Rig& rig) {
+        if (rig.client_transport) return rig.client_transport;
+#ifdef MCP_BENCHMARK_HTTP
+        int port = options.port;
+        if (auto epoll = std::dynamic_pointer_cast<transport::EpollHttpServerTransport>(rig.server_transport)) port = epoll->port();
+        transport::HttpClientOptions client_options;
+        client_options.connections = options.concurrency;
+        return std::make_shared<transport::HttpClientTransport>("http://127.0.0.1:" + std::to_string(port), "/jsonrpc", client_options);
+#else
+        (void)options;
+        return nullptr;
+#endif
+    }
+
+    int run_load(const LoadOptions& options) {
+        if (options.concurrency == 0 || options.rate <= 0) {
+            std::fprintf(stderr, "--concurrency and --rate must be positive\n");
+            return EXIT_FAILURE;
+        }
+        Rig rig = make_rig(options);
+        rig.server->start();
+        auto client = connect(options, rig);
+
+        const auto interval = std::chrono::duration<double>(1.0 / options.rate);
+        Clock::time_point start; // written before the first scheduled request is sent
+        auto latency = std::make_unique<Histogram>();
+        std::atomic<bool> ready{false};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> errors{0};
+
+        client->on_message([&](const json& message) {
+            auto id = message.find("id");
+            if (id == message.end()) return;
+            if (id->is_string()) {
+                ready = true; // initialize
+                return;
+            }
+            if (!id->is_number_unsigned()) return;
+            // The schedule says when request k was due; the gap to now is its latency
+            const uint64_t k = id->get<uint64_t>();
+            const auto due = start + std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(k));
+            if (due >= start + options.warmup) latency->record(Clock::now() - due);
+            if (message.contains("error")) ++errors;
+            ++completed;
+        });
+        client->start();
+
+        // The HTTP server listens from its own thread, so retry until it answers
+        const json initialize = jsonrpc::make_request(std::string("init"), "initialize",
+            {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}, {"clientInfo", {{"name", "benchmark"}, {"version", "1.0.0"}}}});
+        for (int attempt = 0; !ready && attempt < 50; ++attempt) {
+            client->send(initialize);
+            for (int i = 0; !ready && i < 20; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        if (!ready) {
+            std::fprintf(stderr, "server did not answer initialize\n");
+            return EXIT_FAILURE;
+        }
+
+        const std::string tool = options.chunks > 0 ? "stream" : "echo";
+        const json request = tool_call(0, tool, std::string(options.payload, 'x'));
+        const auto total = options.warmup + options.duration;
+        std::atomic<uint64_t> sent{0};
+        std::atomic<int64_t> worst_lag_ns{0};
+
+        start = Clock::now() + std::chrono::milliseconds(10);
+        std::vector<std::thread> senders;
+        for (size_t thread = 0; thread < options.concurrency; ++thread) {
+            senders.emplace_back([&, thread] {
+                int64_t worst = 0;
+                // Sender t owns requests t, t + C, t + 2C, ... of the global schedule
+                for (uint64_t k = thread;; k += options.concurrency) {
+                    const auto due = start + std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(k));
+                    if (due >= start + total) break;
+                    // Timer wake-ups run tens of microseconds late, so spin out the last stretch
+                    std::this_thread::sleep_until(due - std::chrono::microseconds(200));
+                    while (Clock::now() < due) std::this_thread::yield();
+                    json message = request;
+                    message["id"] = k;
+                    worst = std::max<int64_t>(worst, std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due).count());
+                    client->send(std::move(message));
+                    ++sent;
+                }
+                int64_t seen = worst_lag_ns.load();
+                while (worst > seen && !worst_lag_ns.compare_exchange_weak(seen, worst)) {}
+            });
+        }
+        for (auto& sender : senders) sender.join();
+
+        const auto drain_until = Clock::now() + std::chrono::seconds(5);
+        while (completed < sent && Clock::now() < drain_until) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        client->close();
+        rig.server->close();
+
+        const auto snapshot = latency->snapshot();
+        const double seconds = std::chrono::duration<double>(options.duration).count();
+        std::printf("transport %s, concurrency %zu, rate %.0f/s, payload %zu bytes, %s, %zu workers, %.1f s (+%.1f s warm-up)\n",
+                    options.transport.c_str(), options.concurrency, options.rate, options.payload,
+                    options.chunks > 0 ? ("stream x" + std::to_string(options.chunks)).c_str() : "echo",
+                    options.workers, seconds, std::chrono::duration<double>(options.warmup).count());
+        std::printf("sent %llu, completed %llu, errors %llu, unanswered %llu\n",
+                    static_cast<unsigned long long>(sent.load()), static_cast<unsigned long long>(completed.load()),
+                    static_cast<unsigned long long>(errors.load()), static_cast<unsigned long long>(sent - completed));
+        std::printf("throughput %.0f req/s\n", static_cast<double>(snapshot.count) / seconds);
+        std::printf("latency us: p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+                    micros(snapshot.percentile(0.5)), micros(snapshot.percentile(0.9)), micros(snapshot.percentile(0.99)),
+                    micros(snapshot.percentile(0.999)), micros(snapshot.percentile(1.0)));
+        if (worst_lag_ns > 1'000'000) {
+            std::printf("note: senders ran up to %.1f ms behind schedule; add --concurrency to offer the full rate\n",
+                        static_cast<double>(worst_lag_ns.load()) / 1e6);
+        }
+        return sent == completed ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    void usage(const char* program) {
+        std::printf("Usage:\n"
+                    "  %s micro [--filter TEXT] [--time MS] [--payload BYTES]\n"
+                    "  %s load  [--transport memory|pipe|http|epoll] [--concurrency N] [--rate PER_SEC]\n"
+                    "           [--duration MS] [--warmup MS] [--payload BYTES] [--chunks N] [--workers N] [--port PORT]\n",
+                    program, program);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || std::string_view(argv[1]) == "--help") {
+        usage(argv[0]);
+        return argc < 2 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+    const std::string_view mode = argv[1];
+    MicroOptions micro_options;
+    LoadOptions load_options;
+
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const std::string_view flag = argv[i];
+            if (i + 1 >= argc) throw std::invalid_argument("missing value for " + std::string(flag));
+            const std::string value = argv[++i];
+            if (flag == "--filter") micro_options.filter = value;
+            else if (flag == "--time") micro_options.time = std::chrono::milliseconds(std::stoll(value));
+            else if (flag == "--payload") micro_options.payload = load_options.payload = std::stoul(value);
+            else if (flag == "--transport") load_options.transport = value;
+            else if (flag == "--concurrency") load_options.concurrency = std::stoul(value);
+            else if (flag == "--rate") load_options.rate = std::stod(value);
+            else if (flag == "--duration") load_options.duration = std::chrono::milliseconds(std::stoll(value));
+            else if (flag == "--warmup") load_options.warmup = std::chrono::milliseconds(std::stoll(value));
+            else if (flag == "--chunks") load_options.chunks = std::stoul(value);
+            else if (flag == "--workers") load_options.workers = std::stoul(value);
+            else if (flag == "--port") load_options.port = std::stoi(value);
+            else throw std::invalid_argument("unknown option " + std::string(flag));
+        }
+        if (mode == "micro") return run_micro(micro_options);
+        if (mode == "load") return run_load(load_options);
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+}
@@ -1,6 +1,6 @@
 #!/bin/bash
 # Build script for C++ MCP SDK tests
-# Usage: ./build_tests.sh [--clean] [--run] [--verbose]
+# Usage: ./build_tests.sh [--clean] [--run] [--verbose] [--bench]
 
 set -e  # Exit on error
 
@@ -13,13 +13,32 @@ NC='\033[0m' # No Color
 # Configuration
 CXX=${CXX:-clang++-20}
 CXXFLAGS="-std=c++23 -Wall -Wextra -I../include -I../include/external"
+LDLIBS="-pthread"
 BUILD_DIR="build"
 TEST_BINARY="$BUILD_DIR/test_runner"
+BENCH_BINARY="$BUILD_DIR/benchmark"
+
+# zlib enables compression (core/deflate.hpp) when its headers are installed
+if echo '#include <zlib.h>' | $CXX -E -x c++ - >/dev/null 2>&1; then
+    CXXFLAGS="$CXXFLAGS -DPOORIAYOUSEFI_USE_ZLIB"
+    LDLIBS="$LDLIBS -lz"
+fi
+
+# zstd and brotli add those HTTP content codings (transport/content_coding.hpp)
+if echo '#include <zstd.h>' | $CXX -E -x c++ - >/dev/null 2>&1; then
+    CXXFLAGS="$CXXFLAGS -DPOORIAYOUSEFI_USE_ZSTD"
+    LDLIBS="$LDLIBS -lzstd"
+fi
+if echo '#include <brotli/encode.h>' | $CXX -E -x c++ - >/dev/null 2>&1; then
+    CXXFLAGS="$CXXFLAGS -DPOORIAYOUSEFI_USE_BROTLI"
+    LDLIBS="$LDLIBS -lbrotlienc -lbrotlidec"
+fi
 
 # Parse arguments
 CLEAN=false
 RUN=false
 VERBOSE=false
+BENCH=false
 
 for arg in "$@"; do
     case $arg in
@@ -33,6 +52,9 @@ for arg in "$@"; do
             VERBOSE=true
             CXXFLAGS="$CXXFLAGS -DCATCH_CONFIG_CONSOLE_WIDTH=120"
             ;;
+        --bench)
+            BENCH=true
+            ;;
         *)
             echo -e "${YELLOW}Unknown option: $arg${NC}"
             ;;
@@ -89,12 +111,21 @@ $CXX $CXXFLAGS \
     "$BUILD_DIR/main.o" \
     "$BUILD_DIR/catch_amalgamated.o" \
     "${TEST_OBJECTS[@]}" \
+    $LDLIBS \
     -o "$TEST_BINARY"
 
 echo -e "${GREEN}✓ Build successful!${NC}"
 echo "Test binary: $TEST_BINARY"
 echo ""
 
+# Benchmarks are optimized and kept out of the test runner
+if [ "$BENCH" = true ]; then
+    echo -e "${YELLOW}Building benchmarks...${NC}"
+    $CXX $CXXFLAGS -O2 -DNDEBUG benchmark.cpp $LDLIBS -o "$BENCH_BINARY"
+    echo -e "${GREEN}✓ Benchmark binary: $BENCH_BINARY${NC}"
+    echo ""
+fi
+
 # Run tests if requested
 if [ "$RUN" = true ]; then
     echo -e "${GREEN}Running tests...${NC}"
@@ -124,3 +155,7 @@ echo "  ./$TEST_BINARY              # Run all tests"
 echo "  ./$TEST_BINARY --list-tests # List available tests"
 echo "  ./$TEST_BINARY \"[protocol]\" # Run specific tag"
 echo "  ./$TEST_BINARY --help       # Show all options"
+if [ "$BENCH" = true ]; then
+    echo "  ./$BENCH_BINARY micro       # Microbenchmarks"
+    echo "  ./$BENCH_BINARY load --transport memory --rate 20000 --concurrency 4"
+fi
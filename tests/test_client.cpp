@@ -1,10 +1,15 @@
 #include "catch_amalgamated.hpp"
 #include "../include/mcp/client.hpp"
 #include "../include/mcp/server.hpp"
+#include "../include/mcp/server_streaming.hpp"
 #include "../include/mcp/transport/transport.hpp"
+#include "../include/mcp/transport/stdio_fast.hpp"
 #include <atomic>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <sys/socket.h>
+#include <unistd.h>
 
 using namespace pooriayousefi::mcp;
 using json = nlohmann::json;
@@ -206,6 +211,50 @@ TEST_CASE("Client list tools", "[client][tools][list]") {
         REQUIRE(wait_for([&]() { return error_received.load(); }, 100));
         REQUIRE(error_msg == "Client not initialized");
     }
+    
+    SECTION("List tools follows nextCursor across pages") {
+        auto [client_transport, server_transport] = transport::create_in_memory_pair();
+        
+        Implementation server_impl{"test-server", "1.0.0"};
+        Server server(server_transport, server_impl);
+        server.enable_tools();
+        server.set_page_size(3);
+        for (int i = 0; i < 10; ++i) {
+            server.register_tool(Tool{"tool" + std::to_string(i), std::nullopt, ToolInputSchema{}}, [](const json&) {
+                return std::vector<ToolResultContent>{};
+            });
+        }
+        server.start();
+        
+        Client client(client_transport);
+        client.start();
+        
+        std::atomic<bool> init_done{false};
+        client.initialize(
+            Implementation{"client", "1.0.0"},
+            ClientCapabilities{},
+            [&](const ServerInfo&) { init_done = true; },
+            [](const std::string&) {}
+        );
+        REQUIRE(wait_for([&]() { return init_done.load(); }));
+        
+        std::atomic<bool> list_done{false};
+        std::vector<Tool> received_tools;
+        client.list_tools(
+            [&](const std::vector<Tool>& tools) {
+                received_tools = tools;
+                list_done = true;
+            },
+            [](const std::string& error) {
+                FAIL("List tools failed: " + error);
+            }
+        );
+        
+        REQUIRE(wait_for([&]() { return list_done.load(); }));
+        REQUIRE(received_tools.size() == 10);
+        REQUIRE(received_tools.front().name == "tool0");
+        REQUIRE(received_tools.back().name == "tool9");
+    }
 }
 
 TEST_CASE("Client call tool", "[client][tools][execution]") {
@@ -652,6 +701,99 @@ TEST_CASE("Client list resources", "[client][resources][list]") {
     }
 }
 
+TEST_CASE("Client list cache", "[client][tools][list][cache]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools(true);
+    server.enable_prompts();
+    auto no_result = [](const json&) { return std::vector<ToolResultContent>{}; };
+    server.register_tool(Tool{"echo", "Echo tool", ToolInputSchema{}}, no_result);
+    server.register_prompt(Prompt{"greeting", std::nullopt, {}}, [](const std::map<std::string, std::string>&) {
+        return std::vector<PromptMessage>{};
+    });
+    server.start();
+
+    Client client(client_transport);
+    client.start();
+
+    std::atomic<bool> init_done{false};
+    client.initialize(
+        Implementation{"client", "1.0.0"},
+        ClientCapabilities{},
+        [&](const ServerInfo&) { init_done = true; },
+        [](const std::string&) {}
+    );
+    REQUIRE(wait_for([&]() { return init_done.load(); }));
+
+    auto list_tools = [&client]() {
+        std::mutex mutex;
+        std::atomic<bool> done{false};
+        std::vector<std::string> names;
+        client.list_tools(
+            [&](const std::vector<Tool>& tools) {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (const auto& tool : tools) names.push_back(tool.name);
+                done = true;
+            },
+            [](const std::string& error) { FAIL("List tools failed: " + error); }
+        );
+        REQUIRE(wait_for([&]() { return done.load(); }));
+        std::lock_guard<std::mutex> lock(mutex);
+        return names;
+    };
+
+    SECTION("Lists are served locally until the server says they changed") {
+        REQUIRE_FALSE(client.find_tool("echo"));
+        REQUIRE(list_tools() == std::vector<std::string>{"echo"});
+
+        auto echo = client.find_tool("echo");
+        REQUIRE(echo);
+        REQUIRE(echo->description == "Echo tool");
+        REQUIRE_FALSE(client.find_tool("missing"));
+
+        // Registering does not notify, so the cached copy is still served
+        server.register_tool(Tool{"calculator", std::nullopt, ToolInputSchema{}}, no_result);
+        REQUIRE(list_tools() == std::vector<std::string>{"echo"});
+
+        server.notify_tools_changed();
+        REQUIRE(wait_for([&]() { return !client.find_tool("echo"); }));
+        REQUIRE(list_tools().size() == 2);
+        REQUIRE(client.find_tool("calculator"));
+    }
+
+    SECTION("Lists without listChanged are always fetched") {
+        std::atomic<int> calls{0};
+        auto list_prompts = [&]() {
+            std::atomic<size_t> count{0};
+            int before = calls;
+            client.list_prompts(
+                [&](const std::vector<Prompt>& prompts) { count = prompts.size(); ++calls; },
+                [](const std::string& error) { FAIL("List prompts failed: " + error); }
+            );
+            REQUIRE(wait_for([&]() { return calls.load() > before; }));
+            return count.load();
+        };
+
+        REQUIRE(list_prompts() == 1);
+        server.register_prompt(Prompt{"farewell", std::nullopt, {}}, [](const std::map<std::string, std::string>&) {
+            return std::vector<PromptMessage>{};
+        });
+        REQUIRE(list_prompts() == 2);
+    }
+
+    SECTION("Disabling the cache drops it and fetches every time") {
+        REQUIRE(list_tools().size() == 1);
+        client.set_list_cache(false);
+        REQUIRE_FALSE(client.find_tool("echo"));
+
+        server.register_tool(Tool{"calculator", std::nullopt, ToolInputSchema{}}, no_result);
+        REQUIRE(list_tools().size() == 2);
+        REQUIRE_FALSE(client.find_tool("calculator"));
+    }
+}
+
 TEST_CASE("Client read resource", "[client][resources][execution]") {
     SECTION("Read resource content") {
         auto [client_transport, server_transport] = transport::create_in_memory_pair();
@@ -738,6 +880,121 @@ TEST_CASE("Client read resource", "[client][resources][execution]") {
     }
 }
 
+TEST_CASE("Client binary encoding negotiation", "[client][encoding]") {
+    // A Server and a Client on either end of a socket, as separate processes would be
+    int fds[2];
+    REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    auto framed = [](int fd) {
+        transport::FastStdioOptions options;
+        options.input_fd = options.output_fd = fd;
+        options.framing = transport::StdioFraming::content_length;
+        return options;
+    };
+    auto server_options = framed(fds[0]);
+    server_options.framing = transport::StdioFraming::detect; // replies in whichever framing the client uses
+    auto server_transport = std::make_shared<transport::FastStdioTransport>(server_options);
+    Server server(server_transport, Implementation{"test-server", "1.0.0"});
+    server.enable_tools();
+    server.enable_resources();
+
+    std::string data;
+    for (int i = 0; i < 4096; ++i) data.push_back(static_cast<char>(i * 7));
+    server.register_resource(Resource{"mem://blob", "blob", std::nullopt, "application/octet-stream"}, [&](const std::string& uri) {
+        ResourceContent content;
+        content.uri = uri;
+        content.mime_type = "application/octet-stream";
+        content.bytes = data;
+        return std::vector<ResourceContent>{content};
+    });
+    server.register_tool(Tool{"echo", "Echoes", ToolInputSchema{}}, [](const json& args) {
+        return std::vector<ToolResultContent>{ToolResultContent::text_content(args.value("text", ""))};
+    });
+
+    auto connect = [&](Client& client, const ClientCapabilities& capabilities) {
+        server.start();
+        client.start();
+        ServerInfo info;
+        std::atomic<bool> done{false};
+        client.initialize(Implementation{"client", "1.0.0"}, capabilities,
+            [&](const ServerInfo& received) { info = received; done = true; },
+            [](const std::string& error) { FAIL("Initialize failed: " + error); });
+        REQUIRE(wait_for([&]() { return done.load(); }));
+        return info;
+    };
+    auto read_blob = [](Client& client) {
+        std::vector<ResourceContent> contents;
+        std::atomic<bool> done{false};
+        client.read_resource("mem://blob", [&](const std::vector<ResourceContent>& received) { contents = received; done = true; },
+            [](const std::string& error) { FAIL("Read failed: " + error); });
+        REQUIRE(wait_for([&]() { return done.load(); }));
+        REQUIRE(contents.size() == 1);
+        return contents[0];
+    };
+
+    SECTION("Peers that both support CBOR switch to it and send blobs as raw bytes") {
+        server.set_encodings({transport::Encoding::cbor});
+        auto client_transport = std::make_shared<transport::FastStdioTransport>(framed(fds[1]));
+        Client client(client_transport);
+        ClientCapabilities capabilities;
+        capabilities.encodings = {"msgpack", "cbor"};
+        auto info = connect(client, capabilities);
+
+        REQUIRE(info.capabilities["encoding"] == "cbor");
+        REQUIRE(client_transport->encoding() == transport::Encoding::cbor);
+        REQUIRE(wait_for([&]() { return server_transport->encoding() == transport::Encoding::cbor; }));
+
+        auto content = read_blob(client);
+        REQUIRE(content.bytes == data);
+        REQUIRE_FALSE(content.blob.has_value());
+        REQUIRE(content.blob_data() == data);
+
+        std::atomic<bool> called{false};
+        std::string echoed;
+        client.call_tool("echo", {{"text", "over cbor"}},
+            [&](const std::vector<ToolResultContent>& result) { echoed = result.at(0).text.value_or(""); called = true; },
+            [](const std::string& error) { FAIL("Call failed: " + error); });
+        REQUIRE(wait_for([&]() { return called.load(); }));
+        REQUIRE(echoed == "over cbor");
+        client.close();
+    }
+
+    SECTION("Without a common encoding the session stays JSON and blobs are base64") {
+        server.set_encodings({transport::Encoding::msgpack});
+        auto client_transport = std::make_shared<transport::FastStdioTransport>(framed(fds[1]));
+        Client client(client_transport);
+        ClientCapabilities capabilities;
+        capabilities.encodings = {"cbor"};
+        auto info = connect(client, capabilities);
+
+        REQUIRE_FALSE(info.capabilities.contains("encoding"));
+        REQUIRE(client_transport->encoding() == transport::Encoding::json);
+        auto content = read_blob(client);
+        REQUIRE(content.blob == pooriayousefi::core::base64_encode(data));
+        REQUIRE(content.blob_data() == data);
+        client.close();
+    }
+
+    SECTION("Encodings the client transport cannot carry are not offered") {
+        server.set_encodings({transport::Encoding::cbor});
+        auto options = framed(fds[1]);
+        options.framing = transport::StdioFraming::newline;
+        auto client_transport = std::make_shared<transport::FastStdioTransport>(options);
+        REQUIRE_FALSE(client_transport->supports_encoding(transport::Encoding::cbor));
+        Client client(client_transport);
+        ClientCapabilities capabilities;
+        capabilities.encodings = {"cbor"};
+        auto info = connect(client, capabilities);
+
+        REQUIRE_FALSE(info.capabilities.contains("encoding"));
+        REQUIRE(client_transport->encoding() == transport::Encoding::json);
+        client.close();
+    }
+
+    server.close();
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
 TEST_CASE("Client error handling", "[client][errors]") {
     SECTION("Error callback can be registered") {
         auto [client_transport, server_transport] = transport::create_in_memory_pair();
@@ -753,6 +1010,268 @@ TEST_CASE("Client error handling", "[client][errors]") {
     }
 }
 
+TEST_CASE("Client batch calls", "[client][batch]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools();
+    server.enable_resources();
+    server.enable_prompts();
+
+    Tool add_tool;
+    add_tool.name = "add";
+    add_tool.description = "Add numbers";
+    add_tool.input_schema = ToolInputSchema{};
+    server.register_tool(add_tool, [](const json& args) {
+        int sum = args["a"].get<int>() + args["b"].get<int>();
+        return std::vector<ToolResultContent>{
+            ToolResultContent{"text", std::to_string(sum), std::nullopt, std::nullopt, std::nullopt}
+        };
+    });
+
+    Resource notes;
+    notes.uri = "file:///notes.txt";
+    notes.name = "notes";
+    server.register_resource(notes, [](const std::string& uri) {
+        ResourceContent content;
+        content.uri = uri;
+        content.text = "remember the milk";
+        return std::vector<ResourceContent>{content};
+    });
+
+    Prompt greeting;
+    greeting.name = "greeting";
+    server.register_prompt(greeting, [](const std::map<std::string, std::string>& args) {
+        PromptMessage message;
+        message.role = MessageRole::User;
+        message.content.push_back(MessageContent{"text", "Hello, " + args.at("name"), std::nullopt, std::nullopt});
+        return std::vector<PromptMessage>{message};
+    });
+    server.start();
+
+    Client client(client_transport);
+    client.start();
+
+    SECTION("Calls made before initialization fail individually") {
+        std::vector<std::string> errors;
+        client.batch()
+            .call_tool("add", json{{"a", 1}, {"b", 2}}, nullptr, [&](const std::string& e) { errors.push_back(e); })
+            .read_resource("file:///notes.txt", nullptr, [&](const std::string& e) { errors.push_back(e); })
+            .send();
+        REQUIRE(errors == std::vector<std::string>{"Client not initialized", "Client not initialized"});
+    }
+
+    SECTION("Mixed calls are answered through their own callbacks") {
+        std::atomic<bool> init_done{false};
+        client.initialize(Implementation{"client", "1.0.0"}, ClientCapabilities{},
+            [&](const ServerInfo&) { init_done = true; }, [](const std::string&) {});
+        REQUIRE(wait_for([&]() { return init_done.load(); }));
+
+        std::atomic<int> done{0};
+        std::string sum, text, prompt_text, missing_error;
+        auto batch = client.batch();
+        batch.call_tool("add", json{{"a", 2}, {"b", 3}},
+                [&](const std::vector<ToolResultContent>& r) { sum = r[0].text.value(); ++done; }, nullptr)
+            .call_tool("missing", json::object(),
+                [&](const std::vector<ToolResultContent>&) { ++done; },
+                [&](const std::string& e) { missing_error = e; ++done; })
+            .read_resource("file:///notes.txt",
+                [&](const std::vector<ResourceContent>& c) { text = c[0].text.value(); ++done; }, nullptr)
+            .get_prompt("greeting", {{"name", "Ada"}},
+                [&](const std::vector<PromptMessage>& m) { prompt_text = m[0].content[0].text.value(); ++done; }, nullptr);
+        REQUIRE(batch.size() == 4);
+        batch.send();
+        REQUIRE(batch.empty());
+
+        REQUIRE(wait_for([&]() { return done.load() == 4; }));
+        REQUIRE(sum == "5");
+        REQUIRE_FALSE(missing_error.empty());
+        REQUIRE(text == "remember the milk");
+        REQUIRE(prompt_text == "Hello, Ada");
+    }
+}
+
+TEST_CASE("Client request timeouts", "[client][errors][timeout]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools();
+
+    Tool stall_tool;
+    stall_tool.name = "stall";
+    stall_tool.description = "Answers after 200ms";
+    stall_tool.input_schema = ToolInputSchema{};
+    server.register_tool(stall_tool, [](const json&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return std::vector<ToolResultContent>{};
+    });
+    server.start();
+
+    Client client(client_transport);
+    client.start();
+
+    std::atomic<bool> init_done{false};
+    client.initialize(
+        Implementation{"client", "1.0.0"},
+        ClientCapabilities{},
+        [&](const ServerInfo&) { init_done = true; },
+        [](const std::string&) {}
+    );
+    REQUIRE(wait_for([&]() { return init_done.load(); }));
+
+    SECTION("Default timeout reports an error instead of hanging") {
+        client.set_request_timeout(std::chrono::milliseconds(30));
+
+        std::atomic<bool> failed{false};
+        std::atomic<bool> succeeded{false};
+        std::string error_message;
+        client.call_tool("stall", json::object(),
+            [&](const std::vector<ToolResultContent>&) { succeeded = true; },
+            [&](const std::string& error) { error_message = error; failed = true; });
+
+        REQUIRE(wait_for([&]() { return failed.load(); }));
+        REQUIRE(error_message == "Request timed out");
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        REQUIRE_FALSE(succeeded);
+    }
+
+    SECTION("Per-call timeout overrides the default") {
+        client.set_request_timeout(std::chrono::milliseconds(30));
+
+        std::atomic<bool> succeeded{false};
+        client.call_tool("stall", json::object(),
+            [&](const std::vector<ToolResultContent>&) { succeeded = true; },
+            [](const std::string&) {},
+            std::chrono::milliseconds(2000));
+
+        REQUIRE(wait_for([&]() { return succeeded.load(); }));
+    }
+}
+
+TEST_CASE("Client streaming calls", "[client][tools][streaming]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+
+    Implementation server_impl{"test-server", "1.0.0"};
+    StreamingServer server(server_transport, server_impl);
+    server.enable_tools();
+    server.enable_resources();
+
+    std::atomic<bool> release{false};
+    Tool rows_tool;
+    rows_tool.name = "rows";
+    rows_tool.description = "Yields three rows";
+    rows_tool.input_schema = ToolInputSchema{};
+    server.register_streaming_tool(rows_tool, [&release](const json&) -> Generator<ToolResultContent> {
+        co_yield ToolResultContent::text_content("row 1");
+        wait_for([&]() { return release.load(); }, 2000);
+        co_yield ToolResultContent::text_content("row 2");
+        co_yield ToolResultContent::text_content("row 3");
+    });
+
+    Tool plain_tool;
+    plain_tool.name = "plain";
+    plain_tool.description = "Not a streaming tool";
+    plain_tool.input_schema = ToolInputSchema{};
+    server.register_tool(plain_tool, [](const json&) {
+        return std::vector<ToolResultContent>{ToolResultContent::text_content("all at once")};
+    });
+
+    Resource log;
+    log.uri = "file:///app.log";
+    log.name = "log";
+    server.register_streaming_resource(log, [](const std::string& uri) -> Generator<ResourceContent> {
+        for (int i = 0; i < 3; ++i) {
+            ResourceContent line{uri, "text/plain", "line " + std::to_string(i), std::nullopt};
+            co_yield std::move(line);
+        }
+    });
+    server.start();
+
+    Client client(client_transport);
+    client.start();
+
+    std::atomic<bool> init_done{false};
+    client.initialize(Implementation{"client", "1.0.0"}, ClientCapabilities{},
+        [&](const ServerInfo&) { init_done = true; }, [](const std::string&) {});
+    REQUIRE(wait_for([&]() { return init_done.load(); }));
+
+    std::mutex mutex;
+    std::vector<std::string> chunks;
+    auto chunk_count = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return chunks.size();
+    };
+
+    SECTION("Chunks arrive before the tool has finished") {
+        std::atomic<bool> complete{false};
+        client.call_tool_streaming("rows", json::object(),
+            [&](const ToolResultContent& content) {
+                std::lock_guard<std::mutex> lock(mutex);
+                chunks.push_back(content.text.value_or(""));
+            },
+            [&]() { complete = true; },
+            [](const std::string&) {});
+
+        REQUIRE(wait_for([&]() { return chunk_count() == 1; }));
+        REQUIRE_FALSE(complete);
+
+        release = true;
+        REQUIRE(wait_for([&]() { return complete.load(); }));
+        REQUIRE(chunks == std::vector<std::string>{"row 1", "row 2", "row 3"});
+    }
+
+    SECTION("Generator consumer") {
+        release = true;
+        for (const auto& content : client.stream_tool("rows", json::object())) {
+            chunks.push_back(content.text.value_or(""));
+        }
+        REQUIRE(chunks == std::vector<std::string>{"row 1", "row 2", "row 3"});
+    }
+
+    SECTION("Generator consumer rethrows call errors") {
+        REQUIRE_THROWS_AS([&]() {
+            for (const auto& content : client.stream_tool("missing", json::object())) {
+                (void)content;
+            }
+        }(), std::runtime_error);
+    }
+
+    SECTION("Non-streaming tools deliver their result as chunks") {
+        for (const auto& content : client.stream_tool("plain", json::object())) {
+            chunks.push_back(content.text.value_or(""));
+        }
+        REQUIRE(chunks == std::vector<std::string>{"all at once"});
+    }
+
+    SECTION("Plain calls to a streaming tool still get the whole result") {
+        release = true;
+        std::atomic<bool> done{false};
+        std::vector<ToolResultContent> result;
+        client.call_tool("rows", json::object(),
+            [&](const std::vector<ToolResultContent>& r) { result = r; done = true; },
+            [](const std::string&) {});
+        REQUIRE(wait_for([&]() { return done.load(); }));
+        REQUIRE(result.size() == 3);
+    }
+
+    SECTION("Streaming resource read") {
+        std::atomic<bool> complete{false};
+        client.read_resource_streaming("file:///app.log",
+            [&](const ResourceContent& content) {
+                std::lock_guard<std::mutex> lock(mutex);
+                chunks.push_back(content.text.value_or(""));
+            },
+            [&]() { complete = true; },
+            [](const std::string&) {});
+        REQUIRE(wait_for([&]() { return complete.load(); }));
+        REQUIRE(chunks == std::vector<std::string>{"line 0", "line 1", "line 2"});
+    }
+
+    release = true;
+}
+
 TEST_CASE("Client lifecycle management", "[client][lifecycle]") {
     SECTION("Start and close lifecycle") {
         auto [client_transport, server_transport] = transport::create_in_memory_pair();
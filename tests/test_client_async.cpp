@@ -1,6 +1,7 @@
 #include "catch_amalgamated.hpp"
 #include "../include/mcp/client_async.hpp"
 #include "../include/mcp/server.hpp"
+#include "../include/mcp/server_streaming.hpp"
 #include "../include/mcp/transport/transport.hpp"
 #include <atomic>
 #include <chrono>
@@ -559,6 +560,168 @@ TEST_CASE("AsyncClient error handling", "[async_client][errors]") {
     }
 }
 
+TEST_CASE("AsyncClient batch", "[async_client][batch]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools();
+    server.enable_resources();
+
+    Tool square_tool;
+    square_tool.name = "square";
+    square_tool.description = "Square a number";
+    square_tool.input_schema = ToolInputSchema{};
+    server.register_tool(square_tool, [](const json& args) {
+        int x = args["x"].get<int>();
+        return std::vector<ToolResultContent>{
+            ToolResultContent{"text", std::to_string(x * x), std::nullopt, std::nullopt, std::nullopt}
+        };
+    });
+
+    Resource readme;
+    readme.uri = "file:///readme.md";
+    readme.name = "readme";
+    server.register_resource(readme, [](const std::string& uri) {
+        ResourceContent content;
+        content.uri = uri;
+        content.text = "# readme";
+        return std::vector<ResourceContent>{content};
+    });
+    server.start();
+
+    Client client(client_transport);
+    AsyncClient async_client(client);
+    client.start();
+
+    Implementation client_impl{"client", "1.0.0"};
+    ClientCapabilities capabilities;
+    sync_wait_client(async_client.initialize_async(client_impl, capabilities));
+
+    auto test_task = [&]() -> Task<void> {
+        auto batch = async_client.batch();
+        auto four = batch.call_tool("square", json{{"x", 2}});
+        auto text = batch.read_resource("file:///readme.md");
+        auto missing = batch.call_tool("missing", json::object());
+        REQUIRE(batch.size() == 3);
+        batch.send();
+
+        auto squared = co_await four;
+        REQUIRE(squared[0].text.value() == "4");
+        auto contents = co_await text;
+        REQUIRE(contents[0].text.value() == "# readme");
+
+        bool failed = false;
+        try {
+            co_await missing;
+        } catch (const std::runtime_error&) {
+            failed = true;
+        }
+        REQUIRE(failed);
+        co_return;
+    };
+
+    sync_wait_client(test_task());
+}
+
+TEST_CASE("AsyncClient streaming tool calls", "[async_client][tools][streaming]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+
+    Implementation server_impl{"test-server", "1.0.0"};
+    StreamingServer server(server_transport, server_impl);
+    server.enable_tools();
+
+    Tool letters_tool;
+    letters_tool.name = "letters";
+    letters_tool.description = "Yields a, b, c";
+    letters_tool.input_schema = ToolInputSchema{};
+    server.register_streaming_tool(letters_tool, [](const json&) -> Generator<ToolResultContent> {
+        for (const char* letter : {"a", "b", "c"}) {
+            co_yield ToolResultContent::text_content(letter);
+        }
+    });
+    server.start();
+
+    Client client(client_transport);
+    AsyncClient async_client(client);
+    client.start();
+
+    Implementation client_impl{"client", "1.0.0"};
+    ClientCapabilities capabilities;
+    sync_wait_client(async_client.initialize_async(client_impl, capabilities));
+
+    SECTION("Chunks are awaited one at a time") {
+        auto test_task = [&]() -> Task<void> {
+            auto stream = async_client.stream_tool("letters", json::object());
+            std::string letters;
+            while (true) {
+                auto next = stream.next();
+                auto chunk = co_await next;
+                if (!chunk) break;
+                letters += chunk->text.value_or("");
+            }
+            REQUIRE(letters == "abc");
+            co_return;
+        };
+        sync_wait_client(test_task());
+    }
+
+    SECTION("A failed call throws from next()") {
+        auto test_task = [&]() -> Task<void> {
+            auto stream = async_client.stream_tool("missing", json::object());
+            bool failed = false;
+            try {
+                auto next = stream.next();
+                co_await next;
+            } catch (const std::runtime_error&) {
+                failed = true;
+            }
+            REQUIRE(failed);
+            co_return;
+        };
+        sync_wait_client(test_task());
+    }
+}
+
+TEST_CASE("AsyncClient request timeouts", "[async_client][errors][timeout]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools();
+
+    Tool stall_tool;
+    stall_tool.name = "stall";
+    stall_tool.description = "Answers after 200ms";
+    stall_tool.input_schema = ToolInputSchema{};
+    server.register_tool(stall_tool, [](const json&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        return std::vector<ToolResultContent>{};
+    });
+    server.start();
+
+    Client client(client_transport);
+    AsyncClient async_client(client);
+    client.start();
+
+    Implementation client_impl{"client", "1.0.0"};
+    ClientCapabilities capabilities;
+    sync_wait_client(async_client.initialize_async(client_impl, capabilities));
+
+    auto test_task = [&]() -> Task<void> {
+        bool timed_out = false;
+        try {
+            co_await async_client.call_tool_async("stall", json::object(), std::chrono::milliseconds(30));
+        } catch (const std::runtime_error& e) {
+            timed_out = std::string(e.what()) == "Request timed out";
+        }
+        REQUIRE(timed_out);
+        co_return;
+    };
+
+    sync_wait_client(test_task());
+}
+
 TEST_CASE("AsyncClient integration scenarios", "[async_client][integration]") {
     SECTION("Full async client-server workflow") {
         auto [client_transport, server_transport] = transport::create_in_memory_pair();
@@ -730,3 +893,115 @@ TEST_CASE("AsyncClient sync_wait functionality", "[async_client][sync_wait]") {
         REQUIRE(client.is_initialized());
     }
 }
+
+TEST_CASE("Completion awaitable", "[async_client][completion]") {
+    using pooriayousefi::core::Completion;
+
+    SECTION("Value set before co_await does not suspend") {
+        Completion<int> done;
+        done.set_value(7);
+        REQUIRE(done.is_ready());
+
+        auto task = [&]() -> Task<int> { co_return co_await done; };
+        REQUIRE(pooriayousefi::core::sync_wait(task()) == 7);
+    }
+
+    SECTION("Value set from another thread resumes the suspended coroutine") {
+        Completion<std::string> done;
+        std::thread::id resumed_on;
+        std::string value;
+
+        auto body = [&]() -> Task<void> {
+            value = co_await done;
+            resumed_on = std::this_thread::get_id();
+        };
+        auto task = body();
+        task.handle.resume();
+        REQUIRE_FALSE(task.handle.done());
+
+        std::thread producer([&]() { done.set_value("hello"); });
+        auto producer_id = producer.get_id();
+        producer.join();
+
+        REQUIRE(task.handle.done());
+        REQUIRE(value == "hello");
+        REQUIRE(resumed_on == producer_id);
+    }
+
+    SECTION("Only the first result is kept and exceptions propagate") {
+        Completion<int> done;
+        REQUIRE(done.set_exception(std::make_exception_ptr(std::runtime_error("boom"))));
+        REQUIRE_FALSE(done.set_value(1));
+
+        auto task = [&]() -> Task<int> { co_return co_await done; };
+        REQUIRE_THROWS_WITH(pooriayousefi::core::sync_wait(task()), "boom");
+    }
+
+    SECTION("Executor decides where the coroutine resumes") {
+        auto pool = std::make_shared<pooriayousefi::core::ThreadPool>(2);
+        Completion<int> done(pool);
+        std::atomic<bool> on_pool{false};
+
+        auto body = [&]() -> Task<void> {
+            co_await done;
+            on_pool = pool->running_in_pool();
+        };
+        auto task = body();
+        task.handle.resume();
+        done.set_value(1);
+
+        REQUIRE(wait_for([&]() { return task.handle.done(); }));
+        REQUIRE(on_pool);
+    }
+}
+
+TEST_CASE("AsyncClient keeps calls outstanding without blocking", "[async_client][parallel][nonblocking]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools();
+
+    std::atomic<bool> release{false};
+    std::atomic<int> handled{0};
+    Tool echo_tool;
+    echo_tool.name = "echo";
+    echo_tool.description = "Echo n once released";
+    echo_tool.input_schema = ToolInputSchema{};
+    server.register_tool(echo_tool, [&](const json& args) {
+        while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        ++handled;
+        return std::vector<ToolResultContent>{
+            ToolResultContent{"text", std::to_string(args["n"].get<int>()), std::nullopt, std::nullopt, std::nullopt}
+        };
+    });
+    server.start();
+
+    Client client(client_transport);
+    AsyncClient async_client(client);
+    client.start();
+
+    sync_wait_client(async_client.initialize_async(Implementation{"client", "1.0.0"}, ClientCapabilities{}));
+
+    constexpr int calls = 500;
+    std::vector<std::pair<std::string, json>> batch;
+    for (int i = 0; i < calls; ++i) batch.push_back({"echo", json{{"n", i}}});
+
+    std::vector<std::vector<ToolResultContent>> results;
+    auto body = [&]() -> Task<void> {
+        results = co_await async_client.execute_parallel_async(batch);
+    };
+
+    // Starting the coroutine only puts the calls on the wire; this thread is free again
+    auto task = body();
+    task.handle.resume();
+    REQUIRE_FALSE(task.handle.done());
+    REQUIRE(handled == 0);
+
+    release = true;
+    REQUIRE(wait_for([&]() { return task.handle.done(); }, 10000));
+    REQUIRE(results.size() == static_cast<size_t>(calls));
+    for (int i = 0; i < calls; ++i) {
+        REQUIRE(results[i][0].text.value() == std::to_string(i));
+    }
+}
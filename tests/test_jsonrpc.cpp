@@ -1,5 +1,9 @@
 #include <catch_amalgamated.hpp>
 #include <mcp/jsonrpc/jsonrpc.hpp>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <memory>
 
 using namespace pooriayousefi::mcp::jsonrpc;
 using json = nlohmann::json;
@@ -289,6 +293,66 @@ TEST_CASE("Dispatcher method registration", "[jsonrpc][dispatcher]") {
     }
 }
 
+TEST_CASE("Dispatcher lookup table", "[jsonrpc][dispatcher]") {
+    dispatcher disp;
+    for (int i = 0; i < 200; ++i) {
+        disp.add("method/" + std::to_string(i), [i](const json&) -> json { return i; });
+    }
+
+    SECTION("Every registered method resolves to its own handler") {
+        for (int i = 0; i < 200; ++i) {
+            auto resp = disp.handle_single(make_request(i, "method/" + std::to_string(i)));
+            REQUIRE((*resp)["result"] == i);
+        }
+    }
+
+    SECTION("Unregistered names miss") {
+        REQUIRE_FALSE(disp.contains("method/200"));
+        REQUIRE_FALSE(disp.contains("method/"));
+        REQUIRE_FALSE(disp.contains(""));
+        auto resp = disp.handle_single(make_request(1, "method/1x"));
+        REQUIRE((*resp)["error"]["code"] == -32601);
+    }
+
+    SECTION("Re-registering replaces the handler") {
+        disp.add("method/7", [](const json&) -> json { return "replaced"; });
+        REQUIRE((*disp.handle_single(make_request(1, "method/7")))["result"] == "replaced");
+        REQUIRE((*disp.handle_single(make_request(2, "method/8")))["result"] == 8);
+    }
+
+    SECTION("Copies keep working after the original is gone") {
+        auto copy = std::make_unique<dispatcher>(disp);
+        disp = dispatcher();
+        REQUIRE(copy->contains("method/42"));
+        REQUIRE((*copy->handle_single(make_request(1, "method/42")))["result"] == 42);
+        REQUIRE_FALSE(disp.contains("method/42"));
+    }
+
+    SECTION("Methods added while other threads dispatch are published whole") {
+        std::atomic<bool> done{false};
+        std::atomic<bool> consistent{true};
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&, t]() {
+                for (int n = 0; !done; ++n) {
+                    auto resp = disp.handle_single(make_request(n, "method/" + std::to_string((n + t) % 200)));
+                    if (!resp || (*resp)["result"] != (n + t) % 200) consistent = false;
+                    auto added = disp.handle_single(make_request(n, "late/0"));
+                    if (!added || (added->contains("result") && (*added)["result"] != "late")) consistent = false;
+                }
+            });
+        }
+        for (int i = 0; i < 100; ++i) {
+            disp.add("late/" + std::to_string(i), [](const json&) -> json { return "late"; });
+        }
+        done = true;
+        for (auto& reader : readers) reader.join();
+        REQUIRE(consistent);
+        REQUIRE((*disp.handle_single(make_request(1, "late/99")))["result"] == "late");
+        REQUIRE((*disp.handle_single(make_request(2, "method/199")))["result"] == 199);
+    }
+}
+
 TEST_CASE("Dispatcher parameter handling", "[jsonrpc][dispatcher]") {
     dispatcher disp;
     
@@ -325,6 +389,20 @@ TEST_CASE("Dispatcher parameter handling", "[jsonrpc][dispatcher]") {
         
         REQUIRE((*resp)["result"]["received_empty"] == true);
     }
+
+    SECTION("Parameters are passed without copying") {
+        const json* seen = nullptr;
+        disp.add("peek", [&](const json& params) -> json {
+            seen = &params;
+            return json{{"blob", std::string(4096, 'x')}};
+        });
+
+        json req = make_request("req-1", "peek", json{{"key", "value"}});
+        auto resp = disp.handle_single(req);
+
+        REQUIRE(seen == &req["params"]);
+        REQUIRE((*resp)["result"]["blob"].get_ref<const std::string&>().size() == 4096);
+    }
 }
 
 TEST_CASE("Dispatcher error handling", "[jsonrpc][dispatcher]") {
@@ -420,6 +498,32 @@ TEST_CASE("Endpoint request/response flow", "[jsonrpc][endpoint]") {
         REQUIRE(error_data["code"] == -32601);
     }
     
+    SECTION("Explicit ids never share a generated id's slot") {
+        std::string answered;
+        ep.send_request("generated", json{}, [&](const json&) { answered += "generated;"; }, [](const json&) {});
+        REQUIRE(sent_messages[0]["id"] == "req-1");
+
+        // Generated spelling is reserved; other spellings of the same number are plain ids
+        REQUIRE_THROWS_AS(ep.send_request_with_id("req-1", "m", json{}, [](const json&) {}, [](const json&) {}),
+                          std::invalid_argument);
+        REQUIRE_THROWS_AS(ep.send_request_with_id("req-7", "m", json{}, [](const json&) {}, [](const json&) {}),
+                          std::invalid_argument);
+        for (const char* id : {"req-01", "req-0", "req-+1", "req-"}) {
+            ep.send_request_with_id(id, "m", json{}, [&, id](const json&) { answered += std::string(id) + ";"; }, [](const json&) {});
+        }
+        REQUIRE(ep.pending_count() == 5);
+
+        ep.receive(make_result("req-01", json::object()));
+        REQUIRE(answered == "req-01;");
+        ep.receive(make_result("req-1", json::object()));
+        REQUIRE(answered == "req-01;generated;");
+        ep.receive(make_result("req-+1", json::object()));
+        ep.receive(make_result("req-0", json::object()));
+        ep.receive(make_result("req-", json::object()));
+        REQUIRE(answered == "req-01;generated;req-+1;req-0;req-;");
+        REQUIRE(ep.pending_count() == 0);
+    }
+
     SECTION("Send notification") {
         ep.send_notification("notify_event", json{{"event", "test"}});
         
@@ -512,6 +616,421 @@ TEST_CASE("Endpoint cancellation support", "[jsonrpc][endpoint]") {
     }
 }
 
+TEST_CASE("Endpoint concurrent request fan-out", "[jsonrpc][endpoint][concurrency]") {
+    std::mutex sent_mutex;
+    std::vector<json> sent_messages;
+    endpoint ep([&](const json& msg) {
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        sent_messages.push_back(msg);
+    });
+
+    constexpr int threads = 8;
+    constexpr int per_thread = 250;
+    std::atomic<int> results{0};
+
+    std::vector<std::thread> senders;
+    for (int t = 0; t < threads; ++t) {
+        senders.emplace_back([&]() {
+            for (int i = 0; i < per_thread; ++i) {
+                ep.send_request("work", json{{"i", i}},
+                    [&](const json&) { ++results; },
+                    [](const json&) {});
+            }
+        });
+    }
+    for (auto& t : senders) t.join();
+
+    REQUIRE(ep.pending_count() == size_t(threads * per_thread));
+
+    // Answer from two threads at once, in reverse order on one of them
+    std::vector<json> requests;
+    {
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        requests = sent_messages;
+    }
+    std::thread forward([&]() {
+        for (size_t i = 0; i < requests.size(); i += 2) ep.receive(make_result(requests[i]["id"], json{}));
+    });
+    std::thread backward([&]() {
+        for (size_t i = requests.size(); i-- > 0;) {
+            if (i % 2 == 1) ep.receive(make_result(requests[i]["id"], json{}));
+        }
+    });
+    forward.join();
+    backward.join();
+
+    REQUIRE(results.load() == threads * per_thread);
+    REQUIRE(ep.pending_count() == 0);
+
+    SECTION("Late duplicate responses are ignored") {
+        ep.receive(make_result(requests[0]["id"], json{}));
+        REQUIRE(results.load() == threads * per_thread);
+    }
+}
+
+TEST_CASE("Endpoint executor dispatch", "[jsonrpc][endpoint][executor]") {
+    std::mutex sent_mutex;
+    std::vector<json> sent_messages;
+    auto pool = std::make_shared<pooriayousefi::core::ThreadPool>(4, 64);
+    endpoint ep([&](const json& msg) {
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        sent_messages.push_back(msg);
+    });
+    ep.set_executor(pool);
+
+    auto sent_count = [&]() {
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        return sent_messages.size();
+    };
+    auto wait_sent = [&](size_t n) {
+        for (int i = 0; i < 200 && sent_count() < n; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return sent_count() >= n;
+    };
+
+    SECTION("Responses go out in completion order") {
+        ep.add("slow", [](const json&) -> json {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            return json{{"which", "slow"}};
+        });
+        ep.add("fast", [](const json&) -> json { return json{{"which", "fast"}}; });
+
+        ep.receive(make_request("req-1", "slow"));
+        ep.receive(make_request("req-2", "fast"));
+
+        REQUIRE(wait_sent(2));
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        REQUIRE(sent_messages[0]["id"] == "req-2");
+        REQUIRE(sent_messages[1]["id"] == "req-1");
+    }
+
+    SECTION("Cancellation reaches a running handler") {
+        std::atomic<bool> started{false};
+        ep.add("long", [&](const json&) -> json {
+            started = true;
+            for (int i = 0; i < 200 && !is_canceled(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            if (is_canceled()) throw_rpc_error(request_cancelled);
+            return json{{"finished", true}};
+        });
+
+        ep.receive(make_request("req-1", "long"));
+        for (int i = 0; i < 100 && !started; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        REQUIRE(started);
+        ep.receive(make_notification("$/cancelRequest", json{{"id", "req-1"}}));
+
+        REQUIRE(wait_sent(1));
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        REQUIRE(sent_messages[0]["error"]["code"] == -32800);
+    }
+
+    SECTION("Per-method concurrency limit") {
+        std::atomic<int> running{0};
+        std::atomic<int> peak{0};
+        ep.set_method_concurrency("limited", 2);
+        ep.add("limited", [&](const json&) -> json {
+            int now = ++running;
+            int seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            --running;
+            return json{};
+        });
+
+        for (int i = 0; i < 8; ++i) {
+            ep.receive(make_request("req-" + std::to_string(i), "limited"));
+        }
+
+        REQUIRE(wait_sent(8));
+        REQUIRE(peak.load() <= 2);
+    }
+
+    SECTION("Batch still answers with one array") {
+        ep.add("method1", [](const json&) -> json { return json{{"result", 1}}; });
+        json batch = json::array({
+            make_request("req-1", "method1"),
+            make_request("req-2", "method1"),
+            make_notification("method1")
+        });
+        ep.receive(batch);
+
+        ep.wait_idle();
+        REQUIRE(wait_sent(1));
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        REQUIRE(sent_messages.size() == 1);
+        REQUIRE(sent_messages[0].is_array());
+        REQUIRE(sent_messages[0].size() == 2);
+    }
+
+    SECTION("Handed-over batch is moved into its tasks") {
+        ep.add("echo", [](const json& params) -> json { return params; });
+        json batch = json::array({
+            make_request("req-1", "echo", json{{"n", 1}}),
+            make_request("req-2", "echo", json{{"n", 2}})
+        });
+        ep.receive(std::move(batch));
+
+        ep.wait_idle();
+        REQUIRE(wait_sent(1));
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        REQUIRE(sent_messages[0].is_array());
+        REQUIRE(sent_messages[0].size() == 2);
+        int sum = 0;
+        for (const auto& r : sent_messages[0]) sum += r["result"]["n"].get<int>();
+        REQUIRE(sum == 3);
+    }
+
+    ep.wait_idle();
+}
+
+TEST_CASE("Endpoint outgoing batches", "[jsonrpc][endpoint][batch]") {
+    std::vector<json> sent;
+    endpoint ep([&](const json& msg) { sent.push_back(msg); });
+
+    std::vector<std::string> order;
+    std::vector<endpoint::outgoing_call> calls;
+    for (int i = 0; i < 3; ++i) {
+        calls.push_back({"work", json{{"i", i}},
+            [&, i](const json& r) { order.push_back("ok" + std::to_string(i) + ":" + r.get<std::string>()); },
+            [&, i](const json& e) { order.push_back("err" + std::to_string(i) + ":" + std::to_string(e["code"].get<int>())); }});
+    }
+    auto ids = ep.send_batch(std::move(calls));
+
+    REQUIRE(ids.size() == 3);
+    REQUIRE(sent.size() == 1);
+    REQUIRE(sent[0].is_array());
+    REQUIRE(sent[0].size() == 3);
+    REQUIRE(sent[0][1]["params"]["i"] == 1);
+    REQUIRE(ep.pending_count() == 3);
+
+    // The peer answers out of order, in one array
+    ep.receive(json::array({
+        make_result(ids[2], "c"),
+        make_error(ids[0], method_not_found),
+        make_result(ids[1], "b")
+    }));
+
+    REQUIRE(order == std::vector<std::string>{"ok2:c", "err0:-32601", "ok1:b"});
+    REQUIRE(ep.pending_count() == 0);
+    REQUIRE(sent.size() == 1); // responses produce no reply
+
+    REQUIRE(ep.send_batch({}).empty());
+    REQUIRE(sent.size() == 1);
+}
+
+TEST_CASE("Endpoint request deadlines", "[jsonrpc][endpoint][timeout]") {
+    std::mutex sent_mutex;
+    std::vector<json> sent_messages;
+    endpoint ep([&](const json& msg) {
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        sent_messages.push_back(msg);
+    });
+    auto sent = [&]() {
+        std::lock_guard<std::mutex> lock(sent_mutex);
+        return sent_messages;
+    };
+    auto wait_until = [](auto pred) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!pred() && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return pred();
+    };
+
+    SECTION("Unanswered request fails with request_timeout and is cancelled") {
+        std::atomic<int> errors{0};
+        json error_payload;
+        bool result_called = false;
+        auto id = ep.send_request("slow", json::object(),
+            [&](const json&) { result_called = true; },
+            [&](const json& e) { error_payload = e; ++errors; },
+            std::chrono::milliseconds(30));
+
+        REQUIRE(wait_until([&]() { return errors.load() == 1; }));
+        REQUIRE(error_payload["code"] == request_timeout.code);
+        REQUIRE(error_payload["data"]["timeout"] == 30);
+        REQUIRE(ep.pending_count() == 0);
+
+        auto messages = sent();
+        REQUIRE(messages.size() == 2);
+        REQUIRE(messages[1]["method"] == "$/cancelRequest");
+        REQUIRE(messages[1]["params"]["id"] == id);
+
+        // A late answer is dropped
+        ep.receive(make_result(id, json{}));
+        REQUIRE_FALSE(result_called);
+        REQUIRE(errors.load() == 1);
+    }
+
+    SECTION("Answered request never times out") {
+        std::atomic<int> errors{0};
+        std::atomic<int> results{0};
+        auto id = ep.send_request("fast", json::object(),
+            [&](const json&) { ++results; },
+            [&](const json&) { ++errors; },
+            std::chrono::milliseconds(20));
+        ep.receive(make_result(id, json{}));
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        REQUIRE(results.load() == 1);
+        REQUIRE(errors.load() == 0);
+        REQUIRE(sent().size() == 1);
+    }
+
+    SECTION("Default timeout expires many requests in batches") {
+        ep.set_default_timeout(std::chrono::milliseconds(20));
+        ep.set_cancel_on_timeout(false);
+        std::atomic<int> errors{0};
+        constexpr int count = 1000;
+        for (int i = 0; i < count; ++i) {
+            ep.send_request("slow", json::object(), [](const json&) {}, [&](const json&) { ++errors; });
+        }
+        REQUIRE(wait_until([&]() { return errors.load() == count; }));
+        REQUIRE(ep.pending_count() == 0);
+        REQUIRE(sent().size() == size_t(count));
+    }
+}
+
+TEST_CASE("TimerWheel scheduling", "[core][timer]") {
+    pooriayousefi::core::TimerWheel wheel(std::chrono::milliseconds(2), 8);
+    std::atomic<int> fired{0};
+
+    SECTION("Timers longer than one revolution wait their rounds") {
+        auto start = std::chrono::steady_clock::now();
+        std::atomic<long long> elapsed{0};
+        wheel.schedule(std::chrono::milliseconds(40), [&]() {
+            elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            ++fired;
+        });
+        while (fired.load() == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        REQUIRE(elapsed.load() >= 40);
+    }
+
+    SECTION("Cancelled timers never fire") {
+        auto id = wheel.schedule(std::chrono::milliseconds(10), [&]() { ++fired; });
+        REQUIRE(wheel.cancel(id));
+        REQUIRE_FALSE(wheel.cancel(id));
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+        REQUIRE(fired.load() == 0);
+        REQUIRE(wheel.pending() == 0);
+    }
+}
+
+TEST_CASE("Metrics counters, histograms and export", "[core][metrics]") {
+    using pooriayousefi::core::Histogram;
+    using pooriayousefi::core::Metrics;
+    using pooriayousefi::core::MetricSample;
+    using pooriayousefi::core::MetricType;
+    Metrics metrics;
+
+    SECTION("Histogram buckets stay within 1/16 of the value") {
+        for (uint64_t value : {0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, (1ull << 62) + 12345}) {
+            auto bucket = Histogram::bucket_of(value);
+            REQUIRE(Histogram::bucket_max(bucket) >= value);
+            REQUIRE(Histogram::bucket_max(bucket) - value <= value / 16);
+            if (bucket > 0) REQUIRE(Histogram::bucket_max(bucket - 1) < value);
+        }
+        REQUIRE(Histogram::bucket_of(UINT64_MAX) == Histogram::bucket_count - 1);
+    }
+
+    SECTION("Percentiles come from the recorded distribution") {
+        auto& latency = metrics.histogram("op_duration_seconds", "Latency");
+        for (uint64_t i = 1; i <= 1000; ++i) latency.record(i * 1000);
+        auto snapshot = latency.snapshot();
+        REQUIRE(snapshot.count == 1000);
+        REQUIRE(snapshot.sum == 500500000);
+        REQUIRE(snapshot.percentile(0.5) >= 500000);
+        REQUIRE(snapshot.percentile(0.5) <= 500000 + 500000 / 16);
+        REQUIRE(snapshot.percentile(0.99) >= 990000);
+        REQUIRE(snapshot.percentile(1.0) >= 1000000);
+    }
+
+    SECTION("Counters sum every thread's stripe") {
+        auto& counter = metrics.counter("hits_total", "Hits");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t) {
+            threads.emplace_back([&counter]() { for (int i = 0; i < 10000; ++i) counter.add(); });
+        }
+        for (auto& thread : threads) thread.join();
+        REQUIRE(counter.value() == 80000);
+        REQUIRE(&metrics.counter("hits_total", "Hits") == &counter);
+        REQUIRE_THROWS_AS(metrics.histogram("hits_total", "Hits"), std::invalid_argument);
+    }
+
+    SECTION("Gauges are read at export and unregistered with their observation") {
+        double depth = 3;
+        {
+            auto gauge = metrics.observe("queue_depth", "Queued", "queue", "a\"b", [&depth]() { return depth; });
+            metrics.counter("requests_total", "Requests", "method", "ping").add(2);
+            metrics.histogram("request_duration_seconds", "Latency", "method", "ping").record(std::chrono::microseconds(250));
+
+            auto text = metrics.prometheus();
+            REQUIRE(text.find("# TYPE queue_depth gauge\nqueue_depth{queue=\"a\\\"b\"} 3\n") != std::string::npos);
+            REQUIRE(text.find("requests_total{method=\"ping\"} 2\n") != std::string::npos);
+            REQUIRE(text.find("# TYPE request_duration_seconds summary") != std::string::npos);
+            REQUIRE(text.find("request_duration_seconds{method=\"ping\",quantile=\"0.99\"} 0.000") != std::string::npos);
+            REQUIRE(text.find("request_duration_seconds_count{method=\"ping\"} 1\n") != std::string::npos);
+
+            depth = 7;
+            double seen = 0;
+            metrics.collect([&seen](const MetricSample& sample) {
+                if (sample.name == "queue_depth" && sample.type == MetricType::gauge) seen = sample.value;
+            });
+            REQUIRE(seen == 7);
+        }
+        REQUIRE(metrics.prometheus().find("queue_depth{") == std::string::npos);
+    }
+}
+
+TEST_CASE("Endpoint metrics and spans", "[jsonrpc][endpoint][metrics]") {
+    using pooriayousefi::core::SpanKind;
+    auto metrics = std::make_shared<pooriayousefi::core::Metrics>();
+    std::vector<json> sent;
+    endpoint ep([&sent](json&& msg) { sent.push_back(std::move(msg)); });
+    ep.add("echo", [](const json& params) -> json { return params; });
+    ep.add("fail", [](const json&) -> json { throw std::runtime_error("boom"); });
+
+    std::vector<std::string> spans;
+    metrics->set_span_hooks({
+        [&spans](SpanKind kind, std::string_view name) -> void* {
+            spans.push_back(std::string(pooriayousefi::core::span_kind_name(kind)) + ":" + std::string(name));
+            return nullptr;
+        },
+        [&spans](void*, bool ok) { if (!ok) spans.push_back("failed"); }
+    });
+    ep.set_metrics(metrics);
+
+    ep.receive(make_request("1", "echo", json{{"x", 1}}));
+    ep.receive(make_request("2", "fail", json::object()));
+    ep.receive(make_request("3", "echo", json::object()));
+    ep.send_request("echo", json::object(), nullptr, nullptr);
+
+    auto& calls = metrics->counter("mcp_method_calls_total", "", "method", "echo");
+    REQUIRE(calls.value() == 2);
+    REQUIRE(metrics->counter("mcp_method_errors_total", "", "method", "fail").value() == 1);
+    REQUIRE(metrics->histogram("mcp_method_duration_seconds", "", "method", "echo").snapshot().count == 2);
+
+    auto text = metrics->prometheus();
+    REQUIRE(text.find("mcp_pending_requests 1\n") != std::string::npos);
+    REQUIRE(text.find("mcp_method_calls_total{method=\"fail\"} 1\n") != std::string::npos);
+
+    REQUIRE(std::vector<std::string>(spans.begin(), spans.begin() + 3) == std::vector<std::string>{"dispatch:echo", "handler:echo", "send:response"});
+    REQUIRE(std::vector<std::string>(spans.begin() + 3, spans.begin() + 8) ==
+            std::vector<std::string>{"dispatch:fail", "handler:fail", "failed", "failed", "send:response"});
+    REQUIRE(spans.back() == "send:echo");
+
+    SECTION("Without a registry nothing is recorded") {
+        ep.set_metrics(nullptr);
+        spans.clear();
+        ep.receive(make_request("4", "echo", json::object()));
+        REQUIRE(spans.empty());
+        REQUIRE(calls.value() == 2);
+        REQUIRE(metrics->prometheus().find("mcp_pending_requests") == std::string::npos);
+    }
+}
+
 TEST_CASE("Endpoint initialization protocol", "[jsonrpc][endpoint]") {
     std::vector<json> sent_messages;
     endpoint ep([&sent_messages](const json& msg) {
@@ -566,6 +1085,200 @@ TEST_CASE("rpc_exception handling", "[jsonrpc][exception]") {
 
 // ==================== Edge Cases ====================
 
+TEST_CASE("Encoded results", "[jsonrpc][encoding]") {
+    auto encode = [](const json& value) {
+        std::string text = value.dump();
+        return encoded(encoded_buffer(text.begin(), text.end()));
+    };
+    json result = {{"content", json::array({{{"type", "text"}, {"text", "hi"}}})}};
+
+    SECTION("dump_into writes the bytes in place of the result") {
+        json plain = make_result("req-1", result);
+        json pre = make_result("req-1", encode(result));
+        REQUIRE(is_encoded(pre["result"]));
+        std::string out;
+        dump_into(pre, out);
+        REQUIRE(out == plain.dump());
+    }
+
+    SECTION("Batches mix encoded and ordinary responses") {
+        json batch = json::array({make_result(1, encode(result)), make_error(2, method_not_found), make_result(3, 7)});
+        json expected = json::array({make_result(1, result), make_error(2, method_not_found), make_result(3, 7)});
+        std::string out;
+        dump_into(batch, out);
+        REQUIRE(out == expected.dump());
+    }
+
+    SECTION("expand_encoded restores the tree") {
+        json batch = json::array({make_result(1, encode(result)), make_result(2, "plain")});
+        expand_encoded(batch);
+        REQUIRE(batch[0]["result"] == result);
+        REQUIRE(batch[1]["result"] == "plain");
+    }
+
+    SECTION("Ordinary binary values are not mistaken for encoded ones") {
+        REQUIRE_FALSE(is_encoded(json::binary({1, 2, 3})));
+        REQUIRE_FALSE(is_encoded(json::binary({1, 2, 3}, 7)));
+    }
+
+    SECTION("append_string escapes like dump()") {
+        for (std::string text : {std::string("plain"), std::string("q\"b\\s/\b\f\n\r\t"),
+                                 std::string("\x01\x1f\x7f"), std::string("\u00e9\u65e5\U0001F600"), std::string()}) {
+            encoded_buffer out;
+            append_string(out, text);
+            REQUIRE(std::string(out.begin(), out.end()) == json(text).dump());
+        }
+    }
+}
+
+TEST_CASE("Envelope scanning", "[jsonrpc][envelope]") {
+    SECTION("Members are found with their raw text") {
+        std::string text = R"( { "jsonrpc" : "2.0", "id":17, "method":"tools/call",
+            "params":{"name":"x","arguments":{"s":"a\"}b","list":[1,{"k":"]"}]}}, "extra":null } )";
+        auto e = scan_envelope(text);
+        REQUIRE(e.has_value());
+        REQUIRE(e->jsonrpc == "\"2.0\"");
+        REQUIRE(e->id == "17");
+        REQUIRE(e->method_name() == "tools/call");
+        REQUIRE(json::parse(e->params) == json::parse(text)["params"]);
+        REQUIRE(e->result.empty());
+        REQUIRE(is_request(*e));
+        REQUIRE_FALSE(is_notification(*e));
+        REQUIRE(validate_request(*e));
+    }
+
+    SECTION("Long strings with escapes at every offset") {
+        for (size_t at = 0; at < 40; ++at) {
+            std::string payload(48, 'p');
+            payload.insert(at, "\\\"");
+            json msg = make_result("req-9", json{{"text", payload + std::string(at, 'q')}});
+            std::string text = msg.dump();
+            auto e = scan_envelope(text);
+            REQUIRE(e.has_value());
+            REQUIRE(is_response(*e));
+            REQUIRE(json::parse(e->result) == msg["result"]);
+        }
+    }
+
+    SECTION("Checks agree with the json versions") {
+        std::vector<json> messages = {
+            make_request(1, "m", json::object()),
+            make_request("a", "m", json::array()),
+            make_notification("n"),
+            json{{"jsonrpc", "2.0"}, {"method", "m"}, {"params", 3}},
+            json{{"jsonrpc", "1.0"}, {"method", "m"}},
+            json{{"jsonrpc", "2.0"}, {"id", 1.5}, {"method", "m"}},
+            json{{"jsonrpc", "2.0"}, {"id", json::object()}, {"method", "m"}},
+            json{{"jsonrpc", "2.0"}, {"method", 4}},
+            make_result(3, "ok"),
+            make_error(4, method_not_found),
+            json{{"jsonrpc", "2.0"}, {"id", 5}, {"result", 1}, {"error", 2}},
+            json::object()
+        };
+        for (const auto& msg : messages) {
+            std::string text = msg.dump(); // the envelope views this text
+            auto e = scan_envelope(text);
+            REQUIRE(e.has_value());
+            REQUIRE(validate_request(*e) == validate_request(msg));
+            REQUIRE(is_response(*e) == is_response(msg));
+            REQUIRE(is_notification(*e) == is_notification(msg));
+        }
+    }
+
+    SECTION("Anything else is left to the full parser") {
+        REQUIRE_FALSE(scan_envelope(R"([{"jsonrpc":"2.0","method":"m"}])").has_value());
+        REQUIRE_FALSE(scan_envelope(R"({"jsonrpc":"2.0","method":"m")").has_value());
+        REQUIRE_FALSE(scan_envelope(R"({"jsonrpc":"2.0"} trailing)").has_value());
+        REQUIRE_FALSE(scan_envelope(R"({"json\u0072pc":"2.0"})").has_value());
+        REQUIRE_FALSE(scan_envelope(R"({"s":"unterminated})").has_value());
+        REQUIRE_FALSE(scan_envelope("42").has_value());
+        REQUIRE(scan_envelope(" {} ").has_value());
+    }
+}
+
+TEST_CASE("Endpoint envelope filter", "[jsonrpc][endpoint][envelope]") {
+    endpoint ep([](const json&) {});
+    ep.add("known", [](const json&) -> json { return nullptr; });
+    auto accepts = [&](const json& msg) {
+        std::string text = msg.dump();
+        return ep.accepts(*scan_envelope(text));
+    };
+
+    SECTION("Notifications need a handler") {
+        REQUIRE(accepts(make_notification("known")));
+        REQUIRE(accepts(make_notification("$/cancelRequest", json{{"id", 1}})));
+        REQUIRE_FALSE(accepts(make_notification("unknown")));
+    }
+
+    SECTION("Requests are always taken, so unknown methods still get an error") {
+        REQUIRE(accepts(make_request(1, "unknown")));
+    }
+
+    SECTION("Responses need a pending request") {
+        std::string id = ep.send_request("remote", json::object(), [](const json&) {}, [](const json&) {});
+        REQUIRE(accepts(make_result(id, "ok")));
+        REQUIRE_FALSE(accepts(make_result("req-999999", "late")));
+        REQUIRE_FALSE(accepts(make_result("named", "late")));
+        REQUIRE(accepts(make_result(7, "numeric ids are checked after parsing")));
+        ep.receive(make_result(id, "ok"));
+        REQUIRE_FALSE(accepts(make_result(id, "again")));
+    }
+}
+
+TEST_CASE("Progress throttle", "[jsonrpc][endpoint][progress]") {
+    std::vector<json> sent;
+    endpoint ep([&](const json& msg) { sent.push_back(msg); });
+    ep.add("work", [](const json& params) -> json {
+        for (const auto& value : params["reports"]) report_progress(value);
+        return "done";
+    });
+    auto run = [&](json reports) {
+        sent.clear();
+        ep.receive(make_request(1, "work", json{{"progressToken", "p"}, {"reports", std::move(reports)}}));
+        std::vector<json> values;
+        for (const auto& msg : sent) {
+            if (msg.value("method", "") == "$/progress") values.push_back(msg["params"]["value"]);
+        }
+        REQUIRE(sent.back()["result"] == "done");
+        return values;
+    };
+    json tenths = json::array();
+    for (int i = 1; i <= 10; ++i) tenths.push_back(json{{"progress", i / 10.0}});
+
+    SECTION("No limits sends every report") {
+        REQUIRE(run(tenths).size() == 10);
+    }
+
+    SECTION("The interval keeps the first and final reports") {
+        ep.set_progress_throttle({std::chrono::hours(1), 0.0});
+        REQUIRE(run(tenths) == std::vector<json>{tenths[0], tenths[9]});
+    }
+
+    SECTION("The minimum delta skips small steps") {
+        ep.set_progress_throttle({std::chrono::milliseconds(0), 0.25});
+        REQUIRE(run(tenths) == std::vector<json>{tenths[0], tenths[3], tenths[6], tenths[9]});
+        REQUIRE(run(json::array({0.5, 0.6, 0.7})) == std::vector<json>{0.5, 0.7});
+    }
+
+    SECTION("The last held-back report is sent before the response") {
+        ep.set_progress_throttle({std::chrono::hours(1), 0.0});
+        auto values = run(json::array({json{{"items", 1}}, json{{"items", 2}}, json{{"items", 3}}}));
+        REQUIRE(values == std::vector<json>{json{{"items", 1}}, json{{"items", 3}}});
+        REQUIRE(sent.size() == 3);
+    }
+
+    SECTION("Partial results are not throttled") {
+        ep.set_progress_throttle({std::chrono::hours(1), 1.0});
+        ep.add("stream", [](const json&) -> json {
+            for (int i = 0; i < 5; ++i) report_partial_result(i);
+            return nullptr;
+        });
+        sent.clear();
+        ep.receive(make_request(2, "stream", json{{"partialResultToken", "r"}}));
+        REQUIRE(sent.size() == 6);
+    }
+}
+
 TEST_CASE("Edge cases and special scenarios", "[jsonrpc][edge_cases]") {
     SECTION("Null id in request") {
         auto req = make_request(nullptr, "test_method");
@@ -407,3 +407,78 @@ TEST_CASE("Edge cases and error handling", "[protocol][edge_cases]") {
         REQUIRE(j["uri"] == "file:///path%20with%20spaces/file.txt");
     }
 }
+
+TEST_CASE("Direct writers match to_json", "[protocol][encoding]") {
+    auto written = [](const auto& value) {
+        jsonrpc::encoded_buffer out;
+        value.write_json(out);
+        return std::string(out.begin(), out.end());
+    };
+
+    SECTION("ToolResultContent") {
+        auto text = ToolResultContent::text_content("line 1\nline \"2\"\t\x01 \u00e9\u65e5");
+        REQUIRE(written(text) == text.to_json().dump());
+        ToolResultContent full{"resource", "t", "ZGF0YQ==", "text/plain", "file:///a b"};
+        REQUIRE(written(full) == full.to_json().dump());
+        ToolResultContent image{"image", std::nullopt, "iVBORw0KGgo=", "image/png", std::nullopt};
+        REQUIRE(written(image) == image.to_json().dump());
+    }
+
+    SECTION("PromptMessage") {
+        PromptMessage message{MessageRole::Assistant, {
+            MessageContent{"text", "Hello \\ world", std::nullopt, std::nullopt},
+            MessageContent{"image", std::nullopt, "AAAA", "image/png"}
+        }};
+        REQUIRE(written(message) == message.to_json().dump());
+        PromptMessage empty{MessageRole::User, {}};
+        REQUIRE(written(empty) == empty.to_json().dump());
+    }
+
+    SECTION("ResourceContent") {
+        ResourceContent text{"file:///notes.md", "text/markdown", "# Title\r\n", std::nullopt};
+        REQUIRE(written(text) == text.to_json().dump());
+        ResourceContent blob{"file:///bin", std::nullopt, std::nullopt, "AQID"};
+        REQUIRE(written(blob) == blob.to_json().dump());
+    }
+
+    SECTION("ResourceContentWriter matches write_json, however the data is split") {
+        const std::string text = "caf\u00e9 \"\u65e5\u672c\"\n\t\x01 end";
+        std::string bytes;
+        for (int i = 0; i < 40; ++i) bytes.push_back(static_cast<char>(i * 37));
+        ResourceContent as_text{"file:///t.txt", "text/plain", text, std::nullopt};
+        ResourceContent as_blob{"file:///b.bin", "application/octet-stream", std::nullopt, std::nullopt, bytes};
+        ResourceContent bare_blob{"file:///b", std::nullopt, std::nullopt, std::nullopt, bytes};
+
+        auto pieces = [](const ResourceContent& content, std::string_view data, bool blob, std::vector<size_t> cuts) {
+            jsonrpc::encoded_buffer out;
+            std::optional<std::string_view> mime;
+            if (content.mime_type) mime = *content.mime_type;
+            ResourceContentWriter writer(out, content.uri, mime, blob);
+            size_t at = 0;
+            for (size_t cut : cuts) {
+                writer.append(data.substr(at, cut - at));
+                at = cut;
+            }
+            writer.append(data.substr(at));
+            writer.finish();
+            return std::string(out.begin(), out.end());
+        };
+
+        // Text pieces end on character boundaries
+        REQUIRE(pieces(as_text, text, false, {}) == written(as_text));
+        REQUIRE(pieces(as_text, text, false, {3, 5, 7, 10, 13}) == written(as_text));
+        for (size_t a = 0; a <= bytes.size(); ++a) {
+            for (size_t b = a; b <= bytes.size(); b += 7) {
+                REQUIRE(pieces(as_blob, bytes, true, {a, b}) == written(as_blob));
+            }
+        }
+        REQUIRE(pieces(bare_blob, bytes, true, {1, 2, 4}) == written(bare_blob));
+        REQUIRE(pieces(bare_blob, "", true, {}) == written(ResourceContent{"file:///b", std::nullopt, std::nullopt, std::nullopt, std::string()}));
+    }
+
+    SECTION("Invalid UTF-8 is rejected like dump()") {
+        auto bad = ToolResultContent::text_content(std::string("ok \xC3\x28"));
+        REQUIRE_THROWS_AS(bad.to_json().dump(), json::type_error);
+        REQUIRE_THROWS_AS(written(bad), json::type_error);
+    }
+}
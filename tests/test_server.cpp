@@ -1,8 +1,15 @@
 #include <catch_amalgamated.hpp>
 #include <mcp/server.hpp>
+#include <mcp/server_streaming.hpp>
+#include <mcp/helpers/file_resource_server.hpp>
 #include <mcp/transport/transport.hpp>
 #include <thread>
 #include <chrono>
+#include <mutex>
+#include <map>
+#include <fstream>
+#include <filesystem>
+#include <ranges>
 
 using namespace pooriayousefi::mcp;
 using json = nlohmann::json;
@@ -185,8 +192,446 @@ TEST_CASE("Tool execution", "[server][tools][execution]") {
     server_transport->close();
 }
 
+TEST_CASE("Server tool metrics", "[server][tools][metrics]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools();
+    server.register_tool(Tool{"check", "Fails on demand", ToolInputSchema{}}, [](const json& args) {
+        if (args.value("fail", false)) throw std::runtime_error("check failed");
+        return std::vector<ToolResultContent>{ToolResultContent{"text", "ok", std::nullopt, std::nullopt, std::nullopt}};
+    });
+    auto metrics = std::make_shared<pooriayousefi::core::Metrics>();
+    server.set_metrics(metrics, "memory");
+
+    std::atomic<int> responses{0};
+    client_transport->on_message([&](const json& msg) { if (msg.contains("id")) ++responses; });
+    client_transport->start();
+    server.start();
+
+    client_transport->send(json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "initialize"}, {"params", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}}}});
+    REQUIRE(wait_for([&]() { return responses == 1; }, 3000));
+    client_transport->send(json{{"jsonrpc", "2.0"}, {"id", 2}, {"method", "tools/call"}, {"params", {{"name", "check"}, {"arguments", json::object()}}}});
+    client_transport->send(json{{"jsonrpc", "2.0"}, {"id", 3}, {"method", "tools/call"}, {"params", {{"name", "check"}, {"arguments", {{"fail", true}}}}}});
+    REQUIRE(wait_for([&]() { return responses == 3; }, 3000));
+
+    REQUIRE(metrics->counter("mcp_tool_calls_total", "", "tool", "check").value() == 2);
+    REQUIRE(metrics->counter("mcp_tool_errors_total", "", "tool", "check").value() == 1);
+    REQUIRE(metrics->histogram("mcp_tool_duration_seconds", "", "tool", "check").snapshot().count == 2);
+    REQUIRE(metrics->counter("mcp_method_calls_total", "", "method", "tools/call").value() == 2);
+    REQUIRE(metrics->counter("mcp_transport_received_messages_total", "", "transport", "memory").value() == 3);
+
+    const std::string text = metrics->prometheus();
+    REQUIRE(text.find("mcp_tool_calls_total{tool=\"check\"} 2\n") != std::string::npos);
+    REQUIRE(text.find("mcp_tool_duration_seconds_count{tool=\"check\"} 2\n") != std::string::npos);
+
+    client_transport->close();
+    server_transport->close();
+}
+
+TEST_CASE("Server result cache", "[server][tools][cache]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools();
+    server.enable_resources();
+    server.enable_result_cache();
+
+    std::atomic<int> lookups{0};
+    std::atomic<int> clocks{0};
+    std::atomic<int> reads{0};
+    auto text = [](std::string value) {
+        return std::vector<ToolResultContent>{ToolResultContent{"text", std::move(value), std::nullopt, std::nullopt, std::nullopt}};
+    };
+    server.register_tool(Tool{"lookup", "Deterministic", ToolInputSchema{}}, [&](const json& args) {
+        ++lookups;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        if (args.value("fail", false)) throw std::runtime_error("lookup failed");
+        return text(args.dump());
+    }, CachePolicy{});
+    server.register_tool(Tool{"clock", "Not cacheable", ToolInputSchema{}}, [&](const json&) {
+        return text(std::to_string(++clocks));
+    });
+    server.register_resource(Resource{"mem://doc", "doc", "Immutable", "text/plain"}, [&](const std::string& uri) {
+        ++reads;
+        return std::vector<ResourceContent>{ResourceContent{uri, "text/plain", "contents", std::nullopt}};
+    }, CachePolicy{std::chrono::milliseconds(100)});
+
+    std::mutex mutex;
+    std::map<int, json> responses;
+    client_transport->on_message([&](const json& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (msg.contains("id")) responses[msg["id"].get<int>()] = msg;
+    });
+    client_transport->start();
+    server.start();
+
+    std::atomic<int> next_id{0};
+    auto send = [&](const std::string& method, json params) {
+        int id = ++next_id;
+        client_transport->send(json{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", std::move(params)}});
+        return id;
+    };
+    auto response = [&](int id) {
+        json out;
+        REQUIRE(wait_for([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = responses.find(id);
+            if (it == responses.end()) return false;
+            out = it->second;
+            return true;
+        }, 3000));
+        return out;
+    };
+    response(send("initialize", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}}));
+
+    SECTION("Identical calls run the handler once, whatever the key order") {
+        auto first = response(send("tools/call", {{"name", "lookup"}, {"arguments", {{"a", 1}, {"b", 2}}}}));
+        auto second = response(send("tools/call", {{"name", "lookup"}, {"arguments", json::parse(R"({"b":2,"a":1})")}}));
+        REQUIRE(first["result"] == second["result"]);
+        REQUIRE(lookups == 1);
+        response(send("tools/call", {{"name", "lookup"}, {"arguments", {{"a", 2}}}}));
+        REQUIRE(lookups == 2);
+        REQUIRE(server.result_cache_stats().hits == 1);
+
+        // Tools without a policy always run
+        response(send("tools/call", {{"name", "clock"}, {"arguments", json::object()}}));
+        response(send("tools/call", {{"name", "clock"}, {"arguments", json::object()}}));
+        REQUIRE(clocks == 2);
+    }
+
+    SECTION("Concurrent identical calls are coalesced") {
+        auto pool = std::make_shared<pooriayousefi::core::ThreadPool>(4);
+        server.set_executor(pool);
+        std::vector<int> ids;
+        for (int i = 0; i < 8; ++i) ids.push_back(send("tools/call", {{"name", "lookup"}, {"arguments", {{"q", "same"}}}}));
+        for (int id : ids) REQUIRE(response(id)["result"]["content"][0]["text"] == R"({"q":"same"})");
+        REQUIRE(lookups == 1);
+        REQUIRE(server.result_cache_stats().coalesced + server.result_cache_stats().hits == 7);
+        server.set_executor(nullptr);
+    }
+
+    SECTION("Failures are not cached") {
+        REQUIRE(response(send("tools/call", {{"name", "lookup"}, {"arguments", {{"fail", true}}}})).contains("error"));
+        REQUIRE(response(send("tools/call", {{"name", "lookup"}, {"arguments", {{"fail", true}}}})).contains("error"));
+        REQUIRE(lookups == 2);
+    }
+
+    SECTION("List changes and re-registration invalidate") {
+        response(send("tools/call", {{"name", "lookup"}, {"arguments", json::object()}}));
+        server.notify_tools_changed();
+        response(send("tools/call", {{"name", "lookup"}, {"arguments", json::object()}}));
+        REQUIRE(lookups == 2);
+
+        response(send("resources/read", {{"uri", "mem://doc"}}));
+        server.register_tool(Tool{"other", "", ToolInputSchema{}}, [&](const json&) { return text(""); });
+        response(send("tools/call", {{"name", "lookup"}, {"arguments", json::object()}}));
+        response(send("resources/read", {{"uri", "mem://doc"}}));
+        REQUIRE(lookups == 2);
+        REQUIRE(reads == 1);
+        server.notify_resources_changed();
+        response(send("resources/read", {{"uri", "mem://doc"}}));
+        REQUIRE(reads == 2);
+    }
+
+    SECTION("Entries expire after their TTL") {
+        REQUIRE(response(send("resources/read", {{"uri", "mem://doc"}}))["result"]["contents"][0]["text"] == "contents");
+        response(send("resources/read", {{"uri", "mem://doc"}}));
+        REQUIRE(reads == 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        response(send("resources/read", {{"uri", "mem://doc"}}));
+        REQUIRE(reads == 2);
+    }
+
+    SECTION("The byte budget evicts least recently used results") {
+        server.enable_result_cache(2000);
+        response(send("tools/call", {{"name", "lookup"}, {"arguments", {{"pad", std::string(600, 'a')}}}}));
+        response(send("tools/call", {{"name", "lookup"}, {"arguments", {{"pad", std::string(600, 'b')}}}}));
+        REQUIRE(server.result_cache_stats().bytes <= 2000);
+        REQUIRE(server.result_cache_stats().evictions >= 1);
+        response(send("tools/call", {{"name", "lookup"}, {"arguments", {{"pad", std::string(600, 'b')}}}}));
+        REQUIRE(lookups == 2);
+        response(send("tools/call", {{"name", "lookup"}, {"arguments", {{"pad", std::string(600, 'a')}}}}));
+        REQUIRE(lookups == 3);
+    }
+
+    server.close();
+    client_transport->close();
+}
+
+TEST_CASE("StreamingServer incremental delivery", "[server][tools][streaming]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+    Implementation server_impl{"test-server", "1.0.0"};
+    StreamingServer server(server_transport, server_impl);
+    server.enable_tools();
+
+    std::atomic<bool> release{false};
+    Tool count_tool{"count", "Counts to three", ToolInputSchema{}};
+    server.register_streaming_tool(count_tool, [&release](const json&) -> Generator<ToolResultContent> {
+        co_yield ToolResultContent::text_content("one");
+        // Hold the rest back so the test can see the first chunk arrive on its own
+        wait_for([&]() { return release.load(); }, 2000);
+        co_yield ToolResultContent::text_content("two");
+        co_yield ToolResultContent::text_content("three");
+    });
+
+    std::mutex mutex;
+    std::vector<json> received;
+    client_transport->on_message([&](const json& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(msg);
+    });
+    auto count_received = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return received.size();
+    };
+
+    client_transport->start();
+    server.start();
+    client_transport->send(json{
+        {"jsonrpc", "2.0"}, {"id", 1}, {"method", "initialize"},
+        {"params", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}}}
+    });
+    REQUIRE(wait_for([&]() { return count_received() == 1; }));
+
+    SECTION("Chunks go out as partial results on the caller's token") {
+        client_transport->send(json{
+            {"jsonrpc", "2.0"}, {"id", 2}, {"method", "tools/call"},
+            {"params", {{"name", "count"}, {"arguments", json::object()}, {"partialResultToken", "p-1"}}}
+        });
+
+        // The first chunk is delivered while the tool is still running
+        REQUIRE(wait_for([&]() { return count_received() == 2; }));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            REQUIRE(received[1]["method"] == "$/progress");
+            REQUIRE(received[1]["params"]["token"] == "p-1");
+            REQUIRE(received[1]["params"]["value"]["content"][0]["text"] == "one");
+        }
+
+        release = true;
+        REQUIRE(wait_for([&]() { return count_received() == 5; }));
+        std::lock_guard<std::mutex> lock(mutex);
+        REQUIRE(received[2]["params"]["value"]["content"][0]["text"] == "two");
+        REQUIRE(received[3]["params"]["value"]["content"][0]["text"] == "three");
+        REQUIRE(received[4]["id"] == 2);
+        REQUIRE(received[4]["result"]["content"].empty());
+    }
+
+    SECTION("Without a token the chunks are collected into the result") {
+        release = true;
+        client_transport->send(json{
+            {"jsonrpc", "2.0"}, {"id", 2}, {"method", "tools/call"},
+            {"params", {{"name", "count"}, {"arguments", json::object()}}}
+        });
+
+        REQUIRE(wait_for([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return !received.empty() && received.back().contains("id") && received.back()["id"] == 2;
+        }));
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& content = received.back()["result"]["content"];
+        REQUIRE(content.size() == 3);
+        REQUIRE(content[2]["text"] == "three");
+    }
+
+    SECTION("Generator lvalue helpers") {
+        json items = json::array({1, 2, 3});
+        std::vector<int> seen;
+        for (const auto& item : filter_generator(stream_json_array(items), [](const json& v) { return v.get<int>() != 2; })) {
+            seen.push_back(item.get<int>());
+        }
+        REQUIRE(seen == std::vector<int>{1, 3});
+    }
+
+    SECTION("A throwing generator fails the call instead of the process") {
+        Tool broken_tool{"broken", "Fails midway", ToolInputSchema{}};
+        server.register_streaming_tool(broken_tool, [](const json&) -> Generator<ToolResultContent> {
+            co_yield ToolResultContent::text_content("partial");
+            throw std::runtime_error("disk on fire");
+        });
+        client_transport->send(json{
+            {"jsonrpc", "2.0"}, {"id", 3}, {"method", "tools/call"},
+            {"params", {{"name", "broken"}, {"arguments", json::object()}}}
+        });
+
+        REQUIRE(wait_for([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return !received.empty() && received.back().contains("id") && received.back()["id"] == 3;
+        }));
+        std::lock_guard<std::mutex> lock(mutex);
+        REQUIRE(received.back().contains("error"));
+        REQUIRE(received.back()["error"]["message"].get<std::string>().find("disk on fire") != std::string::npos);
+    }
+
+    release = true;
+    client_transport->close();
+    server_transport->close();
+}
+
+namespace {
+    struct CopyCounter {
+        static inline int copies = 0;
+        int value = 0;
+        CopyCounter() = default;
+        explicit CopyCounter(int v) : value(v) {}
+        CopyCounter(const CopyCounter& other) : value(other.value) { ++copies; }
+        CopyCounter& operator=(const CopyCounter& other) { value = other.value; ++copies; return *this; }
+        CopyCounter(CopyCounter&&) = default;
+        CopyCounter& operator=(CopyCounter&&) = default;
+    };
+
+    Generator<CopyCounter> count_up(int n) {
+        CopyCounter current;
+        for (int i = 0; i < n; ++i) {
+            current.value = i;
+            co_yield current;
+        }
+    }
+}
+
+TEST_CASE("Generator yields by reference from pooled frames", "[server][streaming][generator]") {
+    SECTION("Lvalues, temporaries and filters are not copied") {
+        CopyCounter::copies = 0;
+        int sum = 0;
+        for (const auto& item : filter_generator(count_up(10), [](const CopyCounter& c) { return c.value % 2 == 0; })) {
+            sum += item.value;
+        }
+        REQUIRE(sum == 0 + 2 + 4 + 6 + 8);
+
+        auto doubled = transform_generator<CopyCounter, CopyCounter>(count_up(3), [](const CopyCounter& c) {
+            return CopyCounter(c.value * 2);
+        });
+        std::vector<int> values;
+        for (auto& item : doubled) values.push_back(item.value);
+        REQUIRE(values == std::vector<int>{0, 2, 4});
+        REQUIRE(CopyCounter::copies == 0);
+    }
+
+    SECTION("Const lvalues are copied once each") {
+        CopyCounter::copies = 0;
+        auto constant = []() -> Generator<CopyCounter> {
+            const CopyCounter fixed(7);
+            co_yield fixed;
+            co_yield fixed;
+        };
+        int total = 0;
+        for (const auto& item : constant()) total += item.value;
+        REQUIRE(total == 14);
+        REQUIRE(CopyCounter::copies == 2);
+    }
+
+    SECTION("There is no value before the first next() or after the last") {
+        auto numbers = count_up(2);
+        REQUIRE_THROWS_AS(numbers.get_value(), std::out_of_range);
+        REQUIRE(numbers.next());
+        REQUIRE(numbers.get_value().value == 0);
+        REQUIRE(numbers.get_next_value().value == 1);
+        REQUIRE_FALSE(numbers.next());
+        REQUIRE_THROWS_AS(numbers.get_value(), std::out_of_range);
+        REQUIRE_THROWS_AS(numbers.get_next_value(), std::out_of_range);
+
+        auto empty = count_up(0);
+        auto it = empty.begin();
+        REQUIRE(it == empty.end());
+        REQUIRE_THROWS_AS(*it, std::out_of_range);
+    }
+
+    SECTION("Frames are recycled by the thread's pool") {
+        void* first = pooriayousefi::core::FramePool::allocate(200);
+        pooriayousefi::core::FramePool::deallocate(first, 200);
+        void* second = pooriayousefi::core::FramePool::allocate(250); // same 256-byte class
+        REQUIRE(second == first);
+        pooriayousefi::core::FramePool::deallocate(second, 250);
+
+        void* large = pooriayousefi::core::FramePool::allocate(1 << 20);
+        REQUIRE(large != nullptr);
+        pooriayousefi::core::FramePool::deallocate(large, 1 << 20);
+    }
+}
+
 // ==================== Prompt Registration Tests ====================
 
+// Serializes like the byte-stream transports, so the server may hand it encoded results
+class EncodingTransport : public transport::Transport {
+public:
+    using Transport::send;
+    bool accepts_encoded() const override { return true; }
+    void send(const json& message) override {
+        std::string line;
+        jsonrpc::dump_into(message, line);
+        std::lock_guard<std::mutex> lock(mutex_);
+        lines_.push_back(std::move(line));
+        last_encoded_ = message.contains("result") && jsonrpc::is_encoded(message["result"]);
+    }
+    void start() override { open_ = true; }
+    void close() override { open_ = false; }
+    bool is_open() const override { return open_; }
+
+    void inject(json message) { emit_message(std::move(message)); }
+    json last() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lines_.empty() ? json() : json::parse(lines_.back());
+    }
+    // Whether the last result was handed over as pre-encoded bytes
+    bool last_encoded() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return last_encoded_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> lines_;
+    bool last_encoded_ = false;
+    std::atomic<bool> open_{false};
+};
+
+TEST_CASE("Server encoded results", "[server][encoding]") {
+    auto wire = std::make_shared<EncodingTransport>();
+    Server server(wire, Implementation{"test-server", "1.0.0"});
+    server.enable_tools();
+    server.enable_prompts();
+    server.enable_resources();
+
+    std::vector<ToolResultContent> tool_result{
+        ToolResultContent::text_content("first \"quoted\""),
+        ToolResultContent{"image", std::nullopt, "iVBORw0KGgo=", "image/png", std::nullopt}
+    };
+    server.register_tool(Tool{"pair", "Two items", ToolInputSchema{}}, [&](const json&) { return tool_result; });
+    std::vector<PromptMessage> prompt_result{
+        PromptMessage{MessageRole::User, {MessageContent{"text", "Hi\n", std::nullopt, std::nullopt}}}
+    };
+    server.register_prompt(Prompt{"greet", "Greets", {}}, [&](const std::map<std::string, std::string>&) { return prompt_result; });
+    std::vector<ResourceContent> resource_result{ResourceContent{"mem://a", "text/plain", "alpha", std::nullopt}};
+    server.register_resource(Resource{"mem://a", "a", std::nullopt, "text/plain"}, [&](const std::string&) { return resource_result; });
+
+    server.start();
+    wire->inject(jsonrpc::make_request(1, "initialize", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}}));
+    REQUIRE(wire->last()["id"] == 1);
+
+    auto as_array = [](const auto& items) {
+        json array = json::array();
+        for (const auto& item : items) array.push_back(item.to_json());
+        return array;
+    };
+
+    wire->inject(jsonrpc::make_request(2, "tools/call", {{"name", "pair"}, {"arguments", json::object()}}));
+    json response = wire->last();
+    REQUIRE(response["id"] == 2);
+    REQUIRE(response["result"] == json{{"content", as_array(tool_result)}});
+
+    wire->inject(jsonrpc::make_request(3, "prompts/get", {{"name", "greet"}}));
+    REQUIRE(wire->last()["result"] == json{{"messages", as_array(prompt_result)}});
+
+    wire->inject(jsonrpc::make_request(4, "resources/read", {{"uri", "mem://a"}}));
+    REQUIRE(wire->last()["result"] == json{{"contents", as_array(resource_result)}});
+
+    wire->inject(jsonrpc::make_request(5, "tools/call", {{"name", "missing"}}));
+    REQUIRE(wire->last()["error"]["code"] == -32601);
+
+    server.close();
+}
+
 TEST_CASE("Prompt registration and listing", "[server][prompts]") {
     auto [client_transport, server_transport] = transport::create_in_memory_pair();
     Implementation server_impl{"test-server", "1.0.0"};
@@ -247,6 +692,507 @@ TEST_CASE("Resource registration and reading", "[server][resources]") {
 
 // ==================== Initialize Handshake Tests ====================
 
+TEST_CASE("FileResourceServer mapped range reads", "[server][resources][files]") {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / ("mcp_files_" + std::to_string(::getpid()));
+    fs::create_directories(root / "sub");
+    std::string big;
+    for (int i = 0; i < 3000; ++i) big += "abcdefghij";
+    std::string accents;
+    for (int i = 0; i < 10; ++i) accents += "\xC3\xA9"; // U+00E9, two bytes each
+    std::string image;
+    for (int i = 0; i < 5000; ++i) image.push_back(static_cast<char>((i * 131) & 0xFF)); // not UTF-8
+    std::ofstream(root / "sub" / "big.txt", std::ios::binary) << big;
+    std::ofstream(root / "accents.txt", std::ios::binary) << accents;
+    std::ofstream(root / "empty.txt", std::ios::binary);
+    std::ofstream(root / "image.png", std::ios::binary) << image;
+
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_resources();
+    helpers::FileResourceServer files(server, root.string());
+    files.set_read_window(1); // one page per window, so big.txt spans several
+
+    std::mutex mutex;
+    std::vector<json> received;
+    client_transport->on_message([&](const json& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(msg);
+    });
+    client_transport->start();
+    server.start();
+
+    int next_id = 0;
+    auto read = [&](json params) {
+        int id = ++next_id;
+        client_transport->send(json{{"jsonrpc", "2.0"}, {"id", id}, {"method", "resources/read"}, {"params", params}});
+        json response;
+        REQUIRE(wait_for([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& msg : received) {
+                if (msg.contains("id") && msg["id"] == id) { response = msg; return true; }
+            }
+            return false;
+        }));
+        return response;
+    };
+
+    SECTION("Whole file across several windows") {
+        auto response = read({{"uri", "file://sub/big.txt"}});
+        REQUIRE(response["result"]["contents"][0]["text"] == big);
+        REQUIRE(response["result"]["contents"][0]["mimeType"] == "text/plain");
+        REQUIRE(response["result"]["range"]["total"] == big.size());
+        REQUIRE(response["result"]["range"]["length"] == big.size());
+    }
+
+    SECTION("offset and length select a slice") {
+        auto response = read({{"uri", "file://sub/big.txt"}, {"offset", 5003}, {"length", 7000}});
+        REQUIRE(response["result"]["contents"][0]["text"] == big.substr(5003, 7000));
+        REQUIRE(response["result"]["range"]["offset"] == 5003);
+    }
+
+    SECTION("range start and end select a slice") {
+        auto response = read({{"uri", "file://sub/big.txt"}, {"range", {{"start", 10}, {"end", 20}}}});
+        REQUIRE(response["result"]["contents"][0]["text"] == "abcdefghij");
+    }
+
+    SECTION("Text ranges snap to UTF-8 boundaries") {
+        auto response = read({{"uri", "file://accents.txt"}, {"offset", 1}, {"length", 4}});
+        REQUIRE(response["result"]["contents"][0]["text"] == "\xC3\xA9");
+        REQUIRE(response["result"]["range"]["offset"] == 2);
+        REQUIRE(response["result"]["range"]["length"] == 2);
+    }
+
+    SECTION("Empty files and ranges at the end") {
+        REQUIRE(read({{"uri", "file://empty.txt"}})["result"]["contents"][0]["text"] == "");
+        REQUIRE(read({{"uri", "file://sub/big.txt"}, {"offset", big.size()}})["result"]["range"]["length"] == 0);
+        REQUIRE(read({{"uri", "file://sub/big.txt"}, {"offset", big.size() + 1}}).contains("error"));
+        REQUIRE(read({{"uri", "file://sub/big.txt"}, {"offset", -1}})["error"]["code"] == -32602);
+    }
+
+    SECTION("The size cap applies per read, so large files can be paged") {
+        files.set_max_file_size(1000);
+        REQUIRE(read({{"uri", "file://sub/big.txt"}}).contains("error"));
+        REQUIRE(read({{"uri", "file://sub/big.txt"}, {"offset", 0}, {"length", 1000}})["result"]["range"]["length"] == 1000);
+    }
+
+    SECTION("Paths outside the root are rejected") {
+        REQUIRE(read({{"uri", "file://../etc/passwd"}})["error"]["message"] == "Path traversal not allowed");
+        REQUIRE(read({{"uri", "file://sub/../../etc/passwd"}})["error"]["message"] == "Path traversal not allowed");
+    }
+
+    SECTION("Partial results carry one window each") {
+        auto response = read({{"uri", "file://sub/big.txt"}, {"partialResultToken", "f-1"}});
+        REQUIRE(response["result"]["contents"].empty());
+        REQUIRE(response["result"]["range"]["length"] == big.size());
+
+        std::string streamed;
+        size_t chunks = 0;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& msg : received) {
+            if (msg.value("method", "") == "$/progress" && msg["params"]["token"] == "f-1") {
+                streamed += msg["params"]["value"]["contents"][0]["text"].get<std::string>();
+                ++chunks;
+            }
+        }
+        REQUIRE(streamed == big);
+        REQUIRE(chunks > 1);
+    }
+
+    SECTION("Binary files come back as base64 blobs, with exact ranges") {
+        auto content = read({{"uri", "file://image.png"}})["result"]["contents"][0];
+        REQUIRE(content["mimeType"] == "image/png");
+        REQUIRE(content["blob"] == pooriayousefi::core::base64_encode(image));
+        REQUIRE_FALSE(content.contains("text"));
+
+        auto response = read({{"uri", "file://image.png"}, {"offset", 1}, {"length", 4097}});
+        REQUIRE(response["result"]["contents"][0]["blob"] == pooriayousefi::core::base64_encode(image.substr(1, 4097)));
+        REQUIRE(response["result"]["range"]["offset"] == 1);
+        REQUIRE(response["result"]["range"]["length"] == 4097);
+
+        // Each partial result carries its own blob
+        read({{"uri", "file://image.png"}, {"partialResultToken", "f-3"}});
+        std::string streamed;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& msg : received) {
+            if (msg.value("method", "") == "$/progress" && msg["params"]["token"] == "f-3") {
+                streamed += *pooriayousefi::core::base64_decode(msg["params"]["value"]["contents"][0]["blob"].get<std::string>());
+            }
+        }
+        REQUIRE(streamed == image);
+    }
+
+    SECTION("Blobs are raw bytes once the session is binary") {
+        server_transport->set_encoding(transport::Encoding::cbor);
+        auto blob = read({{"uri", "file://image.png"}})["result"]["contents"][0]["blob"];
+        REQUIRE(blob.is_binary());
+        REQUIRE(std::string(blob.get_binary().begin(), blob.get_binary().end()) == image);
+    }
+
+    SECTION("Cached reads follow the file's version") {
+        files.enable_cache();
+        REQUIRE(read({{"uri", "file://accents.txt"}})["result"]["contents"][0]["text"] == accents);
+        REQUIRE(read({{"uri", "file://accents.txt"}})["result"]["contents"][0]["text"] == accents);
+        REQUIRE(files.cache_stats().hits == 1);
+        REQUIRE(files.cache_stats().misses == 1);
+
+        // Another range is another entry
+        read({{"uri", "file://accents.txt"}, {"offset", 2}});
+        REQUIRE(files.cache_stats().misses == 2);
+
+        std::ofstream(root / "accents.txt", std::ios::binary | std::ios::trunc) << "rewritten";
+        REQUIRE(read({{"uri", "file://accents.txt"}})["result"]["contents"][0]["text"] == "rewritten");
+        REQUIRE(files.cache_stats().misses == 3);
+
+        // Partial results are never served from the cache
+        read({{"uri", "file://accents.txt"}, {"partialResultToken", "f-2"}});
+        REQUIRE(files.cache_stats().hits == 1);
+    }
+
+    client_transport->close();
+    server_transport->close();
+    fs::remove_all(root);
+}
+
+TEST_CASE("FileResourceServer encoded reads", "[server][resources][files][encoding]") {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / ("mcp_encoded_files_" + std::to_string(::getpid()));
+    fs::create_directories(root);
+    // Multi-byte characters and escapes straddle the 4096-byte window boundaries
+    std::string text;
+    while (text.size() < 3 * 4096) text += "a\u00e9\"\u65e5\n\t\x01\\\U0001F600";
+    std::string image;
+    for (int i = 0; i < 9000; ++i) image.push_back(static_cast<char>((i * 7) & 0xFF));
+    std::ofstream(root / "notes.txt", std::ios::binary) << text;
+    std::ofstream(root / "image.png", std::ios::binary) << image;
+
+    auto wire = std::make_shared<EncodingTransport>();
+    Server server(wire, Implementation{"test-server", "1.0.0"});
+    server.enable_resources();
+    helpers::FileResourceServer files(server, root.string());
+    files.set_read_window(1);
+    server.start();
+    wire->inject(jsonrpc::make_request(1, "initialize", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}}));
+    REQUIRE(server.encoded_results());
+
+    int next_id = 1;
+    auto read = [&](json params) {
+        wire->inject(jsonrpc::make_request(++next_id, "resources/read", params));
+        json response = wire->last();
+        REQUIRE(response["id"] == next_id);
+        return response["result"];
+    };
+    auto expected = [](const std::string& uri, const char* mime, const char* field, json data, size_t offset, size_t length, size_t total) {
+        return json{
+            {"contents", json::array({json{{"uri", uri}, {"mimeType", mime}, {field, std::move(data)}}})},
+            {"range", {{"offset", offset}, {"length", length}, {"total", total}}}
+        };
+    };
+
+    SECTION("Text is escaped window by window") {
+        REQUIRE(read({{"uri", "file://notes.txt"}}) == expected("file://notes.txt", "text/plain", "text", text, 0, text.size(), text.size()));
+    }
+
+    SECTION("Text ranges snap to characters as in the tree form") {
+        // Starts inside the first U+00E9 and ends inside a later emoji
+        size_t end = text.find("\U0001F600", 4090) + 2;
+        std::string slice = text.substr(3, text.find("\U0001F600", 4090) - 3);
+        REQUIRE(read({{"uri", "file://notes.txt"}, {"offset", 2}, {"length", end - 2}}) ==
+                expected("file://notes.txt", "text/plain", "text", slice, 3, slice.size(), text.size()));
+    }
+
+    SECTION("Blobs are base64-encoded window by window") {
+        REQUIRE(read({{"uri", "file://image.png"}}) ==
+                expected("file://image.png", "image/png", "blob", pooriayousefi::core::base64_encode(image), 0, image.size(), image.size()));
+        REQUIRE(read({{"uri", "file://image.png"}, {"offset", 4095}, {"length", 4099}}) ==
+                expected("file://image.png", "image/png", "blob", pooriayousefi::core::base64_encode(image.substr(4095, 4099)), 4095, 4099, image.size()));
+    }
+
+    SECTION("Cached encoded results are served as they were written") {
+        files.enable_cache();
+        json first = read({{"uri", "file://notes.txt"}});
+        REQUIRE(read({{"uri", "file://notes.txt"}}) == first);
+        REQUIRE(files.cache_stats().hits == 1);
+    }
+
+    SECTION("List pages are cached as encoded bytes") {
+        server.set_page_size(1);
+        std::vector<std::string> uris;
+        json params = json::object();
+        for (int page = 0; page < 3; ++page) {
+            wire->inject(jsonrpc::make_request(++next_id, "resources/list", params));
+            REQUIRE(wire->last_encoded());
+            json result = wire->last()["result"];
+            for (const auto& resource : result["resources"]) uris.push_back(resource["uri"]);
+            if (!result.contains("nextCursor")) break;
+            params = {{"cursor", result["nextCursor"]}};
+        }
+        REQUIRE(uris == std::vector<std::string>{"file://image.png", "file://notes.txt"});
+        // The second walk is served from the cached bytes
+        wire->inject(jsonrpc::make_request(++next_id, "resources/list", json::object()));
+        REQUIRE(wire->last_encoded());
+        REQUIRE(wire->last()["result"]["resources"][0]["mimeType"] == "image/png");
+    }
+
+    server.close();
+    fs::remove_all(root);
+}
+
+TEST_CASE("StreamingFileResourceServer template reads", "[server][resources][files][streaming]") {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / ("mcp_stream_files_" + std::to_string(::getpid()));
+    fs::create_directories(root / "logs");
+    std::string log;
+    for (int i = 0; i < 2000; ++i) log += "line " + std::to_string(i) + " \xE2\x82\xAC\n"; // U+20AC, three bytes
+
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+    Implementation server_impl{"test-server", "1.0.0"};
+    StreamingServer server(server_transport, server_impl);
+    server.enable_resources();
+    helpers::StreamingFileResourceServer files(server, root.string());
+    files.set_chunk_size(1000);
+
+    // Created after construction: resolved when read, not registered up front
+    std::ofstream(root / "logs" / "app.log", std::ios::binary) << log;
+    // Invalid UTF-8 throughout, so it must not go out as text
+    std::string image;
+    for (int i = 0; i < 5000; ++i) image.push_back(static_cast<char>(0x80 | (i * 13 & 0x7F)));
+    std::ofstream(root / "image.png", std::ios::binary) << image;
+
+    std::mutex mutex;
+    std::vector<json> received;
+    client_transport->on_message([&](const json& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(msg);
+    });
+    client_transport->start();
+    server.start();
+
+    int next_id = 0;
+    auto call = [&](const std::string& method, json params) {
+        int id = ++next_id;
+        client_transport->send(json{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", params}});
+        json response;
+        REQUIRE(wait_for([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& msg : received) {
+                if (msg.contains("id") && msg["id"] == id) { response = msg; return true; }
+            }
+            return false;
+        }));
+        return response;
+    };
+    call("initialize", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}});
+
+    SECTION("One template stands for the whole root") {
+        auto templates = call("resources/templates/list", json::object())["result"]["resourceTemplates"];
+        REQUIRE(templates.size() == 1);
+        REQUIRE(templates[0]["uriTemplate"] == "file://{path}");
+        REQUIRE(call("resources/list", json::object())["result"]["resources"].empty());
+    }
+
+    SECTION("Collected chunks are fixed-size and split on character boundaries") {
+        auto contents = call("resources/read", {{"uri", "file://logs/app.log"}})["result"]["contents"];
+        REQUIRE(contents.size() > 1);
+        std::string joined;
+        for (const auto& content : contents) {
+            const auto& text = content["text"].get_ref<const std::string&>();
+            REQUIRE(text.size() <= 1000 + 3);
+            REQUIRE(content["uri"] == "file://logs/app.log");
+            REQUIRE(content["mimeType"] == "text/plain");
+            joined += text;
+        }
+        REQUIRE(joined == log);
+    }
+
+    SECTION("Chunks stream as partial results") {
+        auto response = call("resources/read", {{"uri", "file://logs/app.log"}, {"partialResultToken", "s-1"}});
+        REQUIRE(response["result"]["contents"].empty());
+        std::string streamed;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& msg : received) {
+            if (msg.value("method", "") == "$/progress" && msg["params"]["token"] == "s-1") {
+                streamed += msg["params"]["value"]["contents"][0]["text"].get<std::string>();
+            }
+        }
+        REQUIRE(streamed == log);
+    }
+
+    SECTION("Binary files stream as blob chunks") {
+        auto contents = call("resources/read", {{"uri", "file://image.png"}})["result"]["contents"];
+        REQUIRE(contents.size() == 6);
+        std::string blob;
+        for (const auto& content : contents) {
+            REQUIRE_FALSE(content.contains("text"));
+            REQUIRE(content["mimeType"] == "image/png");
+            blob += content["blob"].get<std::string>();
+        }
+        // 999-byte chunks: whole base64 groups, so the pieces concatenate
+        REQUIRE(blob == pooriayousefi::core::base64_encode(image));
+
+        auto response = call("resources/read", {{"uri", "file://image.png"}, {"partialResultToken", "s-2"}});
+        REQUIRE(response["result"]["contents"].empty());
+        std::string streamed;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& msg : received) {
+            if (msg.value("method", "") == "$/progress" && msg["params"]["token"] == "s-2") {
+                streamed += msg["params"]["value"]["contents"][0]["blob"].get<std::string>();
+            }
+        }
+        REQUIRE(streamed == pooriayousefi::core::base64_encode(image));
+    }
+
+    SECTION("URIs outside the template or the root yield nothing") {
+        REQUIRE(call("resources/read", {{"uri", "file://../etc/passwd"}})["result"]["contents"].empty());
+        REQUIRE(call("resources/read", {{"uri", "file://logs/missing.log"}})["result"]["contents"].empty());
+        REQUIRE(call("resources/read", {{"uri", "http://example.com/x"}})["error"]["code"] == -32601);
+    }
+
+    client_transport->close();
+    server_transport->close();
+    fs::remove_all(root);
+}
+
+TEST_CASE("FileResourceServer watched index", "[server][resources][files]") {
+    namespace fs = std::filesystem;
+    fs::path root = fs::temp_directory_path() / ("mcp_watch_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root / "docs");
+    std::ofstream(root / "docs" / "a.txt") << "a";
+
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_resources(false, true);
+    helpers::FileResourceServer files(server, root.string());
+
+    std::atomic<int> list_changed{0};
+    std::atomic<bool> initialized{false};
+    std::mutex results_mutex;
+    std::map<int, json> results;
+    client_transport->on_message([&](const json& msg) {
+        if (msg.value("method", "") == "notifications/resources/list_changed") ++list_changed;
+        if (msg.contains("result")) {
+            initialized = true;
+            std::lock_guard<std::mutex> lock(results_mutex);
+            results[msg["id"].get<int>()] = msg["result"];
+        }
+    });
+    client_transport->start();
+    server.start();
+    client_transport->send(json{
+        {"jsonrpc", "2.0"}, {"id", 1}, {"method", "initialize"},
+        {"params", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}}}
+    });
+    REQUIRE(wait_for([&]() { return initialized.load(); }));
+
+    auto uris = [&]() {
+        std::vector<std::string> out;
+        auto snapshot = files.snapshot();
+        for (const auto& resource : *snapshot) out.push_back(resource.uri);
+        return out;
+    };
+    REQUIRE(uris() == std::vector<std::string>{"file://docs/a.txt"});
+
+    // resources/list over the wire, one page at a time
+    int next_id = 100;
+    server.set_page_size(2);
+    auto listed = [&]() {
+        std::vector<std::string> out;
+        json params = json::object();
+        for (;;) {
+            const int id = next_id++;
+            client_transport->send(json{{"jsonrpc", "2.0"}, {"id", id}, {"method", "resources/list"}, {"params", params}});
+            REQUIRE(wait_for([&]() {
+                std::lock_guard<std::mutex> lock(results_mutex);
+                return results.contains(id);
+            }));
+            std::lock_guard<std::mutex> lock(results_mutex);
+            const json& result = results[id];
+            for (const auto& resource : result["resources"]) out.push_back(resource["uri"]);
+            if (!result.contains("nextCursor")) return out;
+            params = {{"cursor", result["nextCursor"]}};
+        }
+    };
+    REQUIRE(listed() == uris());
+
+    pooriayousefi::core::DirectoryWatcherOptions options;
+    options.debounce = std::chrono::milliseconds(20);
+    options.poll_interval = std::chrono::milliseconds(50);
+    SECTION("inotify") {}
+    SECTION("polling") { options.force_polling = true; }
+
+    files.watch(options);
+    REQUIRE(files.is_watching());
+    REQUIRE(files.using_inotify() == !options.force_polling);
+    auto before = files.snapshot();
+
+    fs::create_directories(root / "logs" / "2025");
+    std::ofstream(root / "logs" / "2025" / "app.log") << "started";
+    std::ofstream(root / "b.md") << "# b";
+    REQUIRE(wait_for([&]() { return uris().size() == 3; }, 3000));
+    REQUIRE(uris() == std::vector<std::string>{"file://b.md", "file://docs/a.txt", "file://logs/2025/app.log"});
+    REQUIRE(listed() == uris());
+    REQUIRE(wait_for([&]() { return list_changed.load() > 0; }));
+
+    // Snapshots already handed out are immutable
+    REQUIRE(before->size() == 1);
+
+    fs::rename(root / "docs", root / "archive");
+    fs::remove(root / "b.md");
+    REQUIRE(wait_for([&]() {
+        return uris() == std::vector<std::string>{"file://archive/a.txt", "file://logs/2025/app.log"};
+    }, 3000));
+    REQUIRE(listed() == uris());
+
+    files.stop_watching();
+    REQUIRE_FALSE(files.is_watching());
+    client_transport->close();
+    server_transport->close();
+    fs::remove_all(root);
+}
+
+TEST_CASE("DirectoryWatcher stopped from its callback", "[server][resources][files]") {
+    namespace fs = std::filesystem;
+    using pooriayousefi::core::DirectoryWatcher;
+    fs::path root = fs::temp_directory_path() / ("mcp_watch_self_" + std::to_string(::getpid()));
+    fs::remove_all(root);
+    fs::create_directories(root);
+
+    pooriayousefi::core::DirectoryWatcherOptions options;
+    options.debounce = std::chrono::milliseconds(20);
+    options.poll_interval = std::chrono::milliseconds(50);
+    SECTION("inotify") {}
+    SECTION("polling") { options.force_polling = true; }
+
+    std::atomic<int> batches{0};
+    std::atomic<bool> returned{false};
+    std::unique_ptr<DirectoryWatcher> watcher;
+    bool destroy = false;
+    SECTION("stop()") {}
+    SECTION("Destruction") { destroy = true; }
+
+    watcher = std::make_unique<DirectoryWatcher>(root, [&](std::vector<DirectoryWatcher::Event>&&) {
+        ++batches;
+        if (destroy) watcher.reset();
+        else watcher->stop();
+        returned = true;
+    }, options);
+
+    std::ofstream(root / "a.txt") << "a";
+    REQUIRE(wait_for([&]() { return returned.load(); }, 3000));
+    REQUIRE((watcher == nullptr) == destroy);
+
+    // The thread is gone: later changes are not delivered, and destroying the
+    // watcher afterwards neither hangs nor closes anything twice
+    std::ofstream(root / "b.txt") << "b";
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    REQUIRE(batches == 1);
+    watcher.reset();
+    fs::remove_all(root);
+}
+
 TEST_CASE("Server initialize handshake", "[server][initialize]") {
     auto [client_transport, server_transport] = transport::create_in_memory_pair();
     Implementation server_impl{"test-server", "1.0.0"};
@@ -552,6 +1498,276 @@ TEST_CASE("Server list operations", "[server][list]") {
     server_transport->close();
 }
 
+TEST_CASE("Server paginated lists", "[server][list][pagination]") {
+    auto [client_transport, server_transport] = transport::create_in_memory_pair();
+    Implementation server_impl{"test-server", "1.0.0"};
+    Server server(server_transport, server_impl);
+    server.enable_tools();
+    server.set_page_size(2);
+
+    for (const char* name : {"echo", "add", "sum", "diff", "max"}) {
+        server.register_tool(Tool{name, std::nullopt, ToolInputSchema{}}, [](const json&) {
+            return std::vector<ToolResultContent>{};
+        });
+    }
+
+    std::mutex mutex;
+    std::map<int, json> responses;
+    client_transport->on_message([&](const json& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (msg.contains("id")) responses[msg["id"].get<int>()] = msg;
+    });
+    client_transport->start();
+    server.start();
+
+    int next_id = 1;
+    auto call = [&](const std::string& method, json params) {
+        int id = next_id++;
+        client_transport->send(json{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", params}});
+        REQUIRE(wait_for([&]() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return responses.contains(id);
+        }));
+        std::lock_guard<std::mutex> lock(mutex);
+        return responses[id];
+    };
+    call("initialize", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}});
+
+    auto walk = [&]() {
+        std::vector<std::string> names;
+        json params = json::object();
+        int pages = 0;
+        while (true) {
+            json result = call("tools/list", params)["result"];
+            REQUIRE(result["tools"].size() <= 2);
+            for (const auto& tool : result["tools"]) names.push_back(tool["name"]);
+            ++pages;
+            if (!result.contains("nextCursor")) break;
+            params = {{"cursor", result["nextCursor"]}};
+        }
+        return std::make_pair(names, pages);
+    };
+
+    SECTION("Pages follow nextCursor in name order") {
+        auto [names, pages] = walk();
+        REQUIRE(pages == 3);
+        REQUIRE(names == std::vector<std::string>{"add", "diff", "echo", "max", "sum"});
+
+        // Repeated calls return the same cached pages
+        REQUIRE(call("tools/list", json::object())["result"] == call("tools/list", json::object())["result"]);
+    }
+
+    SECTION("Registering invalidates the cache") {
+        auto first = call("tools/list", json::object())["result"];
+        server.register_tool(Tool{"abs", std::nullopt, ToolInputSchema{}}, [](const json&) {
+            return std::vector<ToolResultContent>{};
+        });
+        auto second = call("tools/list", json::object())["result"];
+        REQUIRE(first["tools"][0]["name"] == "add");
+        REQUIRE(second["tools"][0]["name"] == "abs");
+        REQUIRE(walk().first.size() == 6);
+    }
+
+    SECTION("A cursor stays valid when earlier items change") {
+        auto first = call("tools/list", json::object())["result"];
+        server.register_tool(Tool{"aaa", std::nullopt, ToolInputSchema{}}, [](const json&) {
+            return std::vector<ToolResultContent>{};
+        });
+        auto second = call("tools/list", {{"cursor", first["nextCursor"]}})["result"];
+        REQUIRE(second["tools"][0]["name"] == "echo");
+    }
+
+    SECTION("Page size 0 returns everything") {
+        server.set_page_size(0);
+        auto result = call("tools/list", json::object())["result"];
+        REQUIRE(result["tools"].size() == 5);
+        REQUIRE_FALSE(result.contains("nextCursor"));
+    }
+
+    SECTION("Malformed cursors are rejected") {
+        auto response = call("tools/list", {{"cursor", 42}});
+        REQUIRE(response.contains("error"));
+        REQUIRE(response["error"]["code"] == -32602);
+    }
+
+    client_transport->close();
+    server_transport->close();
+}
+
+TEST_CASE("Encoded list pages", "[server][list][pagination][encoding]") {
+    SECTION("An encoded page holds the bytes of the tree page") {
+        pooriayousefi::mcp::detail::list_cache cache("tools");
+        size_t builds = 0;
+        auto build = [&] {
+            ++builds;
+            std::vector<pooriayousefi::mcp::detail::list_cache::entry> entries;
+            for (const char* name : {"delta", "alpha", "charlie \"q\"", "bravo", "echo"}) {
+                entries.emplace_back(name, json{{"name", name}, {"description", "caf\u00e9"}});
+            }
+            return entries;
+        };
+
+        json cursor = json::object();
+        for (int page = 0; page < 3; ++page) {
+            json tree = cache.page(cursor, 2, build, false);
+            json encoded = cache.page(cursor, 2, build, true);
+            REQUIRE(jsonrpc::is_encoded(encoded));
+            const auto& bytes = encoded.get_binary();
+            REQUIRE(std::string(bytes.begin(), bytes.end()) == tree.dump());
+            // Served from the cache the second time
+            REQUIRE(cache.page(cursor, 2, build, true) == encoded);
+            if (!tree.contains("nextCursor")) {
+                REQUIRE(page == 2);
+                break;
+            }
+            cursor = {{"cursor", tree["nextCursor"]}};
+        }
+        REQUIRE(builds == 1);
+        REQUIRE(cache.version() == 1);
+    }
+
+    SECTION("Cursors walk a server's encoded pages") {
+        auto wire = std::make_shared<EncodingTransport>();
+        Server server(wire, Implementation{"test-server", "1.0.0"});
+        server.enable_tools();
+        server.set_page_size(2);
+        for (const char* name : {"e", "d", "c", "b", "a"}) {
+            server.register_tool(Tool{name, "Tool", ToolInputSchema{}}, [](const json&) { return std::vector<ToolResultContent>{}; });
+        }
+        server.start();
+        wire->inject(jsonrpc::make_request(1, "initialize", {{"protocolVersion", "2024-11-05"}, {"capabilities", json::object()}}));
+
+        std::vector<std::string> names;
+        json params = json::object();
+        for (int id = 2; id < 10; ++id) {
+            wire->inject(jsonrpc::make_request(id, "tools/list", params));
+            json result = wire->last()["result"];
+            for (const auto& tool : result["tools"]) names.push_back(tool["name"]);
+            if (!result.contains("nextCursor")) break;
+            params = {{"cursor", result["nextCursor"]}};
+        }
+        REQUIRE(names == std::vector<std::string>{"a", "b", "c", "d", "e"});
+        server.close();
+    }
+}
+
+TEST_CASE("List cache deltas", "[server][list][pagination]") {
+    using pooriayousefi::mcp::detail::list_cache;
+    list_cache cache("resources");
+    size_t builds = 0;
+    auto build = [&] {
+        ++builds;
+        std::vector<list_cache::entry> entries;
+        for (char key = 'a'; key <= 'j'; ++key) {
+            entries.emplace_back(std::string(1, key), json{{"uri", std::string(1, key)}});
+        }
+        return entries;
+    };
+    auto walk = [&]() {
+        std::string keys;
+        json params = json::object();
+        for (;;) {
+            json result = cache.page(params, 3, build);
+            for (const auto& item : result["resources"]) keys += item["uri"].get<std::string>();
+            if (!result.contains("nextCursor")) return keys;
+            params = {{"cursor", result["nextCursor"]}};
+        }
+    };
+
+    // Pages: "" -> abc, "c" -> def, "f" -> ghi, "i" -> j
+    REQUIRE(walk() == "abcdefghij");
+    REQUIRE(cache.cached_pages() == 4);
+
+    SECTION("Replacing an item drops only its page") {
+        cache.put("e", json{{"uri", "e"}, {"name", "changed"}});
+        REQUIRE(cache.cached_pages() == 3);
+        json page = cache.page({{"cursor", "c"}}, 3, build);
+        REQUIRE(page["resources"][1]["name"] == "changed");
+    }
+
+    SECTION("Adding past the end drops only the last page") {
+        cache.put("k", json{{"uri", "k"}});
+        REQUIRE(cache.cached_pages() == 3);
+        REQUIRE(walk() == "abcdefghijk");
+    }
+
+    SECTION("Adding or removing inside a page keeps the other cursors valid") {
+        cache.put("ee", json{{"uri", "ee"}});
+        cache.erase("b");
+        REQUIRE(cache.cached_pages() == 2);
+        REQUIRE(walk() == "acdeeefghij");
+        // Unknown keys change nothing
+        cache.erase("zz");
+        REQUIRE(cache.cached_pages() == 4);
+    }
+
+    SECTION("A batch is applied together with its publish step") {
+        bool published = false;
+        cache.update({{"k", json{{"uri", "k"}}}, {"a", std::nullopt}}, [&] { published = true; });
+        REQUIRE(published);
+        REQUIRE(cache.cached_pages() == 2);
+        REQUIRE(walk() == "bcdefghijk");
+    }
+
+    SECTION("Deltas are ignored until the next rebuild") {
+        cache.invalidate();
+        cache.put("k", json{{"uri", "k"}});
+        REQUIRE(walk() == "abcdefghij");
+        REQUIRE(builds == 2);
+    }
+
+    REQUIRE(cache.version() == builds);
+}
+
+TEST_CASE("ResourceSnapshot deltas", "[server][resources][files]") {
+    using helpers::ResourceSnapshot;
+    const size_t count = ResourceSnapshot::chunk_size * 4;
+    auto uri = [](size_t i) {
+        std::string digits = std::to_string(i);
+        return "file://" + std::string(5 - digits.size(), '0') + digits;
+    };
+    std::map<std::string, Resource> index;
+    for (size_t i = 0; i < count; ++i) {
+        index.emplace(uri(i), Resource{uri(i), "r", std::nullopt, std::nullopt});
+    }
+    auto base = std::make_shared<const ResourceSnapshot>(index | std::views::values);
+    REQUIRE(base->size() == count);
+
+    // Replace the last item, remove the first chunk, grow the second past a split
+    std::vector<ResourceSnapshot::change> changes;
+    changes.emplace_back(uri(count - 1), Resource{uri(count - 1), "replaced", std::nullopt, std::nullopt});
+    for (size_t i = 0; i < ResourceSnapshot::chunk_size; ++i) {
+        changes.emplace_back(uri(i), std::nullopt);
+    }
+    for (size_t i = 0; i < 2 * ResourceSnapshot::chunk_size; ++i) {
+        std::string key = uri(ResourceSnapshot::chunk_size + 1) + "/" + std::to_string(1000 + i);
+        changes.emplace_back(key, Resource{key, "added", std::nullopt, std::nullopt});
+    }
+    changes.emplace_back("file://missing", std::nullopt);
+    auto next = base->with(changes);
+
+    // The old version is untouched
+    REQUIRE(base->size() == count);
+    REQUIRE(std::distance(base->begin(), base->end()) == static_cast<std::ptrdiff_t>(count));
+    REQUIRE(base->begin()->uri == uri(0));
+
+    for (const auto& [key, resource] : changes) {
+        if (resource) index.insert_or_assign(key, *resource);
+        else index.erase(key);
+    }
+    REQUIRE(next->size() == index.size());
+    std::vector<std::string> expected, actual;
+    for (const auto& [key, resource] : index) expected.push_back(key);
+    for (const auto& resource : *next) actual.push_back(resource.uri);
+    REQUIRE(actual == expected);
+    REQUIRE(std::ranges::find_if(*next, [&](const Resource& r) { return r.uri == uri(count - 1); })->name == "replaced");
+
+    // The untouched third chunk is shared, not copied
+    auto third = std::ranges::next(base->begin(), static_cast<std::ptrdiff_t>(2 * ResourceSnapshot::chunk_size));
+    auto same = std::ranges::find_if(*next, [&](const Resource& r) { return r.uri == third->uri; });
+    REQUIRE(&*same == &*third);
+}
+
 // ==================== Error Handling Tests ====================
 
 TEST_CASE("Server error handling", "[server][errors]") {
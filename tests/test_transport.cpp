@@ -1,8 +1,21 @@
 #include <catch_amalgamated.hpp>
 #include <mcp/transport/transport.hpp>
+#include <mcp/transport/stdio_fast.hpp>
+#include <mcp/transport/sse_queue.hpp>
+#include <mcp/transport/http_correlator.hpp>
+#include <mcp/transport/epoll_http.hpp>
+#include <mcp/transport/websocket.hpp>
 #include <thread>
 #include <chrono>
 #include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
 
 using namespace pooriayousefi::mcp::transport;
 using json = nlohmann::json;
@@ -257,6 +270,113 @@ TEST_CASE("InMemoryTransport multiple rapid messages", "[transport][inmemory]")
     }
 }
 
+TEST_CASE("InMemoryTransport bounded lock-free queue", "[transport][inmemory][concurrency]") {
+    SECTION("Ring rejects pushes when full without consuming the value") {
+        pooriayousefi::core::MpscRing<json> ring(2);
+        REQUIRE(ring.capacity() == 2);
+        REQUIRE(ring.try_push(json{{"n", 1}}));
+        REQUIRE(ring.try_push(json{{"n", 2}}));
+        REQUIRE(ring.full());
+
+        json third{{"n", 3}};
+        REQUIRE_FALSE(ring.try_push(third));
+        REQUIRE(third["n"] == 3);
+
+        json out;
+        REQUIRE(ring.try_pop(out));
+        REQUIRE(out["n"] == 1);
+        REQUIRE(ring.try_push(third));
+        REQUIRE(ring.try_pop(out));
+        REQUIRE(ring.try_pop(out));
+        REQUIRE(out["n"] == 3);
+        REQUIRE(ring.empty());
+    }
+
+    SECTION("Senders spill past a full ring and keep per-thread order") {
+        auto [client, server] = create_in_memory_pair(4);
+        constexpr int threads = 4;
+        constexpr int per_thread = 2000;
+
+        std::vector<int> next(threads, 0);
+        std::atomic<int> count{0};
+        std::atomic<bool> in_order{true};
+        server->on_message([&](const json& msg) {
+            int t = msg["t"].get<int>();
+            if (msg["i"].get<int>() != next[t]++) in_order = false;
+            ++count;
+        });
+        client->start();
+        server->start();
+
+        std::vector<std::thread> senders;
+        for (int t = 0; t < threads; ++t) {
+            senders.emplace_back([&, t]() {
+                for (int i = 0; i < per_thread; ++i) {
+                    json msg{{"t", t}, {"i", i}};
+                    client->send(std::move(msg));
+                }
+            });
+        }
+        for (auto& th : senders) th.join();
+
+        REQUIRE(wait_for_condition([&]() { return count.load() == threads * per_thread; }, 5000));
+        REQUIRE(in_order);
+
+        client->close();
+        server->close();
+    }
+
+    SECTION("Both ends flooding each other from their receive threads do not deadlock") {
+        auto [client, server] = create_in_memory_pair(4);
+        constexpr int flood = 1000;
+
+        // On "go", each side sends the peer far more than its ring holds, from its own receive thread
+        struct Side {
+            std::atomic<int> received{0};
+            std::atomic<bool> in_order{true};
+        };
+        Side client_side, server_side;
+        auto handler = [flood](InMemoryTransport& self, Side& side) {
+            return [&self, &side, flood](const json& msg) {
+                if (msg.contains("go")) {
+                    for (int i = 0; i < flood; ++i) self.send(json{{"i", i}});
+                    return;
+                }
+                if (msg["i"].get<int>() != side.received++) side.in_order = false;
+            };
+        };
+        client->on_message(handler(*client, client_side));
+        server->on_message(handler(*server, server_side));
+        client->start();
+        server->start();
+
+        client->send(json{{"go", true}});
+        server->send(json{{"go", true}});
+
+        REQUIRE(wait_for_condition([&]() { return client_side.received == flood && server_side.received == flood; }, 5000));
+        REQUIRE(client_side.in_order);
+        REQUIRE(server_side.in_order);
+
+        client->close();
+        server->close();
+    }
+
+    SECTION("Idle receiver parks and wakes for the next message") {
+        auto [client, server] = create_in_memory_pair();
+        std::atomic<int> count{0};
+        server->on_message([&](const json&) { ++count; });
+        client->start();
+        server->start();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        client->send(json{{"id", 1}});
+        REQUIRE(wait_for_condition([&]() { return count.load() == 1; }));
+
+        client->close();
+        server->close();
+    }
+}
+
 TEST_CASE("create_in_memory_pair creates connected transports", "[transport][inmemory]") {
     SECTION("Pair creation") {
         auto [t1, t2] = create_in_memory_pair();
@@ -591,3 +711,1575 @@ TEST_CASE("Transport edge cases", "[transport][edge_cases]") {
         server->close();
     }
 }
+
+// ==================== FastStdioTransport Tests ====================
+
+namespace {
+    // Pipes standing in for the peer process: we write to `to_transport`, read `from_transport`
+    struct stdio_pipes {
+        int to_transport[2];
+        int from_transport[2];
+        stdio_pipes() {
+            REQUIRE(::pipe(to_transport) == 0);
+            REQUIRE(::pipe(from_transport) == 0);
+        }
+        ~stdio_pipes() {
+            for (int fd : {to_transport[0], to_transport[1], from_transport[0], from_transport[1]}) {
+                if (fd >= 0) ::close(fd);
+            }
+        }
+        FastStdioOptions options(StdioFraming framing = StdioFraming::detect) const {
+            FastStdioOptions o;
+            o.input_fd = to_transport[0];
+            o.output_fd = from_transport[1];
+            o.framing = framing;
+            return o;
+        }
+        void write_raw(const std::string& bytes) {
+            REQUIRE(::write(to_transport[1], bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size()));
+        }
+        void end_input() {
+            ::close(to_transport[1]);
+            to_transport[1] = -1;
+        }
+        std::string read_available(size_t at_least) {
+            std::string out;
+            char buf[65536];
+            while (out.size() < at_least) {
+                ssize_t n = ::read(from_transport[0], buf, sizeof(buf));
+                if (n <= 0) break;
+                out.append(buf, static_cast<size_t>(n));
+            }
+            return out;
+        }
+    };
+}
+
+TEST_CASE("FastStdioTransport framing", "[transport][stdio]") {
+    stdio_pipes pipes;
+    std::mutex mutex;
+    std::vector<json> received;
+    std::vector<std::string> errors;
+
+    SECTION("Newline-delimited messages split across reads") {
+        auto transport = std::make_shared<FastStdioTransport>(pipes.options());
+        transport->on_message([&](const json& msg) { std::lock_guard<std::mutex> l(mutex); received.push_back(msg); });
+        transport->start();
+
+        pipes.write_raw("{\"id\":1}\n{\"id\":2}\r\n\n{\"id\":");
+        pipes.write_raw("3}\n");
+
+        REQUIRE(wait_for_condition([&]() { std::lock_guard<std::mutex> l(mutex); return received.size() == 3; }));
+        REQUIRE(received[0]["id"] == 1);
+        REQUIRE(received[1]["id"] == 2);
+        REQUIRE(received[2]["id"] == 3);
+        transport->close();
+    }
+
+    SECTION("Content-Length frames are detected and mirrored in replies") {
+        auto transport = std::make_shared<FastStdioTransport>(pipes.options());
+        transport->on_message([&](const json& msg) { std::lock_guard<std::mutex> l(mutex); received.push_back(msg); });
+        transport->start();
+
+        // The body contains a newline, which newline framing would split on
+        std::string body = "{\"id\":7,\n\"method\":\"ping\"}";
+        std::string frame = "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        pipes.write_raw(frame.substr(0, 10));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pipes.write_raw(frame.substr(10));
+
+        REQUIRE(wait_for_condition([&]() { std::lock_guard<std::mutex> l(mutex); return received.size() == 1; }));
+        REQUIRE(received[0]["method"] == "ping");
+
+        transport->send(json{{"id", 7}, {"result", "pong"}});
+        std::string reply_body = json{{"id", 7}, {"result", "pong"}}.dump();
+        std::string expected = "Content-Length: " + std::to_string(reply_body.size()) + "\r\n\r\n" + reply_body;
+        REQUIRE(pipes.read_available(expected.size()) == expected);
+        transport->close();
+    }
+
+    SECTION("An oversized frame is skipped whole, even across reads") {
+        auto options = pipes.options();
+        options.max_message_bytes = 64;
+        auto transport = std::make_shared<FastStdioTransport>(options);
+        transport->on_message([&](const json& msg) { std::lock_guard<std::mutex> l(mutex); received.push_back(msg); });
+        transport->on_error([&](const std::string& e) { std::lock_guard<std::mutex> l(mutex); errors.push_back(e); });
+        transport->start();
+
+        // The oversized body looks like a header block followed by a frame of its own
+        std::string decoy = "Content-Length: 12\r\n\r\n{\"decoy\":1}";
+        std::string body = decoy + std::string(200, ' ') + decoy;
+        std::string oversized = "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        std::string valid_body = "{\"id\":9}";
+        std::string valid = "Content-Length: " + std::to_string(valid_body.size()) + "\r\n\r\n" + valid_body;
+
+        pipes.write_raw(oversized.substr(0, 60));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pipes.write_raw(oversized.substr(60, 100));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pipes.write_raw(oversized.substr(160) + valid);
+
+        REQUIRE(wait_for_condition([&]() { std::lock_guard<std::mutex> l(mutex); return received.size() == 1; }));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        {
+            std::lock_guard<std::mutex> l(mutex);
+            REQUIRE(received.size() == 1);
+            REQUIRE(received[0] == json{{"id", 9}});
+            REQUIRE(errors == std::vector<std::string>{"Message exceeds maximum size"});
+        }
+        transport->close();
+    }
+
+    SECTION("Malformed input is reported and skipped") {
+        auto transport = std::make_shared<FastStdioTransport>(pipes.options(StdioFraming::newline));
+        transport->on_message([&](const json& msg) { std::lock_guard<std::mutex> l(mutex); received.push_back(msg); });
+        transport->on_error([&](const std::string& e) { std::lock_guard<std::mutex> l(mutex); errors.push_back(e); });
+        transport->start();
+
+        pipes.write_raw("{not json}\n{\"ok\":true}\n");
+
+        REQUIRE(wait_for_condition([&]() { std::lock_guard<std::mutex> l(mutex); return received.size() == 1; }));
+        REQUIRE(errors.size() == 1);
+        REQUIRE(received[0]["ok"] == true);
+        transport->close();
+    }
+
+    SECTION("Messages the filter rejects are dropped unparsed") {
+        auto transport = std::make_shared<FastStdioTransport>(pipes.options(StdioFraming::newline));
+        transport->on_message([&](const json& msg) { std::lock_guard<std::mutex> l(mutex); received.push_back(msg); });
+        transport->on_error([&](const std::string& e) { std::lock_guard<std::mutex> l(mutex); errors.push_back(e); });
+        transport->set_message_filter([](const pooriayousefi::mcp::jsonrpc::envelope& e) { return e.method_name() != "drop"; });
+        transport->start();
+
+        // The dropped message's params are not valid JSON: parsing them would report an error
+        pipes.write_raw("{\"jsonrpc\":\"2.0\",\"method\":\"drop\",\"params\":[1,,2]}\n");
+        pipes.write_raw("{\"jsonrpc\":\"2.0\",\"method\":\"keep\"}\n");
+
+        REQUIRE(wait_for_condition([&]() { std::lock_guard<std::mutex> l(mutex); return received.size() == 1; }));
+        REQUIRE(received[0]["method"] == "keep");
+        REQUIRE(errors.empty());
+        transport->close();
+    }
+
+    SECTION("End of input closes the transport") {
+        auto transport = std::make_shared<FastStdioTransport>(pipes.options());
+        std::atomic<bool> closed{false};
+        transport->on_close([&]() { closed = true; });
+        transport->start();
+        pipes.end_input();
+        REQUIRE(wait_for_condition([&]() { return closed.load(); }));
+        REQUIRE_FALSE(transport->is_open());
+    }
+}
+
+TEST_CASE("FastStdioTransport large and concurrent writes", "[transport][stdio]") {
+    stdio_pipes pipes;
+
+    SECTION("Multi-megabyte message round trip") {
+        auto transport = std::make_shared<FastStdioTransport>(pipes.options());
+        std::atomic<size_t> payload_size{0};
+        transport->on_message([&](const json& msg) { payload_size = msg["data"].get<std::string>().size(); });
+        transport->start();
+
+        std::string big(3 * 1024 * 1024, 'x');
+        std::string line = json{{"data", big}}.dump() + "\n";
+        std::thread writer([&]() { pipes.write_raw(line); });
+        REQUIRE(wait_for_condition([&]() { return payload_size.load() == big.size(); }, 5000));
+        writer.join();
+        transport->close();
+    }
+
+    SECTION("Messages from many threads arrive whole and in per-thread order") {
+        auto transport = std::make_shared<FastStdioTransport>(pipes.options(StdioFraming::newline));
+        constexpr int threads = 4;
+        constexpr int per_thread = 200;
+
+        std::string output;
+        std::thread reader([&]() {
+            char buf[65536];
+            size_t lines = 0;
+            while (lines < threads * per_thread) {
+                ssize_t n = ::read(pipes.from_transport[0], buf, sizeof(buf));
+                if (n <= 0) break;
+                output.append(buf, static_cast<size_t>(n));
+                lines = static_cast<size_t>(std::count(output.begin(), output.end(), '\n'));
+            }
+        });
+
+        std::vector<std::thread> senders;
+        for (int t = 0; t < threads; ++t) {
+            senders.emplace_back([&, t]() {
+                for (int i = 0; i < per_thread; ++i) transport->send(json{{"t", t}, {"i", i}});
+            });
+        }
+        for (auto& s : senders) s.join();
+        transport->flush();
+        reader.join();
+
+        std::vector<int> next(threads, 0);
+        size_t start = 0;
+        int count = 0;
+        while (start < output.size()) {
+            size_t end = output.find('\n', start);
+            REQUIRE(end != std::string::npos);
+            auto msg = json::parse(output.substr(start, end - start));
+            int t = msg["t"].get<int>();
+            REQUIRE(msg["i"].get<int>() == next[t]++);
+            ++count;
+            start = end + 1;
+        }
+        REQUIRE(count == threads * per_thread);
+    }
+}
+
+TEST_CASE("Pooled serialization buffers", "[transport][stdio][pool]") {
+    using pooriayousefi::core::ObjectPool;
+
+    SECTION("Released objects are reset and reused by the same thread") {
+        ObjectPool<std::string>::reset_stats();
+        const char* data = nullptr;
+        {
+            auto buffer = ObjectPool<std::string>::acquire();
+            buffer->assign(1000, 'x');
+            data = buffer->data();
+        }
+        auto again = ObjectPool<std::string>::acquire();
+        REQUIRE(again->empty());
+        REQUIRE(again->capacity() >= 1000);
+        REQUIRE(again->data() == data);
+        REQUIRE(ObjectPool<std::string>::stats().reused >= 1); // counters are process-wide
+    }
+
+    SECTION("Oversized objects are not kept") {
+        ObjectPool<std::vector<int>>::reset_stats();
+        ObjectPool<std::vector<int>>::set_max_capacity(16);
+        {
+            auto small = ObjectPool<std::vector<int>>::acquire();
+            auto large = ObjectPool<std::vector<int>>::acquire();
+            small->resize(8);
+            large->resize(1000);
+        }
+        auto stats = ObjectPool<std::vector<int>>::stats();
+        REQUIRE(stats.recycled == 1);
+        REQUIRE(stats.discarded == 1);
+        ObjectPool<std::vector<int>>::set_max_capacity(size_t{1} << 20);
+    }
+
+    SECTION("dump_into matches dump") {
+        json message = {{"jsonrpc", "2.0"}, {"id", 3}, {"result", {{"text", "héllo \"quoted\""}, {"n", 1.5}}}};
+        std::string out = "stale contents";
+        pooriayousefi::mcp::jsonrpc::dump_into(message, out);
+        REQUIRE(out == message.dump());
+    }
+
+    SECTION("FastStdioTransport writes reuse their buffers") {
+        stdio_pipes pipes;
+        auto transport = std::make_shared<FastStdioTransport>(pipes.options(StdioFraming::content_length));
+        transport->send(json{{"warm", "up"}});
+        transport->flush();
+        std::string warm = pipes.read_available(1);
+
+        ObjectPool<std::string>::reset_stats();
+        constexpr int messages = 100;
+        std::string expected;
+        for (int i = 0; i < messages; ++i) {
+            json message = {{"id", i}, {"result", "ok"}};
+            std::string body = message.dump();
+            expected += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+            transport->send(message);
+            transport->flush();
+        }
+        REQUIRE(pipes.read_available(expected.size()) == expected);
+        REQUIRE(ObjectPool<std::string>::stats().reused >= messages);
+        transport->close();
+    }
+}
+
+TEST_CASE("SSE subscriber queues", "[transport][sse]") {
+    auto progress = [](int token, int value) {
+        return SseEvent::from(json{{"jsonrpc", "2.0"}, {"method", "notifications/progress"},
+                                   {"params", {{"progressToken", token}, {"progress", value}}}});
+    };
+    auto note = [](int n) {
+        return SseEvent::from(json{{"jsonrpc", "2.0"}, {"method", "notifications/message"}, {"params", {{"n", n}}}});
+    };
+    auto texts = [](const std::vector<SseEvent>& events) {
+        std::vector<std::string> out;
+        for (const auto& event : events) out.push_back(*event.data);
+        return out;
+    };
+
+    SECTION("Events are formatted once and shared between queues") {
+        auto event = note(1);
+        REQUIRE(*event.data == "data: " + json{{"jsonrpc", "2.0"}, {"method", "notifications/message"}, {"params", {{"n", 1}}}}.dump() + "\n\n");
+        REQUIRE(event.progress_key.empty());
+        REQUIRE(progress(7, 1).progress_key == "7");
+        auto report = json{{"jsonrpc", "2.0"}, {"method", "$/progress"}, {"params", {{"token", "t"}, {"value", {{"progress", 0.5}}}}}};
+        REQUIRE(SseEvent::from(report).progress_key == "\"t\"");
+        auto chunk = json{{"jsonrpc", "2.0"}, {"method", "$/progress"}, {"params", {{"token", "t"}, {"value", {{"content", json::array()}}}}}};
+        REQUIRE(SseEvent::from(chunk).progress_key.empty());
+
+        SseQueue a, b;
+        a.push(event);
+        b.push(event);
+        std::vector<SseEvent> from_a, from_b;
+        REQUIRE(a.wait_pop(from_a, std::chrono::milliseconds(0)));
+        REQUIRE(b.wait_pop(from_b, std::chrono::milliseconds(0)));
+        REQUIRE(from_a.at(0).data == from_b.at(0).data);
+    }
+
+    SECTION("A full queue drops its oldest event") {
+        SseQueue queue(2, SseOverflow::drop_oldest);
+        for (int i = 0; i < 4; ++i) REQUIRE(queue.push(note(i)));
+        std::vector<SseEvent> events;
+        REQUIRE(queue.wait_pop(events, std::chrono::milliseconds(0)));
+        REQUIRE(texts(events) == texts({note(2), note(3)}));
+        REQUIRE(queue.dropped() == 2);
+        REQUIRE(queue.size() == 0);
+    }
+
+    SECTION("Progress updates replace the queued one for their token") {
+        SseQueue queue(8, SseOverflow::coalesce_progress);
+        queue.push(progress(1, 10));
+        queue.push(note(0));
+        queue.push(progress(2, 10));
+        queue.push(progress(1, 20));
+        queue.push(progress(1, 30));
+        std::vector<SseEvent> events;
+        REQUIRE(queue.wait_pop(events, std::chrono::milliseconds(0)));
+        REQUIRE(texts(events) == texts({progress(1, 30), note(0), progress(2, 10)}));
+        REQUIRE(queue.dropped() == 2);
+    }
+
+    SECTION("The disconnect policy closes a full queue") {
+        SseQueue queue(1, SseOverflow::disconnect);
+        REQUIRE(queue.push(note(0)));
+        REQUIRE_FALSE(queue.push(note(1)));
+        REQUIRE(queue.closed());
+        std::vector<SseEvent> events;
+        REQUIRE_FALSE(queue.wait_pop(events, std::chrono::milliseconds(0)));
+    }
+
+    SECTION("A waiting consumer wakes on push and on close") {
+        SseQueue queue;
+        std::vector<SseEvent> events;
+        std::thread producer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            queue.push(note(5));
+        });
+        REQUIRE(queue.wait_pop(events, std::chrono::seconds(5)));
+        producer.join();
+        REQUIRE(texts(events) == texts({note(5)}));
+
+        std::thread closer([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            queue.close();
+        });
+        auto start = std::chrono::steady_clock::now();
+        REQUIRE_FALSE(queue.wait_pop(events, std::chrono::seconds(5)));
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+        closer.join();
+        REQUIRE_FALSE(queue.push(note(6)));
+    }
+}
+
+// ==================== HttpCorrelator Tests ====================
+
+TEST_CASE("HttpCorrelator", "[transport][http]") {
+    HttpCorrelator correlator;
+    auto request = [](json id, json params = json::object()) {
+        return json{{"jsonrpc", "2.0"}, {"id", std::move(id)}, {"method", "echo"}, {"params", std::move(params)}};
+    };
+    auto answer = [](const json& forwarded) {
+        return json{{"jsonrpc", "2.0"}, {"id", forwarded["id"]}, {"result", forwarded["params"]}};
+    };
+
+    SECTION("Concurrent POSTs reusing one id each get their own response") {
+        constexpr int posts = 8;
+        std::vector<std::shared_ptr<HttpExchange>> exchanges(posts);
+        std::vector<json> forwarded(posts);
+        std::vector<std::thread> clients;
+        for (int i = 0; i < posts; ++i) {
+            clients.emplace_back([&, i] {
+                exchanges[i] = std::make_shared<HttpExchange>();
+                forwarded[i] = *correlator.accept(request(1, {{"n", i}}).dump(), exchanges[i]).message;
+            });
+        }
+        for (auto& client : clients) client.join();
+        REQUIRE(correlator.size() == posts);
+
+        std::vector<uint64_t> wire_ids;
+        for (const auto& message : forwarded) wire_ids.push_back(message["id"].get<uint64_t>());
+        std::sort(wire_ids.begin(), wire_ids.end());
+        REQUIRE(std::adjacent_find(wire_ids.begin(), wire_ids.end()) == wire_ids.end());
+
+        // Answered out of order, from several threads
+        std::atomic<int> routed{0};
+        std::vector<std::thread> responders;
+        for (int i = posts - 1; i >= 0; --i) {
+            responders.emplace_back([&, i] { if (correlator.route_response(answer(forwarded[i]))) ++routed; });
+        }
+        for (auto& responder : responders) responder.join();
+        REQUIRE(routed == posts);
+        REQUIRE(correlator.size() == 0);
+        for (int i = 0; i < posts; ++i) {
+            REQUIRE(exchanges[i]->complete());
+            json body = json::parse(exchanges[i]->body());
+            REQUIRE(body["id"] == 1);
+            REQUIRE(body["result"]["n"] == i);
+        }
+        REQUIRE_FALSE(correlator.route_response(answer(forwarded[0])));
+    }
+
+    SECTION("A batch mixing requests, notifications and invalid elements") {
+        json batch = json::array({
+            request("a"),
+            json{{"jsonrpc", "2.0"}, {"method", "notifications/initialized"}},
+            json{{"foo", 1}},
+            request(2),
+            json{{"jsonrpc", "2.0"}, {"id", 9}, {"result", json::object()}}
+        });
+        auto exchange = std::make_shared<HttpExchange>();
+        auto post = correlator.accept(batch.dump(), exchange);
+        REQUIRE(post.status == 0);
+        REQUIRE(exchange->batch);
+        REQUIRE(exchange->expected == 3);
+
+        // The invalid element is answered here and not forwarded
+        const json& forwarded = *post.message;
+        REQUIRE(forwarded.size() == 4);
+        REQUIRE(forwarded[1]["method"] == "notifications/initialized");
+        REQUIRE(forwarded[3]["id"] == 9);
+        REQUIRE_FALSE(exchange->complete());
+        REQUIRE(correlator.route_response(answer(forwarded[0])));
+        REQUIRE(correlator.route_response(answer(forwarded[2])));
+        REQUIRE(exchange->complete());
+
+        json body = json::parse(exchange->body());
+        REQUIRE(body.size() == 3);
+        REQUIRE(body[0]["id"].is_null());
+        REQUIRE(body[0]["error"]["code"] == pooriayousefi::mcp::jsonrpc::invalid_request.code);
+        REQUIRE(body[1]["id"] == "a");
+        REQUIRE(body[2]["id"] == 2);
+
+        // Nothing to wait for without requests
+        auto quiet = std::make_shared<HttpExchange>();
+        post = correlator.accept(json::array({json{{"jsonrpc", "2.0"}, {"method", "note"}}}).dump(), quiet);
+        REQUIRE(post.status == 202);
+        REQUIRE(post.message->size() == 1);
+    }
+
+    SECTION("Cancels are translated only when the id is unambiguous") {
+        auto cancel = [](json id) {
+            return json{{"jsonrpc", "2.0"}, {"method", "$/cancelRequest"}, {"params", {{"id", std::move(id)}}}}.dump();
+        };
+        auto first = std::make_shared<HttpExchange>();
+        auto wire_id = (*correlator.accept(request(5).dump(), first).message)["id"];
+
+        auto post = correlator.accept(cancel(5), std::make_shared<HttpExchange>());
+        REQUIRE(post.status == 202);
+        REQUIRE((*post.message)["params"]["id"] == wire_id);
+
+        post = correlator.accept(cancel(6), std::make_shared<HttpExchange>());
+        REQUIRE((*post.message)["params"]["id"].is_null());
+
+        // A second client's request 5 makes the cancel ambiguous
+        auto second = std::make_shared<HttpExchange>();
+        correlator.accept(request(5).dump(), second);
+        post = correlator.accept(cancel(5), std::make_shared<HttpExchange>());
+        REQUIRE((*post.message)["params"]["id"].is_null());
+    }
+
+    SECTION("Progress tokens that defaulted to a wire id are restored") {
+        auto numeric = std::make_shared<HttpExchange>();
+        auto named = std::make_shared<HttpExchange>();
+        auto numeric_wire = (*correlator.accept(request(7).dump(), numeric).message)["id"].get<uint64_t>();
+        auto named_wire = (*correlator.accept(request("job").dump(), named).message)["id"].get<uint64_t>();
+        auto progress = [](json token) {
+            return json{{"jsonrpc", "2.0"}, {"method", "$/progress"}, {"params", {{"token", std::move(token)}, {"value", 1}}}};
+        };
+
+        REQUIRE(correlator.restore_progress_token(progress(std::to_string(numeric_wire)))["params"]["token"] == "7");
+        REQUIRE(correlator.restore_progress_token(progress(std::to_string(named_wire)))["params"]["token"] == "job");
+        REQUIRE(correlator.restore_progress_token(progress("client-token"))["params"]["token"] == "client-token");
+        REQUIRE(correlator.restore_progress_token(progress("999999"))["params"]["token"] == "999999");
+        REQUIRE(correlator.restore_progress_token(progress(numeric_wire))["params"]["token"] == numeric_wire);
+
+        // Once the request is answered its wire id means nothing
+        correlator.route_response(json{{"jsonrpc", "2.0"}, {"id", numeric_wire}, {"result", 1}});
+        REQUIRE(correlator.restore_progress_token(progress(std::to_string(numeric_wire)))["params"]["token"] ==
+                std::to_string(numeric_wire));
+    }
+
+    SECTION("fail_all answers waiting requests; forget drops them") {
+        auto waiting = std::make_shared<HttpExchange>();
+        auto abandoned = std::make_shared<HttpExchange>();
+        correlator.accept(request("w").dump(), waiting);
+        auto wire_id = (*correlator.accept(request("x").dump(), abandoned).message)["id"];
+
+        correlator.forget(abandoned);
+        REQUIRE(correlator.size() == 1);
+        REQUIRE_FALSE(correlator.route_response(json{{"jsonrpc", "2.0"}, {"id", wire_id}, {"result", 1}}));
+
+        correlator.fail_all();
+        REQUIRE(correlator.size() == 0);
+        json body = json::parse(waiting->body());
+        REQUIRE(body["id"] == "w");
+        REQUIRE(body["error"]["code"] == pooriayousefi::mcp::jsonrpc::internal_error.code);
+    }
+}
+
+// ==================== EpollHttpServerTransport Tests ====================
+
+namespace {
+    // A client socket speaking just enough HTTP/1.1 for the tests
+    struct http_peer {
+        int fd = -1;
+        std::string buffered;
+        std::string head; // status line and headers of the last response()
+
+        explicit http_peer(int port) {
+            fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            REQUIRE(fd >= 0);
+            timeval timeout{5, 0};
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(port));
+            ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+            REQUIRE(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        }
+        ~http_peer() { if (fd >= 0) ::close(fd); }
+
+        void write_raw(const std::string& bytes) {
+            REQUIRE(::send(fd, bytes.data(), bytes.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(bytes.size()));
+        }
+        static std::string post(const std::string& body, const std::string& extra_headers = "") {
+            return "POST /jsonrpc HTTP/1.1\r\nHost: test\r\nContent-Type: application/json\r\n" + extra_headers +
+                   "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        }
+        // Reads until pred(buffered) holds or the peer closes; false on timeout or close
+        template<class Pred>
+        bool read_until(Pred pred) {
+            char buf[4096];
+            while (!pred(buffered)) {
+                ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+                if (n <= 0) return false;
+                buffered.append(buf, static_cast<size_t>(n));
+            }
+            return true;
+        }
+        // One Content-Length response: {status, body}
+        std::pair<int, std::string> response() {
+            size_t head_end = std::string::npos;
+            REQUIRE(read_until([&](const std::string& b) { return (head_end = b.find("\r\n\r\n")) != std::string::npos; }));
+            head = buffered.substr(0, head_end);
+            size_t length = 0;
+            if (auto at = head.find("Content-Length: "); at != std::string::npos) length = std::stoul(head.substr(at + 16));
+            REQUIRE(read_until([&](const std::string& b) { return b.size() >= head_end + 4 + length; }));
+            int status = std::stoi(head.substr(9, 3));
+            std::string body = buffered.substr(head_end + 4, length);
+            buffered.erase(0, head_end + 4 + length);
+            return {status, body};
+        }
+        // Skips whatever is still in flight; true once the server closed the connection
+        bool closed_by_peer() {
+            char buf[4096];
+            ssize_t n;
+            while ((n = ::recv(fd, buf, sizeof(buf), 0)) > 0) {}
+            return n == 0;
+        }
+    };
+
+    std::shared_ptr<EpollHttpServerTransport> start_epoll_server(EpollHttpOptions options = {},
+                                                                 std::shared_ptr<pooriayousefi::core::Metrics> metrics = nullptr) {
+        options.host = "127.0.0.1";
+        options.port = 0;
+        auto transport = std::make_shared<EpollHttpServerTransport>(options);
+        if (metrics) transport->set_metrics(metrics, "epoll");
+        // Answers every request inline with its params
+        std::weak_ptr<EpollHttpServerTransport> weak = transport;
+        transport->on_message([weak](json&& msg) {
+            auto reply = [&](const json& element) {
+                if (element.contains("method") && element.contains("id")) {
+                    if (auto t = weak.lock()) t->send(json{{"jsonrpc", "2.0"}, {"id", element["id"]}, {"result", element.value("params", json{})}});
+                }
+            };
+            if (msg.is_array()) for (const auto& element : msg) reply(element);
+            else reply(msg);
+        });
+        transport->start();
+        REQUIRE(transport->port() > 0);
+        return transport;
+    }
+}
+
+TEST_CASE("EpollHttpServerTransport requests", "[transport][epoll]") {
+    auto transport = start_epoll_server();
+
+    SECTION("A POST is answered with the response to its request") {
+        http_peer peer(transport->port());
+        peer.write_raw(http_peer::post(R"({"jsonrpc":"2.0","id":7,"method":"echo","params":{"x":1}})"));
+        auto [status, body] = peer.response();
+        REQUIRE(status == 200);
+        REQUIRE(json::parse(body) == json{{"jsonrpc", "2.0"}, {"id", 7}, {"result", {{"x", 1}}}});
+        REQUIRE(transport->in_flight() == 0);
+    }
+
+    SECTION("partialResultToken is removed, so results come back in the response") {
+        http_peer peer(transport->port());
+        peer.write_raw(http_peer::post(R"({"jsonrpc":"2.0","id":3,"method":"tools/call","params":{"name":"t","partialResultToken":"p1"}})"));
+        auto [status, body] = peer.response();
+        REQUIRE(status == 200);
+        REQUIRE(json::parse(body)["result"] == json{{"name", "t"}});
+    }
+
+    SECTION("Pipelined requests on one connection are answered in order") {
+        http_peer peer(transport->port());
+        peer.write_raw(http_peer::post(R"({"jsonrpc":"2.0","id":1,"method":"a","params":[1]})") +
+                       http_peer::post(R"({"jsonrpc":"2.0","id":2,"method":"b","params":[2]})"));
+        REQUIRE(json::parse(peer.response().second)["id"] == 1);
+        REQUIRE(json::parse(peer.response().second)["id"] == 2);
+    }
+
+    SECTION("Clients reusing the same id get their own responses") {
+        std::vector<std::unique_ptr<http_peer>> peers;
+        for (int i = 0; i < 8; ++i) {
+            peers.push_back(std::make_unique<http_peer>(transport->port()));
+            peers.back()->write_raw(http_peer::post(json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "m"}, {"params", {{"client", i}}}}.dump()));
+        }
+        for (int i = 0; i < 8; ++i) {
+            auto reply = json::parse(peers[i]->response().second);
+            REQUIRE(reply["id"] == 1);
+            REQUIRE(reply["result"]["client"] == i);
+        }
+    }
+
+    SECTION("Batches, notifications and errors") {
+        http_peer peer(transport->port());
+        peer.write_raw(http_peer::post(R"([{"jsonrpc":"2.0","id":"a","method":"m","params":[]},{"bogus":true}])"));
+        auto [status, body] = peer.response();
+        REQUIRE(status == 200);
+        auto replies = json::parse(body);
+        REQUIRE(replies.size() == 2);
+
+        peer.write_raw(http_peer::post(R"({"jsonrpc":"2.0","method":"note"})"));
+        REQUIRE(peer.response().first == 202);
+
+        peer.write_raw(http_peer::post("{not json"));
+        REQUIRE(peer.response().first == 400);
+
+        peer.write_raw("GET /health HTTP/1.1\r\n\r\n");
+        REQUIRE(peer.response() == std::pair<int, std::string>{200, R"({"status":"ok"})"});
+
+        peer.write_raw("GET /missing HTTP/1.1\r\n\r\n");
+        REQUIRE(peer.response().first == 404);
+    }
+
+    SECTION("GET /metrics serves the registry given to set_metrics") {
+        {
+            http_peer peer(transport->port());
+            peer.write_raw("GET /metrics HTTP/1.1\r\n\r\n");
+            REQUIRE(peer.response().first == 404);
+        }
+        transport->close();
+        auto metrics = std::make_shared<pooriayousefi::core::Metrics>();
+        transport = start_epoll_server({}, metrics);
+
+        http_peer peer(transport->port());
+        const std::string request = R"({"jsonrpc":"2.0","id":5,"method":"m","params":[]})";
+        peer.write_raw(http_peer::post(request));
+        REQUIRE(peer.response().first == 200);
+
+        peer.write_raw("GET /metrics HTTP/1.1\r\n\r\n");
+        auto [status, body] = peer.response();
+        REQUIRE(status == 200);
+        REQUIRE(peer.head.find("Content-Type: text/plain; version=0.0.4") != std::string::npos);
+        REQUIRE(body.find("mcp_transport_received_messages_total{transport=\"epoll\"} 1\n") != std::string::npos);
+        REQUIRE(body.find("mcp_transport_received_bytes_total{transport=\"epoll\"} " + std::to_string(request.size()) + "\n") != std::string::npos);
+        REQUIRE(body.find("mcp_http_in_flight{transport=\"epoll\"} 0\n") != std::string::npos);
+        REQUIRE(body.find("mcp_sse_subscribers{transport=\"epoll\"} 0\n") != std::string::npos);
+        REQUIRE(metrics->counter("mcp_transport_sent_bytes_total", "", "transport", "epoll").value() > 0);
+    }
+
+    SECTION("Connection: close ends the connection after the response") {
+        http_peer peer(transport->port());
+        peer.write_raw(http_peer::post(R"({"jsonrpc":"2.0","id":3,"method":"m","params":[]})", "Connection: close\r\n"));
+        REQUIRE(peer.response().first == 200);
+        REQUIRE(peer.closed_by_peer());
+    }
+
+    SECTION("Requests nobody answers time out with 504") {
+        transport->close();
+        EpollHttpOptions options;
+        options.request_timeout = std::chrono::milliseconds(50);
+        transport = start_epoll_server(options);
+        transport->on_message([](json&&) {});
+        http_peer peer(transport->port());
+        peer.write_raw(http_peer::post(R"({"jsonrpc":"2.0","id":4,"method":"slow"})"));
+        REQUIRE(peer.response().first == 504);
+        REQUIRE(transport->in_flight() == 0);
+    }
+
+    transport->close();
+    REQUIRE_FALSE(transport->is_open());
+}
+
+TEST_CASE("EpollHttpServerTransport SSE", "[transport][epoll][sse]") {
+    EpollHttpOptions options;
+    options.loops = 2;
+    auto transport = start_epoll_server(options);
+
+    std::vector<std::unique_ptr<http_peer>> subscribers;
+    for (int i = 0; i < 4; ++i) {
+        subscribers.push_back(std::make_unique<http_peer>(transport->port()));
+        subscribers.back()->write_raw("GET /events HTTP/1.1\r\n\r\n");
+        REQUIRE(subscribers.back()->read_until([](const std::string& b) { return b.find("\r\n\r\n") != std::string::npos; }));
+        REQUIRE(subscribers.back()->buffered.find("text/event-stream") != std::string::npos);
+    }
+    REQUIRE(wait_for_condition([&] { return transport->sse_subscribers() == 4; }));
+
+    SECTION("Notifications reach every subscriber") {
+        json note = {{"jsonrpc", "2.0"}, {"method", "notifications/message"}, {"params", {{"n", 1}}}};
+        transport->send(note);
+        const std::string event = "data: " + note.dump() + "\n\n";
+        for (auto& subscriber : subscribers) {
+            REQUIRE(subscriber->read_until([&](const std::string& b) { return b.find(event) != std::string::npos; }));
+        }
+    }
+
+    SECTION("Closed subscribers are removed") {
+        subscribers.resize(1);
+        REQUIRE(wait_for_condition([&] { return transport->sse_subscribers() == 1; }, 3000));
+        std::string big(100000, 'x');
+        for (int i = 0; i < 20; ++i) transport->send_sse_notification(json{{"method", "bulk"}, {"params", {{"i", i}, {"pad", big}}}});
+        REQUIRE(subscribers[0]->read_until([](const std::string& b) { return b.find("\"i\":19") != std::string::npos; }));
+    }
+
+    SECTION("A POST still works while streams are open") {
+        http_peer peer(transport->port());
+        peer.write_raw(http_peer::post(R"({"jsonrpc":"2.0","id":9,"method":"m","params":[]})"));
+        REQUIRE(peer.response().first == 200);
+    }
+
+    transport->close();
+    for (auto& subscriber : subscribers) REQUIRE(subscriber->closed_by_peer());
+}
+
+TEST_CASE("HTTP content codings", "[transport][compression]") {
+    SECTION("Negotiation follows q-values, then server preference") {
+        const std::vector<ContentCoding> all = available_codings();
+        REQUIRE(negotiate("", all) == ContentCoding::identity);
+        REQUIRE(negotiate("compress", all) == ContentCoding::identity);
+        REQUIRE(negotiate("gzip;q=0, *;q=0", all) == ContentCoding::identity);
+        REQUIRE(parse_coding("X-GZIP") == ContentCoding::gzip);
+        REQUIRE_FALSE(parse_coding("lzma").has_value());
+        if (coding_available(ContentCoding::gzip) && coding_available(ContentCoding::deflate)) {
+            REQUIRE(negotiate("gzip, deflate", {ContentCoding::deflate, ContentCoding::gzip}) == ContentCoding::deflate);
+            REQUIRE(negotiate("gzip;q=0.4, deflate;q=0.5", {ContentCoding::gzip, ContentCoding::deflate}) == ContentCoding::deflate);
+            REQUIRE(negotiate("deflate;q=0, *", {ContentCoding::deflate, ContentCoding::gzip}) == ContentCoding::gzip);
+            REQUIRE(negotiate("GZIP; Q=1.0", {ContentCoding::gzip}) == ContentCoding::gzip);
+            REQUIRE(negotiate("gzip", {}) == ContentCoding::identity);
+            REQUIRE(accept_encoding_header({ContentCoding::gzip, ContentCoding::identity, ContentCoding::deflate}) == "gzip, deflate");
+        }
+    }
+
+    SECTION("Streams decode flush by flush in every available coding") {
+        for (auto coding : available_codings()) {
+            INFO(coding_name(coding));
+            ContentEncoder encoder(coding);
+            ContentDecoder decoder(coding);
+            for (int i = 0; i < 3; ++i) {
+                std::string event = "data: " + json{{"method", "log"}, {"params", {{"line", std::string(2000, char('a' + i))}}}}.dump() + "\n\n";
+                std::string packed, unpacked;
+                encoder.encode(event, packed);
+                REQUIRE(packed.size() < event.size());
+                decoder.decode(packed, unpacked);
+                REQUIRE(unpacked == event);
+            }
+            std::string bomb, out;
+            ContentEncoder(coding).finish(std::string(1 << 20, 'z'), bomb);
+            REQUIRE_THROWS_AS(ContentDecoder(coding).decode(bomb, out, 4096), std::length_error);
+        }
+    }
+
+    SECTION("Bodies under the threshold are sent as they are") {
+        HttpCompressionOptions options;
+        options.threshold = 100;
+        std::string out;
+        REQUIRE_FALSE(compress_body(ContentCoding::identity, std::string(500, 'a'), options, out));
+        for (auto coding : available_codings()) {
+            REQUIRE_FALSE(compress_body(coding, std::string(99, 'a'), options, out));
+            REQUIRE(compress_body(coding, std::string(500, 'a'), options, out));
+            std::string unpacked;
+            ContentDecoder(coding).decode(out, unpacked);
+            REQUIRE(unpacked == std::string(500, 'a'));
+        }
+    }
+}
+
+TEST_CASE("EpollHttpServerTransport compression", "[transport][epoll][compression]") {
+    if (available_codings().empty()) SKIP("built without compression libraries");
+    const ContentCoding coding = available_codings().front();
+    const std::string accept = "Accept-Encoding: " + std::string(coding_name(coding)) + "\r\n";
+    const std::string encoded = "Content-Encoding: " + std::string(coding_name(coding));
+    EpollHttpOptions options;
+    options.compression.threshold = 256;
+    auto transport = start_epoll_server(options);
+    const std::string pad(4000, 'p');
+
+    SECTION("Large responses are compressed for clients that accept it") {
+        http_peer peer(transport->port());
+        const std::string request = json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "m"}, {"params", {{"pad", pad}}}}.dump();
+        peer.write_raw(http_peer::post(request, accept));
+        auto [status, body] = peer.response();
+        REQUIRE(status == 200);
+        REQUIRE(peer.head.find(encoded) != std::string::npos);
+        REQUIRE(body.size() < pad.size());
+        std::string unpacked;
+        ContentDecoder(coding).decode(body, unpacked);
+        REQUIRE(json::parse(unpacked)["result"]["pad"] == pad);
+
+        // Small responses and clients without Accept-Encoding get plain bodies
+        peer.write_raw(http_peer::post(R"({"jsonrpc":"2.0","id":2,"method":"m","params":[]})", accept));
+        REQUIRE(json::parse(peer.response().second)["id"] == 2);
+        REQUIRE(peer.head.find("Content-Encoding") == std::string::npos);
+        peer.write_raw(http_peer::post(request));
+        REQUIRE(json::parse(peer.response().second)["result"]["pad"] == pad);
+        REQUIRE(peer.head.find("Content-Encoding") == std::string::npos);
+    }
+
+    SECTION("Compressed request bodies are decoded") {
+        http_peer peer(transport->port());
+        std::string packed;
+        ContentEncoder(coding).finish(json{{"jsonrpc", "2.0"}, {"id", 3}, {"method", "m"}, {"params", {{"x", 1}}}}.dump(), packed);
+        peer.write_raw(http_peer::post(packed, encoded + "\r\n"));
+        auto [status, body] = peer.response();
+        REQUIRE(status == 200);
+        REQUIRE(json::parse(body)["result"]["x"] == 1);
+
+        peer.write_raw(http_peer::post("{}", "Content-Encoding: lzma\r\n"));
+        REQUIRE(peer.response().first == 415);
+        peer.write_raw(http_peer::post("not compressed", encoded + "\r\n"));
+        REQUIRE(peer.response().first == 400);
+    }
+
+    SECTION("SSE streams are compressed as one stream") {
+        http_peer subscriber(transport->port());
+        subscriber.write_raw("GET /events HTTP/1.1\r\n" + accept + "\r\n");
+        size_t head_end = std::string::npos;
+        REQUIRE(subscriber.read_until([&](const std::string& b) { return (head_end = b.find("\r\n\r\n")) != std::string::npos; }));
+        REQUIRE(subscriber.buffered.substr(0, head_end).find(encoded) != std::string::npos);
+        subscriber.buffered.erase(0, head_end + 4);
+        REQUIRE(wait_for_condition([&] { return transport->sse_subscribers() == 1; }));
+
+        ContentDecoder decoder(coding);
+        std::string events;
+        for (int i = 0; i < 3; ++i) {
+            transport->send_sse_notification(json{{"method", "log"}, {"params", {{"i", i}, {"pad", pad}}}});
+            const std::string tail = "\"i\":" + std::to_string(i);
+            REQUIRE(subscriber.read_until([&](const std::string& b) {
+                decoder.decode(b, events);
+                subscriber.buffered.clear();
+                return events.find(tail) != std::string::npos && events.ends_with("\n\n");
+            }));
+        }
+        REQUIRE(events.find("\"i\":0") < events.find("\"i\":2"));
+    }
+
+    transport->close();
+}
+
+TEST_CASE("WebSocket helpers", "[transport][websocket]") {
+    SECTION("Handshake accept key follows RFC 6455") {
+        REQUIRE(detail::websocket_accept("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+    }
+
+    SECTION("Base64 round trip and strict decoding") {
+        using pooriayousefi::core::base64_decode;
+        using pooriayousefi::core::base64_encode;
+        REQUIRE(base64_encode("") == "");
+        REQUIRE(base64_encode("f") == "Zg==");
+        REQUIRE(base64_encode("fo") == "Zm8=");
+        REQUIRE(base64_encode("foobar") == "Zm9vYmFy");
+        std::string bytes;
+        for (int i = 0; i < 256; ++i) bytes.push_back(char(i));
+        REQUIRE(base64_decode(base64_encode(bytes)) == bytes);
+        REQUIRE_FALSE(base64_decode("Zm9").has_value());
+        REQUIRE_FALSE(base64_decode("Z===").has_value());
+        REQUIRE_FALSE(base64_decode("Zm9v YmFy").has_value());
+    }
+
+    SECTION("permessage-deflate negotiation") {
+        auto offer = detail::deflate_params::parse("x-webkit; a=1, permessage-deflate; client_max_window_bits", true);
+        REQUIRE(offer.has_value());
+        REQUIRE(offer->header() == "permessage-deflate");
+        auto answer = detail::deflate_params::parse("permessage-deflate; server_no_context_takeover; server_max_window_bits=10", false);
+        REQUIRE(answer.has_value());
+        REQUIRE(answer->server_no_context_takeover);
+        REQUIRE(answer->server_max_window_bits == 10);
+        REQUIRE_FALSE(detail::deflate_params::parse("permessage-deflate; server_max_window_bits=8", false).has_value());
+        REQUIRE_FALSE(detail::deflate_params::parse("permessage-deflate; unknown", true).has_value());
+    }
+
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+    SECTION("Deflate streams decode message by message") {
+        using namespace pooriayousefi::core;
+        Deflater deflater(DeflateFormat::raw);
+        Inflater inflater(DeflateFormat::raw);
+        for (int i = 0; i < 3; ++i) {
+            std::string message = std::string(1000, char('a' + i)) + std::to_string(i);
+            std::string packed, unpacked;
+            deflater.compress(message, packed, DeflateFlush::sync);
+            REQUIRE(packed.size() < message.size());
+            inflater.decompress(packed, unpacked);
+            REQUIRE(unpacked == message);
+        }
+        std::string bomb, out;
+        deflater.compress(std::string(1 << 20, 'z'), bomb, DeflateFlush::sync);
+        REQUIRE_THROWS_AS(inflater.decompress(bomb, out, 4096), std::length_error);
+    }
+#endif
+}
+
+namespace {
+    std::shared_ptr<WebSocketServerTransport> start_websocket_server(WebSocketOptions options = {}) {
+        auto transport = std::make_shared<WebSocketServerTransport>(0, "127.0.0.1", options);
+        // Answers every request with its params
+        std::weak_ptr<WebSocketServerTransport> weak = transport;
+        transport->on_message([weak](json&& msg) {
+            if (msg.contains("method") && msg.contains("id")) {
+                if (auto t = weak.lock()) t->send(json{{"jsonrpc", "2.0"}, {"id", msg["id"]}, {"result", msg.value("params", json{})}});
+            }
+        });
+        transport->start();
+        REQUIRE(transport->port() > 0);
+        return transport;
+    }
+
+    struct websocket_client {
+        std::shared_ptr<WebSocketClientTransport> transport;
+        std::mutex mutex;
+        std::vector<json> received;
+        std::atomic<bool> closed{false};
+
+        websocket_client(int port, WebSocketOptions options = {})
+            : transport(std::make_shared<WebSocketClientTransport>("ws://127.0.0.1:" + std::to_string(port) + "/mcp", options))
+        {
+            transport->on_message([this](json&& msg) {
+                std::lock_guard<std::mutex> lock(mutex);
+                received.push_back(std::move(msg));
+            });
+            transport->on_close([this] { closed = true; });
+        }
+
+        size_t count() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return received.size();
+        }
+    };
+}
+
+TEST_CASE("WebSocket transports", "[transport][websocket]") {
+    WebSocketOptions options;
+    options.compression_threshold = 64;
+    auto server = start_websocket_server(options);
+    websocket_client client(server->port(), options);
+    client.transport->start();
+    REQUIRE(client.transport->is_open());
+    REQUIRE(wait_for_condition([&] { return server->has_peer(); }));
+
+#ifdef POORIAYOUSEFI_CORE_HAS_ZLIB
+    REQUIRE(client.transport->connection()->compressed());
+    REQUIRE(server->connection()->compressed());
+#else
+    REQUIRE_FALSE(client.transport->connection()->compressed());
+#endif
+
+    SECTION("Requests and responses travel over one connection") {
+        for (int i = 0; i < 20; ++i) {
+            client.transport->send(json{{"jsonrpc", "2.0"}, {"id", i}, {"method", "echo"}, {"params", {{"i", i}}}});
+        }
+        REQUIRE(wait_for_condition([&] { return client.count() == 20; }));
+        std::lock_guard<std::mutex> lock(client.mutex);
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE(client.received[i]["id"] == i);
+            REQUIRE(client.received[i]["result"]["i"] == i);
+        }
+    }
+
+    SECTION("Large messages are fragmented into extended-length frames and compressed") {
+        std::string big(300000, 'x');
+        for (size_t i = 0; i < big.size(); i += 7) big[i] = char('a' + i % 26);
+        client.transport->send(json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "echo"}, {"params", {{"pad", big}}}});
+        REQUIRE(wait_for_condition([&] { return client.count() == 1; }, 3000));
+        std::lock_guard<std::mutex> lock(client.mutex);
+        REQUIRE(client.received[0]["result"]["pad"] == big);
+    }
+
+    SECTION("Notifications from the server reach the client") {
+        server->send(json{{"jsonrpc", "2.0"}, {"method", "notifications/message"}, {"params", {{"n", 1}}}});
+        REQUIRE(wait_for_condition([&] { return client.count() == 1; }));
+    }
+
+    SECTION("Only one peer at a time") {
+        websocket_client second(server->port());
+        REQUIRE_THROWS_AS(second.transport->start(), std::runtime_error);
+    }
+
+    SECTION("Closing the server closes the client") {
+        server->close();
+        REQUIRE(wait_for_condition([&] { return client.closed.load(); }, 3000));
+        REQUIRE_FALSE(client.transport->is_open());
+    }
+
+    SECTION("A new client may connect once the previous one leaves") {
+        client.transport->close();
+        REQUIRE(wait_for_condition([&] { return !server->has_peer(); }));
+        websocket_client next(server->port());
+        next.transport->start();
+        next.transport->send(json{{"jsonrpc", "2.0"}, {"id", "n"}, {"method", "echo"}, {"params", {}}});
+        REQUIRE(wait_for_condition([&] { return next.count() == 1; }));
+        next.transport->close();
+    }
+
+    client.transport->close();
+    server->close();
+}
+
+TEST_CASE("WebSocket binary frames and health checks", "[transport][websocket]") {
+    WebSocketOptions options;
+    options.frames = WebSocketFrames::binary;
+    options.compression = false;
+    options.ping_interval = std::chrono::milliseconds(30);
+    auto server = start_websocket_server(options);
+    websocket_client client(server->port(), options);
+    client.transport->start();
+    REQUIRE_FALSE(client.transport->connection()->compressed());
+
+    client.transport->send(json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "echo"}, {"params", {{"b", true}}}});
+    REQUIRE(wait_for_condition([&] { return client.count() == 1; }));
+
+    // Idle peers ping each other and stay connected
+    REQUIRE(wait_for_condition([&] { return client.transport->connection()->pongs_received() >= 2; }));
+    REQUIRE(client.transport->is_open());
+
+    SECTION("A peer that stops answering pings is dropped") {
+        // A raw socket that completes the upgrade and then goes silent
+        server->close();
+        WebSocketOptions strict;
+        strict.ping_interval = std::chrono::milliseconds(20);
+        strict.pong_timeout = std::chrono::milliseconds(50);
+        server = start_websocket_server(strict);
+        http_peer peer(server->port());
+        peer.write_raw("GET / HTTP/1.1\r\nHost: x\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                       "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n");
+        REQUIRE(peer.read_until([](const std::string& b) { return b.find("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") != std::string::npos; }));
+        REQUIRE(wait_for_condition([&] { return server->has_peer(); }));
+        REQUIRE(wait_for_condition([&] { return !server->has_peer(); }, 2000));
+        REQUIRE(peer.closed_by_peer());
+    }
+
+    SECTION("Malformed upgrades are refused") {
+        http_peer peer(server->port());
+        peer.write_raw("GET / HTTP/1.1\r\nHost: x\r\n\r\n");
+        REQUIRE(peer.response().first == 400);
+    }
+
+    client.transport->close();
+    server->close();
+}
+
+TEST_CASE("Binary message encodings", "[transport][codec]") {
+    json blob = json::binary(json::binary_t::container_type{0x00, 0xff, 0x10, '{'});
+    json message = {{"jsonrpc", "2.0"}, {"id", 3}, {"result", {{"contents", json::array({{{"uri", "mem://x"}, {"blob", blob}}})}}}};
+
+    SECTION("CBOR and MessagePack round trip binary values") {
+        for (auto encoding : {Encoding::cbor, Encoding::msgpack}) {
+            std::string bytes;
+            encode_message(message, encoding, bytes);
+            REQUIRE_FALSE(looks_like_json(bytes));
+            json decoded = decode_message(bytes, encoding);
+            REQUIRE(decoded["result"]["contents"][0]["blob"].is_binary());
+            REQUIRE(decoded == message);
+        }
+    }
+
+    SECTION("JSON texts are recognised whatever the encoding") {
+        REQUIRE(looks_like_json("  {\"a\":1}"));
+        REQUIRE(looks_like_json("[1]"));
+        REQUIRE(decode_message("{\"a\":1}", Encoding::cbor) == json{{"a", 1}});
+        REQUIRE(parse_encoding("msgpack") == Encoding::msgpack);
+        REQUIRE_FALSE(parse_encoding("bson").has_value());
+        REQUIRE(encoding_name(Encoding::cbor) == "cbor");
+    }
+
+    SECTION("Pre-encoded results are expanded for binary encodings") {
+        namespace rpc = pooriayousefi::mcp::jsonrpc;
+        json response = rpc::make_result(1, rpc::encoded(rpc::encoded_buffer{'[', '1', ']'}));
+        std::string bytes;
+        encode_message(response, Encoding::cbor, bytes);
+        REQUIRE(decode_message(bytes, Encoding::cbor)["result"] == json::array({1}));
+    }
+
+    SECTION("Transports decode binary input only once it is accepted") {
+        auto [a, b] = create_in_memory_pair();
+        REQUIRE(a->supports_encoding(Encoding::msgpack));
+        REQUIRE_FALSE(StdioTransport().supports_encoding(Encoding::cbor));
+        REQUIRE_THROWS_AS(StdioTransport().set_encoding(Encoding::cbor), std::invalid_argument);
+
+        int to_transport[2];
+        REQUIRE(::pipe(to_transport) == 0);
+        FastStdioOptions options;
+        options.input_fd = to_transport[0];
+        options.output_fd = to_transport[1];
+        options.framing = StdioFraming::content_length;
+        FastStdioTransport transport(options);
+        std::vector<json> received;
+        std::vector<std::string> errors;
+        std::mutex mutex;
+        transport.on_message([&](json&& msg) { std::lock_guard<std::mutex> lock(mutex); received.push_back(std::move(msg)); });
+        transport.on_error([&](const std::string& e) { std::lock_guard<std::mutex> lock(mutex); errors.push_back(e); });
+        transport.start();
+
+        auto frame = [](const std::string& body) { return "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body; };
+        std::string cbor;
+        encode_message(json{{"jsonrpc", "2.0"}, {"method", "n"}}, Encoding::cbor, cbor);
+        std::string wire = frame(cbor);
+        REQUIRE(::write(to_transport[1], wire.data(), wire.size()) == static_cast<ssize_t>(wire.size()));
+        REQUIRE(wait_for_condition([&] { std::lock_guard<std::mutex> lock(mutex); return errors.size() == 1; }));
+
+        transport.accept_encoding(Encoding::cbor);
+        wire = frame(cbor) + frame(R"({"jsonrpc":"2.0","method":"text"})");
+        REQUIRE(::write(to_transport[1], wire.data(), wire.size()) == static_cast<ssize_t>(wire.size()));
+        REQUIRE(wait_for_condition([&] { std::lock_guard<std::mutex> lock(mutex); return received.size() == 2; }));
+        REQUIRE(received[0]["method"] == "n");
+        REQUIRE(received[1]["method"] == "text");
+        REQUIRE(transport.encoding() == Encoding::json);
+        transport.close();
+        ::close(to_transport[0]);
+        ::close(to_transport[1]);
+    }
+
+    SECTION("WebSocket carries binary encodings in binary frames") {
+        auto server = start_websocket_server();
+        websocket_client client(server->port());
+        client.transport->start();
+        REQUIRE(wait_for_condition([&] { return server->has_peer(); }));
+        server->set_encoding(Encoding::msgpack);
+        client.transport->set_encoding(Encoding::msgpack);
+        client.transport->send(json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "echo"}, {"params", {{"blob", blob}}}});
+        REQUIRE(wait_for_condition([&] { return client.count() == 1; }));
+        std::lock_guard<std::mutex> lock(client.mutex);
+        REQUIRE(client.received[0]["result"]["blob"] == blob);
+        client.transport->close();
+        server->close();
+    }
+}
+
+#if __has_include(<httplib.h>)
+#include <mcp/transport/http_transport.hpp>
+#include <poll.h>
+
+namespace {
+    // A loopback HTTP/1.1 endpoint recording each POST body and answering it
+    // with reply(body): a JSON body, "" for 202 Accepted, or nullopt to never answer
+    struct http_listener {
+        using reply_fn = std::function<std::optional<std::string>(const std::string&)>;
+
+        int fd = -1;
+        int port = 0;
+        reply_fn reply;
+        std::atomic<bool> running{true};
+        std::mutex mutex;
+        std::vector<std::string> bodies;
+        std::thread thread;
+
+        explicit http_listener(reply_fn r) : reply(std::move(r)) {
+            fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            REQUIRE(fd >= 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+            REQUIRE(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+            REQUIRE(::listen(fd, 16) == 0);
+            socklen_t len = sizeof(addr);
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+            port = ntohs(addr.sin_port);
+            thread = std::thread([this] { run(); });
+        }
+        ~http_listener() { stop(); }
+
+        void stop() {
+            if (!running.exchange(false)) return;
+            thread.join();
+            ::close(fd);
+        }
+
+        size_t count() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return bodies.size();
+        }
+
+        std::string url() const { return "http://127.0.0.1:" + std::to_string(port); }
+
+        // Echoes each request's params back as its result
+        static std::optional<std::string> echo(const std::string& body) {
+            auto answer = [](const json& m) { return json{{"jsonrpc", "2.0"}, {"id", m["id"]}, {"result", m.value("params", json{})}}; };
+            json in = json::parse(body);
+            if (!in.is_array()) return in.contains("id") ? answer(in).dump() : std::string();
+            json out = json::array();
+            for (const auto& m : in) if (m.contains("id")) out.push_back(answer(m));
+            return out.empty() ? std::string() : out.dump();
+        }
+
+    private:
+        void run() {
+            std::vector<pollfd> fds{{fd, POLLIN, 0}};
+            std::vector<std::string> buffers{""};
+            while (running) {
+                if (::poll(fds.data(), fds.size(), 20) <= 0) continue;
+                if (fds[0].revents & POLLIN) {
+                    int client = ::accept(fd, nullptr, nullptr);
+                    if (client >= 0) {
+                        fds.push_back({client, POLLIN, 0});
+                        buffers.emplace_back();
+                    }
+                }
+                for (size_t i = 1; i < fds.size(); ++i) {
+                    if (!(fds[i].revents & (POLLIN | POLLHUP))) continue;
+                    char buf[4096];
+                    ssize_t n = ::recv(fds[i].fd, buf, sizeof(buf), 0);
+                    if (n <= 0) {
+                        ::close(fds[i].fd);
+                        fds[i].fd = -1; // poll skips negative descriptors
+                        continue;
+                    }
+                    buffers[i].append(buf, static_cast<size_t>(n));
+                    serve(fds[i].fd, buffers[i]);
+                }
+            }
+            for (size_t i = 1; i < fds.size(); ++i) if (fds[i].fd >= 0) ::close(fds[i].fd);
+        }
+
+        void serve(int client, std::string& buffer) {
+            while (true) {
+                size_t head_end = buffer.find("\r\n\r\n");
+                if (head_end == std::string::npos) return;
+                std::string head = buffer.substr(0, head_end);
+                for (auto& c : head) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                size_t length = 0;
+                if (auto at = head.find("content-length:"); at != std::string::npos) length = std::stoul(head.substr(at + 15));
+                if (buffer.size() < head_end + 4 + length) return;
+                std::string body = buffer.substr(head_end + 4, length);
+                buffer.erase(0, head_end + 4 + length);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    bodies.push_back(body);
+                }
+                auto answer = reply(body);
+                if (!answer) continue;
+                std::string out = answer->empty()
+                    ? std::string("HTTP/1.1 202 Accepted\r\nContent-Length: 0\r\n\r\n")
+                    : "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                      std::to_string(answer->size()) + "\r\n\r\n" + *answer;
+                ::send(client, out.data(), out.size(), MSG_NOSIGNAL);
+            }
+        }
+    };
+
+    // A loopback port nothing listens on
+    int refused_port() {
+        int probe = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        ::bind(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        socklen_t len = sizeof(addr);
+        ::getsockname(probe, reinterpret_cast<sockaddr*>(&addr), &len);
+        ::close(probe);
+        return ntohs(addr.sin_port);
+    }
+}
+
+TEST_CASE("HttpClientTransport", "[transport][http]") {
+    using pooriayousefi::core::sync_wait;
+
+    SECTION("send_async resumes each caller with the response carrying its id") {
+        http_listener server(http_listener::echo);
+        HttpClientOptions options;
+        options.connections = 3;
+        HttpClientTransport transport(server.url(), "/jsonrpc", options);
+        std::mutex mutex;
+        std::vector<json> unclaimed;
+        transport.on_message([&](json&& msg) {
+            std::lock_guard<std::mutex> lock(mutex);
+            unclaimed.push_back(std::move(msg));
+        });
+
+        std::vector<std::thread> callers;
+        std::atomic<int> matched{0};
+        for (int i = 0; i < 16; ++i) {
+            callers.emplace_back([&, i] {
+                json request{{"jsonrpc", "2.0"}, {"id", i}, {"method", "echo"}, {"params", {{"n", i}}}};
+                json response = sync_wait(transport.send_async(request));
+                if (response["id"] == i && response["result"]["n"] == i) ++matched;
+            });
+        }
+        for (auto& caller : callers) caller.join();
+        REQUIRE(matched == 16);
+
+        // A reply nobody awaits goes to the message handler
+        transport.send(json{{"jsonrpc", "2.0"}, {"id", "plain"}, {"method", "echo"}});
+        REQUIRE(wait_for_condition([&] { std::lock_guard<std::mutex> lock(mutex); return unclaimed.size() == 1; }));
+        REQUIRE(unclaimed[0]["id"] == "plain");
+        REQUIRE(server.count() == 17);
+        transport.close();
+    }
+
+    SECTION("Messages queued behind a POST go out together as one batch") {
+        std::atomic<bool> release{false};
+        http_listener server([&](const std::string& body) {
+            // Hold the first POST until the rest of the messages are queued
+            while (!release) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            return http_listener::echo(body);
+        });
+        HttpClientOptions options;
+        options.connections = 1;
+        options.batch_limit = 8;
+        HttpClientTransport transport(server.url(), "/jsonrpc", options);
+        std::mutex mutex;
+        std::vector<json> received;
+        transport.on_message([&](json&& msg) {
+            std::lock_guard<std::mutex> lock(mutex);
+            received.push_back(std::move(msg));
+        });
+
+        transport.send(json{{"jsonrpc", "2.0"}, {"id", 0}, {"method", "echo"}});
+        REQUIRE(wait_for_condition([&] { return server.count() == 1; }));
+        for (int i = 1; i <= 5; ++i) transport.send(json{{"jsonrpc", "2.0"}, {"id", i}, {"method", "echo"}});
+        transport.send(json{{"jsonrpc", "2.0"}, {"method", "note"}});
+        release = true;
+
+        REQUIRE(wait_for_condition([&] { std::lock_guard<std::mutex> lock(mutex); return received.size() == 6; }));
+        REQUIRE(wait_for_condition([&] { return transport.in_flight() == 0; }));
+        REQUIRE(server.count() == 2);
+        std::lock_guard<std::mutex> lock(server.mutex);
+        json batch = json::parse(server.bodies[1]);
+        REQUIRE(batch.is_array());
+        REQUIRE(batch.size() == 6);
+        REQUIRE(batch[0]["id"] == 1);
+        REQUIRE(batch[5]["method"] == "note");
+        transport.close();
+    }
+
+    SECTION("A refused connection answers queued requests with internal_error") {
+        HttpClientOptions options;
+        options.connections = 1;
+        options.connect_timeout = std::chrono::seconds(1);
+        HttpClientTransport transport("http://127.0.0.1:" + std::to_string(refused_port()), "/jsonrpc", options);
+        std::atomic<int> errors{0};
+        std::atomic<int> messages{0};
+        transport.on_error([&](const std::string&) { ++errors; });
+        transport.on_message([&](json&&) { ++messages; });
+
+        json request{{"jsonrpc", "2.0"}, {"id", 7}, {"method", "ping"}};
+        json response = sync_wait(transport.send_async(request));
+        REQUIRE(response["id"] == 7);
+        REQUIRE(response["error"]["code"] == pooriayousefi::mcp::jsonrpc::internal_error.code);
+        REQUIRE(response["error"]["data"]["what"].get<std::string>().starts_with("HTTP request failed"));
+        REQUIRE(errors == 1);
+
+        // A notification has nobody to answer, so only the error handler hears of it
+        transport.send(json{{"jsonrpc", "2.0"}, {"method", "note"}});
+        REQUIRE(wait_for_condition([&] { return errors == 2; }));
+        REQUIRE(messages == 0);
+        transport.close();
+    }
+
+    SECTION("close() fails calls still waiting for a response") {
+        http_listener server([](const std::string&) { return std::optional<std::string>(); });
+        HttpClientOptions options;
+        options.connections = 1;
+        HttpClientTransport transport(server.url(), "/jsonrpc", options);
+        std::atomic<bool> closed{false};
+        transport.on_close([&] { closed = true; });
+
+        std::atomic<bool> failed{false};
+        std::thread caller([&] {
+            json request{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "slow"}};
+            try {
+                sync_wait(transport.send_async(request));
+            } catch (const std::runtime_error&) {
+                failed = true;
+            }
+        });
+        REQUIRE(wait_for_condition([&] { return server.count() == 1; }));
+
+        // The waiter fails at once; close() itself returns when the POST gives up
+        std::thread closer([&] { transport.close(); });
+        REQUIRE(wait_for_condition([&] { return failed.load(); }));
+        caller.join();
+        server.stop();
+        closer.join();
+        REQUIRE(closed);
+        REQUIRE_FALSE(transport.is_open());
+    }
+
+    SECTION("close() from the message handler does not join its own thread") {
+        http_listener server(http_listener::echo);
+        std::atomic<int> received{0};
+        {
+            HttpClientOptions options;
+            options.connections = 2;
+            HttpClientTransport transport(server.url(), "/jsonrpc", options);
+            transport.on_message([&](json&&) {
+                ++received;
+                transport.close();
+            });
+            transport.send(json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "echo"}});
+            REQUIRE(wait_for_condition([&] { return received == 1 && !transport.is_open(); }));
+
+            // Sending again restarts the I/O threads
+            transport.send(json{{"jsonrpc", "2.0"}, {"id", 2}, {"method", "echo"}});
+            REQUIRE(wait_for_condition([&] { return received == 2 && !transport.is_open(); }));
+        }
+        REQUIRE(server.count() == 2);
+    }
+}
+
+namespace {
+    // Starts a server on a free loopback port and waits until it accepts connections
+    std::shared_ptr<HttpServerTransport> start_http_server(int& port, std::function<void(json&&)> handler) {
+        port = refused_port();
+        auto transport = std::make_shared<HttpServerTransport>(port, "127.0.0.1");
+        transport->on_message(std::move(handler));
+        transport->start();
+        REQUIRE(wait_for_condition([&] {
+            int probe = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(port));
+            ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+            bool ok = ::connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+            ::close(probe);
+            return ok;
+        }, 2000));
+        return transport;
+    }
+}
+
+TEST_CASE("HttpServerTransport", "[transport][http]") {
+    // Requests are held until the test answers them
+    std::mutex mutex;
+    std::vector<json> received;
+    auto hold = [&](json&& msg) {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(std::move(msg));
+    };
+    auto count = [&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return received.size();
+    };
+    auto answer = [](const json& request) {
+        return json{{"jsonrpc", "2.0"}, {"id", request["id"]}, {"result", request.value("params", json{})}};
+    };
+    int port = 0;
+
+    SECTION("Concurrent POSTs reusing one id each get their own response") {
+        auto server = start_http_server(port, hold);
+        std::vector<std::unique_ptr<http_peer>> peers;
+        for (int i = 0; i < 8; ++i) {
+            peers.push_back(std::make_unique<http_peer>(port));
+            peers.back()->write_raw(http_peer::post(json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "echo"}, {"params", {{"n", i}}}}.dump()));
+        }
+        REQUIRE(wait_for_condition([&] { return count() == 8; }));
+        REQUIRE(server->in_flight() == 8);
+        for (auto it = received.rbegin(); it != received.rend(); ++it) server->send(answer(*it));
+        for (int i = 0; i < 8; ++i) {
+            auto [status, body] = peers[i]->response();
+            REQUIRE(status == 200);
+            json response = json::parse(body);
+            REQUIRE(response["id"] == 1);
+            REQUIRE(response["result"]["n"] == i);
+        }
+        server->stop();
+    }
+
+    SECTION("A batch mixing notifications and requests is answered as one array") {
+        auto server = start_http_server(port, hold);
+        http_peer peer(port);
+        json batch = json::array({
+            json{{"jsonrpc", "2.0"}, {"id", 1}, {"method", "echo"}},
+            json{{"jsonrpc", "2.0"}, {"method", "notifications/initialized"}},
+            json{{"jsonrpc", "2.0"}, {"id", "x"}, {"method", "echo"}}
+        });
+        peer.write_raw(http_peer::post(batch.dump()));
+        REQUIRE(wait_for_condition([&] { return count() == 1; }));
+        json forwarded = received[0];
+        REQUIRE(forwarded.size() == 3);
+        server->send(json::array({answer(forwarded[2]), answer(forwarded[0])}));
+        auto [status, body] = peer.response();
+        REQUIRE(status == 200);
+        json responses = json::parse(body);
+        REQUIRE(responses.size() == 2);
+        REQUIRE(responses[0]["id"] == "x");
+        REQUIRE(responses[1]["id"] == 1);
+
+        peer.write_raw(http_peer::post(json::array({json{{"jsonrpc", "2.0"}, {"method", "note"}}}).dump()));
+        REQUIRE(peer.response().first == 202);
+        server->stop();
+    }
+
+    SECTION("A cancel from another POST reaches the request it names") {
+        auto server = start_http_server(port, hold);
+        http_peer caller(port);
+        http_peer canceller(port);
+        caller.write_raw(http_peer::post(json{{"jsonrpc", "2.0"}, {"id", 3}, {"method", "slow"}}.dump()));
+        REQUIRE(wait_for_condition([&] { return count() == 1; }));
+        canceller.write_raw(http_peer::post(json{{"jsonrpc", "2.0"}, {"method", "$/cancelRequest"}, {"params", {{"id", 3}}}}.dump()));
+        REQUIRE(canceller.response().first == 202);
+        REQUIRE(count() == 2);
+        REQUIRE(received[1]["params"]["id"] == received[0]["id"]);
+
+        server->send(json{{"jsonrpc", "2.0"}, {"id", received[0]["id"]}, {"error", {{"code", -32800}, {"message", "Request cancelled"}}}});
+        auto [status, body] = caller.response();
+        REQUIRE(json::parse(body)["id"] == 3);
+        server->stop();
+    }
+
+    SECTION("Progress over SSE carries the client's token") {
+        auto server = start_http_server(port, hold);
+        http_peer events(port);
+        events.write_raw("GET /events HTTP/1.1\r\nHost: test\r\n\r\n");
+        REQUIRE(wait_for_condition([&] { return server->sse_subscribers() == 1; }));
+
+        http_peer caller(port);
+        caller.write_raw(http_peer::post(json{{"jsonrpc", "2.0"}, {"id", 7}, {"method", "slow"}}.dump()));
+        REQUIRE(wait_for_condition([&] { return count() == 1; }));
+        const auto wire_id = received[0]["id"].get<uint64_t>();
+        server->send(json{{"jsonrpc", "2.0"}, {"method", "$/progress"}, {"params", {{"token", std::to_string(wire_id)}, {"value", 50}}}});
+        REQUIRE(events.read_until([](const std::string& b) { return b.find("\"value\":50") != std::string::npos; }));
+        REQUIRE(events.buffered.find(R"("token":"7")") != std::string::npos);
+
+        server->send(answer(received[0]));
+        REQUIRE(json::parse(caller.response().second)["id"] == 7);
+        server->stop();
+    }
+
+    SECTION("stop() answers waiting POSTs with internal_error") {
+        auto server = start_http_server(port, hold);
+        http_peer caller(port);
+        caller.write_raw(http_peer::post(json{{"jsonrpc", "2.0"}, {"id", "w"}, {"method", "slow"}}.dump()));
+        REQUIRE(wait_for_condition([&] { return count() == 1; }));
+        auto started = std::chrono::steady_clock::now();
+        server->stop();
+        REQUIRE(std::chrono::steady_clock::now() - started < std::chrono::seconds(5));
+        auto [status, body] = caller.response();
+        REQUIRE(status == 200);
+        json response = json::parse(body);
+        REQUIRE(response["id"] == "w");
+        REQUIRE(response["error"]["code"] == pooriayousefi::mcp::jsonrpc::internal_error.code);
+    }
+}
+#endif